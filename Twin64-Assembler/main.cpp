@@ -0,0 +1,112 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - File Assembler Program.
+//
+//----------------------------------------------------------------------------------------
+// The assembler program assembles a source file into a big endian ELF64 file, which
+// can be loaded by the simulator. The program is invoked as follows:
+//
+//  Twin64-Assembler <srcFile> [ -o <elfFile> ] [ -s ] [ -l ]
+//
+// Without the "-o" option, the output file name is the source file name with the
+// extension replaced by ".elf". The "-s" option prints the symbol table, the "-l"
+// option prints a disassembled listing of the executable sections. The program exit
+// code is zero when there were no errors.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - File Assembler Program
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details. You should have received a copy of the GNU General Public
+// License along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-InlineAsm.h"
+
+const char  *srcFileName            = nullptr;
+char        elfFileName[ 1024 ]     = { 0 };
+bool        printSymTab             = false;
+bool        printList               = false;
+
+//----------------------------------------------------------------------------------------
+// Program input parameters. The default output file name is built from the source
+// file name.
+//
+//----------------------------------------------------------------------------------------
+bool parseParameters( int argc, const char * argv[] ) {
+
+    for ( int i = 1; i < argc; i++ ) {
+
+        if ( strcmp( argv[ i ], "-s" ) == 0 ) {
+
+            printSymTab = true;
+        }
+        else if ( strcmp( argv[ i ], "-l" ) == 0 ) {
+
+            printList = true;
+        }
+        else if (( strcmp( argv[ i ], "-o" ) == 0 ) && ( i + 1 < argc )) {
+
+            snprintf( elfFileName, sizeof( elfFileName ), "%s", argv[ ++i ] );
+        }
+        else if (( argv[ i ][ 0 ] != '-' ) && ( srcFileName == nullptr )) {
+
+            srcFileName = argv[ i ];
+        }
+        else return( false );
+    }
+
+    if ( srcFileName == nullptr ) return( false );
+
+    if ( elfFileName[ 0 ] == 0 ) {
+
+        snprintf( elfFileName, sizeof( elfFileName ) - 4, "%s", srcFileName );
+
+        char *dot   = strrchr( elfFileName, '.' );
+        char *slash = strrchr( elfFileName, '/' );
+
+        if (( dot != nullptr ) && (( slash == nullptr ) || ( dot > slash ))) *dot = 0;
+        strcat( elfFileName, ".elf" );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Here we go. We assemble the file and write the ELF file when there were no errors.
+//
+//----------------------------------------------------------------------------------------
+int main( int argc, const char * argv[] ) {
+
+    if ( ! parseParameters( argc, argv )) {
+
+        printf( "Usage: Twin64-Assembler <srcFile> [ -o <elfFile> ] [ -s ] [ -l ]\n" );
+        return( 1 );
+    }
+
+    T64FileAssemble asmFile( stderr );
+
+    if ( asmFile.assembleFile( srcFileName ) == 0 ) {
+
+        asmFile.writeElfFile( elfFileName );
+        if ( printSymTab ) asmFile.printSymbols( stdout );
+        if ( printList )   asmFile.printListing( stdout );
+    }
+
+    if ( asmFile.getErrCount( ) > 0 ) {
+
+        fprintf( stderr, "%d error(s)\n", asmFile.getErrCount( ));
+        return( 1 );
+    }
+
+    return( 0 );
+}
@@ -0,0 +1,832 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - Core Library Microbenchmark Program.
+//
+//----------------------------------------------------------------------------------------
+// Bench runs a set of microbenchmarks against the hot paths of the core libraries.
+// Each benchmark is a small function that sets up its objects, starts the timer and
+// runs the measured operation for the requested number of iterations. The harness
+// increases the iteration count until the run takes long enough to give a stable
+// time per operation. The program is invoked as follows:
+//
+//  Twin64-Bench [ -f <filter> ] [ -t <minTimeSec> ] [ -j <jsonFile> ]
+//
+// The filter option selects the benchmarks whose name contains the filter string.
+// Without the JSON option, a table is printed to standard output. With the JSON
+// option, the results are written in the Google Benchmark JSON format, so that the
+// usual compare tools can be used for regression tracking. A "-" for the file name
+// writes the JSON data to standard output.
+//
+// The processor benchmarks use a bench processor, which is a processor module that
+// serves its own bus requests from a host memory buffer. This way, the CPU, TLB and
+// cache numbers measure these components and not the system bus and memory modules,
+// which have their own benchmarks.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - Core Library Microbenchmark Program
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details. You should have received a copy of the GNU General Public
+// License along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+#include "T64-Processor.h"
+#include "T64-Memory.h"
+#include "T64-InlineAsm.h"
+
+#include <chrono>
+#include <ctime>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+// Bench constants. The bench memory is the host buffer behind the bench processor.
+// Code is placed at the code address, data at the data address. The CPU benchmarks
+// run a block of instructions and then restart at the block beginning.
+//
+//----------------------------------------------------------------------------------------
+const int       BENCH_MEM_SIZE          = 1024 * 1024;
+const T64Word   BENCH_CODE_ADR          = 0x1000;
+const T64Word   BENCH_DATA_ADR          = 0x80000;
+const int       BENCH_CODE_BLOCK        = 1024;
+const T64Word   BENCH_CACHED_ADR        = T64_MAX_PHYS_MEM_LIMIT + 1;
+const double    BENCH_DEF_MIN_TIME      = 0.5;
+const T64Word   BENCH_MAX_ITERATIONS    = 1000000000;
+
+//----------------------------------------------------------------------------------------
+// The benchmark state. A benchmark function gets the number of iterations to run and
+// an optional argument. It starts and stops the timer around the measured part.
+//
+//----------------------------------------------------------------------------------------
+struct BenchState {
+
+    T64Word         iterations      = 0;
+    int             arg             = 0;
+    double          realTimeNs      = 0.0;
+    double          cpuTimeNs       = 0.0;
+    bool            failed          = false;
+
+    std::chrono::steady_clock::time_point   realStart;
+    clock_t                                 cpuStart = 0;
+
+    void startTimer( ) {
+
+        cpuStart  = clock( );
+        realStart = std::chrono::steady_clock::now( );
+    }
+
+    void stopTimer( ) {
+
+        auto realEnd = std::chrono::steady_clock::now( );
+
+        realTimeNs += std::chrono::duration<double, std::nano>( realEnd - realStart ).count( );
+        cpuTimeNs  += ( clock( ) - cpuStart ) * ( 1.0e9 / CLOCKS_PER_SEC );
+    }
+};
+
+typedef void ( *BenchFunc )( BenchState *st );
+
+//----------------------------------------------------------------------------------------
+// The benchmark table entry and the benchmark result.
+//
+//----------------------------------------------------------------------------------------
+struct BenchEntry {
+
+    const char      *name;
+    BenchFunc       func;
+    int             arg;
+};
+
+struct BenchResult {
+
+    char            name[ 64 ];
+    T64Word         iterations      = 0;
+    double          realTimeNs      = 0.0;
+    double          cpuTimeNs       = 0.0;
+    bool            failed          = false;
+};
+
+//----------------------------------------------------------------------------------------
+// Program globals. The sink is written by the benchmarks, so that the compiler
+// cannot remove the measured operations.
+//
+//----------------------------------------------------------------------------------------
+const char          *filterStr  = nullptr;
+const char          *jsonFile   = nullptr;
+double              minTime     = BENCH_DEF_MIN_TIME;
+volatile T64Word    benchSink   = 0;
+alignas( 8 ) uint8_t benchMem[ BENCH_MEM_SIZE ];
+
+//----------------------------------------------------------------------------------------
+// The bench processor. A processor module that serves the requests issued by its own
+// caches from the bench memory buffer. Requests issued by other modules are passed
+// to the processor module as usual.
+//
+//----------------------------------------------------------------------------------------
+struct BenchProcessor : T64Processor {
+
+    BenchProcessor( T64System *sys, T64CacheType cacheType ) :
+
+        T64Processor( sys,
+                      1,
+                      T64_PO_NIL,
+                      T64_CPU_T_NIL,
+                      T64_TT_FA_64S,
+                      T64_TT_FA_64S,
+                      cacheType,
+                      cacheType,
+                      0,
+                      0 ) { }
+
+    uint8_t *memPtr( T64Word pAdr ) {
+
+        return( &benchMem[ pAdr & ( BENCH_MEM_SIZE - 1 ) ] );
+    }
+
+    bool busOpReadUncached( int reqModNum, T64Word pAdr, uint8_t *data, int len ) {
+
+        if ( reqModNum != getModuleNum( ))
+            return( T64Processor::busOpReadUncached( reqModNum, pAdr, data, len ));
+
+        return( copyToBigEndian( data, memPtr( pAdr ), len ));
+    }
+
+    bool busOpWriteUncached( int reqModNum, T64Word pAdr, uint8_t *data, int len ) {
+
+        if ( reqModNum != getModuleNum( ))
+            return( T64Processor::busOpWriteUncached( reqModNum, pAdr, data, len ));
+
+        return( copyToBigEndian( memPtr( pAdr ), data, len ));
+    }
+
+    bool busOpReadSharedBlock( int reqModNum, T64Word pAdr, uint8_t *data, int len ) {
+
+        if ( reqModNum != getModuleNum( ))
+            return( T64Processor::busOpReadSharedBlock( reqModNum, pAdr, data, len ));
+
+        memcpy( data, memPtr( rounddown( pAdr, len )), len );
+        return( true );
+    }
+
+    bool busOpReadPrivateBlock( int reqModNum, T64Word pAdr, uint8_t *data, int len ) {
+
+        if ( reqModNum != getModuleNum( ))
+            return( T64Processor::busOpReadPrivateBlock( reqModNum, pAdr, data, len ));
+
+        memcpy( data, memPtr( rounddown( pAdr, len )), len );
+        return( true );
+    }
+
+    bool busOpWriteBlock( int reqModNum, T64Word pAdr, uint8_t *data, int len ) {
+
+        if ( reqModNum != getModuleNum( ))
+            return( T64Processor::busOpWriteBlock( reqModNum, pAdr, data, len ));
+
+        memcpy( memPtr( rounddown( pAdr, len )), data, len );
+        return( true );
+    }
+};
+
+//----------------------------------------------------------------------------------------
+// Local helpers. The cache tag computation mirrors the cache geometry, we need it to
+// set up valid cache lines for the hit benchmarks.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+int log2Int( int val ) {
+
+    int res = 0;
+    while (( 1 << res ) < val ) res ++;
+    return( res );
+}
+
+uint32_t cacheTag( T64Cache *c, T64Word pAdr ) {
+
+    return((uint32_t)( pAdr >> ( log2Int( c -> getCacheLineSize( )) +
+                                 log2Int( c -> getSetSize( )))));
+}
+
+uint32_t cacheSet( T64Cache *c, T64Word pAdr ) {
+
+    return((uint32_t)(( pAdr / c -> getCacheLineSize( )) % c -> getSetSize( )));
+}
+
+//----------------------------------------------------------------------------------------
+// Mark all lines of the set for the address as valid with a tag that does not match
+// the address. The next access to the address will therefore miss and select a valid
+// victim. When "modified" is set, the victim needs to be written back first.
+//
+//----------------------------------------------------------------------------------------
+void fillCacheSet( T64Cache *c, T64Word pAdr, bool modified ) {
+
+    T64CacheLineInfo    *info;
+    uint8_t             *data;
+    uint32_t            set = cacheSet( c, pAdr );
+
+    for ( int w = 0; w < c -> getWays( ); w++ ) {
+
+        if ( c -> getCacheLineByIndex( w, set, &info, &data )) {
+
+            info -> valid       = true;
+            info -> modified    = modified;
+            info -> tag         = cacheTag( c, pAdr ) + 1;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Assemble a block of instructions into the bench memory at the code address. The
+// block is filled with the same instruction. Returns false if the instruction string
+// does not assemble.
+//
+//----------------------------------------------------------------------------------------
+bool loadCodeBlock( const char *asmStr ) {
+
+    T64Assemble doAsm;
+    uint32_t    instr = 0;
+    char        buf[ 64 ];
+
+    strncpy( buf, asmStr, sizeof( buf ) - 1 );
+    buf[ sizeof( buf ) - 1 ] = '\0';
+
+    if ( doAsm.assembleInstr( buf, &instr ) != 0 ) return( false );
+
+    for ( int i = 0; i < BENCH_CODE_BLOCK; i++ ) {
+
+        copyToBigEndian( &benchMem[ BENCH_CODE_ADR + ( i * 4 ) ], (uint8_t *) &instr, 4 );
+    }
+
+    return( true );
+}
+
+} // namespace
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// CPU benchmarks
+//
+//----------------------------------------------------------------------------------------
+// The CPU step benchmarks. There is a benchmark for each opcode family. The CPU runs
+// in privileged mode from physical memory, so the TLBs are not involved. Register 2
+// holds the data address for the memory reference instructions.
+//
+//----------------------------------------------------------------------------------------
+const char *cpuInstrTab[ ] = {
+
+    "ADD R1,R2,R3",
+    "ADD R1,R1,1",
+    "CMP.EQ R1,R2,R3",
+    "EXTR R1,R2,4,8",
+    "LDO R1,8(R2)",
+    "LD R1,0(R2)",
+    "ST R1,0(R2)",
+    "B 4",
+    "MFCR R1,C1"
+};
+
+void benchCpuStep( BenchState *st ) {
+
+    T64System       sys;
+    BenchProcessor  proc( &sys, T64_CT_4W_128S_4L );
+    T64Cpu          *cpu        = proc.getCpuPtr( );
+    T64Word         startPsr    = ( 1ULL << 61 ) | BENCH_CODE_ADR;
+
+    if ( ! loadCodeBlock( cpuInstrTab[ st -> arg ] )) {
+
+        st -> failed = true;
+        return;
+    }
+
+    cpu -> setGeneralReg( 2, BENCH_DATA_ADR );
+    cpu -> setPsrReg( startPsr );
+
+    st -> startTimer( );
+
+    for ( T64Word i = 0; i < st -> iterations; i++ ) {
+
+        cpu -> step( );
+        if (( i % BENCH_CODE_BLOCK ) == ( BENCH_CODE_BLOCK - 1 )) cpu -> setPsrReg( startPsr );
+    }
+
+    st -> stopTimer( );
+    benchSink = cpu -> getGeneralReg( 1 );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// TLB benchmarks
+//
+//----------------------------------------------------------------------------------------
+// TLB lookup hit. The TLB is filled with 4 Kb pages and we look them up round robin.
+//
+//----------------------------------------------------------------------------------------
+void benchTlbLookupHit( BenchState *st ) {
+
+    T64Tlb  tlb( nullptr, T64_TK_DATA_TLB, T64_TT_FA_64S );
+    int     entries = tlb.getTlbSize( );
+
+    for ( int i = 0; i < entries; i++ ) tlb.insert( i * T64_PAGE_SIZE_BYTES, 0 );
+
+    st -> startTimer( );
+
+    for ( T64Word i = 0; i < st -> iterations; i++ ) {
+
+        benchSink = (T64Word) tlb.lookup(( i % entries ) * T64_PAGE_SIZE_BYTES );
+    }
+
+    st -> stopTimer( );
+}
+
+//----------------------------------------------------------------------------------------
+// TLB lookup miss. The TLB is full, but the looked up address is not mapped. This is
+// the worst case, all entries are checked.
+//
+//----------------------------------------------------------------------------------------
+void benchTlbLookupMiss( BenchState *st ) {
+
+    T64Tlb  tlb( nullptr, T64_TK_DATA_TLB, T64_TT_FA_64S );
+    int     entries = tlb.getTlbSize( );
+
+    for ( int i = 0; i < entries; i++ ) tlb.insert( i * T64_PAGE_SIZE_BYTES, 0 );
+
+    st -> startTimer( );
+
+    for ( T64Word i = 0; i < st -> iterations; i++ ) {
+
+        benchSink = (T64Word) tlb.lookup(( entries + 1 ) * T64_PAGE_SIZE_BYTES );
+    }
+
+    st -> stopTimer( );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Cache benchmarks
+//
+//----------------------------------------------------------------------------------------
+// Cache read and write hit. The cache line for the address is set up as valid and
+// then accessed repeatedly. The addresses are above the physical memory range, so
+// that the cached path is taken.
+//
+//----------------------------------------------------------------------------------------
+void benchCacheHit( BenchState *st, bool write ) {
+
+    T64System           sys;
+    BenchProcessor      proc( &sys, T64_CT_4W_128S_4L );
+    T64Cache            *c      = proc.getDCachePtr( );
+    T64Word             adr     = BENCH_CACHED_ADR + c -> getCacheLineSize( );
+    T64Word             val     = 0;
+    T64CacheLineInfo    *info;
+    uint8_t             *data;
+
+    if ( ! c -> getCacheLineByIndex( 0, cacheSet( c, adr ), &info, &data )) {
+
+        st -> failed = true;
+        return;
+    }
+
+    info -> valid       = true;
+    info -> modified    = false;
+    info -> tag         = cacheTag( c, adr );
+
+    st -> startTimer( );
+
+    try {
+
+        for ( T64Word i = 0; i < st -> iterations; i++ ) {
+
+            if ( write ) c -> write( adr, (uint8_t *) &val, 8 );
+            else         c -> read( adr, (uint8_t *) &val, 8 );
+        }
+    }
+    catch ( const T64Trap t ) {
+
+        st -> failed = true;
+    }
+
+    st -> stopTimer( );
+    benchSink = val;
+}
+
+void benchCacheReadHit( BenchState *st ) {
+
+    benchCacheHit( st, false );
+}
+
+void benchCacheWriteHit( BenchState *st ) {
+
+    benchCacheHit( st, true );
+}
+
+//----------------------------------------------------------------------------------------
+// Cache read miss. We walk sequentially through a range larger than the cache, each
+// access is a line miss with a free victim line.
+//
+//----------------------------------------------------------------------------------------
+void benchCacheReadMiss( BenchState *st ) {
+
+    T64System       sys;
+    BenchProcessor  proc( &sys, T64_CT_4W_128S_4L );
+    T64Cache        *c          = proc.getDCachePtr( );
+    int             lineSize    = c -> getCacheLineSize( );
+    T64Word         val         = 0;
+
+    st -> startTimer( );
+
+    try {
+
+        for ( T64Word i = 0; i < st -> iterations; i++ ) {
+
+            T64Word adr = BENCH_CACHED_ADR + (( i * lineSize ) % BENCH_MEM_SIZE );
+            c -> read( adr, (uint8_t *) &val, 8 );
+        }
+    }
+    catch ( const T64Trap t ) {
+
+        st -> failed = true;
+    }
+
+    st -> stopTimer( );
+    benchSink = val;
+}
+
+//----------------------------------------------------------------------------------------
+// Cache write miss with write back. Before each access, the lines of the set are
+// marked valid and modified with a different tag. The access misses and the victim
+// line is written back first. The set up work is part of the measured time, it is
+// just a few stores.
+//
+//----------------------------------------------------------------------------------------
+void benchCacheWriteBack( BenchState *st ) {
+
+    T64System       sys;
+    BenchProcessor  proc( &sys, T64_CT_4W_128S_4L );
+    T64Cache        *c      = proc.getDCachePtr( );
+    T64Word         adr     = BENCH_CACHED_ADR + c -> getCacheLineSize( );
+    T64Word         val     = 0;
+
+    st -> startTimer( );
+
+    try {
+
+        for ( T64Word i = 0; i < st -> iterations; i++ ) {
+
+            fillCacheSet( c, adr, true );
+            c -> write( adr, (uint8_t *) &val, 8 );
+        }
+    }
+    catch ( const T64Trap t ) {
+
+        st -> failed = true;
+    }
+
+    st -> stopTimer( );
+    benchSink = val;
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// System and memory benchmarks
+//
+//----------------------------------------------------------------------------------------
+// System module lookup by address. The system is configured with the number of memory
+// modules given by the argument, each one page in size. We look up the addresses of
+// all modules round robin.
+//
+//----------------------------------------------------------------------------------------
+void benchSystemLookupByAdr( BenchState *st ) {
+
+    T64System               sys;
+    std::vector<T64Memory*> mods;
+
+    for ( int i = 0; i < st -> arg; i++ ) {
+
+        T64Memory *m = new T64Memory( &sys,
+                                      i,
+                                      T64_MK_NIL,
+                                      T64_MT_RAM,
+                                      i * T64_PAGE_SIZE_BYTES,
+                                      T64_PAGE_SIZE_BYTES );
+
+        if ( sys.addToModuleMap( m ) != 0 ) st -> failed = true;
+        mods.push_back( m );
+    }
+
+    if ( ! st -> failed ) {
+
+        st -> startTimer( );
+
+        for ( T64Word i = 0; i < st -> iterations; i++ ) {
+
+            benchSink = (T64Word) sys.lookupByAdr(( i % st -> arg ) * T64_PAGE_SIZE_BYTES );
+        }
+
+        st -> stopTimer( );
+    }
+
+    for ( T64Memory *m : mods ) delete m;
+}
+
+//----------------------------------------------------------------------------------------
+// Memory module read and write by data width. The argument is the width in bytes. We
+// walk through the first page of the module.
+//
+//----------------------------------------------------------------------------------------
+void benchMemory( BenchState *st, bool write ) {
+
+    T64System   sys;
+    T64Memory   mem( &sys, 0, T64_MK_NIL, T64_MT_RAM, 0, 16 * T64_PAGE_SIZE_BYTES );
+    int         len     = st -> arg;
+    T64Word     val     = 0;
+
+    st -> startTimer( );
+
+    for ( T64Word i = 0; i < st -> iterations; i++ ) {
+
+        T64Word adr = ( i * len ) % T64_PAGE_SIZE_BYTES;
+
+        if ( write ) mem.busOpWriteUncached( -1, adr, (uint8_t *) &val, len );
+        else         mem.busOpReadUncached( -1, adr, (uint8_t *) &val, len );
+    }
+
+    st -> stopTimer( );
+    benchSink = val;
+}
+
+void benchMemoryRead( BenchState *st ) {
+
+    benchMemory( st, false );
+}
+
+void benchMemoryWrite( BenchState *st ) {
+
+    benchMemory( st, true );
+}
+
+//----------------------------------------------------------------------------------------
+// The benchmark table. The name follows the "family/variant" convention of the JSON
+// output format.
+//
+//----------------------------------------------------------------------------------------
+const BenchEntry benchTab[ ] = {
+
+    { "BM_CpuStep/ALU_ADD",             benchCpuStep,           0   },
+    { "BM_CpuStep/ALU_ADD_IMM",         benchCpuStep,           1   },
+    { "BM_CpuStep/ALU_CMP",             benchCpuStep,           2   },
+    { "BM_CpuStep/ALU_BITOP",           benchCpuStep,           3   },
+    { "BM_CpuStep/ALU_LDO",             benchCpuStep,           4   },
+    { "BM_CpuStep/MEM_LD",              benchCpuStep,           5   },
+    { "BM_CpuStep/MEM_ST",              benchCpuStep,           6   },
+    { "BM_CpuStep/BR_B",                benchCpuStep,           7   },
+    { "BM_CpuStep/SYS_MR",              benchCpuStep,           8   },
+
+    { "BM_TlbLookup/hit",               benchTlbLookupHit,      0   },
+    { "BM_TlbLookup/miss",              benchTlbLookupMiss,     0   },
+
+    { "BM_CacheRead/hit",               benchCacheReadHit,      0   },
+    { "BM_CacheRead/miss",              benchCacheReadMiss,     0   },
+    { "BM_CacheWrite/hit",              benchCacheWriteHit,     0   },
+    { "BM_CacheWrite/writeback",        benchCacheWriteBack,    0   },
+
+    { "BM_SystemLookupByAdr/1",         benchSystemLookupByAdr, 1   },
+    { "BM_SystemLookupByAdr/2",         benchSystemLookupByAdr, 2   },
+    { "BM_SystemLookupByAdr/4",         benchSystemLookupByAdr, 4   },
+    { "BM_SystemLookupByAdr/8",         benchSystemLookupByAdr, 8   },
+    { "BM_SystemLookupByAdr/16",        benchSystemLookupByAdr, 16  },
+
+    { "BM_MemoryRead/1",                benchMemoryRead,        1   },
+    { "BM_MemoryRead/2",                benchMemoryRead,        2   },
+    { "BM_MemoryRead/4",                benchMemoryRead,        4   },
+    { "BM_MemoryRead/8",                benchMemoryRead,        8   },
+    { "BM_MemoryWrite/1",               benchMemoryWrite,       1   },
+    { "BM_MemoryWrite/2",               benchMemoryWrite,       2   },
+    { "BM_MemoryWrite/4",               benchMemoryWrite,       4   },
+    { "BM_MemoryWrite/8",               benchMemoryWrite,       8   }
+};
+
+const int MAX_BENCH_TAB = sizeof( benchTab ) / sizeof( BenchEntry );
+
+//----------------------------------------------------------------------------------------
+// Run one benchmark. We start with one iteration and increase the count until the
+// run takes at least a tenth of the minimum time. From that run we estimate the
+// iteration count for the minimum time and do the final run.
+//
+//----------------------------------------------------------------------------------------
+void runBench( const BenchEntry *entry, BenchResult *res ) {
+
+    T64Word     iterations = 1;
+    BenchState  st;
+
+    strncpy( res -> name, entry -> name, sizeof( res -> name ) - 1 );
+
+    while ( true ) {
+
+        st              = BenchState( );
+        st.iterations   = iterations;
+        st.arg          = entry -> arg;
+
+        entry -> func( &st );
+        if ( st.failed ) break;
+
+        if ( st.realTimeNs >= minTime * 1.0e8 ) {
+
+            double  perIter = st.realTimeNs / iterations;
+            T64Word needed  = (T64Word)(( minTime * 1.0e9 ) / (( perIter > 0 ) ? perIter : 1 ));
+
+            if ( needed > BENCH_MAX_ITERATIONS ) needed = BENCH_MAX_ITERATIONS;
+            if ( needed <= iterations ) break;
+
+            st              = BenchState( );
+            st.iterations   = needed;
+            st.arg          = entry -> arg;
+
+            entry -> func( &st );
+            break;
+        }
+
+        if ( iterations >= BENCH_MAX_ITERATIONS ) break;
+        iterations *= 10;
+    }
+
+    res -> iterations   = st.iterations;
+    res -> realTimeNs   = ( st.iterations > 0 ) ? st.realTimeNs / st.iterations : 0;
+    res -> cpuTimeNs    = ( st.iterations > 0 ) ? st.cpuTimeNs / st.iterations : 0;
+    res -> failed       = st.failed;
+}
+
+//----------------------------------------------------------------------------------------
+// Print the results as a table.
+//
+//----------------------------------------------------------------------------------------
+void printTable( std::vector<BenchResult> &results ) {
+
+    printf( "%-32s%16s%16s%16s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations" );
+
+    for ( BenchResult &r : results ) {
+
+        if ( r.failed ) printf( "%-32s%16s\n", r.name, "FAILED" );
+        else {
+
+            printf( "%-32s%16.2f%16.2f%16lld\n",
+                    r.name, r.realTimeNs, r.cpuTimeNs, (long long) r.iterations );
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Write the results in the Google Benchmark JSON format. The context part records
+// when and where the benchmarks were run. Failed benchmarks are reported with an
+// error message and no timing data.
+//
+//----------------------------------------------------------------------------------------
+bool writeJson( std::vector<BenchResult> &results ) {
+
+    FILE    *f = stdout;
+    char    dateStr[ 64 ];
+    char    hostStr[ 256 ] = "unknown";
+    time_t  now = time( nullptr );
+
+    if ( strcmp( jsonFile, "-" ) != 0 ) {
+
+        f = fopen( jsonFile, "w" );
+        if ( f == nullptr ) return( false );
+    }
+
+    strftime( dateStr, sizeof( dateStr ), "%Y-%m-%dT%H:%M:%S", localtime( &now ));
+#if __APPLE__ || __linux__
+    gethostname( hostStr, sizeof( hostStr ) - 1 );
+#else
+    if ( getenv( "COMPUTERNAME" ) != nullptr ) {
+
+        strncpy( hostStr, getenv( "COMPUTERNAME" ), sizeof( hostStr ) - 1 );
+    }
+#endif
+
+    fprintf( f, "{\n" );
+    fprintf( f, "  \"context\": {\n" );
+    fprintf( f, "    \"date\": \"%s\",\n", dateStr );
+    fprintf( f, "    \"host_name\": \"%s\",\n", hostStr );
+    fprintf( f, "    \"executable\": \"Twin64-Bench\",\n" );
+    fprintf( f, "    \"min_time\": %.3f,\n", minTime );
+#ifdef NDEBUG
+    fprintf( f, "    \"library_build_type\": \"release\"\n" );
+#else
+    fprintf( f, "    \"library_build_type\": \"debug\"\n" );
+#endif
+    fprintf( f, "  },\n" );
+    fprintf( f, "  \"benchmarks\": [\n" );
+
+    for ( size_t i = 0; i < results.size( ); i++ ) {
+
+        BenchResult &r = results[ i ];
+
+        fprintf( f, "    {\n" );
+        fprintf( f, "      \"name\": \"%s\",\n", r.name );
+        fprintf( f, "      \"run_name\": \"%s\",\n", r.name );
+        fprintf( f, "      \"run_type\": \"iteration\",\n" );
+
+        if ( r.failed ) {
+
+            fprintf( f, "      \"error_occurred\": true,\n" );
+            fprintf( f, "      \"error_message\": \"benchmark setup failed\"\n" );
+        }
+        else {
+
+            fprintf( f, "      \"iterations\": %lld,\n", (long long) r.iterations );
+            fprintf( f, "      \"real_time\": %.4f,\n", r.realTimeNs );
+            fprintf( f, "      \"cpu_time\": %.4f,\n", r.cpuTimeNs );
+            fprintf( f, "      \"time_unit\": \"ns\",\n" );
+            fprintf( f, "      \"items_per_second\": %.1f\n",
+                     ( r.realTimeNs > 0 ) ? 1.0e9 / r.realTimeNs : 0.0 );
+        }
+
+        fprintf( f, "    }%s\n", ( i + 1 < results.size( )) ? "," : "" );
+    }
+
+    fprintf( f, "  ]\n" );
+    fprintf( f, "}\n" );
+
+    if ( f != stdout ) fclose( f );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Program input parameters.
+//
+//----------------------------------------------------------------------------------------
+bool parseParameters( int argc, const char * argv[] ) {
+
+    for ( int i = 1; i < argc; i++ ) {
+
+        if (( strcmp( argv[ i ], "-f" ) == 0 ) && ( i + 1 < argc )) {
+
+            filterStr = argv[ ++i ];
+        }
+        else if (( strcmp( argv[ i ], "-t" ) == 0 ) && ( i + 1 < argc )) {
+
+            minTime = atof( argv[ ++i ] );
+            if ( minTime <= 0 ) return( false );
+        }
+        else if (( strcmp( argv[ i ], "-j" ) == 0 ) && ( i + 1 < argc )) {
+
+            jsonFile = argv[ ++i ];
+        }
+        else return( false );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Here we go. Run all selected benchmarks and report the results.
+//
+//----------------------------------------------------------------------------------------
+int main( int argc, const char * argv[] ) {
+
+    std::vector<BenchResult> results;
+
+    if ( ! parseParameters( argc, argv )) {
+
+        printf( "Usage: Twin64-Bench [ -f <filter> ] [ -t <minTimeSec> ] [ -j <jsonFile> ]\n" );
+        return( 1 );
+    }
+
+    for ( int i = 0; i < MAX_BENCH_TAB; i++ ) {
+
+        if (( filterStr != nullptr ) && ( strstr( benchTab[ i ].name, filterStr ) == nullptr )) {
+
+            continue;
+        }
+
+        BenchResult res;
+        runBench( &benchTab[ i ], &res );
+        results.push_back( res );
+    }
+
+    if ( jsonFile == nullptr ) printTable( results );
+    else if ( ! writeJson( results )) {
+
+        printf( "Cannot write JSON file: \"%s\"\n", jsonFile );
+        return( 1 );
+    }
+
+    int failed = 0;
+    for ( BenchResult &r : results ) if ( r.failed ) failed ++;
+
+    return(( failed > 0 ) ? 1 : 0 );
+}
@@ -0,0 +1,824 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - Guest Workload Benchmark Program.
+//
+//----------------------------------------------------------------------------------------
+// GuestBench runs a set of small guest programs on a configured system and reports
+// how fast the simulator executes them. Each workload is a short assembler program,
+// encoded with the inline assembler, together with the number of processors, the
+// initial register values and an optional data setup routine. The program is run
+// headless until all processors reached the final halt instruction. The program is
+// invoked as follows:
+//
+//  Twin64-GuestBench [ -f <filter> ] [ -w <baseFile> ] [ -b <baseFile> ] [ -t <pct> ]
+//
+// The filter option selects the workloads whose name contains the filter string. For
+// each workload we report the instructions executed, the wall time, the host MIPS
+// and the cache and TLB statistics of all processors. The "-w" option writes the
+// MIPS numbers to a baseline file. The "-b" option compares the MIPS numbers to a
+// baseline file written earlier. When a workload is slower than the baseline by more
+// than the threshold percentage, default is 10, it is flagged and the program exits
+// with a non-zero status.
+//
+// The workload programs use a simple label scheme on top of the one line assembler.
+// A line may start with a "<name>:" label and a branch offset may be written as
+// "@<name>". The offset is replaced by the byte distance to the label before the
+// line is assembled. Every program ends with a "halt" label on a "B 0" instruction.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - Guest Workload Benchmark Program
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details. You should have received a copy of the GNU General Public
+// License along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+#include "T64-Processor.h"
+#include "T64-Memory.h"
+#include "T64-InlineAsm.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+// Guest system layout. There is one memory module starting at physical address zero
+// and up to four processors. Code is placed at the code address, data at the data
+// address. The processors run in privileged mode. The memory module is mapped at
+// the virtual base address with locked and cached 1 Mbyte pages in the instruction
+// and data TLB, so that all instruction and data accesses go through the TLBs and
+// the caches. The code and data addresses are physical, the workloads use them
+// with the virtual base address added.
+//
+//----------------------------------------------------------------------------------------
+const int       GUEST_MAX_PROCS         = 4;
+const int       GUEST_MEM_SIZE          = 1024 * T64_PAGE_SIZE_BYTES;
+const T64Word   GUEST_CODE_ADR          = 0x1000;
+const T64Word   GUEST_DATA_ADR          = 0x10000;
+const T64Word   GUEST_DATA_ADR_2        = 0x100000;
+const T64Word   GUEST_VIRT_BASE         = 0x2000000000;
+const T64Word   GUEST_MAP_PAGE_SIZE     = 0x100000;
+const int       GUEST_MAP_PAGE_SIZE_ID  = 2;
+const T64Word   GUEST_VIRT_ADR          = 0x1000080000;
+const int       GUEST_STEP_CHUNK        = 1024;
+const T64Word   GUEST_MAX_STEPS         = 1000000000;
+const double    GUEST_DEF_THRESHOLD     = 10.0;
+
+//----------------------------------------------------------------------------------------
+// A workload. The register table lists the initial general register values, the
+// same values are set for all processors. The setup routine, when present, is
+// called after the code is loaded to set up the data area.
+//
+//----------------------------------------------------------------------------------------
+struct GuestRegInit {
+
+    int             reg;
+    T64Word         val;
+};
+
+struct GuestWorkload {
+
+    const char          *name;
+    int                 procs;
+    const char          **code;
+    const GuestRegInit  *regs;
+    bool                ( *setup )( T64System *sys );
+};
+
+//----------------------------------------------------------------------------------------
+// The result of a workload run.
+//
+//----------------------------------------------------------------------------------------
+struct GuestResult {
+
+    const char      *name           = nullptr;
+    bool            failed          = false;
+    bool            timedOut        = false;
+    T64Word         instructions    = 0;
+    double          wallTimeSec     = 0.0;
+    double          mips            = 0.0;
+    T64Word         iCacheHits      = 0;
+    T64Word         iCacheMisses    = 0;
+    T64Word         dCacheHits      = 0;
+    T64Word         dCacheMisses    = 0;
+    T64Word         iTlbLookups     = 0;
+    T64Word         iTlbMisses      = 0;
+    T64Word         dTlbLookups     = 0;
+    T64Word         dTlbMisses      = 0;
+    T64Word         stcSuccess      = 0;
+    T64Word         stcFail         = 0;
+    double          baseMips        = 0.0;
+    bool            regression      = false;
+};
+
+//----------------------------------------------------------------------------------------
+// Program options.
+//
+//----------------------------------------------------------------------------------------
+const char  *filterStr      = nullptr;
+const char  *writeBaseFile  = nullptr;
+const char  *readBaseFile   = nullptr;
+double      threshold       = GUEST_DEF_THRESHOLD;
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Workloads
+//
+//----------------------------------------------------------------------------------------
+// Tight ALU loop. R1 is the loop counter.
+//
+//----------------------------------------------------------------------------------------
+const char *aluLoopCode[ ] = {
+
+    "loop: ADD R2,R2,R1",
+    "      XOR R4,R2,R1",
+    "      AND R5,R4,255",
+    "      OR R6,R5,R2",
+    "      SUB R1,R1,1",
+    "      CBR.NE R1,R0,@loop",
+    "halt: B 0",
+    nullptr
+};
+
+const GuestRegInit aluLoopRegs[ ] = {
+
+    { 1, 2000000 }, { -1, 0 }
+};
+
+//----------------------------------------------------------------------------------------
+// Memory copy. R1 is the source, R2 the destination, R3 the number of words per
+// pass and R6 the number of passes.
+//
+//----------------------------------------------------------------------------------------
+const char *memCopyCode[ ] = {
+
+    "outer: ADD R7,R1,0",
+    "       ADD R8,R2,0",
+    "       ADD R9,R3,0",
+    "copy:  LD R4,0(R7)",
+    "       ST R4,0(R8)",
+    "       LDO R7,8(R7)",
+    "       LDO R8,8(R8)",
+    "       SUB R9,R9,1",
+    "       CBR.NE R9,R0,@copy",
+    "       SUB R6,R6,1",
+    "       CBR.NE R6,R0,@outer",
+    "halt:  B 0",
+    nullptr
+};
+
+const GuestRegInit memCopyRegs[ ] = {
+
+    { 1, GUEST_VIRT_BASE + GUEST_DATA_ADR   }, 
+    { 2, GUEST_VIRT_BASE + GUEST_DATA_ADR_2 }, 
+    { 3, 4096 }, { 6, 400 }, { -1, 0 }
+};
+
+//----------------------------------------------------------------------------------------
+// Pointer chasing. R1 is the list head, R3 the number of hops. The list nodes are
+// one cache line apart and linked in a permuted order, so that each hop lands on a
+// different line far away from the previous one. The links are virtual addresses.
+//
+//----------------------------------------------------------------------------------------
+const int   PTR_CHASE_NODES     = 8192;
+const int   PTR_CHASE_STRIDE    = 64;
+
+const char *ptrChaseCode[ ] = {
+
+    "loop: LD R1,0(R1)",
+    "      SUB R3,R3,1",
+    "      CBR.NE R3,R0,@loop",
+    "halt: B 0",
+    nullptr
+};
+
+const GuestRegInit ptrChaseRegs[ ] = {
+
+    { 1, GUEST_VIRT_BASE + GUEST_DATA_ADR_2 }, { 3, 1000000 }, { -1, 0 }
+};
+
+bool ptrChaseSetup( T64System *sys ) {
+
+    std::vector<int> order( PTR_CHASE_NODES );
+    uint64_t         seed = 0x2545F4914F6CDD1DULL;
+
+    for ( int i = 0; i < PTR_CHASE_NODES; i++ ) order[ i ] = i;
+
+    for ( int i = PTR_CHASE_NODES - 1; i > 1; i-- ) {
+
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        int j = 1 + (int)( seed % i );
+        int t = order[ i ];
+        order[ i ] = order[ j ];
+        order[ j ] = t;
+    }
+
+    for ( int i = 0; i < PTR_CHASE_NODES; i++ ) {
+
+        T64Word adr  = GUEST_DATA_ADR_2 + order[ i ] * PTR_CHASE_STRIDE;
+        T64Word next = GUEST_VIRT_BASE + GUEST_DATA_ADR_2 +
+                       order[ ( i + 1 ) % PTR_CHASE_NODES ] * PTR_CHASE_STRIDE;
+
+        if ( ! sys -> writeMem( adr, (uint8_t *) &next, sizeof( next ))) return( false );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Branch heavy code. R1 is the loop counter, the low order bits of the counter
+// decide which way the branches go.
+//
+//----------------------------------------------------------------------------------------
+const char *branchCode[ ] = {
+
+    "loop: AND R4,R1,1",
+    "      CBR.EQ R4,R0,@even",
+    "      ADD R2,R2,3",
+    "      B @next",
+    "even: SUB R2,R2,1",
+    "next: AND R5,R1,6",
+    "      CBR.NE R5,R0,@skip",
+    "      ADD R6,R6,1",
+    "skip: CMP.LT R7,R2,R6",
+    "      CBR.EQ R7,R0,@cont",
+    "      ADD R2,R2,R6",
+    "cont: SUB R1,R1,1",
+    "      CBR.NE R1,R0,@loop",
+    "halt: B 0",
+    nullptr
+};
+
+const GuestRegInit branchRegs[ ] = {
+
+    { 1, 1000000 }, { -1, 0 }
+};
+
+//----------------------------------------------------------------------------------------
+// TLB thrashing page walk. We walk over more pages than the data TLB holds. Each
+// page is looked up with LPA and inserted when not found, just like a software TLB
+// miss handler would do. Then a word of the page is loaded through the mapping. The
+// word index in R11 moves half a cache line further for each page, so that the loads
+// are spread over the cache sets. R1 is the virtual base address, R2 the physical
+// base address, R3 the number of pages and R6 the number of passes.
+//
+//----------------------------------------------------------------------------------------
+const char *tlbWalkCode[ ] = {
+
+    "outer: ADD R4,R1,0",
+    "       ADD R5,R2,0",
+    "       ADD R7,R3,0",
+    "       ADD R11,R0,0",
+    "walk:  LPA R8,R0(R4)",
+    "       CBR.NE R8,R0,@hit",
+    "       IDTLB R9,R4,R5",
+    "hit:   LD R10,R11(R4)",
+    "       ADD R11,R11,2",
+    "       ADD R4,R4,4096",
+    "       ADD R5,R5,4096",
+    "       SUB R7,R7,1",
+    "       CBR.NE R7,R0,@walk",
+    "       SUB R6,R6,1",
+    "       CBR.NE R6,R0,@outer",
+    "halt:  B 0",
+    nullptr
+};
+
+const GuestRegInit tlbWalkRegs[ ] = {
+
+    { 1, GUEST_VIRT_ADR }, { 2, GUEST_DATA_ADR_2 }, { 3, 256 }, { 6, 2000 }, { -1, 0 }
+};
+
+//----------------------------------------------------------------------------------------
+// Multi-processor spinlock contention. All processors run the same code. The lock
+// word is at the address in R2, the shared counter is the next word. R3 is the
+// number of lock acquisitions per processor. The lock is acquired with a LDR and
+// STC sequence, a failed STC leaves a zero in R4 and we start over.
+//
+//----------------------------------------------------------------------------------------
+const char *spinLockCode[ ] = {
+
+    "loop: LDR R4,0(R2)",
+    "      CBR.NE R4,R0,@loop",
+    "      ADD R4,R0,1",
+    "      STC R4,0(R2)",
+    "      CBR.EQ R4,R0,@loop",
+    "      LD R6,8(R2)",
+    "      ADD R6,R6,1",
+    "      ST R6,8(R2)",
+    "      ST R0,0(R2)",
+    "      SUB R3,R3,1",
+    "      CBR.NE R3,R0,@loop",
+    "halt: B 0",
+    nullptr
+};
+
+const GuestRegInit spinLockRegs[ ] = {
+
+    { 2, GUEST_VIRT_BASE + GUEST_DATA_ADR }, { 3, 100000 }, { -1, 0 }
+};
+
+//----------------------------------------------------------------------------------------
+// The workload table.
+//
+//----------------------------------------------------------------------------------------
+const GuestWorkload workloadTab[ ] = {
+
+    { "alu_loop",       1,                  aluLoopCode,    aluLoopRegs,    nullptr         },
+    { "mem_copy",       1,                  memCopyCode,    memCopyRegs,    nullptr         },
+    { "ptr_chase",      1,                  ptrChaseCode,   ptrChaseRegs,   ptrChaseSetup   },
+    { "branch",         1,                  branchCode,     branchRegs,     nullptr         },
+    { "tlb_walk",       1,                  tlbWalkCode,    tlbWalkRegs,    nullptr         },
+    { "spin_lock",      GUEST_MAX_PROCS,    spinLockCode,   spinLockRegs,   nullptr         }
+};
+
+const int WORKLOAD_TAB_SIZE = sizeof( workloadTab ) / sizeof( GuestWorkload );
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Program loader
+//
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// A label found in the program source.
+//
+//----------------------------------------------------------------------------------------
+struct GuestLabel {
+
+    std::string     name;
+    T64Word         adr;
+};
+
+//----------------------------------------------------------------------------------------
+// Split off the label of a source line. We return the position of the instruction
+// part and store the label name, if any.
+//
+//----------------------------------------------------------------------------------------
+const char *splitLabel( const char *line, std::string &label ) {
+
+    const char *colon = strchr( line, ':' );
+
+    label.clear( );
+    if ( colon == nullptr ) return( line );
+
+    for ( const char *p = line; p < colon; p++ ) {
+
+        if ( *p != ' ' ) label += *p;
+    }
+
+    colon ++;
+    while ( *colon == ' ' ) colon ++;
+    return( colon );
+}
+
+T64Word findLabel( std::vector<GuestLabel> &labels, const std::string &name ) {
+
+    for ( GuestLabel &l : labels ) {
+
+        if ( l.name == name ) return( l.adr );
+    }
+
+    return( -1 );
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------------------
+// Load a workload program. The first pass collects the labels, the second pass
+// replaces the label references and assembles each instruction into memory. We
+// return the halt address or -1 on error.
+//
+//----------------------------------------------------------------------------------------
+T64Word loadProgram( T64System *sys, const char **code ) {
+
+    std::vector<GuestLabel> labels;
+    std::string             label;
+    T64Assemble             doAsm;
+    T64Word                 adr = GUEST_CODE_ADR;
+
+    for ( int i = 0; code[ i ] != nullptr; i++ ) {
+
+        splitLabel( code[ i ], label );
+        if ( ! label.empty( )) labels.push_back( { label, adr } );
+        adr += 4;
+    }
+
+    adr = GUEST_CODE_ADR;
+
+    for ( int i = 0; code[ i ] != nullptr; i++ ) {
+
+        std::string src     = splitLabel( code[ i ], label );
+        size_t      pos     = src.find( '@' );
+        uint32_t    instr   = 0;
+        char        buf[ 128 ];
+
+        if ( pos != std::string::npos ) {
+
+            T64Word target = findLabel( labels, src.substr( pos + 1 ));
+            if ( target < 0 ) {
+
+                printf( "Unknown label in: \"%s\"\n", code[ i ] );
+                return( -1 );
+            }
+
+            src = src.substr( 0, pos ) + std::to_string( target - adr );
+        }
+
+        snprintf( buf, sizeof( buf ), "%s", src.c_str( ));
+
+        if ( doAsm.assembleInstr( buf, &instr ) != 0 ) {
+
+            printf( "Assembler error in: \"%s\"\n", code[ i ] );
+            return( -1 );
+        }
+
+        if ( ! sys -> writeMem( adr, (uint8_t *) &instr, 4 )) return( -1 );
+        adr += 4;
+    }
+
+    return( findLabel( labels, "halt" ));
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Workload runner
+//
+//----------------------------------------------------------------------------------------
+// Map the guest memory at the virtual base address. The TLB entries are locked, so 
+// that a workload inserting its own entries will not replace them. The page size 
+// field is at bit 36, the physical page number starts at bit 12.
+//
+//----------------------------------------------------------------------------------------
+bool mapGuestMemory( T64Processor *proc ) {
+
+    for ( T64Word pAdr = 0; pAdr < GUEST_MEM_SIZE; pAdr += GUEST_MAP_PAGE_SIZE ) {
+
+        T64Word info = ( 1ULL << 61 ) | 
+                       (((T64Word) GUEST_MAP_PAGE_SIZE_ID ) << 36 ) | 
+                       pAdr;
+
+        if ( ! proc -> getITlbPtr( ) -> insert( GUEST_VIRT_BASE + pAdr, info )) return( false );
+        if ( ! proc -> getDTlbPtr( ) -> insert( GUEST_VIRT_BASE + pAdr, info )) return( false );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Set up the system for a workload. We build a system with one memory module and the
+// requested number of processors, load the program, set up the data area, map the 
+// memory and set the initial registers. The modules created are returned, such that
+// the caller can delete them. We return the virtual halt address or -1 on error.
+//
+//----------------------------------------------------------------------------------------
+T64Word setupSystem( const GuestWorkload  *wl,
+                     T64System            *sys,
+                     T64Processor         **procs,
+                     T64Memory            **mem ) {
+
+    *mem = new T64Memory( sys, 0, T64_MK_NIL, T64_MT_RAM, 0, GUEST_MEM_SIZE );
+    if ( sys -> addToModuleMap( *mem ) != 0 ) return( -1 );
+
+    for ( int i = 0; i < wl -> procs; i++ ) {
+
+        procs[ i ] = new T64Processor( sys,
+                                       i + 1,
+                                       T64_PO_NIL,
+                                       T64_CPU_T_NIL,
+                                       T64_TT_FA_64S,
+                                       T64_TT_FA_64S,
+                                       T64_CT_2W_128S_4L,
+                                       T64_CT_8W_128S_4L,
+                                       0,
+                                       0 );
+
+        if ( sys -> addToModuleMap( procs[ i ] ) != 0 ) return( -1 );
+        if ( ! mapGuestMemory( procs[ i ] )) return( -1 );
+    }
+
+    T64Word haltAdr = loadProgram( sys, wl -> code );
+    if ( haltAdr < 0 ) return( -1 );
+
+    if (( wl -> setup != nullptr ) && ( ! wl -> setup( sys ))) return( -1 );
+
+    for ( int i = 0; i < wl -> procs; i++ ) {
+
+        T64Cpu *cpu = procs[ i ] -> getCpuPtr( );
+
+        for ( const GuestRegInit *r = wl -> regs; r -> reg >= 0; r++ ) {
+
+            cpu -> setGeneralReg( r -> reg, r -> val );
+        }
+
+        cpu -> setPsrReg(( 1ULL << 61 ) | ( GUEST_VIRT_BASE + GUEST_CODE_ADR ));
+    }
+
+    return( GUEST_VIRT_BASE + haltAdr );
+}
+
+void deleteModules( T64Processor **procs, T64Memory *mem ) {
+
+    for ( int i = 0; i < GUEST_MAX_PROCS; i++ ) delete procs[ i ];
+    delete mem;
+}
+
+//----------------------------------------------------------------------------------------
+// Run a workload. After the system setup, we step the system in chunks until all
+// processors reached the halt address. Only the stepping is timed. Each system step
+// executes one instruction on each processor. A processor that reached the halt
+// address spins there until the others are done, so we only count the steps up to
+// the chunk in which a processor halted.
+//
+//----------------------------------------------------------------------------------------
+void runWorkload( const GuestWorkload *wl, GuestResult *res ) {
+
+    T64System       sys;
+    T64Processor    *procs[ GUEST_MAX_PROCS ] = { nullptr };
+    T64Memory       *mem    = nullptr;
+    T64Word         steps   = 0;
+    T64Word         haltSteps[ GUEST_MAX_PROCS ] = { 0 };
+
+    res -> name = wl -> name;
+
+    T64Word haltAdr = setupSystem( wl, &sys, procs, &mem );
+    if ( haltAdr < 0 ) {
+
+        deleteModules( procs, mem );
+        res -> failed = true;
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now( );
+
+    while ( true ) {
+
+        bool allHalted = true;
+
+        for ( int i = 0; i < wl -> procs; i++ ) {
+
+            if ( haltSteps[ i ] > 0 ) continue;
+
+            T64Word ia = extractField64( procs[ i ] -> getCpuPtr( ) -> getPsrReg( ), 0, 52 );
+            if ( ia == haltAdr ) haltSteps[ i ] = steps;
+            else                 allHalted      = false;
+        }
+
+        if ( allHalted ) break;
+
+        if ( steps >= GUEST_MAX_STEPS ) {
+
+            res -> timedOut = true;
+            break;
+        }
+
+        sys.step( GUEST_STEP_CHUNK );
+        steps += GUEST_STEP_CHUNK;
+    }
+
+    auto stop = std::chrono::steady_clock::now( );
+
+    for ( int i = 0; i < wl -> procs; i++ ) {
+
+        res -> instructions += ( haltSteps[ i ] > 0 ) ? haltSteps[ i ] : steps;
+    }
+
+    res -> wallTimeSec  = std::chrono::duration<double>( stop - start ).count( );
+    res -> mips         = ( res -> wallTimeSec > 0.0 ) ?
+                            ( res -> instructions / res -> wallTimeSec / 1.0e6 ) : 0.0;
+
+    for ( int i = 0; i < wl -> procs; i++ ) {
+
+        res -> iCacheHits   += procs[ i ] -> getICachePtr( ) -> getHitCount( );
+        res -> iCacheMisses += procs[ i ] -> getICachePtr( ) -> getMissCount( );
+        res -> dCacheHits   += procs[ i ] -> getDCachePtr( ) -> getHitCount( );
+        res -> dCacheMisses += procs[ i ] -> getDCachePtr( ) -> getMissCount( );
+        res -> iTlbLookups  += procs[ i ] -> getITlbPtr( ) -> getRequestCount( );
+        res -> iTlbMisses   += procs[ i ] -> getITlbPtr( ) -> getMissCount( );
+        res -> dTlbLookups  += procs[ i ] -> getDTlbPtr( ) -> getRequestCount( );
+        res -> dTlbMisses   += procs[ i ] -> getDTlbPtr( ) -> getMissCount( );
+        res -> stcSuccess   += procs[ i ] -> getCpuPtr( ) -> getStcSuccessCount( );
+        res -> stcFail      += procs[ i ] -> getCpuPtr( ) -> getStcFailCount( );
+    }
+
+    deleteModules( procs, mem );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Baseline file
+//
+//----------------------------------------------------------------------------------------
+// The baseline file is a text file with one line per workload, containing the
+// workload name and the MIPS number.
+//
+//----------------------------------------------------------------------------------------
+bool writeBaseline( const char *fileName, std::vector<GuestResult> &results ) {
+
+    FILE *f = fopen( fileName, "w" );
+    if ( f == nullptr ) return( false );
+
+    for ( GuestResult &r : results ) {
+
+        if (( ! r.failed ) && ( ! r.timedOut )) fprintf( f, "%s %.3f\n", r.name, r.mips );
+    }
+
+    fclose( f );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Compare the results against the baseline file. A workload not found in the file
+// is not compared. We return the number of regressions or -1 if the file cannot be
+// opened.
+//
+//----------------------------------------------------------------------------------------
+int compareBaseline( const char *fileName, std::vector<GuestResult> &results ) {
+
+    char    name[ 64 ];
+    double  mips;
+    int     regressions = 0;
+
+    FILE *f = fopen( fileName, "r" );
+    if ( f == nullptr ) return( -1 );
+
+    while ( fscanf( f, "%63s %lf", name, &mips ) == 2 ) {
+
+        for ( GuestResult &r : results ) {
+
+            if ( strcmp( r.name, name ) != 0 ) continue;
+
+            r.baseMips = mips;
+
+            if (( r.failed ) || ( r.timedOut ) ||
+                ( r.mips < mips * ( 1.0 - threshold / 100.0 ))) {
+
+                r.regression = true;
+                regressions ++;
+            }
+        }
+    }
+
+    fclose( f );
+    return( regressions );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Main program
+//
+//----------------------------------------------------------------------------------------
+// Program input parameters.
+//
+//----------------------------------------------------------------------------------------
+bool parseParameters( int argc, const char * argv[] ) {
+
+    for ( int i = 1; i < argc; i++ ) {
+
+        if (( strcmp( argv[ i ], "-f" ) == 0 ) && ( i + 1 < argc )) {
+
+            filterStr = argv[ ++i ];
+        }
+        else if (( strcmp( argv[ i ], "-w" ) == 0 ) && ( i + 1 < argc )) {
+
+            writeBaseFile = argv[ ++i ];
+        }
+        else if (( strcmp( argv[ i ], "-b" ) == 0 ) && ( i + 1 < argc )) {
+
+            readBaseFile = argv[ ++i ];
+        }
+        else if (( strcmp( argv[ i ], "-t" ) == 0 ) && ( i + 1 < argc )) {
+
+            threshold = atof( argv[ ++i ] );
+            if ( threshold <= 0.0 ) return( false );
+        }
+        else return( false );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Print the result table.
+//
+//----------------------------------------------------------------------------------------
+void printResults( std::vector<GuestResult> &results ) {
+
+    printf( "%-12s%6s%14s%10s%10s%12s%12s%12s%12s%12s%12s%12s%12s%12s%12s\n",
+            "Workload", "Procs", "Instr", "Time s", "MIPS",
+            "I$ Hits", "I$ Miss", "D$ Hits", "D$ Miss",
+            "ITLB Req", "ITLB Miss", "DTLB Req", "DTLB Miss", "STC Ok", "STC Fail" );
+
+    for ( GuestResult &r : results ) {
+
+        const GuestWorkload *wl = nullptr;
+
+        for ( int i = 0; i < WORKLOAD_TAB_SIZE; i++ ) {
+
+            if ( strcmp( workloadTab[ i ].name, r.name ) == 0 ) wl = &workloadTab[ i ];
+        }
+
+        if ( r.failed ) {
+
+            printf( "%-12s FAILED\n", r.name );
+            continue;
+        }
+
+        printf( "%-12s%6d%14lld%10.3f%10.2f%12lld%12lld%12lld%12lld%12lld%12lld%12lld%12lld"
+                "%12lld%12lld",
+                r.name, wl -> procs,
+                (long long) r.instructions, r.wallTimeSec, r.mips,
+                (long long) r.iCacheHits, (long long) r.iCacheMisses,
+                (long long) r.dCacheHits, (long long) r.dCacheMisses,
+                (long long) r.iTlbLookups, (long long) r.iTlbMisses,
+                (long long) r.dTlbLookups, (long long) r.dTlbMisses,
+                (long long) r.stcSuccess, (long long) r.stcFail );
+
+        if ( r.timedOut ) printf( "  TIMEOUT" );
+
+        if ( r.baseMips > 0.0 ) {
+
+            printf( "  base %.2f (%+.1f%%)%s",
+                    r.baseMips, 100.0 * ( r.mips - r.baseMips ) / r.baseMips,
+                    ( r.regression ) ? " REGRESSION" : "" );
+        }
+
+        printf( "\n" );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Here we go. Run all selected workloads, print the results and deal with the
+// baseline file options.
+//
+//----------------------------------------------------------------------------------------
+int main( int argc, const char * argv[] ) {
+
+    if ( ! parseParameters( argc, argv )) {
+
+        printf( "Usage: Twin64-GuestBench [ -f <filter> ] [ -w <baseFile> ] "
+                "[ -b <baseFile> ] [ -t <pct> ]\n" );
+        return( 1 );
+    }
+
+    std::vector<GuestResult> results;
+    int                      exitCode = 0;
+
+    for ( int i = 0; i < WORKLOAD_TAB_SIZE; i++ ) {
+
+        if (( filterStr != nullptr ) &&
+            ( strstr( workloadTab[ i ].name, filterStr ) == nullptr )) continue;
+
+        GuestResult res;
+        runWorkload( &workloadTab[ i ], &res );
+        results.push_back( res );
+
+        if (( res.failed ) || ( res.timedOut )) exitCode = 1;
+    }
+
+    if ( readBaseFile != nullptr ) {
+
+        int regressions = compareBaseline( readBaseFile, results );
+
+        if ( regressions < 0 ) {
+
+            printf( "Cannot open baseline file: \"%s\"\n", readBaseFile );
+            return( 1 );
+        }
+
+        if ( regressions > 0 ) exitCode = 1;
+    }
+
+    printResults( results );
+
+    if (( writeBaseFile != nullptr ) && ( ! writeBaseline( writeBaseFile, results ))) {
+
+        printf( "Cannot write baseline file: \"%s\"\n", writeBaseFile );
+        return( 1 );
+    }
+
+    return( exitCode );
+}
@@ -24,13 +24,13 @@
 #pragma once
 
 //----------------------------------------------------------------------------------------
-// Mac and Windows know different include files and procedure names for some POSIX 
-// routines. Learned the hard way that these files better come really early in the
-// project. All libraries and modules depend on these basic type definitions and 
-// include the "T64-Common.h" file early on.
+// Mac, Linux and Windows know different include files and procedure names for some 
+// POSIX routines. Learned the hard way that these files better come really early in
+// the project. All libraries and modules depend on these basic type definitions and 
+// include the "T64-Common.h" file early on. Mac and Linux share the POSIX branch.
 //
 //----------------------------------------------------------------------------------------
-#if __APPLE__
+#if __APPLE__ || __linux__
 #include <unistd.h>
 #include <termios.h>
 #include <ctype.h>
@@ -39,11 +39,15 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <errno.h>
 #include <stdarg.h>
 #include <iostream>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <poll.h>
 #else
 #define NOMINMAX
 #include <windows.h>
@@ -55,10 +59,13 @@
 #include <string.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
 #include <errno.h>
 #include <stdarg.h>
 #include <iostream>
 #include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #endif
 
 //----------------------------------------------------------------------------------------
@@ -97,6 +104,8 @@ const   T64Word T64_MAX_PHYS_MEM_LIMIT      = 0xFFFFFFFFF;
 const   T64Word T64_MAX_REGION_ID           = 0xFFFFF;
 const   T64Word T64_MAX_VIRT_MEM_LIMIT      = 0xFFFFFFFFFFFFF;
 
+const   int     T64_TRAP_VECTOR_SIZE        = 32;
+
 const   int     T64_PAGE_SIZE_BYTES         = 4096;
 const   int     T64_PAGE_OFS_BITS           = 12;
 const   int     T64_VADR_BITS               = 52;
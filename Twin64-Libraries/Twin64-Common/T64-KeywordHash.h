@@ -0,0 +1,206 @@
+//----------------------------------------------------------------------------------------
+//
+//  Twin64Sim - A 64-bit CPU Simulator - Keyword perfect hash tables
+//
+//----------------------------------------------------------------------------------------
+// The command interpreter and the one line assembler look up every identifier in
+// their reserved word table. This file provides a perfect hash table for such a
+// table, built by the compiler from the table itself. Every name maps to exactly one
+// slot, so a lookup is two hash computations and one name compare.
+//
+// The table is built with the "hash and displace" scheme. All names are first hashed
+// into a small number of buckets. Starting with the largest bucket, we search for
+// each bucket a seed value, such that the second hash with this seed places all names
+// of the bucket into free slots. The lookup hashes the name to find the bucket and
+// its seed and then hashes again with the seed to find the slot. The slot contains
+// the index of the reserved word table entry.
+//
+// The hash is case insensitive. The reserved word names are expected in upper case,
+// an input name may be in any case. A table with duplicate names keeps the first
+// entry, just like a linear search would. A keyword table type is any structure with
+// a "name" field. The table is built in a "constexpr" declaration:
+//
+//  constexpr auto tokHash = T64KeywordHash<MAX_TOKENS>( tokTab );
+//
+//  int index = tokHash.lookup( tokTab, name );
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin64Sim - A 64-bit CPU Simulator - Keyword perfect hash tables
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You
+// should have received a copy of the GNU General Public License along with this
+// program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#pragma once
+#include "T64-Common.h"
+
+//----------------------------------------------------------------------------------------
+// Upshift a character. We cannot use "toupper" in a "constexpr" function.
+//
+//----------------------------------------------------------------------------------------
+constexpr char upshiftKeywordChar( char ch ) {
+
+    return((( ch >= 'a' ) && ( ch <= 'z' )) ? (char) ( ch - 'a' + 'A' ) : ch );
+}
+
+//----------------------------------------------------------------------------------------
+// The keyword hash function. It is a FNV-1a hash over the upshifted name, started
+// with the seed value. A final mixing step spreads the bits for the power of two
+// table sizes.
+//
+//----------------------------------------------------------------------------------------
+constexpr uint32_t hashKeyword( const char *str, uint32_t seed ) {
+
+    uint32_t hash = 2166136261u ^ ( seed * 0x9E3779B9u );
+
+    while ( *str != 0 ) {
+
+        hash ^= (uint8_t) upshiftKeywordChar( *str++ );
+        hash *= 16777619u;
+    }
+
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    return( hash );
+}
+
+//----------------------------------------------------------------------------------------
+// Compare a reserved word name with an input name, ignoring the case of the input.
+//
+//----------------------------------------------------------------------------------------
+constexpr bool isSameKeyword( const char *keyword, const char *str ) {
+
+    while (( *keyword != 0 ) && ( *keyword == upshiftKeywordChar( *str ))) {
+
+        keyword++;
+        str++;
+    }
+
+    return( *keyword == upshiftKeywordChar( *str ));
+}
+
+//----------------------------------------------------------------------------------------
+// The keyword perfect hash table. The number of slots is at least twice the number
+// of entries, rounded up to a power of two. There are four slots for each bucket.
+// Finding the seeds is rather quick with this ratio. If there is no seed for a
+// bucket, the constructor throws, which in a "constexpr" declaration is reported
+// as a compile error.
+//
+//----------------------------------------------------------------------------------------
+template < int N >
+struct T64KeywordHash {
+
+    static constexpr int SLOTS = [ ] ( ) {
+
+        int size = 4;
+        while ( size < 2 * N ) size <<= 1;
+        return( size );
+    } ( );
+
+    static constexpr int        BUCKETS     = SLOTS / 4;
+    static constexpr uint32_t   MAX_SEED    = 65535;
+
+    uint16_t    seeds[ BUCKETS ]    = { };
+    int16_t     slots[ SLOTS ]      = { };
+
+    template < typename T >
+    constexpr T64KeywordHash( const T ( &tab )[ N ] ) {
+
+        int     bucket[ N ]         = { };
+        int     bucketSize[ BUCKETS ] = { };
+        int     placed[ N ]         = { };
+        int     maxBucketSize       = 0;
+
+        for ( int i = 0; i < SLOTS; i++ ) slots[ i ] = -1;
+
+        for ( int i = 0; i < N; i++ ) {
+
+            bucket[ i ] = (int) ( hashKeyword( tab[ i ].name, 0 ) & ( BUCKETS - 1 ));
+
+            for ( int j = 0; j < i; j++ ) {
+
+                if ( isSameKeyword( tab[ j ].name, tab[ i ].name )) {
+
+                    bucket[ i ] = -1;
+                    break;
+                }
+            }
+
+            if ( bucket[ i ] >= 0 ) bucketSize[ bucket[ i ]] ++;
+        }
+
+        for ( int b = 0; b < BUCKETS; b++ ) {
+
+            if ( bucketSize[ b ] > maxBucketSize ) maxBucketSize = bucketSize[ b ];
+        }
+
+        for ( int size = maxBucketSize; size > 0; size-- ) {
+
+            for ( int b = 0; b < BUCKETS; b++ ) {
+
+                if ( bucketSize[ b ] != size ) continue;
+
+                uint32_t seed = 1;
+
+                for ( ; seed <= MAX_SEED; seed++ ) {
+
+                    int  numPlaced  = 0;
+                    bool fits       = true;
+
+                    for ( int i = 0; ( i < N ) && ( fits ); i++ ) {
+
+                        if ( bucket[ i ] != b ) continue;
+
+                        int slot = (int) ( hashKeyword( tab[ i ].name, seed ) & ( SLOTS - 1 ));
+
+                        if ( slots[ slot ] != -1 ) fits = false;
+
+                        for ( int k = 0; ( k < numPlaced ) && ( fits ); k++ ) {
+
+                            if ( placed[ k ] == slot ) fits = false;
+                        }
+
+                        placed[ numPlaced++ ] = slot;
+                    }
+
+                    if ( fits ) break;
+                }
+
+                if ( seed > MAX_SEED ) throw( "No keyword hash seed found" );
+
+                seeds[ b ] = (uint16_t) seed;
+
+                for ( int i = 0; i < N; i++ ) {
+
+                    if ( bucket[ i ] != b ) continue;
+
+                    slots[ hashKeyword( tab[ i ].name, seed ) & ( SLOTS - 1 )] = (int16_t) i;
+                }
+            }
+        }
+    }
+
+    //------------------------------------------------------------------------------------
+    // Look up a name. We return the reserved word table index or -1 if not found.
+    //
+    //------------------------------------------------------------------------------------
+    template < typename T >
+    constexpr int lookup( const T *tab, const char *str ) const {
+
+        uint32_t seed   = seeds[ hashKeyword( str, 0 ) & ( BUCKETS - 1 )];
+        int      index  = slots[ hashKeyword( str, seed ) & ( SLOTS - 1 )];
+
+        if (( index >= 0 ) && ( isSameKeyword( tab[ index ].name, str ))) return( index );
+        else return( -1 );
+    }
+};
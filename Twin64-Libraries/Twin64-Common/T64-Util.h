@@ -27,13 +27,11 @@
 
 //----------------------------------------------------------------------------------------
 // Byte order conversion functions. They are different on Mac and Windows and LINUX,
-// GCC and CLANG.
+// GCC and CLANG. GCC and CLANG on Mac and Linux use the compiler builtin functions,
+// which compile to a single byte swap instruction.
 //
 //----------------------------------------------------------------------------------------
-#if defined(__APPLE__)
-  #include <libkern/OSByteOrder.h>
-  #define HOST_IS_BIG_ENDIAN  (__BIG_ENDIAN__)
-#elif defined(_WIN32)
+#if defined(_WIN32)
   #define HOST_IS_BIG_ENDIAN  0
 #elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
   #define HOST_IS_BIG_ENDIAN  1
@@ -46,20 +44,15 @@
     inline uint32_t toBigEndian32(uint32_t val) { return val; }
     inline uint64_t toBigEndian64(uint64_t val) { return val; }
 #else
-  #if defined(__APPLE__)
-    #include <libkern/OSByteOrder.h>
-    inline uint16_t toBigEndian16(uint16_t val) { return OSSwapHostToBigInt16(val); }
-    inline uint32_t toBigEndian32(uint32_t val) { return OSSwapHostToBigInt32(val); }
-    inline uint64_t toBigEndian64(uint64_t val) { return OSSwapHostToBigInt64(val); }
-  #elif defined(_MSC_VER)
+  #if defined(__GNUC__) || defined(__clang__)
+    inline uint16_t toBigEndian16(uint16_t val) { return __builtin_bswap16(val); }
+    inline uint32_t toBigEndian32(uint32_t val) { return __builtin_bswap32(val); }
+    inline uint64_t toBigEndian64(uint64_t val) { return __builtin_bswap64(val); }
+  #else
     #include <intrin.h>
     inline uint16_t toBigEndian16(uint16_t val) { return _byteswap_ushort(val); }
     inline uint32_t toBigEndian32(uint32_t val) { return _byteswap_ulong(val); }
     inline uint64_t toBigEndian64(uint64_t val) { return _byteswap_uint64(val); }
-  #else
-    inline uint16_t toBigEndian16(uint16_t val) { return __builtin_bswap16(val); }
-    inline uint32_t toBigEndian32(uint32_t val) { return __builtin_bswap32(val); }
-    inline uint64_t toBigEndian64(uint64_t val) { return __builtin_bswap64(val); }
   #endif
 #endif
 
@@ -195,9 +188,9 @@ inline int extractInstrFieldU( T64Instr arg, int bitpos, int len ) {
 
 inline int extractInstrFieldS( T64Instr arg, int bitpos, int len ) {
     
-    T64Word field = ( arg >> bitpos ) & (( 1ULL << len ) - 1 );
+    uint32_t field = ( arg >> bitpos ) & (( 1ULL << len ) - 1 );
     
-    if ( len < 32 )  return ( field << ( 32 - len )) >> ( 32 - len );
+    if ( len < 32 )  return ((int32_t)( field << ( 32 - len ))) >> ( 32 - len );
     else             return ( field );
 }
 
@@ -437,6 +430,16 @@ inline bool extractPsrXbit( T64Word psr ) {
     return( extractBit64( psr, 61 ));
 }
 
+inline bool extractPsrIbit( T64Word psr ) {
+
+    return( extractBit64( psr, 60 ));
+}
+
+inline bool extractPsrRbit( T64Word psr ) {
+
+    return( extractBit64( psr, 59 ));
+}
+
 // ??? more to come, align with document...
 
 //----------------------------------------------------------------------------------------
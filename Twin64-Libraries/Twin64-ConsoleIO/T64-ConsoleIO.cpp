@@ -10,7 +10,8 @@
 //
 // Unfortunately, PCs and Macs differ. The standard system calls typically buffer the
 // input up to the carriage return. To avoid this, the terminal needs to be place in
-// "raw" mode. And this is different for the two platforms.
+// "raw" mode. And this is different for the two platforms. Mac and Linux share the
+// POSIX terminal code.
 //
 //----------------------------------------------------------------------------------------
 //
@@ -43,16 +44,93 @@ namespace {
 // is deleted.
 //
 //----------------------------------------------------------------------------------------
-#if __APPLE__
+#if __APPLE__ || __linux__
 struct termios saveTermSetting;
 #endif
 
 //----------------------------------------------------------------------------------------
+// The output buffer for formatting the "writeChars" data.
 //
+//----------------------------------------------------------------------------------------
+char outputBuffer[ 1024 ];
+
+//----------------------------------------------------------------------------------------
+// The format descriptor bits that describe the display attributes of a screen cell. 
+// The shadow screen buffer only keeps these bits.
 //
+//----------------------------------------------------------------------------------------
+const uint32_t SCREEN_ATTR_MASK = 0xFF | FMT_BOLD | FMT_BLINK | FMT_INVERSE | 
+                                  FMT_UNDER_LINE | FMT_HALF_BRIGHT;
+
+//----------------------------------------------------------------------------------------
+// The output buffer is sent to the terminal at the latest when it reaches this size.
 //
 //----------------------------------------------------------------------------------------
-char outputBuffer[ 1024 ];
+const int OUT_BUF_FLUSH_SIZE = 64 * 1024;
+
+//----------------------------------------------------------------------------------------
+// Number formatting helpers. The window fields print a lot of numbers and we do not 
+// want to go through "printf" for each of them. The routines store the digits in the
+// buffer and return the number of characters. "fmtHex" stores the lower "digits" hex
+// digits, "fmtHexGroups" prints groups of four hex digits separated by an underscore, 
+// where the first group has "firstDigits" digits.
+//
+//----------------------------------------------------------------------------------------
+const char hexDigits[ ] = "0123456789abcdef";
+
+int fmtHex( char *buf, uint64_t val, int digits ) {
+
+    for ( int i = digits - 1; i >= 0; i-- ) {
+
+        buf[ i ] = hexDigits[ val & 0xF ];
+        val >>= 4;
+    }
+
+    return( digits );
+}
+
+int fmtHexMin( char *buf, uint64_t val ) {
+
+    int digits = 1;
+
+    while (( digits < 16 ) && (( val >> ( 4 * digits )) != 0 )) digits++;
+    return( fmtHex( buf, val, digits ));
+}
+
+int fmtHexGroups( char *buf, uint64_t val, int firstDigits, int groups ) {
+
+    int len = fmtHex( buf, val >> ( 16 * ( groups - 1 )), firstDigits );
+
+    for ( int i = groups - 2; i >= 0; i-- ) {
+
+        buf[ len++ ] = '_';
+        len += fmtHex( buf + len, val >> ( 16 * i ), 4 );
+    }
+
+    return( len );
+}
+
+int fmtDec( char *buf, int64_t val, int fieldLen = 0 ) {
+
+    char        tmp[ 24 ];
+    int         tmpLen  = 0;
+    int         len     = 0;
+    uint64_t    uVal    = ( val < 0 ) ? ( 0 - (uint64_t) val ) : (uint64_t) val;
+
+    do {
+
+        tmp[ tmpLen++ ] = (char) ( '0' + ( uVal % 10 ));
+        uVal /= 10;
+
+    } while ( uVal != 0 );
+
+    if ( val < 0 ) tmp[ tmpLen++ ] = '-';
+
+    while ( len < fieldLen - tmpLen ) buf[ len++ ] = ' ';
+    while ( tmpLen > 0 ) buf[ len++ ] = tmp[ --tmpLen ];
+
+    return( len );
+}
 
 //----------------------------------------------------------------------------------------
 // Sometimes we need to delay a little, and sure enough WIN and Mac have different 
@@ -76,7 +154,7 @@ char outputBuffer[ 1024 ];
 //----------------------------------------------------------------------------------------
 SimConsoleIO::SimConsoleIO( ) {
   
-#if __APPLE__
+#if __APPLE__ || __linux__
     tcgetattr( fileno( stdin ), &saveTermSetting );
 #endif
     
@@ -84,10 +162,15 @@ SimConsoleIO::SimConsoleIO( ) {
 
 SimConsoleIO::~SimConsoleIO( ) {
     
-#if __APPLE__
+#if __APPLE__ || __linux__
     tcsetattr( fileno( stdin ), TCSANOW, &saveTermSetting );
 #endif
-    
+
+    flushOutput( );
+
+    delete [ ] frontBuf;
+    delete [ ] backBuf;
+    free( outBuf );
 }
 
 //----------------------------------------------------------------------------------------
@@ -110,7 +193,7 @@ SimConsoleIO::~SimConsoleIO( ) {
 //----------------------------------------------------------------------------------------
 void SimConsoleIO::initConsoleIO( ) {
 
-#if __APPLE__
+#if __APPLE__ || __linux__
     struct termios term;
     tcgetattr( fileno( stdin ), &term );
     term.c_lflag &= ~ ( ICANON | ECHO );
@@ -130,7 +213,7 @@ void SimConsoleIO::initConsoleIO( ) {
 //----------------------------------------------------------------------------------------
 bool  SimConsoleIO::isConsole( ) {
     
-    #if __APPLE__
+    #if __APPLE__ || __linux__
     return( isatty( fileno( stdin )));
     #else
     return( _isatty( _fileno( stdin )));
@@ -144,7 +227,7 @@ bool  SimConsoleIO::isConsole( ) {
 //----------------------------------------------------------------------------------------
 int  SimConsoleIO::getConsoleSize( int *rows, int *cols ) {
     
-    #if __APPLE__
+    #if __APPLE__ || __linux__
 
     struct winsize w;
     if ( ioctl( STDOUT_FILENO, TIOCGWINSZ, &w ) == -1 ) {
@@ -183,37 +266,21 @@ int  SimConsoleIO::getConsoleSize( int *rows, int *cols ) {
 // "setBlockingMode" will put the terminal into blocking or non-blocking mode. For
 // the command interpreter we will use the blocking mode, i.e. we wait for character
 // input. When the CPU runs, the console IO must be in non-blocking, and we check 
-// for input on each CPU "tick".
+// for input on each CPU "tick". On Mac/Linux we do not set the O_NONBLOCK flag on
+// the terminal. The flag belongs to the open file, which standard input shares with
+// standard output on a terminal, and a full terminal would then fail our writes. 
+// Instead, "readChar" polls for input in non-blocking mode.
 //
 //----------------------------------------------------------------------------------------
 void SimConsoleIO::setBlockingMode( bool enabled ) {
     
-#if __APPLE__
-    
-    int flags = fcntl( STDIN_FILENO, F_GETFL, 0 );
-    if ( flags == -1 ) {
-        
-        // ??? error ....
-    }
-    else {
-        
-        if ( enabled )  flags &= ~O_NONBLOCK;
-        else            flags |= O_NONBLOCK;
-        
-        if ( fcntl( STDIN_FILENO, F_SETFL, flags ) == -1 ) {
-               
-            // ??? error ....
-        }
-    }
-#endif
-    
     blockingMode = enabled;
 }
 
 //----------------------------------------------------------------------------------------
 // "readConsoleChar" is the single entry point to get a character from the terminal
-// input. On Mac/Linux, this is the "read" system call. Whether the mode is blocking
-// or non-blocking is set in the terminal settings. The read function is the same. 
+// input. On Mac/Linux, this is the "read" system call. In non-blocking mode, we first
+// "poll" the terminal input without waiting and only read when there is a character.
 // If there is no character available, a zero is returned, otherwise the character.
 //
 // On Windows there is a similar call, which does just return one character at a 
@@ -223,11 +290,22 @@ void SimConsoleIO::setBlockingMode( bool enabled ) {
 // either the character typed or a zero.
 //
 // On Windows, we delay a little to avoid a busy loop.
+//
+// Before reading, any buffered output is sent to the terminal.
 // 
 //----------------------------------------------------------------------------------------
 int SimConsoleIO::readChar( ) {
+
+    flushOutput( );
     
-#if __APPLE__
+#if __APPLE__ || __linux__
+    if ( ! blockingMode ) {
+
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        if ( poll( &pfd, 1, 0 ) <= 0 ) return( 0 );
+        if (( pfd.revents & POLLIN ) == 0 ) return( 0 );
+    }
+
     char ch;
     if ( read( STDIN_FILENO, &ch, 1 ) == 1 ) return( ch );
     else return ( 0 );
@@ -251,14 +329,12 @@ int SimConsoleIO::readChar( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// "writeChars" is the single entry point to write to the terminal. On Mac/Linux, 
-// we still try to send out the data in batches to the terminal emulator for better
-// stability. In Windows this does not seems to be an issue, we send a single char
-// at a time.
-//
-// I still get from time time garbled screens, which disappear on a redraw. Perhaps
-// the single character write logic is too much for the terminal driver. So, let's
-// accumulate larger sequences and only use "writeChars" for printing.
+// "writeChars" is the single entry point to write formatted data to the terminal. 
+// Each escape sequence and each field is a "writeChars" call. Sending each of them
+// with a system call is slow, and I also got from time to time garbled screens with
+// the single character write logic. So, the data is accumulated in an output buffer
+// and sent in large batches. During a window frame, the data goes into the shadow 
+// screen buffer instead. "writeText" is the same without the formatting.
 //
 //----------------------------------------------------------------------------------------
 int SimConsoleIO::writeChars( const char *format, ... ) {
@@ -268,11 +344,63 @@ int SimConsoleIO::writeChars( const char *format, ... ) {
     int len = vsnprintf( outputBuffer, sizeof( outputBuffer ), format, args );
     va_end( args );
 
-     if (len <= 0) return 0;
+    if ( len <= 0 ) return 0;
+    if ( len >= (int) sizeof( outputBuffer )) len = sizeof( outputBuffer ) - 1;
+
+    return( writeText( outputBuffer, len ));
+}
+
+int SimConsoleIO::writeText( const char *buf, int len ) {
+
+    if ( outMode == OUT_FRAME ) putFrameChars( buf, len );
+    else                        appendOutput( buf, len );
+
+    return( len );
+}
+
+//----------------------------------------------------------------------------------------
+// Add data to the output buffer. The buffer grows as needed, but is sent once it
+// reached the flush size.
+//
+//----------------------------------------------------------------------------------------
+void SimConsoleIO::appendOutput( const char *buf, int len ) {
+
+    if ( outBufLen + len > outBufSize ) {
+
+        outBufSize = ( outBufLen + len ) * 2;
+        outBuf     = (char *) realloc( outBuf, outBufSize );
+    }
+
+    memcpy( outBuf + outBufLen, buf, len );
+    outBufLen += len;
+
+    if ( outBufLen >= OUT_BUF_FLUSH_SIZE ) flushOutput( );
+}
+
+//----------------------------------------------------------------------------------------
+// Send the output buffer to the terminal. This is done before waiting for input, at
+// the end of a window frame and on program exit.
+//
+//----------------------------------------------------------------------------------------
+void SimConsoleIO::flushOutput( ) {
+
+    if ( outBufLen > 0 ) {
+
+        writeRaw( outBuf, outBufLen );
+        outBufLen = 0;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// "writeRaw" sends a buffer of characters to the terminal. On Mac/Linux, this is the
+// "write" system call. In Windows, we send a single char at a time.
+//
+//----------------------------------------------------------------------------------------
+void SimConsoleIO::writeRaw( const char *buf, int len ) {
 
     #if __APPLE__ || __linux__
 
-    const char  *p          = outputBuffer;
+    const char  *p          = buf;
     size_t      remaining   = len;
 
     while ( remaining > 0   ) {
@@ -292,12 +420,267 @@ int SimConsoleIO::writeChars( const char *format, ... ) {
 
     for (int i = 0; i < len; i++) {
 
-        _putch((unsigned char)outputBuffer[i]);
+        _putch((unsigned char) buf[i]);
     }
 
     #endif
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Shadow screen buffer.
+//
+//----------------------------------------------------------------------------------------
+// Redrawing all windows after each command emits every field with fresh escape 
+// sequences, even when almost nothing changed. Over a remote connection this is slow.
+// The window display therefore renders a frame into a shadow screen buffer instead of
+// the terminal. The buffer is a grid of cells with character and attributes. There
+// are two grids. The front grid is what we believe is on the terminal screen, the 
+// back grid is the frame being drawn. At the end of a frame, only the cells that 
+// differ are emitted, with cursor positioning only where the cells are not adjacent
+// and attribute changes only where they differ. Blanks up to the end of a line are 
+// sent as an erase to end of line. The result is sent with one write from the output
+// buffer.
+//
+// Output outside a frame, such as the command line input, goes directly to the 
+// terminal. This output stays within the terminal scroll area, so the rows of the
+// scroll area are considered unknown at the start of each frame.
+//
+//----------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------
+// Set the frame size. When the size changes, the grids are allocated again and the 
+// terminal content is considered unknown.
+//
+//----------------------------------------------------------------------------------------
+void SimConsoleIO::setFrameSize( int rows, int cols ) {
+
+    if (( rows == scrRows ) && ( cols == scrCols ) && ( frontBuf != nullptr )) return;
+
+    delete [ ] frontBuf;
+    delete [ ] backBuf;
+
+    scrRows     = rows;
+    scrCols     = cols;
+    frontBuf    = new SimScreenCell[ rows * cols ];
+    backBuf     = new SimScreenCell[ rows * cols ];
+
+    for ( int i = 0; i < rows * cols; i++ ) frontBuf[ i ] = { ' ', false, 0 };
+}
+
+//----------------------------------------------------------------------------------------
+// Start a frame. The back grid starts as a copy of the front grid, so cells not drawn
+// in this frame remain as they are. The rows in the scroll area may have changed by 
+// the direct output since the last frame and are marked unknown.
+//
+//----------------------------------------------------------------------------------------
+void SimConsoleIO::beginFrame( int rows, int cols ) {
+
+    setFrameSize( rows, cols );
+
+    int first = 1;
+    int last  = scrRows;
+
+    if ( scrollStart > 0 ) {
+
+        first = scrollStart;
+        last  = ( scrollEnd < scrRows ) ? scrollEnd : scrRows;
+    }
+
+    for ( int i = ( first - 1 ) * scrCols; i < last * scrCols; i++ ) frontBuf[ i ].valid = false;
+
+    memcpy( backBuf, frontBuf, sizeof( SimScreenCell ) * scrRows * scrCols );
+
+    frameRow        = 1;
+    frameCol        = 1;
+    emitRow         = -1;
+    emitAttrValid   = false;
+    outMode         = OUT_FRAME;
+}
+
+//----------------------------------------------------------------------------------------
+// End a frame. We compare the back grid with the front grid and collect the output 
+// for all changed cells. Finally, the cursor and the attributes are set to where the
+// frame drawing left them, so that direct output continues as before. The output 
+// buffer is then sent in one go and the back grid becomes the front grid.
+//
+//----------------------------------------------------------------------------------------
+void SimConsoleIO::endFrame( ) {
+
+    outMode = OUT_DIRECT;
+
+    for ( int row = 1; row <= scrRows; row++ ) {
+
+        SimScreenCell   *bRow   = &backBuf[ ( row - 1 ) * scrCols ];
+        SimScreenCell   *fRow   = &frontBuf[ ( row - 1 ) * scrCols ];
+        int             blankCol = scrCols;
+
+        while (( blankCol > 0 ) && 
+               ( bRow[ blankCol - 1 ].valid ) && 
+               ( bRow[ blankCol - 1 ].ch == ' ' ) && 
+               ( bRow[ blankCol - 1 ].attr == bRow[ scrCols - 1 ].attr )) blankCol--;
+
+        for ( int col = 1; col <= scrCols; col++ ) {
+
+            SimScreenCell *b = &bRow[ col - 1 ];
+            SimScreenCell *f = &fRow[ col - 1 ];
+
+            if ( ! b -> valid ) continue;
+            if (( f -> valid ) && ( f -> ch == b -> ch ) && ( f -> attr == b -> attr )) continue;
+
+            if (( emitRow != row ) || ( emitCol != col )) SimFormatter::setAbsCursor( row, col );
+
+            if (( ! emitAttrValid ) || ( emitAttr != b -> attr )) {
+
+                SimFormatter::setFmtAttributes( b -> attr | FMT_DEF_ATTR );
+                emitAttr        = b -> attr;
+                emitAttrValid   = true;
+            }
+
+            if ( col > blankCol ) {
+
+                writeChars( "\x1b[K" );
+                emitRow = row;
+                emitCol = col;
+                break;
+            }
+
+            appendOutput( &b -> ch, 1 );
+
+            emitRow = ( col < scrCols ) ? row : -1;
+            emitCol = col + 1;
+        }
+    }
+
+    SimFormatter::setAbsCursor( frameRow, frameCol );
+    
+    if (( ! emitAttrValid ) || ( emitAttr != frameAttr )) 
+        SimFormatter::setFmtAttributes( frameAttr | FMT_DEF_ATTR );
+
+    SimScreenCell *tmp = frontBuf;
+    frontBuf = backBuf;
+    backBuf  = tmp;
+
+    flushOutput( );
+}
+
+//----------------------------------------------------------------------------------------
+// Put the characters into the back grid at the frame cursor position. Escape sequences
+// are skipped, they have no meaning in the grid. Characters outside the grid are
+// dropped.
+//
+//----------------------------------------------------------------------------------------
+void SimConsoleIO::putFrameChars( const char *buf, int len ) {
+
+    for ( int i = 0; i < len; i++ ) {
+
+        char ch = buf[ i ];
+
+        if ( ch == '\033' ) {
+
+            if (( i + 1 < len ) && ( buf[ i + 1 ] == '[' )) {
+
+                i += 2;
+                while (( i < len ) && (( buf[ i ] < 0x40 ) || ( buf[ i ] > 0x7E ))) i++;
+            }
+            else i++;
+        }
+        else if ( ch == '\n' ) {
+
+            frameRow ++;
+            frameCol = 1;
+        }
+        else if ( ch == '\r' ) {
+
+            frameCol = 1;
+        }
+        else if ( isprint((unsigned char) ch )) {
+
+            if (( frameRow >= 1 ) && ( frameRow <= scrRows ) && 
+                ( frameCol >= 1 ) && ( frameCol <= scrCols )) {
+                
+                backBuf[ ( frameRow - 1 ) * scrCols + frameCol - 1 ] = { ch, true, frameAttr };
+            }
+
+            frameCol ++;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The escape code functions used for drawing windows. During a frame they operate on
+// the back grid, otherwise they are sent to the terminal. Clearing the screen also 
+// means that we know the terminal content again. The scroll area is remembered for
+// the frame handling.
+//
+//----------------------------------------------------------------------------------------
+void SimConsoleIO::clearScreen( ) {
+
+    if ( outMode == OUT_FRAME ) {
+
+        for ( int i = 0; i < scrRows * scrCols; i++ ) backBuf[ i ] = { ' ', true, 0 };
+    }
+    else {
+
+        SimFormatter::setFmtAttributes( FMT_DEF_ATTR );
+        SimFormatter::clearScreen( );
+        
+        for ( int i = 0; i < scrRows * scrCols; i++ ) frontBuf[ i ] = { ' ', true, 0 };
+        emitRow = -1;
+    }
+}
+
+void SimConsoleIO::clearLine( ) {
+
+    if ( outMode == OUT_FRAME ) {
+
+        if (( frameRow >= 1 ) && ( frameRow <= scrRows )) {
+
+            for ( int i = 0; i < scrCols; i++ ) 
+                backBuf[ ( frameRow - 1 ) * scrCols + i ] = { ' ', true, frameAttr };
+        }
+    }
+    else SimFormatter::clearLine( );
+}
+
+void SimConsoleIO::setAbsCursor( int row, int col ) {
+
+    if ( outMode == OUT_FRAME ) {
+
+        frameRow = row;
+        frameCol = col;
+    }
+    else SimFormatter::setAbsCursor( row, col );
+}
+
+void SimConsoleIO::setCursorInLine( int col ) {
+
+    if ( outMode == OUT_FRAME ) frameCol = col;
+    else SimFormatter::setCursorInLine( col );
+}
+
+void SimConsoleIO::setScrollArea( int start, int end ) {
+
+    scrollStart = start;
+    scrollEnd   = end;
+    SimFormatter::setScrollArea( start, end );
+}
+
+void SimConsoleIO::clearScrollArea( ) {
+
+    scrollStart = 0;
+    scrollEnd   = 0;
+    SimFormatter::clearScrollArea( );
+}
 
-    return len;
+void SimConsoleIO::setFmtAttributes( uint32_t fmtDesc ) {
+
+    if ( outMode == OUT_FRAME ) {
+
+        if ( fmtDesc != 0 ) frameAttr = fmtDesc & SCREEN_ATTR_MASK;
+    }
+    else SimFormatter::setFmtAttributes( fmtDesc );
 }
 
 //****************************************************************************************
@@ -314,6 +697,16 @@ int SimConsoleIO::writeChars( const char *format, ... ) {
 // output methods is the formatter.
 //----------------------------------------------------------------------------------------
 
+//----------------------------------------------------------------------------------------
+// Write a buffer of characters without formatting. The default just goes through the
+// "writeChars" routine, derived classes may do better.
+//
+//----------------------------------------------------------------------------------------
+int SimFormatter::writeText( const char *buf, int len ) {
+
+    return( writeChars( "%.*s", len, buf ));
+}
+
 //----------------------------------------------------------------------------------------
 // Escape code functions.
 //
@@ -345,7 +738,7 @@ void SimFormatter::writeScrollDown( int n ) {
 
 void SimFormatter::writeCarriageReturn( ) {
 
-    #if __APPLE__
+    #if __APPLE__ || __linux__
         writeChars( "\n" );
     #else 
         writeChars( "\r\n" );
@@ -436,7 +829,11 @@ void SimFormatter::setFmtAttributes( uint32_t fmtDesc ) {
 //----------------------------------------------------------------------------------------
 int SimFormatter::printBlanks( int len ) {
 
-    for ( int i = 0; i < len; i++ ) writeChars((char *) " " );
+    static const char blanks[ ] = "                                ";
+    const int         chunk     = sizeof( blanks ) - 1;
+
+    for ( int i = 0; i < len; i += chunk ) writeText( blanks, ( len - i < chunk ) ? len - i : chunk );
+    
     return( len );
 }
 
@@ -447,9 +844,11 @@ int SimFormatter::printBlanks( int len ) {
 //----------------------------------------------------------------------------------------
 int SimFormatter::printText( char *text, int maxLen ) {
     
-    if ( strlen( text ) <= maxLen ) {
+    int len = (int) strlen( text );
+
+    if ( len <= maxLen ) {
         
-        return( writeChars((char *) "%s", text ));
+        return( writeText( text, len ));
     }
     else {
      
@@ -487,272 +886,83 @@ char SimFormatter::printBit( T64Word val, int pos, char printChar ) {
 // "printNumber" will print the number in the selected format. There quite a few HEX
 // format to ease the printing of large numbers as we have in 64-bit system. If the 
 // "invalid number" option is set in addition to the number format, the format is filled 
-// with asterisks instead of numbers.
+// with asterisks instead of numbers. The number is formatted into a local buffer with 
+// our own formatting routines and written in one call.
 //
 //----------------------------------------------------------------------------------------
 int SimFormatter::printNumber( T64Word val, uint32_t fmtDesc ) {
 
-    if ((( fmtDesc >> 8 ) & 0xF ) > 0 ) {
-
-        switch (( fmtDesc >> 8 ) & 0xF ) {
-
-            case 1: { // HEX as is
-
-                int len = 0;
-
-                if ( fmtDesc & FMT_PREFIX_0X ) 
-                        len += writeChars((char *) "0x" ); 
-
-                if ( fmtDesc & FMT_INVALID_NUM ) 
-                    len += writeChars((char *) "**" );          
-                else                             
-                    len += writeChars((char *) "%x", val );
-
-                return ( len );
-
-            } break;
-
-            case 2: { // HEX_2
-
-                int len = 0;
-
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                        len += writeChars((char *) "0x" );
-
-                if ( fmtDesc & FMT_INVALID_NUM )
-                    len += writeChars((char *) "**" );          
-                else 
-                    len += writeChars((char *) "%02x", val & 0xFF );
-                
-                return( len );
-
-            } break;
-
-            case 3: { // HEX_4
-
-                int len = 0;
-
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                    len += writeChars((char *) "0x" );
-
-                if ( fmtDesc & FMT_INVALID_NUM )
-                    len += writeChars((char *) "****" );          
-                else 
-                    len += writeChars((char *) "%04x", val & 0xFFFF );
-
-                return( len );
-
-            } break;
-
-            case 4: { // HEX_8
+    char    buf[ 32 ];
+    int     len     = 0;
+    int     hexFmt  = ( fmtDesc >> 8 ) & 0xF;
+    int     decFmt  = ( fmtDesc >> 12 ) & 0xF;
 
-                int len = 0;
+    if ( hexFmt > 0 ) {
 
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                    len += writeChars((char *) "0x" );
+        if ( fmtDesc & FMT_PREFIX_0X ) {
 
-                if ( fmtDesc & FMT_INVALID_NUM )
-                    len += writeChars((char *) "****" "****" );         
-                else 
-                    len += writeChars((char *) "%08x", val & 0xFFFFFFFF );
-                
-                return( len );
-
-            } break;
-
-            case 5: { // HEX_16
-
-                int len = 0;
-
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                    len += writeChars((char *) "0x" );
-
-                if ( fmtDesc & FMT_INVALID_NUM ) 
-                    len += writeChars((char *) "****" "****" "****" "****" );
-                else 
-                    len += writeChars((char *) "%016x", val );
-                
-                    return( len );
-
-            } break;
-
-            case 6: { // FMT_HEX_2_4
-
-                int len = 0;
-                
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                    len += writeChars((char *) "0x" );
-
-                if ( fmtDesc & FMT_INVALID_NUM ) 
-                    len += writeChars((char *) "**_****" );
-                else
-                    len += writeChars((char *) "%02x_%04x", 
-                                      (( val >> 16 ) & 0xFF   ),
-                                      (( val       ) & 0xFFFF ));
-                
-                return( len );
-
-            } break;
-
-            case 7: { // FMT_HEX_4_4
-
-                int len = 0;
-
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                    len += writeChars((char *) "0x" );
+            buf[ len++ ] = '0';
+            buf[ len++ ] = 'x';
+        }
 
-                if ( fmtDesc & FMT_INVALID_NUM ) 
-                    len += writeChars((char *) "****_****" );
-                else
-                    len += writeChars((char *) "%04x_%04x", 
-                                      (( val >> 16 ) & 0xFFFF ),
-                                      (( val       ) & 0xFFFF ));
-                return( len );
+        int numStart = len;
+
+        switch ( hexFmt ) {
+
+            case 1:     len += fmtHexMin( buf + len, val );         break; // HEX
+            case 2:     len += fmtHex( buf + len, val, 2 );         break; // HEX_2
+            case 3:     len += fmtHex( buf + len, val, 4 );         break; // HEX_4
+            case 4:     len += fmtHex( buf + len, val, 8 );         break; // HEX_8
+            case 5:     len += fmtHex( buf + len, val, 16 );        break; // HEX_16
+            case 6:     len += fmtHexGroups( buf + len, val, 2, 2 ); break; // HEX_2_4
+            case 7:     len += fmtHexGroups( buf + len, val, 4, 2 ); break; // HEX_4_4
+            case 8:     len += fmtHexGroups( buf + len, val, 2, 3 ); break; // HEX_2_4_4
+            case 9:     len += fmtHexGroups( buf + len, val, 4, 3 ); break; // HEX_4_4_4
+            case 10:    len += fmtHexGroups( buf + len, val, 2, 4 ); break; // HEX_2_4_4_4
+            case 11:    len += fmtHexGroups( buf + len, val, 4, 4 ); break; // HEX_4_4_4_4
+            default:    return ( writeText( "*num*", 5 ));
+        }
 
-            } break;
+        if ( fmtDesc & FMT_INVALID_NUM ) {
 
-            case 8: { // FMT_HEX_2_4_4
+            if ( hexFmt == 1 ) len = numStart + 2;
 
-                int len = 0;
+            for ( int i = numStart; i < len; i++ ) {
                 
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                    len += writeChars((char *) "0x" );
-
-                if ( fmtDesc & FMT_INVALID_NUM ) 
-                    len += writeChars((char *) "**_****_****" );
-                else 
-                    len += writeChars((char *) "%02x_%04x_%04x", 
-                                      (( val >> 32 ) & 0xFF   ),
-                                      (( val >> 16 ) & 0xFFFF ),
-                                      (( val       ) & 0xFFFF ));
-
-                return( len );
-
-            } break;
-
-            case 9: { // FMT_HEX_4_4_4
-
-                int len = 0;
-
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                    len += writeChars((char *) "0x" );
-
-                if ( fmtDesc & FMT_INVALID_NUM ) 
-                    len += writeChars((char *) "****_****_****" );
-                else 
-                    len += writeChars((char *) "%04x_%04x_%04x", 
-                                      (( val >> 32 ) & 0xFFFF ),
-                                      (( val >> 16 ) & 0xFFFF ),
-                                      (( val       ) & 0xFFFF ));
-
-                return( len );
-
-            } break;
-
-            case 10: { // FMT_HEX_2_4_4_4
-
-                int len = 0;
-
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                    len += writeChars((char *) "0x" );
-
-                if ( fmtDesc & FMT_INVALID_NUM ) 
-                    len += writeChars((char *) "**_****_****_****" );
-                else
-                    len += writeChars((char *) "%02X_%04x_%04x_%04x", 
-                                      (( val >> 48 ) & 0xFF   ),
-                                      (( val >> 32 ) & 0xFFFF ),
-                                      (( val >> 16 ) & 0xFFFF ),
-                                      (( val       ) & 0xFFFF ));
-
-                return( len );
-
-            } break;
-
-            case 11: { // FMT_HEX_4_4_4_4
-
-                int len = 0;
-
-                if ( fmtDesc & FMT_PREFIX_0X )   
-                    len += writeChars((char *) "0x" );
-
-                if ( fmtDesc & FMT_INVALID_NUM ) 
-                    len += writeChars((char *) "****_****_****_****" );
-                else
-                    len += writeChars((char *) "%04x_%04x_%04x_%04x", 
-                                      (( val >> 48 ) & 0xFFFF ),
-                                      (( val >> 32 ) & 0xFFFF ),
-                                      (( val >> 16 ) & 0xFFFF ),
-                                      (( val       ) & 0xFFFF ));
-                return( len );
-
-            } break;
-
-            default: return ( writeChars ((char *) "*num*" ));
+                if ( buf[ i ] != '_' ) buf[ i ] = '*';
+            }
         }
-    }
-    else  if ((( fmtDesc >> 12 ) & 0xF ) > 0 ) {
-
-         switch (( fmtDesc >> 12 ) & 0xF ) {
-
-            case 1: { // DEC as is
-
-                return ( writeChars((char *) "%d", val));
-
-            } break;
-
-            case 2: { // DEC_32
-
-                return ( writeChars((char *) "%10d", val ));
-
-            } break;
-
-            default: return ( writeChars ((char *) "*num*" ));
-         }
 
+        return( writeText( buf, len ));
     }
-    else if ( fmtDesc & FMT_ASCII_4 ) {
-
-        int           len = 0;
-        unsigned char bytes[ 4 ];
+    else if ( decFmt > 0 ) {
 
-        for ( int i = 0; i < 4; i++ )
-            bytes[ i ] = ( val >> ( 8 * ( 3 - i ))) & 0xFF;
+        switch ( decFmt ) {
 
-        len += writeChars( "\"");
-        for ( int i = 0; i < 4; i++ ) {
-            
-            unsigned char c = bytes[i];
-            
-            if ( isprint(c)) len += writeChars( "%c", c );
-            else             len += writeChars( "." );
+            case 1:     len = fmtDec( buf, val );                   break; // DEC
+            case 2:     len = fmtDec( buf, (int32_t) val, 10 );     break; // DEC_32
+            default:    return ( writeText( "*num*", 5 ));
         }
-        
-        len += writeChars( "\"" );
 
-        return( len );
+        return( writeText( buf, len ));
     }
-    else if ( fmtDesc & FMT_ASCII_8 ) {
+    else if ( fmtDesc & ( FMT_ASCII_4 | FMT_ASCII_8 )) {
 
-        int           len = 0;
-        unsigned char bytes[ 8 ];
+        int bytes = ( fmtDesc & FMT_ASCII_4 ) ? 4 : 8;
 
-        for ( int i = 0; i < 8; i++ )
-            bytes[ i ] = ( val >> (8 * ( 7 - i ))) & 0xFF;
+        buf[ len++ ] = '"';
 
-        len += writeChars( "\"" );
-        for ( int i = 0; i < 8; i++ ) {
+        for ( int i = bytes - 1; i >= 0; i-- ) {
             
-            unsigned char c = bytes[ i ];
-            
-            if (isprint(c)) len += writeChars( "%c", c );
-            else            len += writeChars( "." );
+            unsigned char c = ( val >> ( 8 * i )) & 0xFF;
+            buf[ len++ ] = ( isprint( c )) ? c : '.';
         }
-        len += writeChars( "\"" );
+        
+        buf[ len++ ] = '"';
 
-        return( len );
+        return( writeText( buf, len ));
     }
-    else return( writeChars( "*num*" ));
+    else return( writeText( "*num*", 5 ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -770,17 +980,8 @@ int SimFormatter::numberFmtLen( uint32_t fmtDesc, T64Word val ) {
 
             case 1: { // HEX
 
-                int len = prefixLen + 1;
-
-                val = abs( val );
-                
-                while ( val & 0xF ) {
-
-                    val >>= 4;
-                    len ++;
-                }
-                
-                return( len );
+                char buf[ 16 ];
+                return( prefixLen + fmtHexMin( buf, val ));
 
             } break;
 
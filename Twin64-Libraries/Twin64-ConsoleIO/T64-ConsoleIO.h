@@ -138,6 +138,7 @@ enum FmtDescOptions : uint32_t {
 struct SimFormatter {
 
     virtual int     writeChars( const char *format, ... ) = 0;
+    virtual int     writeText( const char *buf, int len );
     
     void            writeCarriageReturn( );
     void            eraseChar( );
@@ -147,15 +148,15 @@ struct SimFormatter {
     void            writeScrollDown( int n );
     void            writeCharAtLinePos( int ch, int pos );
   
-    void            clearScreen( );
-    void            clearLine( );
-    void            setAbsCursor( int row, int col );
-    void            setCursorInLine( int col ); 
+    virtual void    clearScreen( );
+    virtual void    clearLine( );
+    virtual void    setAbsCursor( int row, int col );
+    virtual void    setCursorInLine( int col ); 
     void            setWindowSize( int row, int col );
-    void            setScrollArea( int start, int end );
-    void            clearScrollArea( );
+    virtual void    setScrollArea( int start, int end );
+    virtual void    clearScrollArea( );
 
-    void            setFmtAttributes( uint32_t fmtDesc );
+    virtual void    setFmtAttributes( uint32_t fmtDesc );
     int             printBlanks( int len );
     int             printText( char *text, int len );
     int             printNumber( T64Word val, uint32_t fmtDesc );
@@ -164,6 +165,19 @@ struct SimFormatter {
 
 };
 
+//----------------------------------------------------------------------------------------
+// The screen cell for the shadow screen buffer. A cell contains the character and the
+// display attributes. A cell that is not valid has an unknown content on the terminal
+// screen.
+//
+//----------------------------------------------------------------------------------------
+struct SimScreenCell {
+
+    char        ch;
+    bool        valid;
+    uint32_t    attr;
+};
+
 //----------------------------------------------------------------------------------------
 // Console IO object. The simulator is a character based interface. The typical terminal
 // IO functionality such as buffered data input and output needs to be disabled. We run
@@ -172,6 +186,13 @@ struct SimFormatter {
 // CPU code, the console IO is mapped to a virtual console configured in the IO address
 // space. This interface will also write and read a character at a time.
 //
+// Terminal output is accumulated in an output buffer and sent when the simulator is 
+// about to wait for input, at the end of a window frame or when the buffer is full.
+//
+// The window display draws its windows as a frame into a shadow screen buffer. The 
+// escape code routines for cursor, line clearing and attributes operate on this buffer
+// while a frame is drawn. At the end of the frame only the changed cells are sent.
+//
 //----------------------------------------------------------------------------------------
 struct SimConsoleIO : SimFormatter {
     
@@ -186,10 +207,50 @@ struct SimConsoleIO : SimFormatter {
     int     getConsoleSize( int *rows, int *cols );
     int     readChar( );
     int     writeChars( const char *format, ... );
+    int     writeText( const char *buf, int len );
+    void    flushOutput( );
+
+    void    beginFrame( int rows, int cols );
+    void    endFrame( );
+
+    void    clearScreen( );
+    void    clearLine( );
+    void    setAbsCursor( int row, int col );
+    void    setCursorInLine( int col );
+    void    setScrollArea( int start, int end );
+    void    clearScrollArea( );
+    void    setFmtAttributes( uint32_t fmtDesc );
     
     private:
+
+    enum OutMode : int { OUT_DIRECT, OUT_FRAME };
+
+    void    writeRaw( const char *buf, int len );
+    void    appendOutput( const char *buf, int len );
+    void    putFrameChars( const char *buf, int len );
+    void    setFrameSize( int rows, int cols );
     
-    bool    blockingMode = false;
+    bool            blockingMode    = false;
+    OutMode         outMode         = OUT_DIRECT;
+
+    SimScreenCell   *frontBuf       = nullptr;
+    SimScreenCell   *backBuf        = nullptr;
+    int             scrRows         = 0;
+    int             scrCols         = 0;
+    int             scrollStart     = 0;
+    int             scrollEnd       = 0;
+
+    int             frameRow        = 1;
+    int             frameCol        = 1;
+    uint32_t        frameAttr       = 0;
+    int             emitRow         = -1;
+    int             emitCol         = -1;
+    uint32_t        emitAttr        = 0;
+    bool            emitAttrValid   = false;
+
+    char            *outBuf         = nullptr;
+    int             outBufLen       = 0;
+    int             outBufSize      = 0;
 };
 
 #endif // T64_ConsoleIO_h
@@ -0,0 +1,328 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - Block storage module
+//
+//----------------------------------------------------------------------------------------
+// The block storage module is a disk backed by a host image file. Data moves between
+// the image file and memory by DMA, a single command can transfer megabytes. The
+// command completes after a simulated latency, which depends on the number of blocks
+// transferred. Completion is signalled with an interrupt.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - Block storage module
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-IO.h"
+
+//----------------------------------------------------------------------------------------
+// Name space for local routines.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const int DISK_EVT_DONE = 1;
+
+//----------------------------------------------------------------------------------------
+// Positioned reads and writes of the image file. The routines return false unless
+// the full length was transferred.
+//
+//----------------------------------------------------------------------------------------
+bool readImage( int fd, uint8_t *buf, T64Word len, T64Word ofs ) {
+
+#if __APPLE__ || __linux__
+    return( pread( fd, buf, len, ofs ) == len );
+#else
+    if ( _lseeki64( fd, ofs, SEEK_SET ) != ofs ) return( false );
+    return( _read( fd, buf, (unsigned int) len ) == len );
+#endif
+}
+
+bool writeImage( int fd, uint8_t *buf, T64Word len, T64Word ofs ) {
+
+#if __APPLE__ || __linux__
+    return( pwrite( fd, buf, len, ofs ) == len );
+#else
+    if ( _lseeki64( fd, ofs, SEEK_SET ) != ofs ) return( false );
+    return( _write( fd, buf, (unsigned int) len ) == len );
+#endif
+}
+
+} // namespace
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Block storage module
+//
+//----------------------------------------------------------------------------------------
+// Object constructor and destructor. The transfer buffer is allocated once, larger
+// transfers are done in several pieces.
+//
+//----------------------------------------------------------------------------------------
+T64Disk::T64Disk( T64System  *sys,
+                  int        modNum,
+                  T64Word    spaAdr,
+                  T64Word    spaLen ) :
+
+                  T64IoModule( sys,
+                               modNum,
+                               T64_IO_DISK,
+                               spaAdr,
+                               spaLen ) {
+
+    xferBuf = (uint8_t *) malloc( T64_DISK_XFER_BUF_SIZE );
+    reset( );
+}
+
+T64Disk:: ~T64Disk( ) {
+
+    detachImage( );
+    if ( xferBuf != nullptr ) free( xferBuf );
+}
+
+//----------------------------------------------------------------------------------------
+// Reset the module. A transfer in progress is abandoned. The image file stays
+// attached.
+//
+//----------------------------------------------------------------------------------------
+void T64Disk::reset( ) {
+
+    sys -> cancelModuleEvents( this );
+    resetIntr( );
+
+    status      = 0;
+    blockNum    = 0;
+    blockCnt    = 0;
+    memAdr      = 0;
+    curCmd      = DISK_CMD_NOP;
+}
+
+//----------------------------------------------------------------------------------------
+// The disk is not a clocked module. All work is done when the command is issued and
+// when the completion event is due.
+//
+//----------------------------------------------------------------------------------------
+void T64Disk::step( ) { }
+
+//----------------------------------------------------------------------------------------
+// Save and restore the disk state for a record and replay snapshot. A command in 
+// progress is part of the system event queue. The image file is a host setting and
+// stays attached. The image content is not part of the state, a reverse step does not
+// undo a write to the image.
+//
+//----------------------------------------------------------------------------------------
+void T64Disk::saveState( T64StateBuf *buf ) {
+
+    T64IoModule::saveState( buf );
+
+    buf -> put( &status, sizeof( status ));
+    buf -> put( &blockNum, sizeof( blockNum ));
+    buf -> put( &blockCnt, sizeof( blockCnt ));
+    buf -> put( &memAdr, sizeof( memAdr ));
+    buf -> put( &curCmd, sizeof( curCmd ));
+}
+
+void T64Disk::restoreState( T64StateBuf *buf ) {
+
+    T64IoModule::restoreState( buf );
+
+    buf -> get( &status, sizeof( status ));
+    buf -> get( &blockNum, sizeof( blockNum ));
+    buf -> get( &blockCnt, sizeof( blockCnt ));
+    buf -> get( &memAdr, sizeof( memAdr ));
+    buf -> get( &curCmd, sizeof( curCmd ));
+}
+
+//----------------------------------------------------------------------------------------
+// Attach a host image file. The file is opened for reading and writing, when this
+// is not possible, the disk is read only. The disk size is the number of full blocks
+// in the file.
+//
+//----------------------------------------------------------------------------------------
+bool T64Disk::attachImage( const char *fileName ) {
+
+    detachImage( );
+
+    readOnly = false;
+    fd       = open( fileName, O_RDWR );
+
+    if ( fd < 0 ) {
+
+        readOnly = true;
+        fd       = open( fileName, O_RDONLY );
+        if ( fd < 0 ) return( false );
+    }
+
+    struct stat st;
+
+    if ( fstat( fd, &st ) != 0 ) {
+
+        detachImage( );
+        return( false );
+    }
+
+    diskSize = st.st_size / T64_DISK_BLOCK_SIZE;
+    return( true );
+}
+
+void T64Disk::detachImage( ) {
+
+    if ( fd >= 0 ) close( fd );
+
+    fd       = -1;
+    diskSize = 0;
+}
+
+T64Word T64Disk::getDiskSize( ) {
+
+    return( diskSize );
+}
+
+//----------------------------------------------------------------------------------------
+// Device register access. The transfer parameters can only be changed while the
+// disk is not busy. Writing the command register starts a command.
+//
+//----------------------------------------------------------------------------------------
+bool T64Disk::spaRegRead( int regNum, T64Word *val ) {
+
+    switch ( regNum ) {
+
+        case DISK_REG_STATUS:       *val = status;      break;
+        case DISK_REG_COMMAND:      *val = curCmd;      break;
+        case DISK_REG_BLOCK_NUM:    *val = blockNum;    break;
+        case DISK_REG_BLOCK_CNT:    *val = blockCnt;    break;
+        case DISK_REG_MEM_ADR:      *val = memAdr;      break;
+        case DISK_REG_DISK_SIZE:    *val = diskSize;    break;
+        default:                    *val = 0;
+    }
+
+    return( true );
+}
+
+bool T64Disk::spaRegWrite( int regNum, T64Word val ) {
+
+    if (( status & DISK_ST_BUSY ) && ( regNum != DISK_REG_COMMAND )) return( true );
+
+    switch ( regNum ) {
+
+        case DISK_REG_COMMAND:      startCommand((int) val );  break;
+        case DISK_REG_BLOCK_NUM:    blockNum    = val;          break;
+        case DISK_REG_BLOCK_CNT:    blockCnt    = val;          break;
+        case DISK_REG_MEM_ADR:      memAdr      = val;          break;
+        default: ;
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Start a command. The acknowledge command clears the done and error status. A read
+// or write command is only accepted when the disk is idle. The transfer itself takes
+// place when the completion event is due, the time to completion is a fixed command
+// overhead plus a time per block.
+//
+//----------------------------------------------------------------------------------------
+void T64Disk::startCommand( int cmd ) {
+
+    if ( cmd == DISK_CMD_ACK ) {
+
+        status &= ~ ( DISK_ST_DONE | DISK_ST_ERROR );
+        return;
+    }
+
+    if ((( cmd != DISK_CMD_READ ) && ( cmd != DISK_CMD_WRITE )) ||
+        ( status & DISK_ST_BUSY )) return;
+
+    T64Word delay = T64_DISK_CMD_CYCLES;
+    if ( blockCnt > 0 ) delay += blockCnt * T64_DISK_BLOCK_CYCLES;
+
+    curCmd = cmd;
+    status = DISK_ST_BUSY;
+
+    if ( sys -> scheduleEvent( this, delay, DISK_EVT_DONE ) < 0 ) {
+
+        status = DISK_ST_DONE | DISK_ST_ERROR;
+        sendIntr( );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The command completion event. We carry out the transfer, set the final status and
+// send the interrupt.
+//
+//----------------------------------------------------------------------------------------
+void T64Disk::handleEvent( int eventId ) {
+
+    if ( eventId != DISK_EVT_DONE ) return;
+
+    status = ( transferBlocks( )) ? DISK_ST_DONE : ( DISK_ST_DONE | DISK_ST_ERROR );
+    sendIntr( );
+}
+
+//----------------------------------------------------------------------------------------
+// Transfer the blocks between the image file and memory. The data moves in pieces
+// of the transfer buffer size, each piece is one DMA bus operation. The block range
+// must be on the disk and the memory range must be covered by a memory module. The
+// data read from the image is an input from the host. A recording logs each piece
+// read, a failed read is logged without data. A replay takes the pieces from the log
+// and does not write to the image.
+//
+//----------------------------------------------------------------------------------------
+bool T64Disk::transferBlocks( ) {
+
+    if (( fd < 0 ) || ( xferBuf == nullptr )) return( false );
+    if (( blockCnt <= 0 ) || ( blockNum < 0 ) || ( blockNum > diskSize - blockCnt )) return( false );
+    if (( curCmd == DISK_CMD_WRITE ) && ( readOnly )) return( false );
+
+    T64Word ofs = blockNum * T64_DISK_BLOCK_SIZE;
+    T64Word adr = memAdr;
+    T64Word len = blockCnt * T64_DISK_BLOCK_SIZE;
+
+    while ( len > 0 ) {
+
+        T64Word piece = ( len < T64_DISK_XFER_BUF_SIZE ) ? len : T64_DISK_XFER_BUF_SIZE;
+
+        if ( curCmd == DISK_CMD_READ ) {
+
+            if ( sys -> isReplaying( )) {
+
+                if ( ! sys -> replayData( moduleNum, T64_RPK_DISK_READ, xferBuf, (int) piece ))
+                    return( false );
+            }
+            else {
+
+                bool ok = readImage( fd, xferBuf, piece, ofs );
+
+                sys -> recordData( moduleNum, T64_RPK_DISK_READ, xferBuf, ok ? (int) piece : 0 );
+                if ( ! ok ) return( false );
+            }
+
+            if ( ! sys -> busOpDmaWrite( moduleNum, adr, xferBuf, piece )) return( false );
+        }
+        else {
+
+            if ( ! sys -> busOpDmaRead( moduleNum, adr, xferBuf, piece )) return( false );
+
+            if (( ! sys -> isReplaying( )) && ( ! writeImage( fd, xferBuf, piece, ofs )))
+                return( false );
+        }
+
+        ofs += piece;
+        adr += piece;
+        len -= piece;
+    }
+
+    return( true );
+}
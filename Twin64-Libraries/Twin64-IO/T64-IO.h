@@ -0,0 +1,429 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - I/O modules
+//
+//----------------------------------------------------------------------------------------
+// This module contains the I/O modules of the system. An I/O module has the HPA
+// registers common to all modules and a set of device registers in its SPA address
+// range. Guest programs access both with uncached loads and stores. An I/O module
+// signals the completion of work with an external interrupt to a processor.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - I/O modules
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#ifndef T64_IO_h
+#define T64_IO_h
+
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+#include "T64-Replay.h"
+
+#include <atomic>
+
+//----------------------------------------------------------------------------------------
+// I/O module types.
+//
+//----------------------------------------------------------------------------------------
+enum T64IoType : int {
+
+    T64_IO_NIL          = 0,
+    T64_IO_DISK         = 1,
+    T64_IO_UART         = 2,
+    T64_IO_TIMER        = 3
+};
+
+//----------------------------------------------------------------------------------------
+// The HPA registers of an I/O module. The interrupt target is the physical address
+// of the interrupt request register of the processor to interrupt, the interrupt
+// mask holds the bits to post. A zero target disables interrupts.
+//
+//----------------------------------------------------------------------------------------
+enum T64IoHpaReg : int {
+
+    IO_HPA_REG_STATUS       = 0,
+    IO_HPA_REG_COMMAND      = 1,
+    IO_HPA_REG_HPA_ADR      = 2,
+    IO_HPA_REG_SPA_ADR      = 3,
+    IO_HPA_REG_SPA_LEN      = 4,
+    IO_HPA_REG_NUM_ELEM     = 5,
+    IO_HPA_REG_HW_VERSION   = 6,
+    IO_HPA_REG_SW_VERSION   = 7,
+    IO_HPA_REG_INTR_TARGET  = 8,
+    IO_HPA_REG_INTR_MASK    = 9
+};
+
+//----------------------------------------------------------------------------------------
+// The I/O module base class. It implements the HPA registers and routes the uncached
+// SPA accesses to the device register routines of the concrete module. Registers are
+// 8-byte words, other accesses are rejected. I/O modules do not take part in cache
+// operations.
+//
+//----------------------------------------------------------------------------------------
+struct T64IoModule : T64Module {
+
+    public:
+
+    T64IoModule( T64System  *sys,
+                 int        modNum,
+                 T64IoType  ioType,
+                 T64Word    spaAdr,
+                 T64Word    spaLen );
+
+    virtual         ~ T64IoModule( );
+
+    T64IoType       getIoType( );
+
+    void            saveState( T64StateBuf *buf );
+    void            restoreState( T64StateBuf *buf );
+
+    bool            busOpReadUncached( int srcModNum,
+                                       T64Word pAdr,
+                                       uint8_t *data,
+                                       int len );
+
+    bool            busOpWriteUncached( int srcModNum,
+                                        T64Word pAdr,
+                                        uint8_t *data,
+                                        int len );
+
+    bool            busOpReadSharedBlock( int srcModNum,
+                                          T64Word pAdr,
+                                          uint8_t *data,
+                                          int len );
+
+    bool            busOpReadPrivateBlock( int srcModNum,
+                                           T64Word pAdr,
+                                           uint8_t *data,
+                                           int len );
+
+    bool            busOpWriteBlock( int srcModNum,
+                                     T64Word pAdr,
+                                     uint8_t *data,
+                                     int len );
+
+    protected:
+
+    virtual bool    spaRegRead( int regNum, T64Word *val ) = 0;
+    virtual bool    spaRegWrite( int regNum, T64Word val ) = 0;
+
+    void            resetIntr( );
+    bool            sendIntr( );
+
+    T64System       *sys        = nullptr;
+    T64IoType       ioType      = T64_IO_NIL;
+
+    private:
+
+    bool            hpaRegRead( int regNum, T64Word *val );
+    bool            hpaRegWrite( int regNum, T64Word val );
+
+    T64Word         intrTarget  = 0;
+    T64Word         intrMask    = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// Block storage module. The disk is backed by a host image file and transfers whole
+// blocks between the image and memory with DMA. A guest sets the block number, the
+// block count and the memory address and then issues a read or write command. The
+// transfer completes after a simulated latency, the status turns to done and an
+// interrupt is sent. A further command is only accepted when the module is idle. The
+// device registers in the SPA range are:
+//
+//  0 - status      ( busy, done, error )
+//  1 - command     ( read, write, acknowledge )
+//  2 - block number
+//  3 - block count
+//  4 - memory address
+//  5 - disk size in blocks
+//
+//----------------------------------------------------------------------------------------
+enum T64DiskReg : int {
+
+    DISK_REG_STATUS         = 0,
+    DISK_REG_COMMAND        = 1,
+    DISK_REG_BLOCK_NUM      = 2,
+    DISK_REG_BLOCK_CNT      = 3,
+    DISK_REG_MEM_ADR        = 4,
+    DISK_REG_DISK_SIZE      = 5
+};
+
+enum T64DiskStatus : int {
+
+    DISK_ST_BUSY            = 1,
+    DISK_ST_DONE            = 2,
+    DISK_ST_ERROR           = 4
+};
+
+enum T64DiskCmd : int {
+
+    DISK_CMD_NOP            = 0,
+    DISK_CMD_READ           = 1,
+    DISK_CMD_WRITE          = 2,
+    DISK_CMD_ACK            = 3
+};
+
+const int     T64_DISK_BLOCK_SIZE       = 512;
+const int     T64_DISK_XFER_BUF_SIZE    = 256 * 1024;
+const T64Word T64_DISK_CMD_CYCLES       = 2000;
+const T64Word T64_DISK_BLOCK_CYCLES     = 16;
+
+struct T64Disk : T64IoModule {
+
+    public:
+
+    T64Disk( T64System  *sys,
+             int        modNum,
+             T64Word    spaAdr,
+             T64Word    spaLen );
+
+    virtual         ~ T64Disk( );
+
+    void            reset( );
+    void            step( );
+    void            handleEvent( int eventId );
+    void            saveState( T64StateBuf *buf );
+    void            restoreState( T64StateBuf *buf );
+
+    bool            attachImage( const char *fileName );
+    void            detachImage( );
+    T64Word         getDiskSize( );
+
+    protected:
+
+    bool            spaRegRead( int regNum, T64Word *val );
+    bool            spaRegWrite( int regNum, T64Word val );
+
+    private:
+
+    void            startCommand( int cmd );
+    bool            transferBlocks( );
+
+    int             fd          = -1;
+    bool            readOnly    = false;
+    T64Word         diskSize    = 0;
+    uint8_t         *xferBuf    = nullptr;
+
+    T64Word         status      = 0;
+    T64Word         blockNum    = 0;
+    T64Word         blockCnt    = 0;
+    T64Word         memAdr      = 0;
+    int             curCmd      = DISK_CMD_NOP;
+};
+
+//----------------------------------------------------------------------------------------
+// Console UART module. The UART transfers characters between a guest and the host
+// through a transmit and a receive FIFO. Each FIFO is a ring buffer with a single 
+// producer and a single consumer, the head and tail indices are atomic, so the two
+// sides need no lock. For the transmit FIFO the guest is the producer and the host
+// is the consumer, for the receive FIFO it is the other way around. The host drains 
+// the transmit FIFO in batches, either into the simulator console or into an output
+// file. The device registers in the SPA range are:
+//
+//  0 - status      ( receive data ready, transmit space, receive overrun )
+//  1 - data        ( a read takes a receive character, a write puts a transmit character )
+//  2 - control     ( receive and transmit interrupt enable )
+//  3 - number of characters in the receive FIFO
+//  4 - free space in the transmit FIFO
+//
+// An interrupt is sent when characters arrive in the receive FIFO or the host has
+// drained the transmit FIFO, provided the respective interrupt is enabled.
+//
+//----------------------------------------------------------------------------------------
+enum T64UartReg : int {
+
+    UART_REG_STATUS         = 0,
+    UART_REG_DATA           = 1,
+    UART_REG_CONTROL        = 2,
+    UART_REG_RX_COUNT       = 3,
+    UART_REG_TX_SPACE       = 4
+};
+
+enum T64UartStatus : int {
+
+    UART_ST_RX_READY        = 1,
+    UART_ST_TX_SPACE        = 2,
+    UART_ST_RX_OVERRUN      = 4
+};
+
+enum T64UartControl : int {
+
+    UART_CTL_RX_INTR        = 1,
+    UART_CTL_TX_INTR        = 2
+};
+
+const int T64_UART_FIFO_SIZE    = 16 * 1024;
+const int T64_UART_DRAIN_SIZE   = 4 * 1024;
+
+//----------------------------------------------------------------------------------------
+// A single producer single consumer character ring. The size is a power of two, the 
+// indices run freely and are masked on access. The producer only writes the head, 
+// the consumer only writes the tail.
+//
+//----------------------------------------------------------------------------------------
+struct T64UartFifo {
+
+    public:
+
+    void            clear( );
+    int             count( );
+    int             space( );
+    bool            put( uint8_t ch );
+    bool            get( uint8_t *ch );
+    int             putBlock( const uint8_t *data, int len );
+    int             getBlock( uint8_t *data, int len );
+    void            saveState( T64StateBuf *buf );
+    void            restoreState( T64StateBuf *buf );
+
+    private:
+
+    uint8_t                 buf[ T64_UART_FIFO_SIZE ];
+    std::atomic<uint32_t>   head    = 0;
+    std::atomic<uint32_t>   tail    = 0;
+};
+
+struct T64Uart : T64IoModule {
+
+    public:
+
+    T64Uart( T64System  *sys,
+             int        modNum,
+             T64Word    spaAdr,
+             T64Word    spaLen );
+
+    virtual         ~ T64Uart( );
+
+    void            reset( );
+    void            step( );
+    void            saveState( T64StateBuf *buf );
+    void            restoreState( T64StateBuf *buf );
+    void            replayInput( T64ReplayKind kind, uint8_t *data, int len );
+
+    bool            setOutputFile( const char *fileName );
+    bool            hasOutputFile( );
+    void            flushOutput( );
+
+    int             drainTx( char *buf, int maxLen );
+    int             putRx( const char *buf, int len );
+
+    protected:
+
+    bool            spaRegRead( int regNum, T64Word *val );
+    bool            spaRegWrite( int regNum, T64Word val );
+
+    private:
+
+    int             receive( const uint8_t *buf, int len );
+
+    T64UartFifo     txFifo;
+    T64UartFifo     rxFifo;
+
+    FILE            *outFile    = nullptr;
+    T64Word         control     = 0;
+    bool            rxOverrun   = false;
+};
+
+//----------------------------------------------------------------------------------------
+// Interval timer and real time clock module. The timer counts simulated cycles. When
+// armed, it schedules a system event for the cycle at which it expires, an idle timer
+// costs nothing. On expiry, the status shows expired and an interrupt is sent. A 
+// periodic timer rearms itself with the interval. The timer is armed by enabling it
+// with a non-zero interval, or by writing an absolute cycle to the compare register.
+// In real time mode, the simulation waits on each expiry until the host time has 
+// caught up with the simulated time, using the clock rate in cycles per second. The
+// device registers in the SPA range are:
+//
+//  0 - status      ( expired, armed, write one to clear expired )
+//  1 - control     ( enable, periodic, interrupt enable, real time )
+//  2 - interval in cycles
+//  3 - compare, the cycle at which the timer expires
+//  4 - counter, the cycles remaining until the timer expires
+//  5 - current system cycle count
+//  6 - clock rate in cycles per second
+//  7 - host wall clock in microseconds since the epoch
+//
+//----------------------------------------------------------------------------------------
+enum T64TimerReg : int {
+
+    TIMER_REG_STATUS        = 0,
+    TIMER_REG_CONTROL       = 1,
+    TIMER_REG_INTERVAL      = 2,
+    TIMER_REG_COMPARE       = 3,
+    TIMER_REG_COUNTER       = 4,
+    TIMER_REG_CYCLES        = 5,
+    TIMER_REG_CLOCK_RATE    = 6,
+    TIMER_REG_WALL_CLOCK    = 7
+};
+
+enum T64TimerStatus : int {
+
+    TIMER_ST_EXPIRED        = 1,
+    TIMER_ST_ARMED          = 2
+};
+
+enum T64TimerControl : int {
+
+    TIMER_CTL_ENABLE        = 1,
+    TIMER_CTL_PERIODIC      = 2,
+    TIMER_CTL_INTR          = 4,
+    TIMER_CTL_REAL_TIME     = 8
+};
+
+const T64Word T64_TIMER_DEF_CLOCK_RATE  = 100000000;
+
+struct T64Timer : T64IoModule {
+
+    public:
+
+    T64Timer( T64System  *sys,
+              int        modNum,
+              T64Word    spaAdr,
+              T64Word    spaLen );
+
+    virtual         ~ T64Timer( );
+
+    void            reset( );
+    void            step( );
+    void            handleEvent( int eventId );
+    void            saveState( T64StateBuf *buf );
+    void            restoreState( T64StateBuf *buf );
+
+    void            setClockRate( T64Word rate );
+    T64Word         getClockRate( );
+
+    protected:
+
+    bool            spaRegRead( int regNum, T64Word *val );
+    bool            spaRegWrite( int regNum, T64Word val );
+
+    private:
+
+    void            arm( T64Word cycle );
+    void            disarm( );
+    void            waitForRealTime( );
+
+    T64Word         status      = 0;
+    T64Word         control     = 0;
+    T64Word         interval    = 0;
+    T64Word         compare     = 0;
+    T64Word         clockRate   = T64_TIMER_DEF_CLOCK_RATE;
+    T64Word         evtHandle   = -1;
+
+    T64Word         rtBaseCycle = 0;
+    T64Word         rtBaseUs    = 0;
+};
+
+#endif // T64-IO.h
@@ -0,0 +1,234 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - I/O module base
+//
+//----------------------------------------------------------------------------------------
+// The I/O module base implements what all I/O modules share. These are the HPA
+// registers, the routing of uncached bus requests to the device registers and the
+// sending of interrupts.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - I/O module base
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-IO.h"
+
+//----------------------------------------------------------------------------------------
+// Name space for local routines.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// Registers are accessed as 8-byte words. The bus data buffer holds the value in host
+// byte order.
+//
+//----------------------------------------------------------------------------------------
+bool isRegAccess( T64Word ofs, int len ) {
+
+    return(( len == sizeof( T64Word )) && (( ofs & ( sizeof( T64Word ) - 1 )) == 0 ));
+}
+
+T64Word getBusWord( uint8_t *data ) {
+
+    T64Word val;
+    memcpy( &val, data, sizeof( val ));
+    return( val );
+}
+
+void setBusWord( uint8_t *data, T64Word val ) {
+
+    memcpy( data, &val, sizeof( val ));
+}
+
+} // namespace
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// I/O module
+//
+//----------------------------------------------------------------------------------------
+// Object constructor and destructor.
+//
+//----------------------------------------------------------------------------------------
+T64IoModule::T64IoModule( T64System  *sys,
+                          int        modNum,
+                          T64IoType  ioType,
+                          T64Word    spaAdr,
+                          T64Word    spaLen ) :
+
+                          T64Module( MT_IO,
+                                     modNum,
+                                     spaAdr,
+                                     spaLen ) {
+
+    this -> sys     = sys;
+    this -> ioType  = ioType;
+}
+
+T64IoModule:: ~T64IoModule( ) { }
+
+T64IoType T64IoModule::getIoType( ) {
+
+    return( ioType );
+}
+
+//----------------------------------------------------------------------------------------
+// Save and restore the interrupt setup for a record and replay snapshot. The I/O
+// modules call these routines before saving their own state.
+//
+//----------------------------------------------------------------------------------------
+void T64IoModule::saveState( T64StateBuf *buf ) {
+
+    buf -> put( &intrTarget, sizeof( intrTarget ));
+    buf -> put( &intrMask, sizeof( intrMask ));
+}
+
+void T64IoModule::restoreState( T64StateBuf *buf ) {
+
+    buf -> get( &intrTarget, sizeof( intrTarget ));
+    buf -> get( &intrMask, sizeof( intrMask ));
+}
+
+//----------------------------------------------------------------------------------------
+// Uncached bus operations. The system bus informs all modules about a request. We
+// only react when the address is in our HPA or SPA range, all other requests are
+// none of our business.
+//
+//----------------------------------------------------------------------------------------
+bool T64IoModule::busOpReadUncached( int     srcModNum,
+                                     T64Word pAdr,
+                                     uint8_t *data,
+                                     int     len ) {
+
+    T64Word val = 0;
+
+    if (( pAdr >= hpaAdr ) && ( pAdr < hpaAdr + hpaLen )) {
+
+        if ( ! isRegAccess( pAdr - hpaAdr, len )) return( false );
+        if ( ! hpaRegRead((int) (( pAdr - hpaAdr ) / sizeof( T64Word )), &val )) return( false );
+    }
+    else if (( pAdr >= spaAdr ) && ( pAdr < spaAdr + spaLen )) {
+
+        if ( ! isRegAccess( pAdr - spaAdr, len )) return( false );
+        if ( ! spaRegRead((int) (( pAdr - spaAdr ) / sizeof( T64Word )), &val )) return( false );
+    }
+    else return( true );
+
+    setBusWord( data, val );
+    return( true );
+}
+
+bool T64IoModule::busOpWriteUncached( int     srcModNum,
+                                      T64Word pAdr,
+                                      uint8_t *data,
+                                      int     len ) {
+
+    if (( pAdr >= hpaAdr ) && ( pAdr < hpaAdr + hpaLen )) {
+
+        if ( ! isRegAccess( pAdr - hpaAdr, len )) return( false );
+        return( hpaRegWrite((int) (( pAdr - hpaAdr ) / sizeof( T64Word )), getBusWord( data )));
+    }
+    else if (( pAdr >= spaAdr ) && ( pAdr < spaAdr + spaLen )) {
+
+        if ( ! isRegAccess( pAdr - spaAdr, len )) return( false );
+        return( spaRegWrite((int) (( pAdr - spaAdr ) / sizeof( T64Word )), getBusWord( data )));
+    }
+    else return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// An I/O module does not hold cached data and its address ranges can only be accessed
+// uncached. As an observer we ignore the cache operations, as a target we refuse them.
+//
+//----------------------------------------------------------------------------------------
+bool T64IoModule::busOpReadSharedBlock( int     srcModNum,
+                                        T64Word pAdr,
+                                        uint8_t *data,
+                                        int     len ) {
+
+    return( false );
+}
+
+bool T64IoModule::busOpReadPrivateBlock( int     srcModNum,
+                                         T64Word pAdr,
+                                         uint8_t *data,
+                                         int     len ) {
+
+    return( false );
+}
+
+bool T64IoModule::busOpWriteBlock( int     srcModNum,
+                                   T64Word pAdr,
+                                   uint8_t *data,
+                                   int     len ) {
+
+    return( false );
+}
+
+//----------------------------------------------------------------------------------------
+// HPA register access. The address, length and interrupt registers are implemented.
+// All other registers read as zero and ignore a write.
+//
+//----------------------------------------------------------------------------------------
+bool T64IoModule::hpaRegRead( int regNum, T64Word *val ) {
+
+    switch ( regNum ) {
+
+        case IO_HPA_REG_HPA_ADR:        *val = hpaAdr;      break;
+        case IO_HPA_REG_SPA_ADR:        *val = spaAdr;      break;
+        case IO_HPA_REG_SPA_LEN:        *val = spaLen;      break;
+        case IO_HPA_REG_INTR_TARGET:    *val = intrTarget;  break;
+        case IO_HPA_REG_INTR_MASK:      *val = intrMask;    break;
+        default:                        *val = 0;
+    }
+
+    return( true );
+}
+
+bool T64IoModule::hpaRegWrite( int regNum, T64Word val ) {
+
+    switch ( regNum ) {
+
+        case IO_HPA_REG_INTR_TARGET:    intrTarget  = val;  break;
+        case IO_HPA_REG_INTR_MASK:      intrMask    = val;  break;
+        default: ;
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Interrupts. An interrupt is an uncached write of the interrupt mask to the target
+// address, which is the interrupt request register of a processor HPA. Without a
+// target or a mask, no interrupt is sent.
+//
+//----------------------------------------------------------------------------------------
+void T64IoModule::resetIntr( ) {
+
+    intrTarget  = 0;
+    intrMask    = 0;
+}
+
+bool T64IoModule::sendIntr( ) {
+
+    if (( intrTarget == 0 ) || ( intrMask == 0 )) return( false );
+
+    uint8_t data[ sizeof( T64Word ) ];
+    setBusWord( data, intrMask );
+
+    return( sys -> busOpWriteUncached( moduleNum, intrTarget, data, sizeof( data )));
+}
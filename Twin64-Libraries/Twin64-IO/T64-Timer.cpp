@@ -0,0 +1,291 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - Interval timer module
+//
+//----------------------------------------------------------------------------------------
+// The interval timer module gives a guest a periodic or a one shot timer interrupt
+// and a real time clock. The timer runs on the simulated cycle count. Instead of 
+// counting down on every cycle, an armed timer schedules a system event for the
+// cycle at which it expires.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - Interval timer module
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-IO.h"
+
+#include <chrono>
+#include <thread>
+
+//----------------------------------------------------------------------------------------
+// Name space for local routines.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const int TIMER_EVT_EXPIRED = 1;
+
+//----------------------------------------------------------------------------------------
+// Host time in microseconds. The monotonic clock is used for the real time mode, the
+// system clock for the wall clock register.
+//
+//----------------------------------------------------------------------------------------
+T64Word hostMonotonicUs( ) {
+
+    return( std::chrono::duration_cast<std::chrono::microseconds>( 
+                std::chrono::steady_clock::now( ).time_since_epoch( )).count( ));
+}
+
+T64Word hostWallClockUs( ) {
+
+    return( std::chrono::duration_cast<std::chrono::microseconds>( 
+                std::chrono::system_clock::now( ).time_since_epoch( )).count( ));
+}
+
+} // namespace
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Interval timer module
+//
+//----------------------------------------------------------------------------------------
+// Object constructor and destructor.
+//
+//----------------------------------------------------------------------------------------
+T64Timer::T64Timer( T64System  *sys,
+                    int        modNum,
+                    T64Word    spaAdr,
+                    T64Word    spaLen ) :
+
+                    T64IoModule( sys,
+                                 modNum,
+                                 T64_IO_TIMER,
+                                 spaAdr,
+                                 spaLen ) {
+
+    reset( );
+}
+
+T64Timer:: ~T64Timer( ) { }
+
+//----------------------------------------------------------------------------------------
+// Reset the module. The timer is stopped and a pending expiry is cancelled. The clock
+// rate is a host setting and stays.
+//
+//----------------------------------------------------------------------------------------
+void T64Timer::reset( ) {
+
+    sys -> cancelModuleEvents( this );
+    resetIntr( );
+
+    evtHandle   = -1;
+    status      = 0;
+    control     = 0;
+    interval    = 0;
+    compare     = 0;
+    rtBaseCycle = 0;
+    rtBaseUs    = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// The timer is not a clocked module. All work is done when a register is written and
+// when the expiry event is due.
+//
+//----------------------------------------------------------------------------------------
+void T64Timer::step( ) { }
+
+//----------------------------------------------------------------------------------------
+// Save and restore the timer state for a record and replay snapshot. A pending expiry
+// is part of the system event queue, the event handle stays valid across a restore.
+// The real time base is taken anew, a replay does not wait for the host time. 
+//
+//----------------------------------------------------------------------------------------
+void T64Timer::saveState( T64StateBuf *buf ) {
+
+    T64IoModule::saveState( buf );
+
+    buf -> put( &status, sizeof( status ));
+    buf -> put( &control, sizeof( control ));
+    buf -> put( &interval, sizeof( interval ));
+    buf -> put( &compare, sizeof( compare ));
+    buf -> put( &evtHandle, sizeof( evtHandle ));
+}
+
+void T64Timer::restoreState( T64StateBuf *buf ) {
+
+    T64IoModule::restoreState( buf );
+
+    buf -> get( &status, sizeof( status ));
+    buf -> get( &control, sizeof( control ));
+    buf -> get( &interval, sizeof( interval ));
+    buf -> get( &compare, sizeof( compare ));
+    buf -> get( &evtHandle, sizeof( evtHandle ));
+
+    rtBaseCycle = sys -> getCycleCount( );
+    rtBaseUs    = hostMonotonicUs( );
+}
+
+//----------------------------------------------------------------------------------------
+// The clock rate is the number of cycles per simulated second. It converts between 
+// cycles and host time in real time mode, a guest reads it to compute its intervals.
+//
+//----------------------------------------------------------------------------------------
+void T64Timer::setClockRate( T64Word rate ) {
+
+    if ( rate > 0 ) clockRate = rate;
+}
+
+T64Word T64Timer::getClockRate( ) {
+
+    return( clockRate );
+}
+
+//----------------------------------------------------------------------------------------
+// Arm and disarm the timer. Arming replaces a pending expiry. A compare cycle in the
+// past expires before the next instruction.
+//
+//----------------------------------------------------------------------------------------
+void T64Timer::arm( T64Word cycle ) {
+
+    disarm( );
+
+    compare   = cycle;
+    evtHandle = sys -> scheduleEvent( this, cycle - sys -> getCycleCount( ), TIMER_EVT_EXPIRED );
+
+    if ( evtHandle >= 0 ) status |= TIMER_ST_ARMED;
+}
+
+void T64Timer::disarm( ) {
+
+    if ( evtHandle >= 0 ) sys -> cancelEvent( evtHandle );
+
+    evtHandle = -1;
+    status    &= ~ TIMER_ST_ARMED;
+}
+
+//----------------------------------------------------------------------------------------
+// Real time mode. The host time that corresponds to the current cycle is computed 
+// from the base cycle and host time taken when the timer was enabled. If the 
+// simulation is ahead of the host time, we sleep for the difference. A simulation 
+// that is behind just continues.
+//
+//----------------------------------------------------------------------------------------
+void T64Timer::waitForRealTime( ) {
+
+    T64Word cycles   = sys -> getCycleCount( ) - rtBaseCycle;
+    T64Word targetUs = rtBaseUs + 
+                       ( cycles / clockRate ) * 1000000 + 
+                       (( cycles % clockRate ) * 1000000 ) / clockRate;
+    T64Word nowUs    = hostMonotonicUs( );
+
+    if ( targetUs > nowUs ) 
+        std::this_thread::sleep_for( std::chrono::microseconds( targetUs - nowUs ));
+}
+
+//----------------------------------------------------------------------------------------
+// The expiry event. The status turns to expired and the interrupt is sent. A periodic
+// timer is rearmed relative to the last compare value, so the period does not drift.
+// A replay runs at full speed and does not wait for the host time.
+//
+//----------------------------------------------------------------------------------------
+void T64Timer::handleEvent( int eventId ) {
+
+    if ( eventId != TIMER_EVT_EXPIRED ) return;
+
+    evtHandle = -1;
+    status    = ( status & ~ TIMER_ST_ARMED ) | TIMER_ST_EXPIRED;
+
+    if (( control & TIMER_CTL_REAL_TIME ) && ( ! sys -> isReplaying( ))) waitForRealTime( );
+    if ( control & TIMER_CTL_INTR )      sendIntr( );
+
+    if (( control & TIMER_CTL_PERIODIC ) && ( interval > 0 )) arm( compare + interval );
+}
+
+//----------------------------------------------------------------------------------------
+// Device register access. The counter, cycle, clock rate and wall clock registers are
+// read only. The wall clock is an input from the host, a recording logs the value read
+// and a replay returns the logged value. Writing the control register with the enable
+// bit set starts the timer with the interval, clearing it stops the timer. Writing
+// the compare register arms the enabled timer for that cycle.
+//
+//----------------------------------------------------------------------------------------
+bool T64Timer::spaRegRead( int regNum, T64Word *val ) {
+
+    switch ( regNum ) {
+
+        case TIMER_REG_STATUS:      *val = status;      break;
+        case TIMER_REG_CONTROL:     *val = control;     break;
+        case TIMER_REG_INTERVAL:    *val = interval;    break;
+        case TIMER_REG_COMPARE:     *val = compare;     break;
+
+        case TIMER_REG_COUNTER: {
+
+            *val = 0;
+            if ( status & TIMER_ST_ARMED ) *val = compare - sys -> getCycleCount( );
+
+        } break;
+
+        case TIMER_REG_CYCLES:      *val = sys -> getCycleCount( );     break;
+        case TIMER_REG_CLOCK_RATE:  *val = clockRate;                   break;
+        case TIMER_REG_WALL_CLOCK: {
+
+            *val = sys -> inputWord( moduleNum, T64_RPK_WALL_CLOCK, hostWallClockUs( ));
+
+        } break;
+
+        default:                    *val = 0;
+    }
+
+    return( true );
+}
+
+bool T64Timer::spaRegWrite( int regNum, T64Word val ) {
+
+    switch ( regNum ) {
+
+        case TIMER_REG_STATUS: status &= ~ ( val & TIMER_ST_EXPIRED ); break;
+
+        case TIMER_REG_CONTROL: {
+
+            control = val & ( TIMER_CTL_ENABLE | TIMER_CTL_PERIODIC | 
+                              TIMER_CTL_INTR | TIMER_CTL_REAL_TIME );
+
+            disarm( );
+
+            if ( control & TIMER_CTL_ENABLE ) {
+
+                rtBaseCycle = sys -> getCycleCount( );
+                rtBaseUs    = hostMonotonicUs( );
+
+                if ( interval > 0 ) arm( rtBaseCycle + interval );
+            }
+
+        } break;
+
+        case TIMER_REG_INTERVAL: interval = ( val > 0 ) ? val : 0; break;
+
+        case TIMER_REG_COMPARE: {
+
+            compare = val;
+            if ( control & TIMER_CTL_ENABLE ) arm( val );
+
+        } break;
+
+        default: ;
+    }
+
+    return( true );
+}
@@ -0,0 +1,391 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - Console UART module
+//
+//----------------------------------------------------------------------------------------
+// The console UART module connects a guest to the host console or to an output file.
+// Characters are buffered in a transmit and a receive FIFO. The guest side works on
+// single characters, the host side moves characters in blocks. This way, a guest that
+// prints a lot does not cause a host write for each character.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - A 64-bit CPU - Console UART module
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-IO.h"
+
+//----------------------------------------------------------------------------------------
+// Name space for local routines.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const uint32_t FIFO_MASK = T64_UART_FIFO_SIZE - 1;
+
+static_assert(( T64_UART_FIFO_SIZE & FIFO_MASK ) == 0, "FIFO size must be a power of two" );
+
+} // namespace
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// UART FIFO
+//
+//----------------------------------------------------------------------------------------
+// The FIFO indices run freely, the difference of head and tail is the number of
+// characters in the FIFO. A producer reads the tail with acquire semantics to see 
+// the space freed by the consumer, and publishes new data with a release store of
+// the head. The consumer does the reverse. Clearing the FIFO is only allowed when
+// neither side is active.
+//
+//----------------------------------------------------------------------------------------
+void T64UartFifo::clear( ) {
+
+    head.store( 0 );
+    tail.store( 0 );
+}
+
+int T64UartFifo::count( ) {
+
+    return((int) ( head.load( std::memory_order_acquire ) - 
+                   tail.load( std::memory_order_acquire )));
+}
+
+int T64UartFifo::space( ) {
+
+    return( T64_UART_FIFO_SIZE - count( ));
+}
+
+bool T64UartFifo::put( uint8_t ch ) {
+
+    uint32_t h = head.load( std::memory_order_relaxed );
+    uint32_t t = tail.load( std::memory_order_acquire );
+
+    if ( h - t >= (uint32_t) T64_UART_FIFO_SIZE ) return( false );
+
+    buf[ h & FIFO_MASK ] = ch;
+    head.store( h + 1, std::memory_order_release );
+    return( true );
+}
+
+bool T64UartFifo::get( uint8_t *ch ) {
+
+    uint32_t t = tail.load( std::memory_order_relaxed );
+    uint32_t h = head.load( std::memory_order_acquire );
+
+    if ( h == t ) return( false );
+
+    *ch = buf[ t & FIFO_MASK ];
+    tail.store( t + 1, std::memory_order_release );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Block transfers. The data is copied in at most two pieces, one up to the end of 
+// the buffer and one from the start. The routines return the number of characters 
+// transferred, which is less than requested when the FIFO is full or empty.
+//
+//----------------------------------------------------------------------------------------
+int T64UartFifo::putBlock( const uint8_t *data, int len ) {
+
+    uint32_t h = head.load( std::memory_order_relaxed );
+    uint32_t t = tail.load( std::memory_order_acquire );
+    int      n = T64_UART_FIFO_SIZE - (int) ( h - t );
+
+    if ( len < n ) n = len;
+    if ( n <= 0 ) return( 0 );
+
+    int ofs   = (int) ( h & FIFO_MASK );
+    int first = T64_UART_FIFO_SIZE - ofs;
+    
+    if ( first > n ) first = n;
+
+    memcpy( buf + ofs, data, first );
+    memcpy( buf, data + first, n - first );
+
+    head.store( h + n, std::memory_order_release );
+    return( n );
+}
+
+int T64UartFifo::getBlock( uint8_t *data, int len ) {
+
+    uint32_t t = tail.load( std::memory_order_relaxed );
+    uint32_t h = head.load( std::memory_order_acquire );
+    int      n = (int) ( h - t );
+
+    if ( len < n ) n = len;
+    if ( n <= 0 ) return( 0 );
+
+    int ofs   = (int) ( t & FIFO_MASK );
+    int first = T64_UART_FIFO_SIZE - ofs;
+    
+    if ( first > n ) first = n;
+
+    memcpy( data, buf + ofs, first );
+    memcpy( data + first, buf, n - first );
+
+    tail.store( t + n, std::memory_order_release );
+    return( n );
+}
+
+//----------------------------------------------------------------------------------------
+// Save and restore the FIFO for a record and replay snapshot. Only the characters in
+// the FIFO and the index values are saved. This is only allowed when neither side is 
+// active.
+//
+//----------------------------------------------------------------------------------------
+void T64UartFifo::saveState( T64StateBuf *buf ) {
+
+    uint32_t h = head.load( );
+    uint32_t t = tail.load( );
+
+    buf -> put( &h, sizeof( h ));
+    buf -> put( &t, sizeof( t ));
+
+    for ( uint32_t i = t; i != h; i++ ) buf -> put( &this -> buf[ i & FIFO_MASK ], 1 );
+}
+
+void T64UartFifo::restoreState( T64StateBuf *buf ) {
+
+    uint32_t h = 0;
+    uint32_t t = 0;
+
+    buf -> get( &h, sizeof( h ));
+    buf -> get( &t, sizeof( t ));
+
+    if ( h - t > (uint32_t) T64_UART_FIFO_SIZE ) h = t;
+
+    for ( uint32_t i = t; i != h; i++ ) buf -> get( &this -> buf[ i & FIFO_MASK ], 1 );
+
+    head.store( h );
+    tail.store( t );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Console UART module
+//
+//----------------------------------------------------------------------------------------
+// Object constructor and destructor. Characters still in the transmit FIFO are
+// written to the output file before it is closed.
+//
+//----------------------------------------------------------------------------------------
+T64Uart::T64Uart( T64System  *sys,
+                  int        modNum,
+                  T64Word    spaAdr,
+                  T64Word    spaLen ) :
+
+                  T64IoModule( sys,
+                               modNum,
+                               T64_IO_UART,
+                               spaAdr,
+                               spaLen ) {
+
+    reset( );
+}
+
+T64Uart:: ~T64Uart( ) {
+
+    if ( outFile != nullptr ) {
+
+        flushOutput( );
+        fclose( outFile );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Reset the module. Both FIFOs are emptied and the interrupts are disabled. An output
+// file stays attached.
+//
+//----------------------------------------------------------------------------------------
+void T64Uart::reset( ) {
+
+    resetIntr( );
+    txFifo.clear( );
+    rxFifo.clear( );
+
+    control     = 0;
+    rxOverrun   = false;
+}
+
+//----------------------------------------------------------------------------------------
+// The UART is not a clocked module. The guest side works when a device register is 
+// accessed, the host side when the simulator moves characters.
+//
+//----------------------------------------------------------------------------------------
+void T64Uart::step( ) { }
+
+//----------------------------------------------------------------------------------------
+// Save and restore the UART state for a record and replay snapshot. An output file
+// is a host setting and stays.
+//
+//----------------------------------------------------------------------------------------
+void T64Uart::saveState( T64StateBuf *buf ) {
+
+    T64IoModule::saveState( buf );
+    txFifo.saveState( buf );
+    rxFifo.saveState( buf );
+
+    buf -> put( &control, sizeof( control ));
+    buf -> put( &rxOverrun, sizeof( rxOverrun ));
+}
+
+void T64Uart::restoreState( T64StateBuf *buf ) {
+
+    T64IoModule::restoreState( buf );
+    txFifo.restoreState( buf );
+    rxFifo.restoreState( buf );
+
+    buf -> get( &control, sizeof( control ));
+    buf -> get( &rxOverrun, sizeof( rxOverrun ));
+}
+
+//----------------------------------------------------------------------------------------
+// Output file. When an output file is set, the transmitted characters go to the file
+// instead of the console. The simulator calls "flushOutput" after each run quantum, 
+// in addition a full transmit FIFO is flushed right away, so a guest can write to the
+// file at full speed.
+//
+//----------------------------------------------------------------------------------------
+bool T64Uart::setOutputFile( const char *fileName ) {
+
+    if ( outFile != nullptr ) {
+
+        flushOutput( );
+        fclose( outFile );
+    }
+
+    outFile = fopen( fileName, "w" );
+    return( outFile != nullptr );
+}
+
+bool T64Uart::hasOutputFile( ) {
+
+    return( outFile != nullptr );
+}
+
+void T64Uart::flushOutput( ) {
+
+    if ( outFile == nullptr ) return;
+
+    char buf[ T64_UART_DRAIN_SIZE ];
+    int  len;
+
+    while (( len = drainTx( buf, sizeof( buf ))) > 0 ) fwrite( buf, 1, len, outFile );
+    fflush( outFile );
+}
+
+//----------------------------------------------------------------------------------------
+// Host side character transfer. "drainTx" moves transmitted characters to the host 
+// buffer, "putRx" moves host characters to the receive FIFO. Characters that do not 
+// fit into the receive FIFO are lost and the overrun status is set. The interrupts 
+// are sent when the transmit FIFO was drained completely and when new characters 
+// were received. The received characters are console input for a recording. During
+// a replay, host characters are ignored and the recorded characters are delivered
+// through "replayInput" in the cycle they were received.
+//
+//----------------------------------------------------------------------------------------
+int T64Uart::drainTx( char *buf, int maxLen ) {
+
+    int len = txFifo.getBlock((uint8_t *) buf, maxLen );
+
+    if (( len > 0 ) && ( control & UART_CTL_TX_INTR ) && ( txFifo.count( ) == 0 )) sendIntr( );
+    return( len );
+}
+
+int T64Uart::putRx( const char *buf, int len ) {
+
+    if ( sys -> isReplaying( )) return( 0 );
+
+    sys -> recordData( moduleNum, T64_RPK_CONSOLE_IN, (const uint8_t *) buf, len );
+    return( receive((const uint8_t *) buf, len ));
+}
+
+void T64Uart::replayInput( T64ReplayKind kind, uint8_t *data, int len ) {
+
+    if ( kind == T64_RPK_CONSOLE_IN ) receive( data, len );
+}
+
+int T64Uart::receive( const uint8_t *buf, int len ) {
+
+    int n = rxFifo.putBlock( buf, len );
+
+    if ( n < len ) rxOverrun = true;
+    if (( n > 0 ) && ( control & UART_CTL_RX_INTR )) sendIntr( );
+    return( n );
+}
+
+//----------------------------------------------------------------------------------------
+// Device register access. Reading the data register takes the next received 
+// character, it reads as zero when there is none. Reading the status register clears
+// the overrun status. Writing the data register adds a character to the transmit 
+// FIFO. When the FIFO is full, it is flushed to an output file if there is one, 
+// otherwise the character is lost.
+//
+//----------------------------------------------------------------------------------------
+bool T64Uart::spaRegRead( int regNum, T64Word *val ) {
+
+    switch ( regNum ) {
+
+        case UART_REG_STATUS: {
+
+            *val = 0;
+            if ( rxFifo.count( ) > 0 )  *val |= UART_ST_RX_READY;
+            if ( txFifo.space( ) > 0 )  *val |= UART_ST_TX_SPACE;
+            if ( rxOverrun )            *val |= UART_ST_RX_OVERRUN;
+
+            rxOverrun = false;
+
+        } break;
+
+        case UART_REG_DATA: {
+
+            uint8_t ch = 0;
+
+            rxFifo.get( &ch );
+            *val = ch;
+
+        } break;
+
+        case UART_REG_CONTROL:      *val = control;             break;
+        case UART_REG_RX_COUNT:     *val = rxFifo.count( );     break;
+        case UART_REG_TX_SPACE:     *val = txFifo.space( );     break;
+        default:                    *val = 0;
+    }
+
+    return( true );
+}
+
+bool T64Uart::spaRegWrite( int regNum, T64Word val ) {
+
+    switch ( regNum ) {
+
+        case UART_REG_DATA: {
+
+            if ( ! txFifo.put((uint8_t) val )) {
+
+                flushOutput( );
+                txFifo.put((uint8_t) val );
+            }
+
+        } break;
+
+        case UART_REG_CONTROL: control = val & ( UART_CTL_RX_INTR | UART_CTL_TX_INTR ); break;
+        default: ;
+    }
+
+    return( true );
+}
@@ -0,0 +1,1594 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - File Assembler
+//
+//----------------------------------------------------------------------------------------
+// The file assembler is a two pass assembler for a source file. The instructions are
+// encoded by the one line assembler, so the simulator and the file assembler share
+// the same encoding code. The file assembler adds labels, sections, data directives
+// and the symbol table. A source line has the following format:
+//
+//      [ <label> ":" ] [ <instruction> | <directive> ] [ ";" <comment> ]
+//
+// Labels start with a letter. A label starting with a "@" is a local label, which is
+// only known between two global labels. Symbol names are case insensitive. In an
+// expression, the "." preceded by a blank is the current location counter. The
+// branch instructions "B", "ABR", "CBR" and "MBR" take the target address, the
+// assembler computes the offset. The directives are:
+//
+//      .SECTION <name> [ "," "<flags>" ]     - select or create a section
+//      .ORG <expr>                         - set the location counter
+//      .ALIGN <expr>                       - align the location counter
+//      .BYTE | .HALF | .WORD | .DWORD <expr> { "," <expr> }
+//      .ASCII | .ASCIZ <string> { "," <string> }
+//      .SPACE <expr>                       - reserve zeroed bytes
+//      .EQU <name> "," <expr>              - define an absolute symbol
+//      .GLOBAL <name> { "," <name> }       - make symbols global
+//      .ENTRY <expr>                       - the program entry address
+//
+// The section flags are "w" for writable, "x" for executable and "b" for a section
+// without file data. Without flags, sections named ".text" are executable, ".data"
+// is writable and ".bss" is a writable section without data. A new section starts at
+// the end of the previously created section, unless the first thing in the section
+// is an ".ORG" directive. Sections must not overlap. The expressions of ".ORG",
+// ".ALIGN", ".SPACE" and ".EQU" are evaluated in the first pass, so all symbols used
+// must be defined before. All other expressions may use forward references.
+//
+// The first pass only computes the locations. Every instruction is four bytes, so
+// we do not need to parse instructions in the first pass. The second pass generates
+// the section data. The result is a big endian ELF64 executable with one loadable
+// segment per section and a symbol table. There is no linker yet, so all addresses
+// are absolute.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - File Assembler
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-KeywordHash.h"
+#include "T64-InlineAsm.h"
+
+#include <stdarg.h>
+
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// File assembler constants. A symbol name must fit into a token of the one line
+// assembler.
+//
+//----------------------------------------------------------------------------------------
+const int       MAX_ASM_LINE_SIZE       = 1024;
+const int       MAX_ASM_SECTIONS        = 16;
+const int       MAX_SECTION_NAME_SIZE   = 32;
+const int       MAX_SYM_NAME_SIZE       = 32;
+const int       INIT_SYM_SLOTS          = 1024;
+const int       INIT_NAME_POOL_SIZE     = 16 * 1024;
+const T64Word   MAX_SECTION_SIZE        = 256 * 1024 * 1024;
+
+//----------------------------------------------------------------------------------------
+// Section flags. "SF_BY_NAME" derives the flags from the section name.
+//
+//----------------------------------------------------------------------------------------
+enum SectionFlags : uint32_t {
+
+    SF_NIL          = 0,
+    SF_WRITE        = 1,
+    SF_EXEC         = 2,
+    SF_NOBITS       = 4,
+    SF_BY_NAME      = 0x80000000
+};
+
+//----------------------------------------------------------------------------------------
+// The ELF64 constants we need. The sizes are the sizes of the file structures.
+//
+//----------------------------------------------------------------------------------------
+const int       ELF_EHDR_SIZE           = 64;
+const int       ELF_PHDR_SIZE           = 56;
+const int       ELF_SHDR_SIZE           = 64;
+const int       ELF_SYM_SIZE            = 24;
+
+const uint16_t  ELF_ET_EXEC             = 2;
+const uint16_t  ELF_EM_NONE             = 0;
+const uint32_t  ELF_PT_LOAD             = 1;
+const uint32_t  ELF_PF_X                = 1;
+const uint32_t  ELF_PF_W                = 2;
+const uint32_t  ELF_PF_R                = 4;
+
+const uint32_t  ELF_SHT_PROGBITS        = 1;
+const uint32_t  ELF_SHT_SYMTAB          = 2;
+const uint32_t  ELF_SHT_STRTAB          = 3;
+const uint32_t  ELF_SHT_NOBITS          = 8;
+const uint64_t  ELF_SHF_WRITE           = 1;
+const uint64_t  ELF_SHF_ALLOC           = 2;
+const uint64_t  ELF_SHF_EXECINSTR       = 4;
+const uint16_t  ELF_SHN_ABS             = 0xfff1;
+const uint8_t   ELF_STB_LOCAL           = 0;
+const uint8_t   ELF_STB_GLOBAL          = 1;
+
+//----------------------------------------------------------------------------------------
+// The assembler directives. They are looked up through a perfect hash table.
+//
+//----------------------------------------------------------------------------------------
+enum DirId : int {
+
+    DIR_NIL = 0,    DIR_SECTION,    DIR_ORG,        DIR_ALIGN,      DIR_BYTE,
+    DIR_HALF,       DIR_WORD,       DIR_DWORD,      DIR_ASCII,      DIR_ASCIZ,
+    DIR_SPACE,      DIR_EQU,        DIR_GLOBAL,     DIR_ENTRY
+};
+
+struct DirEntry {
+
+    char    name[ 16 ];
+    DirId   id;
+};
+
+constexpr DirEntry DirTab[ ] = {
+
+    { "SECTION",    DIR_SECTION },  { "ORG",        DIR_ORG     },
+    { "ALIGN",      DIR_ALIGN   },  { "BYTE",       DIR_BYTE    },
+    { "HALF",       DIR_HALF    },  { "WORD",       DIR_WORD    },
+    { "DWORD",      DIR_DWORD   },  { "ASCII",      DIR_ASCII   },
+    { "ASCIZ",      DIR_ASCIZ   },  { "SPACE",      DIR_SPACE   },
+    { "EQU",        DIR_EQU     },  { "GLOBAL",     DIR_GLOBAL  },
+    { "ENTRY",      DIR_ENTRY   }
+};
+
+constexpr int   MAX_DIR_TAB     = sizeof( DirTab ) / sizeof( DirEntry );
+constexpr auto  DirHash         = T64KeywordHash<MAX_DIR_TAB>( DirTab );
+
+//----------------------------------------------------------------------------------------
+// The symbol name hash. It is a FNV-1a hash, the names are already upshifted.
+//
+//----------------------------------------------------------------------------------------
+uint32_t hashName( const char *name ) {
+
+    uint32_t hash = 2166136261u;
+
+    while ( *name != 0 ) {
+
+        hash ^= (uint8_t) *name++;
+        hash *= 16777619u;
+    }
+
+    return ( hash );
+}
+
+//----------------------------------------------------------------------------------------
+// Store a value in big endian byte order.
+//
+//----------------------------------------------------------------------------------------
+void putBigEndian( uint8_t *buf, uint64_t val, int size ) {
+
+    for ( int i = size - 1; i >= 0; i-- ) {
+
+        buf[ i ] = (uint8_t) val;
+        val >>= 8;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// A growing byte buffer for building the ELF file in memory. All values are appended
+// in big endian byte order.
+//
+//----------------------------------------------------------------------------------------
+struct ElfBuf {
+
+    uint8_t     *data   = nullptr;
+    size_t      len     = 0;
+    size_t      max     = 0;
+
+    ~ElfBuf( ) {
+
+        free( data );
+    }
+
+    uint8_t *reserve( size_t size ) {
+
+        if ( len + size > max ) {
+
+            while ( len + size > max ) max = ( max == 0 ) ? 4096 : max * 2;
+            data = (uint8_t *) realloc( data, max );
+        }
+
+        uint8_t *ptr = data + len;
+        memset( ptr, 0, size );
+        len += size;
+        return ( ptr );
+    }
+
+    void appendVal( uint64_t val, int size ) {
+
+        putBigEndian( reserve( size ), val, size );
+    }
+
+    void appendBytes( const void *src, size_t size ) {
+
+        if ( size > 0 ) memcpy( reserve( size ), src, size );
+    }
+
+    void alignTo( size_t align ) {
+
+        while (( len % align ) != 0 ) reserve( 1 );
+    }
+};
+
+//----------------------------------------------------------------------------------------
+// A string table for the ELF file. The first byte is the empty name. We return the
+// offset of the added name.
+//
+//----------------------------------------------------------------------------------------
+uint32_t addElfString( ElfBuf *strTab, const char *str ) {
+
+    if ( strTab -> len == 0 ) strTab -> reserve( 1 );
+
+    uint32_t ofs = (uint32_t) strTab -> len;
+    strTab -> appendBytes( str, strlen( str ) + 1 );
+    return ( ofs );
+}
+
+//----------------------------------------------------------------------------------------
+// Remove the comment from a source line. A ";" inside a string does not start a
+// comment. Trailing white space is removed too.
+//
+//----------------------------------------------------------------------------------------
+void stripComment( char *line ) {
+
+    bool    inStr   = false;
+    char    *p      = line;
+
+    for ( ; *p != 0; p++ ) {
+
+        if ( inStr ) {
+
+            if (( *p == '\\' ) && ( p[ 1 ] != 0 )) p++;
+            else if ( *p == '"' ) inStr = false;
+        }
+        else if ( *p == '"' ) inStr = true;
+        else if ( *p == ';' ) break;
+    }
+
+    *p = 0;
+    while (( p > line ) && ( isspace((uint8_t) p[ -1 ] ))) *--p = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// "nextOperand" copies the next comma separated operand to the buffer. Commas in
+// parentheses or strings do not separate operands. We return false when there are
+// no more operands.
+//
+//----------------------------------------------------------------------------------------
+bool nextOperand( char **pos, char *buf, int bufLen ) {
+
+    char    *p      = *pos;
+    int     len     = 0;
+    int     depth   = 0;
+    bool    inStr   = false;
+
+    while ( isspace((uint8_t) *p )) p++;
+    if ( *p == 0 ) return ( false );
+
+    while (( *p != 0 ) && (( inStr ) || ( depth > 0 ) || ( *p != ',' ))) {
+
+        if ( inStr ) {
+
+            if (( *p == '\\' ) && ( p[ 1 ] != 0 ) && ( len + 1 < bufLen )) {
+
+                buf[ len++ ] = *p++;
+            }
+            else if ( *p == '"' ) inStr = false;
+        }
+        else if ( *p == '"' ) inStr = true;
+        else if ( *p == '(' ) depth ++;
+        else if ( *p == ')' ) depth --;
+
+        if ( len + 1 < bufLen ) buf[ len++ ] = *p;
+        p++;
+    }
+
+    while (( len > 0 ) && ( isspace((uint8_t) buf[ len - 1 ] ))) len--;
+    buf[ len ] = 0;
+
+    if ( *p == ',' ) p++;
+    *pos = p;
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Check a symbol name. It starts with a letter or a "@" and continues with letters,
+// digits and underscores.
+//
+//----------------------------------------------------------------------------------------
+bool isValidSymName( const char *name ) {
+
+    if ( ! (( isalpha((uint8_t) name[ 0 ] )) || ( name[ 0 ] == '@' ))) return ( false );
+    if ( strlen( name ) >= MAX_SYM_NAME_SIZE ) return ( false );
+
+    for ( const char *p = name + 1; *p != 0; p++ ) {
+
+        if ( ! (( isalnum((uint8_t) *p )) || ( *p == '_' ))) return ( false );
+    }
+
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Parse a quoted string with the escape characters "\n", "\t", "\r", "\0", "\\" and
+// "\"". The result length is returned, -1 for a malformed string.
+//
+//----------------------------------------------------------------------------------------
+int parseString( const char *str, uint8_t *buf, int bufLen ) {
+
+    int len = 0;
+
+    if ( *str++ != '"' ) return ( -1 );
+
+    while (( *str != 0 ) && ( *str != '"' ) && ( len < bufLen )) {
+
+        if ( *str == '\\' ) {
+
+            str++;
+
+            switch ( *str ) {
+
+                case 'n':   buf[ len++ ] = '\n';    break;
+                case 't':   buf[ len++ ] = '\t';    break;
+                case 'r':   buf[ len++ ] = '\r';    break;
+                case '0':   buf[ len++ ] = 0;       break;
+                case '\\':  buf[ len++ ] = '\\';    break;
+                case '"':   buf[ len++ ] = '"';     break;
+                default:    return ( -1 );
+            }
+        }
+        else buf[ len++ ] = (uint8_t) *str;
+
+        str++;
+    }
+
+    if (( *str != '"' ) || ( str[ 1 ] != 0 )) return ( -1 );
+    return ( len );
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------------------
+// An assembler section. The base address is fixed by the first pass. The section
+// data buffer is allocated for the second pass with the size from the first pass.
+//
+//----------------------------------------------------------------------------------------
+struct T64AsmSection {
+
+    char        name[ MAX_SECTION_NAME_SIZE ];
+    uint32_t    flags;
+    T64Word     base;
+    T64Word     loc;
+    T64Word     size;
+    bool        started;
+    uint8_t     *data;
+};
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// The symbol table.
+//
+//----------------------------------------------------------------------------------------
+// The symbol table object. The symbol array, the hash slots and the name pool grow as
+// needed. We start with empty tables.
+//
+//----------------------------------------------------------------------------------------
+T64AsmSymTab::T64AsmSymTab( ) { }
+
+T64AsmSymTab::~T64AsmSymTab( ) {
+
+    free( syms );
+    free( slots );
+    free( namePool );
+}
+
+//----------------------------------------------------------------------------------------
+// Remove all symbols. The allocated tables are kept.
+//
+//----------------------------------------------------------------------------------------
+void T64AsmSymTab::reset( ) {
+
+    symCount    = 0;
+    namePoolLen = 0;
+    scope[ 0 ]  = 0;
+
+    for ( int i = 0; i < slotMax; i++ ) slots[ i ] = -1;
+}
+
+//----------------------------------------------------------------------------------------
+// Set the scope for local labels. This is the name of the last global label.
+//
+//----------------------------------------------------------------------------------------
+void T64AsmSymTab::setScope( const char *name ) {
+
+    strncpy( scope, name, sizeof( scope ) - 1 );
+    scope[ sizeof( scope ) - 1 ] = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// Build the full symbol name. A local label is prefixed with the scope. The name is
+// upshifted. We return false if the name does not fit.
+//
+//----------------------------------------------------------------------------------------
+bool T64AsmSymTab::qualifyName( char *buf, int bufLen, const char *name ) {
+
+    int len = 0;
+
+    if ( name[ 0 ] == '@' ) len = snprintf( buf, bufLen, "%s%s", scope, name );
+    else                    len = snprintf( buf, bufLen, "%s", name );
+
+    if (( len < 0 ) || ( len >= bufLen )) return ( false );
+
+    for ( char *p = buf; *p != 0; p++ ) *p = (char) toupper((uint8_t) *p );
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Find the hash slot for a name. It is either the slot with the symbol index or the
+// first free slot. The stored hash value saves most of the name compares.
+//
+//----------------------------------------------------------------------------------------
+int T64AsmSymTab::findSlot( const char *name, uint32_t hash ) {
+
+    uint32_t mask = slotMax - 1;
+    uint32_t i    = hash & mask;
+
+    while ( slots[ i ] != -1 ) {
+
+        T64AsmSymbol *sym = &syms[ slots[ i ]];
+
+        if (( sym -> hash == hash ) &&
+            ( strcmp( namePool + sym -> nameOfs, name ) == 0 )) return ( i );
+
+        i = ( i + 1 ) & mask;
+    }
+
+    return ( i );
+}
+
+//----------------------------------------------------------------------------------------
+// Double the hash slots and enter all symbols again. The table is kept at most half
+// full.
+//
+//----------------------------------------------------------------------------------------
+void T64AsmSymTab::growSlots( ) {
+
+    slotMax = ( slotMax == 0 ) ? INIT_SYM_SLOTS : slotMax * 2;
+    slots   = (int *) realloc( slots, slotMax * sizeof( int ));
+
+    for ( int i = 0; i < slotMax; i++ ) slots[ i ] = -1;
+
+    for ( int s = 0; s < symCount; s++ ) {
+
+        uint32_t i = syms[ s ].hash & ( slotMax - 1 );
+
+        while ( slots[ i ] != -1 ) i = ( i + 1 ) & ( slotMax - 1 );
+        slots[ i ] = s;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Look up a symbol. We return the symbol index or -1 if not found.
+//
+//----------------------------------------------------------------------------------------
+int T64AsmSymTab::lookup( const char *name ) {
+
+    char fullName[ sizeof( scope ) + MAX_SYM_NAME_SIZE ];
+
+    if (( slotMax == 0 ) || ( ! qualifyName( fullName, sizeof( fullName ), name ))) {
+
+        return ( -1 );
+    }
+
+    return ( slots[ findSlot( fullName, hashName( fullName )) ] );
+}
+
+//----------------------------------------------------------------------------------------
+// Enter a symbol. If the symbol exists, we return its index. Otherwise a new and
+// undefined symbol is added. A name that does not fit returns -1.
+//
+//----------------------------------------------------------------------------------------
+int T64AsmSymTab::enter( const char *name ) {
+
+    char fullName[ sizeof( scope ) + MAX_SYM_NAME_SIZE ];
+
+    if ( ! qualifyName( fullName, sizeof( fullName ), name )) return ( -1 );
+
+    if (( symCount + 1 ) * 2 > slotMax ) growSlots( );
+
+    uint32_t    hash    = hashName( fullName );
+    int         slot    = findSlot( fullName, hash );
+    int         nameLen = (int) strlen( fullName ) + 1;
+
+    if ( slots[ slot ] != -1 ) return ( slots[ slot ] );
+
+    if ( symCount == symMax ) {
+
+        symMax  = ( symMax == 0 ) ? INIT_SYM_SLOTS : symMax * 2;
+        syms    = (T64AsmSymbol *) realloc( syms, symMax * sizeof( T64AsmSymbol ));
+    }
+
+    if ( namePoolLen + nameLen > namePoolMax ) {
+
+        while ( namePoolLen + nameLen > namePoolMax ) {
+
+            namePoolMax = ( namePoolMax == 0 ) ? INIT_NAME_POOL_SIZE : namePoolMax * 2;
+        }
+
+        namePool = (char *) realloc( namePool, namePoolMax );
+    }
+
+    memcpy( namePool + namePoolLen, fullName, nameLen );
+
+    syms[ symCount ]            = T64AsmSymbol( );
+    syms[ symCount ].nameOfs    = namePoolLen;
+    syms[ symCount ].hash       = hash;
+
+    namePoolLen     += nameLen;
+    slots[ slot ]   = symCount;
+    return ( symCount ++ );
+}
+
+//----------------------------------------------------------------------------------------
+// Symbol table access functions.
+//
+//----------------------------------------------------------------------------------------
+int T64AsmSymTab::getCount( ) {
+
+    return ( symCount );
+}
+
+T64AsmSymbol *T64AsmSymTab::getSymbol( int index ) {
+
+    if (( index >= 0 ) && ( index < symCount )) return ( &syms[ index ] );
+    else return ( nullptr );
+}
+
+const char *T64AsmSymTab::getName( int index ) {
+
+    if (( index >= 0 ) && ( index < symCount )) return ( namePool + syms[ index ].nameOfs );
+    else return ( "" );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// The file assembler.
+//
+//----------------------------------------------------------------------------------------
+// The file assembler object. Errors are written to the "errOut" file, which may be
+// a null pointer for just counting the errors.
+//
+//----------------------------------------------------------------------------------------
+T64FileAssemble::T64FileAssemble( FILE *errOut ) {
+
+    this -> errOut  = errOut;
+    sections        = (T64AsmSection *) calloc( MAX_ASM_SECTIONS, sizeof( T64AsmSection ));
+
+    doAsm.setSymTab( &symTab );
+}
+
+T64FileAssemble::~T64FileAssemble( ) {
+
+    for ( int i = 0; i < sectionCount; i++ ) free( sections[ i ].data );
+    free( sections );
+}
+
+//----------------------------------------------------------------------------------------
+// Report an error with the file name and line number. Errors found after a pass have
+// no line number.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::reportError( const char *fmt, ... ) {
+
+    errCount ++;
+
+    if ( errOut != nullptr ) {
+
+        va_list args;
+
+        va_start( args, fmt );
+
+        if ( lineNum > 0 ) fprintf( errOut, "%s:%d: error: ", srcFileName, lineNum );
+        else               fprintf( errOut, "%s: error: ", srcFileName );
+
+        vfprintf( errOut, fmt, args );
+        fprintf( errOut, "\n" );
+        va_end( args );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Assemble a source file. We run the first pass, check the sections and run the
+// second pass. The second pass only runs when the first pass had no errors. We
+// return the number of errors.
+//
+//----------------------------------------------------------------------------------------
+int T64FileAssemble::assembleFile( const char *srcFileName ) {
+
+    for ( int i = 0; i < sectionCount; i++ ) free( sections[ i ].data );
+
+    this -> srcFileName = srcFileName;
+    errCount            = 0;
+    sectionCount        = 0;
+    entryAdr            = 0;
+    entrySet            = false;
+
+    symTab.reset( );
+
+    if ( ! runPass( 1 )) return ( errCount );
+
+    checkPassOne( );
+    if ( errCount > 0 ) return ( errCount );
+
+    for ( int i = 0; i < sectionCount; i++ ) {
+
+        T64AsmSection *sec = &sections[ i ];
+
+        if ( ! ( sec -> flags & SF_NOBITS )) {
+
+            sec -> data = (uint8_t *) calloc(( sec -> size + 3 ) & ~3, 1 );
+        }
+    }
+
+    runPass( 2 );
+
+    if (( ! entrySet ) && ( sectionCount > 0 )) entryAdr = sections[ 0 ].base;
+    return ( errCount );
+}
+
+//----------------------------------------------------------------------------------------
+// Run one pass over the source file. The file is read line by line. Each pass starts
+// with the location counters at the section base addresses.
+//
+//----------------------------------------------------------------------------------------
+bool T64FileAssemble::runPass( int pass ) {
+
+    char    line[ MAX_ASM_LINE_SIZE ];
+    FILE    *srcFile = fopen( srcFileName, "r" );
+
+    this -> pass    = pass;
+    lineNum         = 0;
+    curSection      = -1;
+
+    if ( srcFile == nullptr ) {
+
+        reportError( "Cannot open source file" );
+        return ( false );
+    }
+
+    symTab.setScope( "" );
+
+    for ( int i = 0; i < sectionCount; i++ ) {
+
+        sections[ i ].loc       = sections[ i ].base;
+        sections[ i ].started   = false;
+    }
+
+    while ( fgets( line, sizeof( line ), srcFile ) != nullptr ) {
+
+        size_t len = strlen( line );
+
+        lineNum ++;
+
+        if (( len == sizeof( line ) - 1 ) && ( line[ len - 1 ] != '\n' )) {
+
+            int ch;
+            while ((( ch = fgetc( srcFile )) != EOF ) && ( ch != '\n' ));
+
+            reportError( "Line too long" );
+            continue;
+        }
+
+        assembleLine( line );
+    }
+
+    fclose( srcFile );
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Checks after the first pass. Global symbols must be defined, sections must fit into
+// physical memory and must not overlap.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::checkPassOne( ) {
+
+    lineNum = 0;
+
+    for ( int i = 0; i < symTab.getCount( ); i++ ) {
+
+        T64AsmSymbol *sym = symTab.getSymbol( i );
+
+        if (( sym -> global ) && ( ! sym -> defined )) {
+
+            reportError( "Undefined global symbol: %s", symTab.getName( i ));
+        }
+    }
+
+    for ( int i = 0; i < sectionCount; i++ ) {
+
+        T64AsmSection *a = &sections[ i ];
+
+        if (( a -> base < 0 ) ||
+            ( a -> size > MAX_SECTION_SIZE ) ||
+            ( a -> base + a -> size > T64_MAX_PHYS_MEM_LIMIT )) {
+
+            reportError( "Section \"%s\" exceeds memory limits", a -> name );
+            continue;
+        }
+
+        for ( int j = 0; j < i; j++ ) {
+
+            T64AsmSection *b = &sections[ j ];
+
+            if (( a -> size > 0 ) && ( b -> size > 0 ) &&
+                ( a -> base < b -> base + b -> size ) &&
+                ( b -> base < a -> base + a -> size )) {
+
+                reportError( "Sections \"%s\" and \"%s\" overlap", b -> name, a -> name );
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Assemble one source line. We remove the comment, define the label, if any, and
+// hand the rest to the directive parser or the one line assembler. In the first
+// pass, an instruction just advances the location counter.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::assembleLine( char *line ) {
+
+    char *p = line;
+
+    stripComment( line );
+    while ( isspace((uint8_t) *p )) p++;
+
+    if (( isalpha((uint8_t) *p )) || ( *p == '@' )) {
+
+        char *q = p + 1;
+        while (( isalnum((uint8_t) *q )) || ( *q == '_' )) q++;
+
+        if ( *q == ':' ) {
+
+            *q = 0;
+            defineLabel( p );
+
+            p = q + 1;
+            while ( isspace((uint8_t) *p )) p++;
+        }
+    }
+
+    if ( *p == 0 ) return;
+
+    if ( *p == '.' ) {
+
+        parseDirective( p );
+        return;
+    }
+
+    useDefaultSection( );
+
+    T64AsmSection   *sec    = &sections[ curSection ];
+    uint32_t        instr   = 0;
+
+    if ( sec -> flags & SF_NOBITS ) {
+
+        reportError( "Instruction in section without data" );
+        return;
+    }
+
+    if (( sec -> loc & 3 ) != 0 ) {
+
+        reportError( "Instruction is not word aligned" );
+        return;
+    }
+
+    if ( pass == 2 ) {
+
+        doAsm.setLocation( sec -> loc );
+
+        if ( doAsm.assembleInstr( p, &instr ) != 0 ) {
+
+            reportError( "%s", doAsm.getErrStr( doAsm.getErrId( )));
+        }
+    }
+
+    emitValue( instr, 4 );
+}
+
+//----------------------------------------------------------------------------------------
+// Define a label with the current location. A global label also sets the scope for
+// the local labels that follow. Labels are defined in the first pass, the second pass
+// only tracks the scope.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::defineLabel( char *name ) {
+
+    if ( ! isValidSymName( name )) {
+
+        reportError( "Invalid label name: %s", name );
+        return;
+    }
+
+    if ( doAsm.isReservedWord( name )) {
+
+        reportError( "Reserved word used as label: %s", name );
+        return;
+    }
+
+    if ( name[ 0 ] != '@' ) symTab.setScope( name );
+
+    useDefaultSection( );
+    sections[ curSection ].started = true;
+
+    if ( pass == 1 ) {
+
+        int             index   = symTab.enter( name );
+        T64AsmSymbol    *sym    = symTab.getSymbol( index );
+
+        if ( sym == nullptr ) {
+
+            reportError( "Invalid label name: %s", name );
+        }
+        else if ( sym -> defined ) {
+
+            reportError( "Duplicate symbol: %s", symTab.getName( index ));
+        }
+        else {
+
+            sym -> val          = sections[ curSection ].loc;
+            sym -> sectionIndex = curSection;
+            sym -> defined      = true;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Parse a directive. We isolate the directive name and dispatch with the rest of the
+// line as argument string.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::parseDirective( char *str ) {
+
+    char    dirName[ 16 ]   = { 0 };
+    int     len             = 0;
+    char    *p              = str + 1;
+
+    while (( isalnum((uint8_t) *p )) || ( *p == '_' )) {
+
+        if ( len + 1 < (int) sizeof( dirName )) dirName[ len++ ] = *p;
+        p++;
+    }
+
+    int index = DirHash.lookup( DirTab, dirName );
+
+    if (( len == 0 ) || ( index < 0 ) || (( *p != 0 ) && ( ! isspace((uint8_t) *p )))) {
+
+        reportError( "Unknown directive: %s", str );
+        return;
+    }
+
+    switch ( DirTab[ index ].id ) {
+
+        case DIR_SECTION:   directiveSection( p );          break;
+        case DIR_ORG:       directiveOrg( p );              break;
+        case DIR_ALIGN:     directiveAlign( p );            break;
+        case DIR_BYTE:      directiveData( p, 1 );          break;
+        case DIR_HALF:      directiveData( p, 2 );          break;
+        case DIR_WORD:      directiveData( p, 4 );          break;
+        case DIR_DWORD:     directiveData( p, 8 );          break;
+        case DIR_ASCII:     directiveString( p, false );    break;
+        case DIR_ASCIZ:     directiveString( p, true );     break;
+        case DIR_SPACE:     directiveSpace( p );            break;
+        case DIR_EQU:       directiveEqu( p );              break;
+        case DIR_GLOBAL:    directiveGlobal( p );           break;
+        case DIR_ENTRY:     directiveEntry( p );            break;
+        default: ;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Evaluate an expression operand with the one line assembler expression parser. The
+// location counter is the one of the current section. Errors are reported here.
+//
+//----------------------------------------------------------------------------------------
+bool T64FileAssemble::evalOperand( char *str, T64Word *val ) {
+
+    doAsm.setLocation(( curSection >= 0 ) ? sections[ curSection ].loc : 0 );
+
+    if ( doAsm.evalExpr( str, val ) != 0 ) {
+
+        reportError( "%s", doAsm.getErrStr( doAsm.getErrId( )));
+        return ( false );
+    }
+
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Emit data at the current location. A null data pointer just advances the location
+// counter, the section buffer is zeroed. In the first pass we only track the size.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::emitBytes( const uint8_t *data, T64Word len ) {
+
+    useDefaultSection( );
+
+    T64AsmSection *sec = &sections[ curSection ];
+
+    if (( data != nullptr ) && ( sec -> flags & SF_NOBITS )) {
+
+        reportError( "Data in section without data" );
+        return;
+    }
+
+    if (( pass == 2 ) && ( data != nullptr )) {
+
+        T64Word ofs = sec -> loc - sec -> base;
+
+        if (( ofs < 0 ) || ( ofs + len > sec -> size )) {
+
+            reportError( "Location differs between passes" );
+            return;
+        }
+
+        memcpy( sec -> data + ofs, data, len );
+    }
+
+    sec -> loc      += len;
+    sec -> started  = true;
+
+    if (( pass == 1 ) && ( sec -> loc - sec -> base > sec -> size )) {
+
+        sec -> size = sec -> loc - sec -> base;
+    }
+}
+
+void T64FileAssemble::emitValue( T64Word val, int size ) {
+
+    uint8_t buf[ 8 ];
+
+    putBigEndian( buf, (uint64_t) val, size );
+    emitBytes( buf, size );
+}
+
+//----------------------------------------------------------------------------------------
+// Select a section, creating it if needed. A new section starts at the end of the
+// previously created section, aligned to a double word.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::selectSection( const char *name, uint32_t flags ) {
+
+    for ( int i = 0; i < sectionCount; i++ ) {
+
+        if ( strcmp( sections[ i ].name, name ) == 0 ) {
+
+            curSection = i;
+            return;
+        }
+    }
+
+    if ( sectionCount >= MAX_ASM_SECTIONS ) {
+
+        reportError( "Too many sections" );
+        return;
+    }
+
+    if ( flags == SF_BY_NAME ) {
+
+        if      ( strncmp( name, ".text", 5 ) == 0 ) flags = SF_EXEC;
+        else if ( strncmp( name, ".bss", 4 )  == 0 ) flags = SF_WRITE | SF_NOBITS;
+        else if ( strncmp( name, ".data", 5 ) == 0 ) flags = SF_WRITE;
+        else                                         flags = SF_NIL;
+    }
+
+    T64AsmSection *sec = &sections[ sectionCount ];
+
+    strcpy( sec -> name, name );
+    sec -> flags    = flags;
+    sec -> base     = 0;
+    sec -> size     = 0;
+    sec -> started  = false;
+    sec -> data     = nullptr;
+
+    if ( sectionCount > 0 ) sec -> base = ( sections[ sectionCount - 1 ].loc + 7 ) & ~7;
+
+    sec -> loc = sec -> base;
+    curSection = sectionCount ++;
+}
+
+//----------------------------------------------------------------------------------------
+// Code and data before any ".SECTION" directive go to the ".text" section.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::useDefaultSection( ) {
+
+    if ( curSection < 0 ) selectSection( ".text", SF_BY_NAME );
+}
+
+//----------------------------------------------------------------------------------------
+// ".SECTION" selects a section. The optional flags string is only used when the
+// section is created.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::directiveSection( char *args ) {
+
+    char        name[ MAX_ASM_LINE_SIZE ];
+    char        flagStr[ MAX_ASM_LINE_SIZE ];
+    uint8_t     flagBuf[ 8 ];
+    uint32_t    flags = SF_BY_NAME;
+
+    if (( ! nextOperand( &args, name, sizeof( name ))) ||
+        ( name[ 0 ] == 0 ) ||
+        ( strlen( name ) >= MAX_SECTION_NAME_SIZE )) {
+
+        reportError( "Expected a section name" );
+        return;
+    }
+
+    if ( nextOperand( &args, flagStr, sizeof( flagStr ))) {
+
+        int len = parseString( flagStr, flagBuf, sizeof( flagBuf ));
+
+        if ( len < 0 ) {
+
+            reportError( "Expected a section flags string" );
+            return;
+        }
+
+        flags = SF_NIL;
+
+        for ( int i = 0; i < len; i++ ) {
+
+            switch ( tolower( flagBuf[ i ] )) {
+
+                case 'w': flags |= SF_WRITE;    break;
+                case 'x': flags |= SF_EXEC;     break;
+                case 'b': flags |= SF_NOBITS;   break;
+
+                default: {
+
+                    reportError( "Invalid section flag: %c", flagBuf[ i ] );
+                    return;
+                }
+            }
+        }
+    }
+
+    selectSection( name, flags );
+}
+
+//----------------------------------------------------------------------------------------
+// ".ORG" sets the location counter. As the first thing in a section, it sets the
+// section base address. Otherwise the location counter can only move forward.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::directiveOrg( char *args ) {
+
+    T64Word adr = 0;
+
+    if ( ! evalOperand( args, &adr )) return;
+
+    useDefaultSection( );
+
+    T64AsmSection *sec = &sections[ curSection ];
+
+    if ( ! sec -> started ) {
+
+        sec -> base     = adr;
+        sec -> loc      = adr;
+        sec -> started  = true;
+    }
+    else if ( adr < sec -> loc ) {
+
+        reportError( "Location counter cannot move backward" );
+    }
+    else emitBytes( nullptr, adr - sec -> loc );
+}
+
+//----------------------------------------------------------------------------------------
+// ".ALIGN" aligns the location counter to a power of two.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::directiveAlign( char *args ) {
+
+    T64Word align = 0;
+
+    if ( ! evalOperand( args, &align )) return;
+
+    if (( align <= 0 ) || (( align & ( align - 1 )) != 0 )) {
+
+        reportError( "Alignment must be a power of two" );
+        return;
+    }
+
+    useDefaultSection( );
+    emitBytes( nullptr, ( - sections[ curSection ].loc ) & ( align - 1 ));
+}
+
+//----------------------------------------------------------------------------------------
+// ".BYTE", ".HALF", ".WORD" and ".DWORD" emit a list of values. A value must fit
+// into the data size, either signed or unsigned. The values are evaluated in the
+// second pass, so they can refer to labels defined later.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::directiveData( char *args, int size ) {
+
+    char    buf[ MAX_ASM_LINE_SIZE ];
+    int     count = 0;
+
+    while ( nextOperand( &args, buf, sizeof( buf ))) {
+
+        T64Word val = 0;
+
+        if (( pass == 2 ) && ( evalOperand( buf, &val ))) {
+
+            if ( size < 8 ) {
+
+                T64Word limit = (T64Word) 1 << ( size * 8 );
+
+                if (( val < - ( limit / 2 )) || ( val >= limit )) {
+
+                    reportError( "Value does not fit into %d bytes", size );
+                }
+            }
+        }
+
+        emitValue( val, size );
+        count ++;
+    }
+
+    if ( count == 0 ) reportError( "Expected a value" );
+}
+
+//----------------------------------------------------------------------------------------
+// ".ASCII" and ".ASCIZ" emit a list of strings. ".ASCIZ" adds a zero byte to each
+// string.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::directiveString( char *args, bool addZero ) {
+
+    char    buf[ MAX_ASM_LINE_SIZE ];
+    uint8_t strBuf[ MAX_ASM_LINE_SIZE ];
+    int     count = 0;
+
+    while ( nextOperand( &args, buf, sizeof( buf ))) {
+
+        int len = parseString( buf, strBuf, sizeof( strBuf ) - 1 );
+
+        if ( len < 0 ) {
+
+            reportError( "Expected a string" );
+            return;
+        }
+
+        if ( addZero ) strBuf[ len++ ] = 0;
+
+        emitBytes( strBuf, len );
+        count ++;
+    }
+
+    if ( count == 0 ) reportError( "Expected a string" );
+}
+
+//----------------------------------------------------------------------------------------
+// ".SPACE" reserves a number of zeroed bytes.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::directiveSpace( char *args ) {
+
+    T64Word len = 0;
+
+    if ( ! evalOperand( args, &len )) return;
+
+    if (( len < 0 ) || ( len > MAX_SECTION_SIZE )) {
+
+        reportError( "Invalid space size" );
+        return;
+    }
+
+    emitBytes( nullptr, len );
+}
+
+//----------------------------------------------------------------------------------------
+// ".EQU" defines an absolute symbol in the first pass.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::directiveEqu( char *args ) {
+
+    char name[ MAX_ASM_LINE_SIZE ];
+    char expr[ MAX_ASM_LINE_SIZE ];
+
+    if (( ! nextOperand( &args, name, sizeof( name ))) ||
+        ( ! nextOperand( &args, expr, sizeof( expr )))) {
+
+        reportError( "Expected a name and a value" );
+        return;
+    }
+
+    if (( ! isValidSymName( name )) || ( doAsm.isReservedWord( name ))) {
+
+        reportError( "Invalid symbol name: %s", name );
+        return;
+    }
+
+    if ( pass == 1 ) {
+
+        T64Word val = 0;
+
+        if ( ! evalOperand( expr, &val )) return;
+
+        int             index   = symTab.enter( name );
+        T64AsmSymbol    *sym    = symTab.getSymbol( index );
+
+        if ( sym -> defined ) {
+
+            reportError( "Duplicate symbol: %s", symTab.getName( index ));
+        }
+        else {
+
+            sym -> val          = val;
+            sym -> sectionIndex = -1;
+            sym -> defined      = true;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// ".GLOBAL" marks symbols as global in the ELF symbol table.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::directiveGlobal( char *args ) {
+
+    char name[ MAX_ASM_LINE_SIZE ];
+
+    while ( nextOperand( &args, name, sizeof( name ))) {
+
+        if (( ! isValidSymName( name )) || ( name[ 0 ] == '@' )) {
+
+            reportError( "Invalid symbol name: %s", name );
+            continue;
+        }
+
+        if ( pass == 1 ) symTab.getSymbol( symTab.enter( name )) -> global = true;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// ".ENTRY" sets the program entry address. Without this directive, the entry address
+// is the start of the first section.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::directiveEntry( char *args ) {
+
+    if (( pass == 2 ) && ( evalOperand( args, &entryAdr ))) entrySet = true;
+}
+
+//----------------------------------------------------------------------------------------
+// Write the ELF file. The file layout is the ELF header, the program headers, the
+// section data, the symbol table, the string tables and the section headers. The
+// file offset of each section is congruent to its address modulo eight, so that
+// the segment alignment is always valid. The simulator loads segments by words, so
+// the segment data is padded to a word size. Local symbols come before the global
+// ones.
+//
+//----------------------------------------------------------------------------------------
+int T64FileAssemble::writeElfFile( const char *elfFileName ) {
+
+    ElfBuf      file;
+    ElfBuf      symTabBuf;
+    ElfBuf      strTab;
+    ElfBuf      shStrTab;
+    uint64_t    secOfs[ MAX_ASM_SECTIONS ]      = { 0 };
+    uint32_t    secName[ MAX_ASM_SECTIONS ]     = { 0 };
+    int         phNum                           = 0;
+    int         shNum                           = sectionCount + 4;
+    int         symTabIndex                     = sectionCount + 1;
+    int         firstGlobal                     = 1;
+
+    lineNum = 0;
+
+    for ( int i = 0; i < sectionCount; i++ ) {
+
+        if ( sections[ i ].size > 0 ) phNum ++;
+    }
+
+    file.reserve( ELF_EHDR_SIZE + phNum * ELF_PHDR_SIZE );
+
+    for ( int i = 0; i < sectionCount; i++ ) {
+
+        T64AsmSection *sec = &sections[ i ];
+
+        if ( sec -> flags & SF_NOBITS ) continue;
+
+        while (( file.len & 7 ) != ( sec -> base & 7 )) file.reserve( 1 );
+
+        secOfs[ i ] = file.len;
+        file.appendBytes( sec -> data, ( sec -> size + 3 ) & ~3 );
+    }
+
+    symTabBuf.reserve( ELF_SYM_SIZE );
+    addElfString( &strTab, "" );
+
+    for ( int global = 0; global <= 1; global++ ) {
+
+        if ( global ) firstGlobal = (int) ( symTabBuf.len / ELF_SYM_SIZE );
+
+        for ( int i = 0; i < symTab.getCount( ); i++ ) {
+
+            T64AsmSymbol *sym = symTab.getSymbol( i );
+
+            if (( ! sym -> defined ) || ( sym -> global != ( global == 1 ))) continue;
+
+            uint8_t bind = ( sym -> global ) ? ELF_STB_GLOBAL : ELF_STB_LOCAL;
+
+            symTabBuf.appendVal( addElfString( &strTab, symTab.getName( i )), 4 );
+            symTabBuf.appendVal( bind << 4, 1 );
+            symTabBuf.appendVal( 0, 1 );
+            symTabBuf.appendVal(( sym -> sectionIndex < 0 ) ?
+                                ELF_SHN_ABS : sym -> sectionIndex + 1, 2 );
+            symTabBuf.appendVal( sym -> val, 8 );
+            symTabBuf.appendVal( 0, 8 );
+        }
+    }
+
+    addElfString( &shStrTab, "" );
+    for ( int i = 0; i < sectionCount; i++ ) {
+
+        secName[ i ] = addElfString( &shStrTab, sections[ i ].name );
+    }
+
+    uint32_t symTabName     = addElfString( &shStrTab, ".symtab" );
+    uint32_t strTabName     = addElfString( &shStrTab, ".strtab" );
+    uint32_t shStrTabName   = addElfString( &shStrTab, ".shstrtab" );
+
+    file.alignTo( 8 );
+    uint64_t symTabOfs = file.len;
+    file.appendBytes( symTabBuf.data, symTabBuf.len );
+
+    uint64_t strTabOfs = file.len;
+    file.appendBytes( strTab.data, strTab.len );
+
+    uint64_t shStrTabOfs = file.len;
+    file.appendBytes( shStrTab.data, shStrTab.len );
+
+    file.alignTo( 8 );
+    uint64_t shOfs = file.len;
+
+    //------------------------------------------------------------------------------------
+    // The section headers. Index zero is the null section.
+    //
+    //------------------------------------------------------------------------------------
+    file.reserve( ELF_SHDR_SIZE );
+
+    for ( int i = 0; i < sectionCount; i++ ) {
+
+        T64AsmSection   *sec    = &sections[ i ];
+        uint64_t        flags   = ELF_SHF_ALLOC;
+
+        if ( sec -> flags & SF_WRITE ) flags |= ELF_SHF_WRITE;
+        if ( sec -> flags & SF_EXEC  ) flags |= ELF_SHF_EXECINSTR;
+
+        file.appendVal( secName[ i ], 4 );
+        file.appendVal(( sec -> flags & SF_NOBITS ) ? ELF_SHT_NOBITS : ELF_SHT_PROGBITS, 4 );
+        file.appendVal( flags, 8 );
+        file.appendVal( sec -> base, 8 );
+        file.appendVal( secOfs[ i ], 8 );
+        file.appendVal( sec -> size, 8 );
+        file.appendVal( 0, 4 );
+        file.appendVal( 0, 4 );
+        file.appendVal(( sec -> flags & SF_EXEC ) ? 4 : 1, 8 );
+        file.appendVal( 0, 8 );
+    }
+
+    file.appendVal( symTabName, 4 );
+    file.appendVal( ELF_SHT_SYMTAB, 4 );
+    file.appendVal( 0, 8 );
+    file.appendVal( 0, 8 );
+    file.appendVal( symTabOfs, 8 );
+    file.appendVal( symTabBuf.len, 8 );
+    file.appendVal( symTabIndex + 1, 4 );
+    file.appendVal( firstGlobal, 4 );
+    file.appendVal( 8, 8 );
+    file.appendVal( ELF_SYM_SIZE, 8 );
+
+    file.appendVal( strTabName, 4 );
+    file.appendVal( ELF_SHT_STRTAB, 4 );
+    file.appendVal( 0, 8 );
+    file.appendVal( 0, 8 );
+    file.appendVal( strTabOfs, 8 );
+    file.appendVal( strTab.len, 8 );
+    file.appendVal( 0, 4 );
+    file.appendVal( 0, 4 );
+    file.appendVal( 1, 8 );
+    file.appendVal( 0, 8 );
+
+    file.appendVal( shStrTabName, 4 );
+    file.appendVal( ELF_SHT_STRTAB, 4 );
+    file.appendVal( 0, 8 );
+    file.appendVal( 0, 8 );
+    file.appendVal( shStrTabOfs, 8 );
+    file.appendVal( shStrTab.len, 8 );
+    file.appendVal( 0, 4 );
+    file.appendVal( 0, 4 );
+    file.appendVal( 1, 8 );
+    file.appendVal( 0, 8 );
+
+    //------------------------------------------------------------------------------------
+    // The program headers, one loadable segment for each section with a size.
+    //
+    //------------------------------------------------------------------------------------
+    uint8_t *ph = file.data + ELF_EHDR_SIZE;
+
+    for ( int i = 0; i < sectionCount; i++ ) {
+
+        T64AsmSection   *sec    = &sections[ i ];
+        uint32_t        flags   = ELF_PF_R;
+        bool            noBits  = ( sec -> flags & SF_NOBITS );
+
+        if ( sec -> size == 0 ) continue;
+
+        if ( sec -> flags & SF_WRITE ) flags |= ELF_PF_W;
+        if ( sec -> flags & SF_EXEC  ) flags |= ELF_PF_X;
+
+        putBigEndian( ph +  0, ELF_PT_LOAD, 4 );
+        putBigEndian( ph +  4, flags, 4 );
+        putBigEndian( ph +  8, secOfs[ i ], 8 );
+        putBigEndian( ph + 16, sec -> base, 8 );
+        putBigEndian( ph + 24, sec -> base, 8 );
+        putBigEndian( ph + 32, ( noBits ) ? 0 : (( sec -> size + 3 ) & ~3 ), 8 );
+        putBigEndian( ph + 40, ( noBits ) ? sec -> size : (( sec -> size + 3 ) & ~3 ), 8 );
+        putBigEndian( ph + 48, 8, 8 );
+        ph += ELF_PHDR_SIZE;
+    }
+
+    //------------------------------------------------------------------------------------
+    // The ELF header. Class 64-bit, big endian data, current version.
+    //
+    //------------------------------------------------------------------------------------
+    uint8_t *eh = file.data;
+
+    eh[ 0 ] = 0x7f;
+    eh[ 1 ] = 'E';
+    eh[ 2 ] = 'L';
+    eh[ 3 ] = 'F';
+    eh[ 4 ] = 2;
+    eh[ 5 ] = 2;
+    eh[ 6 ] = 1;
+
+    putBigEndian( eh + 16, ELF_ET_EXEC, 2 );
+    putBigEndian( eh + 18, ELF_EM_NONE, 2 );
+    putBigEndian( eh + 20, 1, 4 );
+    putBigEndian( eh + 24, entryAdr, 8 );
+    putBigEndian( eh + 32, ( phNum > 0 ) ? ELF_EHDR_SIZE : 0, 8 );
+    putBigEndian( eh + 40, shOfs, 8 );
+    putBigEndian( eh + 48, 0, 4 );
+    putBigEndian( eh + 52, ELF_EHDR_SIZE, 2 );
+    putBigEndian( eh + 54, ELF_PHDR_SIZE, 2 );
+    putBigEndian( eh + 56, phNum, 2 );
+    putBigEndian( eh + 58, ELF_SHDR_SIZE, 2 );
+    putBigEndian( eh + 60, shNum, 2 );
+    putBigEndian( eh + 62, shNum - 1, 2 );
+
+    FILE *elfFile = fopen( elfFileName, "wb" );
+
+    if ( elfFile == nullptr ) {
+
+        reportError( "Cannot open output file: %s", elfFileName );
+        return ( errCount );
+    }
+
+    if ( fwrite( file.data, 1, file.len, elfFile ) != file.len ) {
+
+        reportError( "Cannot write output file: %s", elfFileName );
+    }
+
+    fclose( elfFile );
+    return ( errCount );
+}
+
+//----------------------------------------------------------------------------------------
+// Print the symbol table, in the order of definition.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::printSymbols( FILE *out ) {
+
+    for ( int i = 0; i < symTab.getCount( ); i++ ) {
+
+        T64AsmSymbol *sym = symTab.getSymbol( i );
+
+        if ( ! sym -> defined ) continue;
+
+        fprintf( out, "%-32s 0x%016llx %-12s %s\n",
+                 symTab.getName( i ),
+                 (unsigned long long) sym -> val,
+                 ( sym -> sectionIndex < 0 ) ? "ABS" : sections[ sym -> sectionIndex ].name,
+                 ( sym -> global ) ? "GLOBAL" : "" );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Print a listing of the executable sections. The section data is disassembled in 
+// blocks of instruction words, each block is formatted with one disassembler call.
+// The section data is in big endian byte order.
+//
+//----------------------------------------------------------------------------------------
+void T64FileAssemble::printListing( FILE *out ) {
+
+    const int       BLOCK_SIZE  = 256;
+    const int       LINE_LEN    = 64;
+
+    T64DisAssemble  disAsm;
+    uint32_t        instr[ BLOCK_SIZE ];
+    char            buf[ BLOCK_SIZE * LINE_LEN ];
+
+    for ( int s = 0; s < sectionCount; s++ ) {
+
+        T64AsmSection *sec = &sections[ s ];
+
+        if (( ! ( sec -> flags & SF_EXEC )) || ( sec -> data == nullptr )) continue;
+
+        fprintf( out, "Section %s:\n", sec -> name );
+
+        T64Word words = ( sec -> size + 3 ) / 4;
+
+        for ( T64Word w = 0; w < words; w += BLOCK_SIZE ) {
+
+            int count = ( words - w < BLOCK_SIZE ) ? (int) ( words - w ) : BLOCK_SIZE;
+
+            for ( int i = 0; i < count; i++ ) {
+
+                const uint8_t *p = sec -> data + (( w + i ) * 4 );
+
+                instr[ i ] = ((uint32_t) p[ 0 ] << 24 ) | ((uint32_t) p[ 1 ] << 16 ) |
+                             ((uint32_t) p[ 2 ] << 8  ) | ((uint32_t) p[ 3 ] );
+            }
+
+            disAsm.formatInstrBlock( buf, LINE_LEN, instr, count, 16 );
+
+            for ( int i = 0; i < count; i++ ) {
+
+                fprintf( out, "0x%016llx: 0x%08x  %s\n",
+                         (unsigned long long) ( sec -> base + (( w + i ) * 4 )),
+                         instr[ i ],
+                         buf + ( i * LINE_LEN ));
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Access functions.
+//
+//----------------------------------------------------------------------------------------
+int T64FileAssemble::getErrCount( ) {
+
+    return ( errCount );
+}
+
+T64Word T64FileAssemble::getEntryAdr( ) {
+
+    return ( entryAdr );
+}
@@ -28,6 +28,8 @@
 //
 //----------------------------------------------------------------------------------------
 #include "T64-InlineAsm.h"
+#include "T64-InstrDesc.h"
+#include "T64-KeywordHash.h"
 
 //----------------------------------------------------------------------------------------
 // Local namespace. These routines are not visible outside this source file.
@@ -81,7 +83,10 @@ enum ErrId : int {
     ERR_EXPR_TYPE_MATCH             = 40,
     ERR_NUMERIC_OVERFLOW            = 41,
     ERR_IMM_VAL_RANGE               = 42,
-    ERR_DUPLICATE_INSTR_OPT         = 43
+    ERR_DUPLICATE_INSTR_OPT         = 43,
+    ERR_UNDEFINED_SYMBOL            = 44,
+    ERR_IDENT_TOO_LONG              = 45,
+    ERR_INPUT_LINE_TOO_LONG         = 46
 };
 
 //----------------------------------------------------------------------------------------
@@ -128,7 +133,10 @@ const ErrMsg ErrMsgTable[ ] = {
    
     { ERR_EXPR_TYPE_MATCH ,         (char *) "Expression type mismatch" },
     { ERR_IMM_VAL_RANGE,            (char *) "Value range error " },
-    { ERR_DUPLICATE_INSTR_OPT,      (char *) "Duplicate Instruction option " }
+    { ERR_DUPLICATE_INSTR_OPT,      (char *) "Duplicate Instruction option " },
+    { ERR_UNDEFINED_SYMBOL,         (char *) "Undefined symbol" },
+    { ERR_IDENT_TOO_LONG,           (char *) "Identifier too long" },
+    { ERR_INPUT_LINE_TOO_LONG,      (char *) "Input line too long" }
 };
 
 const int MAX_ERR_MSG_TAB = sizeof( ErrMsgTable ) / sizeof( ErrMsg );
@@ -243,70 +251,6 @@ struct Token {
      T64Word    val                         = 0;  
 };
 
-//----------------------------------------------------------------------------------------
-// An instruction template consists of the instruction group bits ( 31,30 ), the op 
-// code family bits ( 29, 28, 27, 26 ) and the option or mode bits ( 21, 20, 19 ). The
-// mode bits are for some instruction the default and could be changed during the 
-// parsing process. From the defined constants we will build the instruction template 
-// which is stored for the opcode mnemonic in the token value field. The values for the
-// opcode group and the opcode families are in the "T64-Types" include file.
-//
-//----------------------------------------------------------------------------------------
-enum InstrTemplate : uint32_t {
-    
-    OPG_ALU      = ( OPC_GRP_ALU  << 30 ),
-    OPG_MEM      = ( OPC_GRP_MEM  << 30 ),
-    OPG_BR       = ( OPC_GRP_BR   << 30 ),
-    OPG_SYS      = ( OPC_GRP_SYS  << 30 ),
-  
-    OPF_ADD      = ( OPC_ADD    << 26 ),
-    OPF_SUB      = ( OPC_SUB    << 26 ),
-    OPF_AND      = ( OPC_AND    << 26 ),
-    OPF_OR       = ( OPC_OR     << 26 ),
-    OPF_XOR      = ( OPC_XOR    << 26 ),
-    OPF_CMP      = ( OPC_CMP_A  << 26 ),
-    OPF_CMP_A    = ( OPC_CMP_A  << 26 ),
-    OPF_CMP_B    = ( OPC_CMP_B  << 26 ),
-    OPF_BITOP    = ( OPC_BITOP  << 26 ),
-    OPF_SHAOP    = ( OPC_SHAOP  << 26 ),
-    OPF_IMMOP    = ( OPC_IMMOP  << 26 ),
-    OPF_LDO      = ( OPC_LDO    << 26 ),
-    
-    OPF_LD       = ( OPC_LD     << 26 ),
-    OPF_ST       = ( OPC_ST     << 26 ),
-    OPF_LDR      = ( OPC_LDR    << 26 ),
-    OPF_STC      = ( OPC_STC    << 26 ),
-    
-    OPF_B        = ( OPC_B      << 26 ),
-    OPF_BE       = ( OPC_BE     << 26 ),
-    OPF_BR       = ( OPC_BR     << 26 ),
-    OPF_BV       = ( OPC_BV     << 26 ),
-    
-    OPF_BB       = ( OPC_BB     << 26 ),
-    OPF_CBR      = ( OPC_CBR    << 26 ),
-    OPF_MBR      = ( OPC_MBR    << 26 ),
-    OPF_ABR      = ( OPC_ABR    << 26 ),
-    
-    OPF_MR       = ( OPC_MR     << 26 ),
-    OPF_LPA      = ( OPC_LPA    << 26 ),
-    OPF_PRB      = ( OPC_PRB    << 26 ),
-    OPF_TLB      = ( OPC_TLB    << 26 ),
-    OPF_CA       = ( OPC_CA     << 26 ),
-    OPF_MST      = ( OPC_MST    << 26 ),
-    OPF_RFI      = ( OPC_RFI    << 26 ),
-    OPF_TRAP     = ( OPC_TRAP   << 26 ),
-    OPF_DIAG     = ( OPC_DIAG   << 26 ),
-    
-    OPM_FLD_0    = ( 0U  << 19 ),
-    OPM_FLD_1    = ( 1U  << 19 ),
-    OPM_FLD_2    = ( 2U  << 19 ),
-    OPM_FLD_3    = ( 3U  << 19 ),
-    OPM_FLD_4    = ( 4U  << 19 ),
-    OPM_FLD_5    = ( 5U  << 19 ),
-    OPM_FLD_6    = ( 6U  << 19 ),
-    OPM_FLD_7    = ( 7U  << 19 )
-};
-
 //----------------------------------------------------------------------------------------
 // Instruction flags. They are used to keep track of instruction attributes used in 
 // assembling the final instruction word. Examples are the data width encoded in the 
@@ -378,7 +322,7 @@ enum InstrFlags : uint32_t {
 // token. The parser can directly use the value in an expression.
 //
 //----------------------------------------------------------------------------------------
-const Token AsmTokTab[ ] = {
+constexpr Token AsmTokTab[ ] = {
     
     //------------------------------------------------------------------------------------
     // General registers.
@@ -611,7 +555,37 @@ const Token AsmTokTab[ ] = {
    
 };
 
-const int MAX_ASM_TOKEN_TAB = sizeof( AsmTokTab ) / sizeof( Token );
+constexpr int MAX_ASM_TOKEN_TAB = sizeof( AsmTokTab ) / sizeof( Token );
+
+//----------------------------------------------------------------------------------------
+// The perfect hash table for the reserved words, built by the compiler.
+//
+//----------------------------------------------------------------------------------------
+constexpr auto AsmTokHash = T64KeywordHash<MAX_ASM_TOKEN_TAB>( AsmTokTab );
+
+//----------------------------------------------------------------------------------------
+// The mnemonic templates and the instruction description table used by the
+// disassembler must agree. Every instruction template decodes to a description of
+// the same opcode group and family. The check is done by the compiler.
+//
+//----------------------------------------------------------------------------------------
+constexpr bool checkInstrTemplates( ) {
+
+    for ( int i = 0; i < MAX_ASM_TOKEN_TAB; i++ ) {
+
+        if ( AsmTokTab[ i ].typ != TYP_OP_CODE ) continue;
+
+        uint32_t    instr   = (uint32_t) AsmTokTab[ i ].val;
+        int         index   = InstrDecodeTab.lookup( instr );
+
+        if ( index < 0 ) return( false );
+        if (( InstrDescTab[ index ].instr & OPM_FAM ) != ( instr & OPM_FAM )) return( false );
+    }
+
+    return( true );
+}
+
+static_assert( checkInstrTemplates( ), "Instruction template without description" );
 
 //----------------------------------------------------------------------------------------
 // Expression value. The analysis of an expression results in a value. Depending on 
@@ -637,8 +611,17 @@ int     currentLineLen                      = 0;
 int     currentCharIndex                    = 0;
 int     currentTokCharIndex                 = 0;
 char    currentChar                         = ' ';
+bool    currentTokAfterSpace                = false;
 Token   currentToken;
 
+//----------------------------------------------------------------------------------------
+// The assembler context. The symbol table and the location counter are set by the 
+// file assembler. The one line assembler has no symbol table.
+//
+//----------------------------------------------------------------------------------------
+T64AsmSymTab    *asmSymTab                  = nullptr;
+T64Word         asmLocAdr                   = 0;
+
 //----------------------------------------------------------------------------------------
 // Forward declarations.
 //
@@ -646,7 +629,8 @@ Token   currentToken;
 void parseExpr( Expr *rExpr );
 
 //----------------------------------------------------------------------------------------
-// The token lookup function. We just do a linear search.
+// The token lookup function. The reserved words are found through the perfect hash
+// table.
 //
 //----------------------------------------------------------------------------------------
 int lookupToken( char *inputStr, const Token *tokTab ) {
@@ -654,12 +638,7 @@ int lookupToken( char *inputStr, const Token *tokTab ) {
     if (( strlen( inputStr ) == 0 ) || 
         ( strlen ( inputStr ) > MAX_TOKEN_NAME_SIZE )) return ( -1 );
     
-    for ( int i = 0; i < MAX_ASM_TOKEN_TAB; i++  ) {
-        
-        if ( strcmp( inputStr, tokTab[ i ].name ) == 0 ) return ( i );
-    }
-    
-    return ( -1 );
+    return ( AsmTokHash.lookup( tokTab, inputStr ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -822,6 +801,53 @@ void parseNum( ) {
     currentToken.val = tmpVal;
 }
 
+//----------------------------------------------------------------------------------------
+// "lookupSymbolVal" returns the value of a symbol. The symbol must be defined.
+//
+//----------------------------------------------------------------------------------------
+T64Word lookupSymbolVal( char *name ) {
+    
+    int index = asmSymTab -> lookup( name );
+    
+    if (( index < 0 ) || ( ! asmSymTab -> getSymbol( index ) -> defined )) {
+        
+        throw ( ERR_UNDEFINED_SYMBOL );
+    }
+    
+    return ( asmSymTab -> getSymbol( index ) -> val );
+}
+
+//----------------------------------------------------------------------------------------
+// "parseFieldSelectorArg" parses the argument of a "L%", "R%", "M%" or "U%" field 
+// selector. It is a number or, when there is a symbol table, a symbol name. The 
+// result is a numeric token.
+//
+//----------------------------------------------------------------------------------------
+void parseFieldSelectorArg( ) {
+    
+    if ( isdigit( currentChar )) {
+        
+        parseNum( );
+    }
+    else if (( asmSymTab != nullptr ) && 
+             (( isalpha( currentChar )) || ( currentChar == '@' ))) {
+        
+        char nameBuf[ MAX_INPUT_LINE_SIZE ] = "";
+        
+        do {
+            
+            addChar( nameBuf, sizeof( nameBuf ), currentChar );
+            nextChar( );
+        }
+        while (( isalnum( currentChar )) || ( currentChar == '_' ));
+        
+        currentToken.tid = TOK_NUM;
+        currentToken.typ = TYP_NUM;
+        currentToken.val = lookupSymbolVal( nameBuf );
+    }
+    else throw ( ERR_INVALID_CHAR_IN_IDENT );
+}
+
 //----------------------------------------------------------------------------------------
 // "parseIdent" parses an identifier. It is a sequence of characters starting with an
 // alpha character. An identifier found in the token table will assume the type and 
@@ -829,6 +855,7 @@ void parseNum( ) {
 // is one more thing. There are qualified constants that begin with a character followed 
 // by a percent character, followed by a numeric value. During the character analysis,
 // We first check for these kind of qualifiers and if found hand over to parse a number.
+// With a symbol table, identifiers may also start with a "@" for local labels.
 //
 //----------------------------------------------------------------------------------------
 void parseIdent( ) {
@@ -849,14 +876,10 @@ void parseIdent( ) {
             addChar( identBuf, sizeof( identBuf ), currentChar );
             nextChar( );
             
-            if ( isdigit( currentChar )) {
-                
-                parseNum( );
+            parseFieldSelectorArg( );
                 currentToken.val &= 0x00000000FFFFF000;
                 currentToken.val >>= 12;
-                return;
-            }
-            else throw ( ERR_INVALID_CHAR_IN_IDENT );
+            return;
         }
     }
     else if (( currentChar == 'R' ) || ( currentChar == 'r' )) {
@@ -869,13 +892,9 @@ void parseIdent( ) {
             addChar( identBuf, sizeof( identBuf ), currentChar );
             nextChar( );
             
-            if ( isdigit( currentChar )) {
-                
-                parseNum( );
+            parseFieldSelectorArg( );
                 currentToken.val &= 0x0000000000000FFF;
-                return;
-            }
-            else throw ( ERR_INVALID_CHAR_IN_IDENT );
+            return;
         }
     }
     else if (( currentChar == 'M' ) || ( currentChar == 'm' )) {
@@ -888,14 +907,10 @@ void parseIdent( ) {
             addChar( identBuf, sizeof( identBuf ), currentChar );
             nextChar( );
             
-            if ( isdigit( currentChar )) {
-                
-                parseNum( );
+            parseFieldSelectorArg( );
                 currentToken.val &= 0x000FFFFF00000000;
                 currentToken.val >>= 32;
-                return;
-            }
-            else throw ( ERR_INVALID_CHAR_IN_IDENT );
+            return;
         }
     }
     else if (( currentChar == 'U' ) || ( currentChar == 'u' )) {
@@ -908,23 +923,27 @@ void parseIdent( ) {
             addChar( identBuf, sizeof( identBuf ), currentChar );
             nextChar( );
             
-            if ( isdigit( currentChar )) {
-                
-                parseNum( );
+            parseFieldSelectorArg( );
                 currentToken.val &= 0xFFF0000000000000;
                 currentToken.val >>= 52;
-                return;
-            }
-            else throw ( ERR_INVALID_CHAR_IN_IDENT );
+            return;
         }
     }
     
+    else if ( currentChar == '@' ) {
+        
+        addChar( identBuf, sizeof( identBuf ), currentChar );
+        nextChar( );
+    }
+    
     while (( isalnum( currentChar )) || ( currentChar == '_' )) {
         
         addChar( identBuf, sizeof( identBuf ), currentChar );
         nextChar( );
     }
     
+    if ( strlen( identBuf ) >= MAX_TOKEN_NAME_SIZE ) throw ( ERR_IDENT_TOO_LONG );
+    
     upshiftStr( identBuf );
     
     int index = lookupToken( identBuf, AsmTokTab );
@@ -949,14 +968,21 @@ void nextToken( ) {
     currentToken.typ        = TYP_NIL;
     currentToken.tid        = TOK_NIL;
     currentToken.val        = 0;
+    currentTokAfterSpace    = false;
     
     while (( currentChar == ' ' ) || 
+            ( currentChar == '\t' ) || 
             ( currentChar == '\n' ) || 
-            ( currentChar == '\r' )) nextChar( );
+            ( currentChar == '\r' )) {
+        
+        currentTokAfterSpace = true;
+        nextChar( );
+    }
     
     currentTokCharIndex = currentCharIndex - 1;
     
-    if ( isalpha( currentChar )) {
+    if (( isalpha( currentChar )) || 
+        (( currentChar == '@' ) && ( asmSymTab != nullptr ))) {
         
         parseIdent( );
     }
@@ -1065,6 +1091,8 @@ void nextToken( ) {
 //----------------------------------------------------------------------------------------
 void setupTokenizer( char *inputStr ) {
     
+    if ( strlen( inputStr ) >= MAX_INPUT_LINE_SIZE ) throw ( ERR_INPUT_LINE_TOO_LONG );
+    
     strcpy( tokenLine, inputStr );
     upshiftStr( tokenLine );
     
@@ -1114,11 +1142,25 @@ static inline void acceptRparen( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// "parseFactor" parses the factor syntax part of an expression.
+// "isLocCounter" checks whether a period is the location counter. A period directly
+// following the previous token starts an instruction option. With a symbol table, a
+// period preceded by white space is the location counter.
+//
+//----------------------------------------------------------------------------------------
+static inline bool isLocCounter( ) {
+    
+    return (( isToken( TOK_PERIOD )) && ( asmSymTab != nullptr ) && ( currentTokAfterSpace ));
+}
+
+//----------------------------------------------------------------------------------------
+// "parseFactor" parses the factor syntax part of an expression. The symbol and the 
+// location counter are only valid when there is a symbol table.
 //
 //      <factor> -> <number>            |
 //                  <gregId>            |
 //                  <cregId>            |
+//                  <symbol>            |
+//                  "."                 |
 //                  "~" <factor>        |
 //                  "(" <expr> ")"
 //
@@ -1146,8 +1188,21 @@ void parseFactor( Expr *rExpr ) {
         rExpr -> val = currentToken.val;
         nextToken( );
     }
+    else if (( isToken( TOK_IDENT )) && ( asmSymTab != nullptr )) {
+        
+        rExpr -> typ    = TYP_NUM;
+        rExpr -> val    = lookupSymbolVal( currentToken.name );
+        nextToken( );
+    }
+    else if (( isToken( TOK_PERIOD )) && ( asmSymTab != nullptr )) {
+        
+        rExpr -> typ    = TYP_NUM;
+        rExpr -> val    = asmLocAdr;
+        nextToken( );
+    }
     else if ( isToken( TOK_NEG )) {
         
+        nextToken( );
         parseFactor( rExpr );
         rExpr -> val = ~ rExpr -> val;
     }
@@ -1404,7 +1459,7 @@ void parseInstrOptions( uint32_t *instrFlags, uint32_t instrOpToken ) {
     
     uint32_t instrMask = IM_NIL;
     
-    while ( isToken( TOK_PERIOD )) {
+    while (( isToken( TOK_PERIOD )) && ( ! isLocCounter( ))) {
         
         nextToken( );
         
@@ -2079,7 +2134,8 @@ void parseMemOp( T64Instr *instr, uint32_t instrOpToken ) {
 
 //----------------------------------------------------------------------------------------
 // "parseOpB" parses the branch instruction. The branch instruction may have the "gate"
-// option.
+// option. With a symbol table, the argument is the target address and we compute the
+// offset from the location counter.
 //
 //      B [ .G ] <ofs> [ "," <Reg R> ]
 //
@@ -2094,6 +2150,8 @@ void parseInstrB( uint32_t *instr, uint32_t instrOpToken ) {
     parseExpr( &rExpr );
     if ( rExpr.typ == TYP_NUM ) {
      
+        if ( asmSymTab != nullptr ) rExpr.val -= asmLocAdr;
+        
         rExpr.val = rExpr.val >> 2;
         depositInstrImm19( instr, (uint32_t) rExpr.val );
     }
@@ -2224,7 +2282,8 @@ void parseInstrBB( uint32_t *instr, uint32_t instrOpToken ) {
 }
 
 //----------------------------------------------------------------------------------------
-// "parseOpCBR" performa a compare and a branch based on the condition.
+// "parseOpCBR" performa a compare and a branch based on the condition. With a symbol
+// table, the offset argument is the target address.
 //
 //      ABR ".EQ/NE/LT/LE/GT/GE/OD/EV" RegR "," RegB "," <ofs>
 //      CBR ".EQ/NE/LT/LE/GT/GE/OD/EV" RegR "," RegB "," <ofs>
@@ -2246,8 +2305,10 @@ void parseInstrXBR( uint32_t *instr, uint32_t instrOpToken ) {
     parseExpr( &rExpr );
     if ( rExpr.typ == TYP_NUM ) {
      
+        if ( asmSymTab != nullptr ) rExpr.val -= asmLocAdr;
+        
         rExpr.val = rExpr.val >> 2;
-        depositInstrImm19( instr, (uint32_t) rExpr.val );
+        depositInstrImm15( instr, (uint32_t) rExpr.val );
     }
     else throw ( ERR_EXPECTED_BR_OFS );
     
@@ -2666,13 +2727,17 @@ void parseLine( char *inputStr, uint32_t *instr ) {
 //----------------------------------------------------------------------------------------
 // A simple one line assembler. We will parse a one line input string for a 
 // valid instruction, using the syntax of the real assembler. There will be no 
-// labels and comments, only the opcode and the operands.
+// labels and comments, only the opcode and the operands. The tokenizer state is 
+// global, so we first install the symbol table and location counter of this object.
 //
 //----------------------------------------------------------------------------------------
 T64Assemble::T64Assemble( ) { }
 
 int T64Assemble::assembleInstr( char *inputStr, uint32_t *instr ) {
     
+    asmSymTab = symTab;
+    asmLocAdr = locAdr;
+    
     try {
         
         parseLine( inputStr, instr );
@@ -2686,6 +2751,61 @@ int T64Assemble::assembleInstr( char *inputStr, uint32_t *instr ) {
     }
 }
 
+//----------------------------------------------------------------------------------------
+// "evalExpr" evaluates a numeric expression. The file assembler uses this routine 
+// for the directive arguments.
+//
+//----------------------------------------------------------------------------------------
+int T64Assemble::evalExpr( char *inputStr, T64Word *val ) {
+    
+    Expr rExpr = INIT_EXPR;
+    
+    asmSymTab = symTab;
+    asmLocAdr = locAdr;
+    
+    try {
+        
+        setupTokenizer( inputStr );
+        parseExpr( &rExpr );
+        
+        if ( rExpr.typ != TYP_NUM ) throw ( ERR_EXPECTED_NUMERIC );
+        acceptEOS( );
+        
+        *val = rExpr.val;
+        return ( NO_ERR );
+    }
+    catch ( ErrId errNum ) {
+        
+        *val    = 0;
+        lastErr = errNum;
+        return ( errNum );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Symbol table and location counter for the assembler context. 
+//
+//----------------------------------------------------------------------------------------
+void T64Assemble::setSymTab( T64AsmSymTab *symTab ) {
+    
+    this -> symTab = symTab;
+}
+
+void T64Assemble::setLocation( T64Word adr ) {
+    
+    this -> locAdr = adr;
+}
+
+//----------------------------------------------------------------------------------------
+// Check whether a name is a reserved word, such as an opCode or register name. Such
+// names cannot be used as symbols.
+//
+//----------------------------------------------------------------------------------------
+bool T64Assemble::isReservedWord( const char *name ) {
+    
+    return ( AsmTokHash.lookup( AsmTokTab, name ) >= 0 );
+}
+
 int T64Assemble::getErrId( ) {
     
     return ( lastErr );
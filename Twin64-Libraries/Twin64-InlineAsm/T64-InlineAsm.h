@@ -11,6 +11,11 @@
 // Considering that we only have one line to parse, there is no need to implement a 
 // better parser error recovery method.
 //
+// The file assembler builds on the one line assembler. It is a two pass assembler for
+// source files with labels, sections and data directives. The instruction encoding
+// is the one line assembler, which resolves identifiers through the symbol table of
+// the file assembler, when one is set.
+//
 //----------------------------------------------------------------------------------------
 //
 // T64 - A 64-bit Processor - InLine Assembler
@@ -33,11 +38,74 @@
 #include "T64-Common.h"
 #include "T64-Util.h"
 
+//----------------------------------------------------------------------------------------
+// An assembler symbol. The name is stored in the name pool of the symbol table. A 
+// symbol is either a label in a section or an absolute value defined with ".equ", in
+// which case the section index is -1.
+//
+//----------------------------------------------------------------------------------------
+struct T64AsmSymbol {
+    
+    int         nameOfs         = 0;
+    uint32_t    hash            = 0;
+    T64Word     val             = 0;
+    int         sectionIndex    = -1;
+    bool        defined         = false;
+    bool        global          = false;
+};
+
+//----------------------------------------------------------------------------------------
+// "T64AsmSymTab" is the symbol table of the file assembler. The symbols are kept in
+// an array in the order of their definition, an open addressing hash table maps the 
+// names to the array index. Names are case insensitive and stored in upper case. A 
+// name starting with a "@" is a local label. It is qualified with the scope, which is
+// the last global label defined. Symbol pointers are valid until the next "enter".
+//
+//----------------------------------------------------------------------------------------
+struct T64AsmSymTab {
+    
+public:
+    
+    T64AsmSymTab( );
+    ~T64AsmSymTab( );
+    
+    void            reset( );
+    void            setScope( const char *name );
+    
+    int             lookup( const char *name );
+    int             enter( const char *name );
+    
+    int             getCount( );
+    T64AsmSymbol    *getSymbol( int index );
+    const char      *getName( int index );
+    
+private:
+    
+    bool            qualifyName( char *buf, int bufLen, const char *name );
+    int             findSlot( const char *name, uint32_t hash );
+    void            growSlots( );
+    
+    T64AsmSymbol    *syms       = nullptr;
+    int             symCount    = 0;
+    int             symMax      = 0;
+    
+    int             *slots      = nullptr;
+    int             slotMax     = 0;
+    
+    char            *namePool   = nullptr;
+    int             namePoolLen = 0;
+    int             namePoolMax = 0;
+    
+    char            scope[ 256 ] = { 0 };
+};
+
 //----------------------------------------------------------------------------------------
 // "T64Assemble" is a one line assembler. It just parses the instruction string and 
 // produces an instruction. Utility routines for converting an error code to an error
 // message and an index into the input source line to where the error occurred is 
-// provided too.
+// provided too. When a symbol table is set, identifiers in expressions are symbols, 
+// "." is the location counter and branch offsets are specified as target addresses.
+// The file assembler uses these options, the simulator does not.
 //
 //----------------------------------------------------------------------------------------
 struct T64Assemble {
@@ -47,10 +115,87 @@ public:
     T64Assemble( );
     
     int         assembleInstr( char *inputStr, uint32_t *instr );
+    int         evalExpr( char *inputStr, T64Word *val );
+    
+    void        setSymTab( T64AsmSymTab *symTab );
+    void        setLocation( T64Word adr );
+    bool        isReservedWord( const char *name );
 
     int         getErrId( );
     int         getErrPos( );
     const char  *getErrStr( int errId );
+    
+private:
+    
+    T64AsmSymTab    *symTab     = nullptr;
+    T64Word         locAdr      = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// "T64FileAssemble" is the two pass file assembler. The first pass reads the source 
+// file, defines the labels and computes the section sizes. The second pass reads the
+// file again and generates the section data. Both passes stream the source file line
+// by line. The result is written as a big endian ELF64 file. Errors are reported with
+// the file name and line number to the error file.
+//
+//----------------------------------------------------------------------------------------
+struct T64AsmSection;
+
+struct T64FileAssemble {
+    
+public:
+    
+    T64FileAssemble( FILE *errOut );
+    ~T64FileAssemble( );
+    
+    int             assembleFile( const char *srcFileName );
+    int             writeElfFile( const char *elfFileName );
+    void            printSymbols( FILE *out );
+    void            printListing( FILE *out );
+    
+    int             getErrCount( );
+    T64Word         getEntryAdr( );
+    
+private:
+    
+    bool            runPass( int pass );
+    void            assembleLine( char *line );
+    void            defineLabel( char *name );
+    void            parseDirective( char *str );
+    
+    void            directiveSection( char *args );
+    void            directiveOrg( char *args );
+    void            directiveAlign( char *args );
+    void            directiveData( char *args, int size );
+    void            directiveString( char *args, bool addZero );
+    void            directiveSpace( char *args );
+    void            directiveEqu( char *args );
+    void            directiveGlobal( char *args );
+    void            directiveEntry( char *args );
+    
+    bool            evalOperand( char *str, T64Word *val );
+    void            emitBytes( const uint8_t *data, T64Word len );
+    void            emitValue( T64Word val, int size );
+    void            selectSection( const char *name, uint32_t flags );
+    void            useDefaultSection( );
+    void            checkPassOne( );
+    void            reportError( const char *fmt, ... );
+    
+    FILE            *errOut         = nullptr;
+    const char      *srcFileName    = nullptr;
+    int             lineNum         = 0;
+    int             pass            = 0;
+    int             errCount        = 0;
+    
+    T64AsmSymTab    symTab;
+    T64Assemble     doAsm;
+    
+    T64AsmSection   *sections       = nullptr;
+    int             sectionCount    = 0;
+    int             curSection      = -1;
+    
+    T64Word         entryAdr        = 0;
+    bool            entrySet        = false;
 };
 
 //----------------------------------------------------------------------------------------
@@ -58,7 +203,8 @@ public:
 // The disassembled string can also contains  two parts, which are the opcode part and
 // the operand part. There are options to just one of the parts or both. The split
 // allows for displaying the disassembled instruction in an aligned fashion, when 
-// printing several lines.
+// printing several lines. A whole block of instructions can be formatted with one
+// call into an array of fixed size lines, which is used for listings.
 //
 //----------------------------------------------------------------------------------------
 struct T64DisAssemble {
@@ -70,6 +216,7 @@ public:
     int formatInstr( char *buf, int bufLen, uint32_t instr, int rdx );
     int formatOpCode( char *buf, int bufLen, uint32_t instr );
     int formatOperands( char *buf, int bufLen, uint32_t instr, int rdx );
+    int formatInstrBlock( char *buf, int lineLen, const uint32_t *instr, int count, int rdx );
     int getOpCodeFieldWidth( );
     int getOperandsFieldWidth( );
 };
@@ -11,6 +11,11 @@
 // The disassemble routine will analyze an instruction word and present the instruction
 // portion in the above order. The result is a string with the disassembled instruction.
 //
+// The decoding is table driven. The instruction description table, shared with the
+// one line assembler, describes for each opcode family and option field the mnemonic
+// and the option and operand formats. The compiler builds a decode table from it, so
+// that decoding an instruction is one table lookup. The strings are built without 
+// "snprintf".
 //
 //----------------------------------------------------------------------------------------
 //
@@ -29,6 +34,7 @@
 //
 //----------------------------------------------------------------------------------------
 #include "T64-InlineAsm.h"
+#include "T64-InstrDesc.h"
 #include "T64-Util.h"
 
 //----------------------------------------------------------------------------------------
@@ -47,860 +53,387 @@ const int LEN_16 = 16;
 const int LEN_32 = 32;
 
 //----------------------------------------------------------------------------------------
-// A little helper function to display the comparison condition codes in human readable
-// form. The function returns the characters written.
+// The comparison condition codes and the data width names. Note that we do not 
+// display the "D" option. It is the default and thus will not be shown.
 //
 //----------------------------------------------------------------------------------------
-int printCondField( char *buf, uint32_t cmpCode ) {
-    
-    switch( cmpCode ) {
-            
-        case 0:  return ( snprintf( buf, 4, ".EQ" ));
-        case 1:  return ( snprintf( buf, 4, ".LT" ));
-        case 2:  return ( snprintf( buf, 4, ".GT" ));
-        case 3:  return ( snprintf( buf, 4, ".EV" ));
-        case 4:  return ( snprintf( buf, 4, ".NE" ));
-        case 5:  return ( snprintf( buf, 4, ".GE" ));
-        case 6:  return ( snprintf( buf, 4, ".LE" ));
-        case 7:  return ( snprintf( buf, 4, ".OD" ));
-        default: return ( snprintf( buf, 4, ".**" ));
-    }
+const char *condFieldNames[ ] = {
+    
+    ".EQ", ".LT", ".GT", ".EV", ".NE", ".GE", ".LE", ".OD" 
+};
+
+const char *dwFieldNames[ ] = { ".B", ".H", ".W", "" };
+
+//----------------------------------------------------------------------------------------
+// Little helper functions to append a string, a number or a register to the output
+// buffer. We do not use "snprintf", formatting is the bulk of the disassembly work 
+// when whole code ranges are listed. The functions return the new buffer position.
+//
+//----------------------------------------------------------------------------------------
+char *putStr( char *buf, const char *str ) {
+    
+    while ( *str != 0 ) *buf++ = *str++;
+    return ( buf );
+}
+
+char *putNum( char *buf, int val ) {
+    
+    char        tmp[ 12 ];
+    int         len = 0;
+    uint32_t    num = ( val < 0 ) ? ( 0U - (uint32_t) val ) : (uint32_t) val;
+    
+    if ( val < 0 ) *buf++ = '-';
+    
+    do {
+        
+        tmp[ len++ ] = (char) ( '0' + ( num % 10 ));
+        num /= 10;
+        
+    } while ( num != 0 );
+    
+    while ( len > 0 ) *buf++ = tmp[ --len ];
+    return ( buf );
+}
+
+char *putReg( char *buf, char prefix, int regNum ) {
+    
+    *buf++ = prefix;
+    return ( putNum( buf, regNum ));
 }
 
 //----------------------------------------------------------------------------------------
-// A little helper function to display the DW field. Note that we do not display the 
-// "D" option. It is the default and thus will not be shown.
+// Append the opcode options. The option format of the instruction description is a 
+// set of flags. They are processed in the order of their definition, which is the
+// order the options are shown.
 //
 //----------------------------------------------------------------------------------------
-int printDwField( char *buf, uint32_t dw ) {
+char *putOptions( char *buf, uint32_t instr, uint32_t optFmt ) {
     
-    switch( dw ) {
-            
-        case 0:  return ( snprintf( buf, 4, ".B" ));
-        case 1:  return ( snprintf( buf, 4, ".H" ));
-        case 2:  return ( snprintf( buf, 4, ".W" ));
-        case 3:  return ( 0 );
-        default: return ( snprintf( buf, 8, ".*dw*" ));
+    if ( optFmt & IOF_SHA ) {
+        
+        *buf++ = (char) ( '0' + extractInstrDwField( instr ));
+        *buf++ = 'A';
     }
+    
+    if (( optFmt & IOF_BAD_19 ) && ( extractInstrBit( instr, 19 )))
+        buf = putStr( buf, ".**" );
+    
+    if (( optFmt & IOF_BAD_21 ) && ( extractInstrBit( instr, 21 )))
+        buf = putStr( buf, ".**" );
+    
+    if (( optFmt & IOF_BAD_20_21 ) && ( extractInstrFieldU( instr, 20, 2 ) != 0 ))
+        buf = putStr( buf, ".**" );
+    
+    if ( optFmt & IOF_BAD )
+        buf = putStr( buf, ".**" );
+    
+    if (( optFmt & IOF_U ) && ( extractInstrBit( instr, 20 )))
+        buf = putStr( buf, ".U" );
+    
+    if ( optFmt & IOF_COND )
+        buf = putStr( buf, condFieldNames[ extractInstrOptField( instr ) ] );
+    
+    if ( optFmt & IOF_DW )
+        buf = putStr( buf, dwFieldNames[ extractInstrDwField( instr ) ] );
+    
+    if (( optFmt & IOF_C ) && ( extractInstrBit( instr, 20 )))
+        buf = putStr( buf, ".C" );
+    
+    if (( optFmt & IOF_BAD_20 ) && ( extractInstrBit( instr, 20 )))
+        buf = putStr( buf, ".**" );
+    
+    if (( optFmt & IOF_N ) && ( extractInstrBit( instr, 21 )))
+        buf = putStr( buf, ".N" );
+    
+    if (( optFmt & IOF_S ) && ( extractInstrBit( instr, 12 )))
+        buf = putStr( buf, ".S" );
+    
+    if (( optFmt & IOF_Z ) && ( extractInstrBit( instr, 12 )))
+        buf = putStr( buf, ".Z" );
+    
+    if (( optFmt & IOF_G ) && ( extractInstrBit( instr, 19 )))
+        buf = putStr( buf, ".G" );
+    
+    if ( optFmt & IOF_TF )
+        buf = putStr( buf, ( extractInstrBit( instr, 19 )) ? ".T" : ".F" );
+    
+    return ( buf );
 }
 
 //----------------------------------------------------------------------------------------
 // Decode the opcode and opcode option portion. An opcode consist of the instruction
-// group and the opcode family. We construct the final opcode for the case statement.
+// group and the opcode family. The decode table yields the instruction description 
+// for the opcode and the option field. An instruction without a description is shown
+// with its opcode number.
 //
 //----------------------------------------------------------------------------------------
-int buildOpCodeStr( char *buf, T64Instr instr ) {
+int buildOpCodeStr( char *buf, uint32_t instr ) {
     
-    uint32_t opCode = extractInstrOpGroup( instr ) * 16 + extractInstrOpCode( instr );
-
-    switch( opCode ) {
-            
-        case ( OPC_GRP_ALU * 16 + OPC_ADD ): {
-            
-            return ( snprintf( buf, LEN_16, "ADD" ));
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_ADD ): {
-            
-            int cursor = snprintf( buf, LEN_16, "ADD" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_SUB ): {
-            
-            return ( snprintf( buf, LEN_16, "SUB" ));
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_SUB ): {
-            
-            int cursor = snprintf( buf, LEN_16, "SUB" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_AND ): {
-            
-            int cursor = snprintf( buf, LEN_16, "AND" );
-            if ( extractInstrBit( instr, 20 )) 
-               cursor += snprintf( buf + cursor, 4, ".C" );
-            if ( extractInstrBit( instr, 21 )) 
-               cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_AND ): {
-            
-            int cursor = snprintf( buf, LEN_16, "AND" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".C" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_OR ): {
-            
-            int cursor = snprintf( buf, LEN_16, "OR" );
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".C" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_OR ): {
-            
-            int cursor = snprintf( buf, LEN_16, "OR" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".C" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_XOR ): {
-            
-            int cursor = snprintf( buf, LEN_16, "XOR" );
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_XOR ): {
-            
-            int cursor = snprintf( buf, LEN_16, "XOR" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".N" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_CMP_A ): 
-        case ( OPC_GRP_ALU * 16 + OPC_CMP_B ): {
-            
-            int cursor = snprintf( buf, LEN_16, "CMP" );
-            cursor += printCondField( buf + cursor, extractInstrFieldU( instr, 19, 3 ));
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_CMP_A ):
-        case ( OPC_GRP_MEM * 16 + OPC_CMP_B ): {
+    int     index   = InstrDecodeTab.lookup( instr );
+    char    *cursor = buf;
+    
+    if ( index < 0 ) {
+        
+        cursor = putStr( cursor, "**OPC:" );
+        cursor = putNum( cursor, (int) ( instr >> 26 ));
+        cursor = putStr( cursor, "**" );
+    }
+    else {
+        
+        const T64InstrDesc *desc = &InstrDescTab[ index ];
+        
+        if (( desc -> optFmt & IOF_SHA ) && ( extractInstrDwField( instr ) == 0 )) {
             
-            int cursor = snprintf( buf, LEN_16, "CMP" );
-            cursor += printCondField( buf + cursor, extractInstrFieldU( instr, 19, 3 ));
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
+            cursor = putStr( cursor, "**SHAOP**" );
         }
+        else {
             
-        case ( OPC_GRP_ALU * 16 + OPC_BITOP ): {
-            
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-                    
-                case 0: { // EXTR
-                    
-                    int cursor = snprintf( buf, LEN_16, "EXTR" );
-                    if ( extractInstrBit( instr, 12 )) 
-                        cursor += snprintf( buf + cursor, 4, ".S" );
-                    return ( cursor );
-                }
-                    
-                case 1: { // DEP
-                    
-                    int cursor = snprintf( buf, LEN_16, "DEP" );
-                    if ( extractInstrBit( instr, 12 )) 
-                        cursor += snprintf( buf + cursor, 4, ".Z" );
-                    return ( cursor );
-                }
-                    
-                case 2: { // DSR
-                    
-                    return ( snprintf( buf, LEN_16, "DSR" ));
-                }
-                    
-                default: {
-                    
-                    return ( snprintf( buf, LEN_16, "**BITOP**" ));
-                }
-            }
+            cursor = putStr( cursor, desc -> name );
+            cursor = putOptions( cursor, instr, desc -> optFmt );
         }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_SHAOP ): {
-
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-                    
-                case 0:
-                case 1: {
-
-                    switch ( extractInstrFieldU( instr, 13, 2 )) {
-                    
-                        case 1: return ( snprintf( buf, LEN_16, "SHL1A" )); 
-                        case 2: return ( snprintf( buf, LEN_16, "SHL2A" ));
-                        case 3: return ( snprintf( buf, LEN_16, "SHL3A" )); 
-                        default: return ( snprintf( buf, LEN_16, "**SHAOP**" ));
-                    }
-                
-                } break;
-
-                case 2: 
-                case 3: {
+    }
+    
+    *cursor = 0;
+    return ((int) ( cursor - buf ));
+}
 
-                    switch ( extractInstrFieldU( instr, 13, 2 )) {
-                    
-                        case 1: return ( snprintf( buf, LEN_16, "SHR1A" )); 
-                        case 2: return ( snprintf( buf, LEN_16, "SHR2A" ));
-                        case 3: return ( snprintf( buf, LEN_16, "SHR3A" )); 
-                        default: return ( snprintf( buf, LEN_16, "**SHAOP**" ));
-                    }
-                }  break;
-               
-                default: return ( snprintf( buf, LEN_16, "**SHAOP**" ));
-            }
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_IMMOP ): {
-            
-            switch ( extractInstrFieldU( instr, 20, 2 )) {
-                  
-                case 0:  return ( snprintf( buf, LEN_16, "ADDIL" ));
-                case 1:  return ( snprintf( buf, LEN_16, "LDI.L" ));
-                case 2:  return ( snprintf( buf, LEN_16, "LDI.S" ));
-                case 3:  return ( snprintf( buf, LEN_16, "LDI.U" ));
-            }
-        }
-            
-        case ( OPC_GRP_ALU * 16 + OPC_LDO ): {
-            
-            int cursor = snprintf( buf, LEN_16, "LDO" );
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) {
-                
-                cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            }
-            
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_MEM * 16 + OPC_LD ): {
-            
-            int cursor = snprintf( buf, LEN_16, "LD" );
+//----------------------------------------------------------------------------------------
+// Decode the instruction operands. The operand format is taken from the instruction
+// description. Some formats select between the immediate and the register form of 
+// an instruction with an instruction bit.
+//
+//----------------------------------------------------------------------------------------
+int buildOperandStr( char *buf, uint32_t instr, int rdx ) {
+    
+    int     index   = InstrDecodeTab.lookup( instr );
+    char    *cursor = buf;
+    
+    InstrOprFmt oprFmt = ( index < 0 ) ? IOP_OPC : InstrDescTab[ index ].oprFmt;
+    
+    switch ( oprFmt ) {
             
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".U" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
+        case IOP_NIL: break;
             
-        case ( OPC_GRP_MEM * 16 + OPC_ST ): {
+        case IOP_ALU: {
             
-            int cursor = snprintf( buf, LEN_16, "ST" );
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegB( instr ));
+            cursor = putStr( cursor, ", " );
             
-        case ( OPC_GRP_MEM * 16 + OPC_LDR ): {
+            if ( extractInstrBit( instr, 19 )) 
+                cursor = putNum( cursor, extractInstrSignedImm15( instr ));
+            else 
+                cursor = putReg( cursor, 'R', extractInstrRegA( instr ));
             
-            int cursor = snprintf( buf, LEN_16, "LDR" );
-            if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, 4, ".U" );
+        } break;
             
-            return ( cursor );
-        }
+        case IOP_R_B_A: {
             
-        case ( OPC_GRP_MEM * 16 + OPC_STC ): {
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegB( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegA( instr ));
             
-            int cursor = snprintf( buf, LEN_16, "STC" );
-            if ( extractInstrFieldU( instr, 19, 3) != 0 ) {
-                
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            }
-
-            return ( cursor );
-        }
+        } break;
             
-        case ( OPC_GRP_BR * 16 + OPC_B ): {
+        case IOP_R_B_IMM: {
             
-            int cursor = snprintf( buf, LEN_16, "B" );
-            if ( extractInstrFieldU( instr, 20, 2 ) != 0 ) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 19 ))           
-                cursor += snprintf( buf + cursor, 4, ".G" );
-            return ( cursor );
-        }
-
-        case ( OPC_GRP_BR * 16 + OPC_BE ): {
-            
-            int cursor = snprintf( buf, LEN_16, "BE" );
-            if ( extractInstrFieldU( instr, 20, 2) != 0 ) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 19 ))           
-                cursor += snprintf( buf + cursor, 4, ".G" );
-            return ( cursor );
-        }
-
-        case ( OPC_GRP_BR * 16 + OPC_BR ): {
-
-           return ( snprintf( buf, LEN_16, "BR" ));
-        }
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegB( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putNum( cursor, extractInstrSignedImm15( instr ));
             
-        case ( OPC_GRP_BR * 16 + OPC_BV ): {
-
-           return ( snprintf( buf, LEN_16, "BV" ));
-        }
-      
-        case ( OPC_GRP_BR * 16 + OPC_BB ): {
+        } break;
             
-            int cursor = snprintf( buf, LEN_16, "BB" );
-            if ( extractInstrBit( instr, 21 )) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            if ( extractInstrBit( instr, 19 )) 
-                cursor += snprintf( buf + cursor, 4, ".T" );
-            else  cursor += snprintf( buf + cursor, 4, ".F" );
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_BR * 16 + OPC_CBR ): {
+        case IOP_EXTR: 
+        case IOP_DEP: {
             
-            int cursor = snprintf( buf, LEN_16, "CBR" );
-            if ( extractInstrBit( instr, 19 )) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            cursor += printCondField( buf + cursor, extractInstrFieldU( instr, 19, 3 ));
-            return ( cursor );
-        }
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
             
-        case ( OPC_GRP_BR * 16 + OPC_MBR ): {
+            if (( oprFmt == IOP_DEP ) && ( extractInstrBit( instr, 14 ))) 
+                cursor = putNum( cursor, extractInstrFieldU( instr, 15, 4 ));
+            else
+                cursor = putReg( cursor, 'R', extractInstrRegB( instr ));
             
-            int cursor = snprintf( buf, LEN_16, "MBR" );
-            if ( extractInstrBit( instr, 19 )) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            cursor += printCondField( buf + cursor, extractInstrFieldU( instr, 19, 3 ));
-            return ( cursor );
-        }
-
-        case ( OPC_GRP_BR * 16 + OPC_ABR ): {
+            cursor = putStr( cursor, ", " );
             
-            int cursor = snprintf( buf, LEN_16, "ABR" );
-            if ( extractInstrBit( instr, 19 )) 
-                cursor += snprintf( buf + cursor, 4, ".**" );
-            cursor += printCondField( buf + cursor, extractInstrFieldU( instr, 19, 3 ));
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_MR ): {
-          
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 )
-                return ( snprintf( buf, 8, "MFCR "));
-            else if ( extractInstrFieldU( instr, 19, 3 ) == 1 )   
-                return ( snprintf( buf, 8, "MTCR "));
-            else if ( extractInstrFieldU( instr, 19, 3 ) == 2 )   
-                return ( snprintf( buf, 8, "MFIA "));
+            if ( extractInstrBit( instr, 13 )) 
+                cursor = putStr( cursor, "SAR" );
             else 
-                return ( snprintf( buf, LEN_16, "**MROP**" ));
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_LPA ): {
-            
-            int cursor = 0;
-        
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) 
-                cursor = snprintf( buf, LEN_16, "LPA" );
-            else                                     
-                cursor = snprintf( buf, LEN_16, "**LPAOP**" );
-            
-            cursor += printDwField( buf + cursor, extractInstrDwField( instr ));
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_PRB ): {
+                cursor = putNum( cursor, extractInstrFieldU( instr, 6, 6 ));
             
-            int cursor = 0;
+            cursor = putStr( cursor, ", " );
+            cursor = putNum( cursor, extractInstrFieldU( instr, 0, 6 ));
             
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) 
-                cursor = snprintf( buf, LEN_16, "PRB" );
-            else                                    
-                cursor = snprintf( buf, LEN_16, "**PRBOP**" );
-            return ( cursor );
-        }
+        } break;
             
-        case ( OPC_GRP_SYS * 16 + OPC_TLB ): {
-
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-
-                case 0: return ( snprintf( buf, LEN_16, "IITLB" ));
-                case 1: return ( snprintf( buf, LEN_16, "IDTLB" ));
-                case 2: return ( snprintf( buf, LEN_16, "PITLB" ));
-                case 3: return ( snprintf( buf, LEN_16, "PDTLB" ));
-                default: return ( snprintf( buf, 8, "**TLB**" ));
-            }
-        }
+        case IOP_DSR: {
             
-        case ( OPC_GRP_SYS * 16 + OPC_CA ): {
-
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-
-                case 0: return ( snprintf( buf, LEN_16, "PICA" ));
-                case 1: return ( snprintf( buf, LEN_16, "PDCA" ));
-                case 2: return ( snprintf( buf, LEN_16, "FICA" ));
-                case 3: return ( snprintf( buf, LEN_16, "FDCA" ));
-                default: return ( snprintf( buf, 8, "**CA**" ));
-            }
-        }
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegB( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegA( instr ));
+            cursor = putStr( cursor, ", " );
             
-        case ( OPC_GRP_SYS * 16 + OPC_MST ): {
-            
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) 
-                return ( snprintf( buf, LEN_16, "RSM" ));
-            else if ( extractInstrFieldU( instr, 19, 3 ) == 1 )
-                 return ( snprintf( buf, LEN_16, "SSM" ));
+            if ( extractInstrBit( instr, 13 )) 
+                cursor = putStr( cursor, "SAR" );
             else 
-                return ( snprintf( buf, 8, "**MST**" ));
-        }
+                cursor = putNum( cursor, extractInstrFieldU( instr, 0, 6 ));
             
-        case ( OPC_GRP_SYS * 16 + OPC_RFI ):   {
+        } break;
             
-            return ( snprintf( buf, LEN_16, "RFI" ));
-        }
+        case IOP_BITOP: {
             
-        case ( OPC_GRP_SYS * 16 + OPC_TRAP ):  {
+            cursor = putStr( cursor, "**BITOP**" );
             
-            return ( snprintf( buf, LEN_16, "TRAP" ));
-        }
+        } break;
             
-        case ( OPC_GRP_SYS * 16 + OPC_DIAG ):  {
+        case IOP_R_IMM20: {
             
-            return ( snprintf( buf, LEN_16, "DIAG" ));
-        }
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putNum( cursor, extractInstrImm20( instr ));
             
-        case ( OPC_GRP_ALU * 16 + OPC_NOP ): {
+        } break;
             
-            return ( snprintf( buf, LEN_16, "NOP" ));
-        }
+        case IOP_MEM:
+        case IOP_MEM_OFS:
+        case IOP_MEM_IDX: 
+        case IOP_LPA: {
             
-        default: {
+            bool isIndexed = ( oprFmt == IOP_MEM_IDX ) || 
+                             (( oprFmt == IOP_MEM ) && ( extractInstrBit( instr, 19 )));
             
-            return ( snprintf( buf, LEN_16, "**OPC:%d**", opCode ));
-        }
-    }
-}
-
-//----------------------------------------------------------------------------------------
-// Decode the instruction operands. An opcode consist of the instruction group and 
-// the opcode family. We construct the final opcode for the case statement.
-//
-//----------------------------------------------------------------------------------------
-int buildOperandStr( char *buf, uint32_t instr, int rdx ) {
-    
-    uint32_t opCode = 
-        extractInstrFieldU( instr, 30, 2 ) * 16 + extractInstrFieldU( instr, 26, 4 );
-    
-    switch ( opCode ) {
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
             
-        case ( OPC_GRP_ALU * 16 + OPC_ADD   ):
-        case ( OPC_GRP_ALU * 16 + OPC_SUB   ):
-        case ( OPC_GRP_ALU * 16 + OPC_AND   ):
-        case ( OPC_GRP_ALU * 16 + OPC_OR    ):
-        case ( OPC_GRP_ALU * 16 + OPC_XOR   ): {
+            if ( isIndexed ) 
+                cursor = putReg( cursor, 'R', extractInstrRegA( instr ));
+            else if ( oprFmt == IOP_LPA ) 
+                cursor = putNum( cursor, extractInstrSignedImm13( instr ));
+            else 
+                cursor = putNum( cursor, extractInstrSignedScaledImm13( instr ));
             
-            if ( extractInstrBit( instr, 19 )) {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d, %d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrSignedImm15( instr )));
-            }
-            else {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d, R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr )));
-            }
-        }
-
-        case ( OPC_GRP_ALU * 16 + OPC_CMP_A ):
-        case ( OPC_GRP_ALU * 16 + OPC_CMP_B ): {
+            cursor = putStr( cursor, "(R" );
+            cursor = putNum( cursor, extractInstrRegB( instr ));
+            *cursor++ = ')';
             
-            if ( extractInstrBit( instr, 26 )) {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d, %d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrSignedImm15( instr )));
-            }
-            else {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d, R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr )));
-            }
-        }
- 
-        case ( OPC_GRP_ALU * 16 + OPC_BITOP ): {
-            
-            switch ( extractInstrFieldU( instr, 19, 3 )) {
-                    
-                case 0: { // EXTR
-                    
-                    if ( extractInstrBit( instr, 13 )) {
-                        
-                        return ( snprintf( buf, LEN_32, "R%d, R%d, SAR, %d",
-                                           extractInstrRegR( instr ),
-                                           extractInstrRegB( instr ),
-                                           extractInstrFieldU( instr, 0, 6 )));
-                    }
-                    else {
-                        
-                        return ( snprintf( buf, LEN_32, "R%d, R%d, %d, %d",
-                                           extractInstrRegR( instr ),
-                                           extractInstrRegB( instr ),
-                                           extractInstrFieldU( instr, 6, 6 ),
-                                           extractInstrFieldU( instr, 0, 6 )));
-                    }
-                }
-                    
-                case 1: { // DEP
-                    
-                    if ( extractInstrBit( instr, 14 )) {
-                        
-                        if ( extractInstrBit( instr, 13 )) {
-                            
-                            return ( snprintf( buf, LEN_32, "R%d, %d, SAR, %d",
-                                               extractInstrRegR( instr ),
-                                               extractInstrFieldU( instr, 15, 4 ),
-                                               extractInstrFieldU( instr, 0, 6 )));
-                        }
-                        else {
-                            
-                            return ( snprintf( buf, LEN_32, "R%d, %d, %d, %d",
-                                               extractInstrRegR( instr ),
-                                               extractInstrFieldU( instr, 15, 4 ),
-                                               extractInstrFieldU( instr, 6, 6 ),
-                                               extractInstrFieldU( instr, 0, 6 )));
-                        }
-                    }
-                    else {
-                        
-                        if ( extractInstrBit( instr, 13 )) {
-                            
-                            return ( snprintf( buf, LEN_32, "R%d, R%d, SAR, %d",
-                                               extractInstrRegR( instr ),
-                                               extractInstrRegB( instr ),
-                                               extractInstrFieldU( instr, 0, 6 )));
-                        }
-                        else {
-                            
-                            return ( snprintf( buf, LEN_32, "R%d, R%d, %d, %d",
-                                               extractInstrRegR( instr ),
-                                               extractInstrRegB( instr ),
-                                               extractInstrFieldU( instr, 6, 6 ),
-                                               extractInstrFieldU( instr, 0, 6 )));
-                        }
-                    }
-                }
-                    
-                case 2: { // DSR
-                    
-                    if ( extractInstrBit( instr, 13 )) {
-                        
-                        return ( snprintf( buf, LEN_32, "R%d, R%d, R%d, SAR",
-                                           extractInstrRegR( instr ),
-                                           extractInstrRegB( instr ),
-                                           extractInstrRegA( instr )));
-                    }
-                    else {
-                        
-                        return ( snprintf( buf, LEN_32, "R%d, R%d, R%d, %d",
-                                           extractInstrRegR( instr ),
-                                           extractInstrRegB( instr ),
-                                           extractInstrRegA( instr ),
-                                           extractInstrFieldU( instr, 0, 6 )));
-                    }
-                }
-                    
-                default: return ( snprintf( buf, LEN_32, "**BITOP**" ));
-            }
-        }
+        } break;
             
-        case ( OPC_GRP_ALU * 16 + OPC_SHAOP ): {
+        case IOP_B: {
             
-            if ( extractInstrBit( instr, 19 )) {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d, %d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrSignedImm15( instr )));
-            }
-            else {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d, R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr )));
-            }
-        }
+            cursor = putStr( cursor, ", " );
+            cursor = putNum( cursor, extractInstrSignedImm19( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
             
-        case ( OPC_GRP_ALU * 16 + OPC_IMMOP ): {
+        } break;
             
-            return ( snprintf( buf, LEN_32, "R%d, %d",
-                              extractInstrRegR( instr ),
-                              extractInstrImm20( instr )));
-        }
+        case IOP_BE: {
             
-        case ( OPC_GRP_MEM * 16 + OPC_ADD   ):
-        case ( OPC_GRP_MEM * 16 + OPC_SUB   ):
-        case ( OPC_GRP_MEM * 16 + OPC_AND   ):
-        case ( OPC_GRP_MEM * 16 + OPC_OR    ):
-        case ( OPC_GRP_MEM * 16 + OPC_XOR   ):
-        case ( OPC_GRP_MEM * 16 + OPC_LD    ):
-        case ( OPC_GRP_MEM * 16 + OPC_ST    ):
-        case ( OPC_GRP_MEM * 16 + OPC_LDR   ):
-        case ( OPC_GRP_MEM * 16 + OPC_STC   ): {
-            
-            if ( extractInstrBit( instr, 19 ) == 0 ) {
-                
-                return ( snprintf( buf, LEN_32, "R%d, %d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrSignedScaledImm13( instr ),
-                                   extractInstrRegB( instr )));
-            }
-            else {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegA( instr ),
-                                   extractInstrRegB( instr )));
-            }
-        }
-
-        case ( OPC_GRP_MEM * 16 + OPC_CMP_A ):
-        case ( OPC_GRP_MEM * 16 + OPC_CMP_B ): {
+            cursor = putNum( cursor, extractInstrSignedImm15( instr ));
+            cursor = putStr( cursor, "(R" );
+            cursor = putNum( cursor, extractInstrRegB( instr ));
+            cursor = putStr( cursor, "), " );
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
             
-            if ( extractInstrBit( instr, 26 ) == 0 ) {
-                
-                return ( snprintf( buf, LEN_32, "R%d, %d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrSignedScaledImm13( instr ),
-                                   extractInstrRegB( instr )));
-            }
-            else {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegA( instr ),
-                                   extractInstrRegB( instr )));
-            }
-        }
-
-        case ( OPC_GRP_ALU * 16 + OPC_LDO ): {
-
-            if ( extractInstrBit( instr, 19 ) == 0 ) {
-                
-                return ( snprintf( buf, LEN_32, "R%d, %d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrSignedScaledImm13( instr ),
-                                   extractInstrRegB( instr )));
-            }
-            else if ( extractInstrBit( instr, 19 ) == 1 ) {
-            
-                return ( snprintf( buf, LEN_32, "R%d, R%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegA( instr ),
-                                   extractInstrRegB( instr )));
-            } 
-            else return( snprintf( buf, LEN_32, "***" ));
-        }
+        } break;
             
-        case ( OPC_GRP_BR * 16 + OPC_B ): {
+        case IOP_BR: {
             
-            int cursor = snprintf( buf, LEN_32, ", %d", extractInstrSignedImm19( instr ));
+            cursor = putReg( cursor, 'R', extractInstrRegB( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
             
-            if ( extractInstrFieldU( instr, 26, 4 ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_32, ", R%d", 
-                                    extractInstrRegR( instr ));
-            }
+        } break;
             
-            return ( cursor );
-        }
-
-        case ( OPC_GRP_BR * 16 + OPC_BE ): {
-
-            int cursor = snprintf( buf, LEN_32, "%d", extractInstrSignedImm15( instr ));
-
-            cursor += snprintf( buf + cursor, LEN_32, "(R%d)", extractInstrRegB( instr ));
-            
-            if ( extractInstrFieldU( instr, 26, 4 ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_32, ", R%d", 
-                                    extractInstrRegR( instr ));
-            }
+        case IOP_BV: {
             
-            return ( cursor );
-        }
+            cursor = putReg( cursor, 'R', extractInstrRegB( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegA( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
             
-        case ( OPC_GRP_BR * 16 + OPC_BR ): {
-
-            int cursor = snprintf( buf, LEN_32, "R%d", extractInstrRegB( instr ));
+        } break;
             
-                if ( extractInstrFieldU( instr, 26, 4 ) != 0 ) {
-
-                    cursor += snprintf( buf + cursor, LEN_32, ", R%d", 
-                                                    extractInstrRegR( instr ));
-                }
+        case IOP_BB: {
             
-               return ( cursor ); 
-        }
-
-         case ( OPC_GRP_BR * 16 + OPC_BV ): {
-
-            int cursor = snprintf( buf, LEN_32, "R%d, R%d",
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr ));
-            
-            if ( extractInstrFieldU( instr, 26, 4 ) != 0 ) {
-
-                cursor += snprintf( buf + cursor, LEN_32, ", R%d", 
-                                    extractInstrRegR( instr ));
-                }
-
-            return ( cursor );
-        }
-            
-        case ( OPC_GRP_BR * 16 + OPC_BB ): {
-            
-            int cursor = snprintf( buf, LEN_32, "R%d", extractInstrRegR( instr ));
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
             
             if ( extractInstrBit( instr, 20 )) 
-                cursor += snprintf( buf + cursor, LEN_32, ", SAR" );
-            else  
-                cursor += snprintf( buf + cursor, LEN_32, ", %d", 
-                                    extractInstrFieldU( instr, 13, 6 ));
+                cursor = putStr( cursor, "SAR" );
+            else 
+                cursor = putNum( cursor, extractInstrFieldU( instr, 13, 6 ));
             
-            cursor += snprintf( buf + cursor, LEN_32, ", %d", extractInstrSignedImm13( instr ));
-            return ( cursor );
-        }
+            cursor = putStr( cursor, ", " );
+            cursor = putNum( cursor, extractInstrSignedImm13( instr ));
             
-        case ( OPC_GRP_BR * 16 + OPC_CBR ):
-        case ( OPC_GRP_BR * 16 + OPC_MBR ):  {
+        } break;
             
-            int cursor = snprintf( buf, LEN_32, "R%d, R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ));
+        case IOP_CBR: {
             
-            cursor += snprintf( buf + cursor, LEN_32, ", %d", extractInstrSignedImm15( instr ));
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegB( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putNum( cursor, extractInstrSignedImm15( instr ));
             
-            return ( cursor );
-        }
+        } break;
             
-        case ( OPC_GRP_SYS * 16 + OPC_MR ): {
-
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) {
+        case IOP_MFCR: 
+        case IOP_MTCR: {
             
-                return ( snprintf( buf, LEN_32, "R%d, C%d",
-                                    extractInstrRegR( instr ),
-                                    extractInstrRegB( instr )));
-            }
-            else if (extractInstrFieldU( instr, 19, 3 ) == 1 ) {
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'C', extractInstrRegB( instr ));
             
-                return ( snprintf( buf, LEN_32, "R%d, C%d, R%d",
-                                    extractInstrRegR( instr ),
-                                    extractInstrRegB( instr ),
-                                    extractInstrFieldU( instr, 0, 6 )));
-            }
-            else if ( extractInstrFieldU( instr, 19, 3 ) == 2 ) {
-
-                return ( snprintf( buf, LEN_32, "R%d",
-                                    extractInstrRegR( instr )));
-            }
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_LPA ): {
-            
-            if ( extractInstrFieldU( instr, 19, 3 ) == 0 ) {
-                
-                return ( snprintf( buf, LEN_32, "R%d, %d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrSignedImm13( instr ),
-                                   extractInstrRegB( instr )));
-            }
-            else {
+            if ( oprFmt == IOP_MTCR ) {
                 
-                return ( snprintf( buf, LEN_32, "R%d, R%d(R%d)",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegA( instr ),
-                                   extractInstrRegB( instr )));
+                cursor = putStr( cursor, ", " );
+                cursor = putReg( cursor, 'R', extractInstrFieldU( instr, 0, 6 ));
             }
-        }
             
-        case ( OPC_GRP_SYS * 16 + OPC_PRB ): {
+        } break;
             
-            if ( extractInstrBit( instr, 14 )) {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr )));
-            }
-            else {
-                
-                return ( snprintf( buf, LEN_32, "R%d, R%d, R%d",
-                                   extractInstrRegR( instr ),
-                                   extractInstrRegB( instr ),
-                                   extractInstrRegA( instr )));
-            }
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_TLB ): {
+        case IOP_R: {
             
-            return ( snprintf( buf, LEN_32, "R%d, R%d, R%d",
-                               extractInstrRegR( instr ),
-                               extractInstrRegB( instr ),
-                               extractInstrRegA( instr )));
-        }
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
             
-        case ( OPC_GRP_SYS * 16 + OPC_CA ): {
+        } break;
             
-            return ( snprintf( buf, LEN_32, "R%d, R%d",
-                               extractInstrRegR( instr ),
-                               extractInstrRegB( instr )));
-        }
+        case IOP_R_B: 
+        case IOP_PRB: {
             
-        case ( OPC_GRP_SYS * 16 + OPC_MST ): {
-            
-            return ( snprintf( buf, LEN_32, "R%d", extractInstrRegR( instr )));
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_RFI ): {
-            
-            return ( 0 );
-        }
-            
-        case ( OPC_GRP_SYS * 16 + OPC_TRAP ):  {
-            
-            return ( 0 );  // ??? to do ...
-        }
+            cursor = putReg( cursor, 'R', extractInstrRegR( instr ));
+            cursor = putStr( cursor, ", " );
+            cursor = putReg( cursor, 'R', extractInstrRegB( instr ));
             
-        case ( OPC_GRP_SYS * 16 + OPC_DIAG ):  {
+            if (( oprFmt == IOP_PRB ) && ( ! extractInstrBit( instr, 14 ))) {
+                
+                cursor = putStr( cursor, ", " );
+                cursor = putReg( cursor, 'R', extractInstrRegA( instr ));
+            }
             
-            return ( snprintf( buf, LEN_32, "R%d, R%d, R%d",
-                               extractInstrRegR( instr ),
-                               extractInstrRegB( instr ),
-                               extractInstrRegA( instr )));
-        }
+        } break;
             
-        case ( OPC_GRP_ALU * 16 + OPC_NOP ): {
+        case IOP_OPC:
+        default: {
             
-            buf[0] = 0;
-            return ( 0 );
+            cursor = putStr( cursor, "**OPC:" );
+            cursor = putNum( cursor, (int) ( instr >> 26 ));
+            cursor = putStr( cursor, "**" );
         }
-            
-        default: return ( snprintf( buf, LEN_32, "**OPC:%d**", opCode ));
     }
+    
+    *cursor = 0;
+    return ((int) ( cursor - buf ));
 }
 
 } // namespace
@@ -945,17 +478,41 @@ int T64DisAssemble::formatInstr( char *buf, int bufLen, uint32_t instr, int rdx
     
     if ( bufLen >= ( getOpCodeFieldWidth( ) + 1 + getOperandsFieldWidth( ))) {
         
-        char operandBuf[ LEN_32 ];
-
-        int cursor = buildOpCodeStr( buf, instr );
+        int cursor  = buildOpCodeStr( buf, instr );
+        int len     = buildOperandStr( buf + cursor + 1, instr, rdx );
         
-        buildOperandStr( operandBuf, instr, rdx );
-        if ( strlen( operandBuf ) > 0 ) {
+        if ( len > 0 ) {
             
-            cursor += snprintf( buf + cursor, LEN_32, " %s", operandBuf );
+            buf[ cursor ] = ' ';
+            cursor += 1 + len;
         }
+        else buf[ cursor ] = 0;
         
         return ( cursor );
     }
     else return ( -1 );
 }
+
+//----------------------------------------------------------------------------------------
+// Format a block of instructions. The caller passes an array of instruction words 
+// and a buffer with one fixed size line for each instruction. Line "i" starts at 
+// "buf + i * lineLen" and holds the same string "formatInstr" would produce. Listing
+// a whole code range is thus one call instead of one call per instruction. We return
+// the number of instructions formatted or -1 when the line length is too small.
+//
+//----------------------------------------------------------------------------------------
+int T64DisAssemble::formatInstrBlock( char           *buf, 
+                                      int            lineLen, 
+                                      const uint32_t *instr, 
+                                      int            count, 
+                                      int            rdx ) {
+    
+    if ( lineLen < ( getOpCodeFieldWidth( ) + 1 + getOperandsFieldWidth( ))) return ( -1 );
+    
+    for ( int i = 0; i < count; i++ ) {
+        
+        formatInstr( buf + ( i * lineLen ), lineLen, instr[ i ], rdx );
+    }
+    
+    return ( count );
+}
@@ -0,0 +1,401 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Instruction descriptions
+//
+//----------------------------------------------------------------------------------------
+// The one line assembler and the disassembler share one description of the
+// instruction set. The instruction templates are the opcode group, opcode family and
+// option field bits for a mnemonic. The assembler stores them for each mnemonic in
+// its token table. The instruction description table lists for each opcode family
+// and option field value the mnemonic and how the instruction options and operands
+// are formatted. The disassembler does not walk this table. At compile time, the table
+// is turned into a decode table, indexed by the upper instruction bits, which yields
+// the description entry directly.
+//
+// The upper instruction bits are the group bits ( 31, 30 ), the family bits ( 29 .. 26 )
+// and the option field bits ( 21, 20, 19 ), with the register R field in between. We
+// strip the register field, so that the decode table index is a 9-bit value.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Instruction descriptions
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#ifndef T64_InstrDesc_h
+#define T64_InstrDesc_h
+
+#include "T64-Common.h"
+
+//----------------------------------------------------------------------------------------
+// An instruction template consists of the instruction group bits ( 31,30 ), the op
+// code family bits ( 29, 28, 27, 26 ) and the option or mode bits ( 21, 20, 19 ). The
+// mode bits are for some instruction the default and could be changed during the
+// parsing process. From the defined constants we will build the instruction template
+// which is stored for the opcode mnemonic in the token value field. The values for the
+// opcode group and the opcode families are in the "T64-Types" include file.
+//
+//----------------------------------------------------------------------------------------
+enum InstrTemplate : uint32_t {
+
+    OPG_ALU      = ( OPC_GRP_ALU  << 30 ),
+    OPG_MEM      = ( OPC_GRP_MEM  << 30 ),
+    OPG_BR       = ( OPC_GRP_BR   << 30 ),
+    OPG_SYS      = ( OPC_GRP_SYS  << 30 ),
+
+    OPF_NOP      = ( OPC_NOP    << 26 ),
+    OPF_ADD      = ( OPC_ADD    << 26 ),
+    OPF_SUB      = ( OPC_SUB    << 26 ),
+    OPF_AND      = ( OPC_AND    << 26 ),
+    OPF_OR       = ( OPC_OR     << 26 ),
+    OPF_XOR      = ( OPC_XOR    << 26 ),
+    OPF_CMP      = ( OPC_CMP_A  << 26 ),
+    OPF_CMP_A    = ( OPC_CMP_A  << 26 ),
+    OPF_CMP_B    = ( OPC_CMP_B  << 26 ),
+    OPF_BITOP    = ( OPC_BITOP  << 26 ),
+    OPF_SHAOP    = ( OPC_SHAOP  << 26 ),
+    OPF_IMMOP    = ( OPC_IMMOP  << 26 ),
+    OPF_LDO      = ( OPC_LDO    << 26 ),
+
+    OPF_LD       = ( OPC_LD     << 26 ),
+    OPF_ST       = ( OPC_ST     << 26 ),
+    OPF_LDR      = ( OPC_LDR    << 26 ),
+    OPF_STC      = ( OPC_STC    << 26 ),
+
+    OPF_B        = ( OPC_B      << 26 ),
+    OPF_BE       = ( OPC_BE     << 26 ),
+    OPF_BR       = ( OPC_BR     << 26 ),
+    OPF_BV       = ( OPC_BV     << 26 ),
+
+    OPF_BB       = ( OPC_BB     << 26 ),
+    OPF_CBR      = ( OPC_CBR    << 26 ),
+    OPF_MBR      = ( OPC_MBR    << 26 ),
+    OPF_ABR      = ( OPC_ABR    << 26 ),
+
+    OPF_MR       = ( OPC_MR     << 26 ),
+    OPF_LPA      = ( OPC_LPA    << 26 ),
+    OPF_PRB      = ( OPC_PRB    << 26 ),
+    OPF_TLB      = ( OPC_TLB    << 26 ),
+    OPF_CA       = ( OPC_CA     << 26 ),
+    OPF_MST      = ( OPC_MST    << 26 ),
+    OPF_RFI      = ( OPC_RFI    << 26 ),
+    OPF_TRAP     = ( OPC_TRAP   << 26 ),
+    OPF_DIAG     = ( OPC_DIAG   << 26 ),
+
+    OPM_FLD_0    = ( 0U  << 19 ),
+    OPM_FLD_1    = ( 1U  << 19 ),
+    OPM_FLD_2    = ( 2U  << 19 ),
+    OPM_FLD_3    = ( 3U  << 19 ),
+    OPM_FLD_4    = ( 4U  << 19 ),
+    OPM_FLD_5    = ( 5U  << 19 ),
+    OPM_FLD_6    = ( 6U  << 19 ),
+    OPM_FLD_7    = ( 7U  << 19 )
+};
+
+//----------------------------------------------------------------------------------------
+// Template masks. An instruction description matches an instruction when the bits
+// selected by its mask are equal to the template. Most entries match on the opcode
+// group and family, or in addition on the option field or some of its bits.
+//
+//----------------------------------------------------------------------------------------
+enum InstrTemplateMask : uint32_t {
+
+    OPM_FAM         = 0xFC000000,
+    OPM_FAM_FLD     = 0xFC380000,
+    OPM_FAM_FLD_HI  = 0xFC300000,
+    OPM_FAM_FLD_21  = 0xFC200000
+};
+
+//----------------------------------------------------------------------------------------
+// Instruction option formats. The options follow the mnemonic in the order of the
+// flags below. "IOF_SHA" is special, the shift amount in the DW field completes the
+// mnemonic. The formats marked with "**" show option bits that have no meaning for
+// the instruction.
+//
+//----------------------------------------------------------------------------------------
+enum InstrOptFmt : uint32_t {
+
+    IOF_NIL         = 0,
+    IOF_SHA         = ( 1U << 0  ),     // "1A" .. "3A" from the DW field.
+    IOF_BAD_19      = ( 1U << 1  ),     // ".**" when bit 19 is set.
+    IOF_BAD_21      = ( 1U << 2  ),     // ".**" when bit 21 is set.
+    IOF_BAD_20_21   = ( 1U << 3  ),     // ".**" when bit 20 or 21 is set.
+    IOF_BAD         = ( 1U << 4  ),     // ".**" always.
+    IOF_U           = ( 1U << 5  ),     // ".U" when bit 20 is set.
+    IOF_COND        = ( 1U << 6  ),     // comparison condition from bits 19 .. 21.
+    IOF_DW          = ( 1U << 7  ),     // ".B", ".H", ".W" from the DW field.
+    IOF_C           = ( 1U << 8  ),     // ".C" when bit 20 is set.
+    IOF_BAD_20      = ( 1U << 9  ),     // ".**" when bit 20 is set.
+    IOF_N           = ( 1U << 10 ),     // ".N" when bit 21 is set.
+    IOF_S           = ( 1U << 11 ),     // ".S" when bit 12 is set.
+    IOF_Z           = ( 1U << 12 ),     // ".Z" when bit 12 is set.
+    IOF_G           = ( 1U << 13 ),     // ".G" when bit 19 is set.
+    IOF_TF          = ( 1U << 14 )      // ".T" or ".F" from bit 19.
+};
+
+//----------------------------------------------------------------------------------------
+// Instruction operand formats. "R" is the target register field, "B" and "A" are the
+// two source register fields. The formats that test a bit choose between the
+// immediate and the register form of an instruction.
+//
+//----------------------------------------------------------------------------------------
+enum InstrOprFmt : uint8_t {
+
+    IOP_NIL         = 0,    // no operands.
+    IOP_ALU         = 1,    // bit 19 ? R, B, imm15 : R, B, A
+    IOP_R_B_A       = 2,    // R, B, A
+    IOP_R_B_IMM     = 3,    // R, B, imm15
+    IOP_EXTR        = 4,    // R, B, pos | SAR, len
+    IOP_DEP         = 5,    // R, B | val, pos | SAR, len
+    IOP_DSR         = 6,    // R, B, A, len | SAR
+    IOP_BITOP       = 7,    // invalid bit operation
+    IOP_R_IMM20     = 8,    // R, imm20
+    IOP_MEM         = 9,    // bit 19 ? R, A(B) : R, ofs(B)
+    IOP_MEM_OFS     = 10,   // R, ofs(B)
+    IOP_MEM_IDX     = 11,   // R, A(B)
+    IOP_LPA         = 12,   // R, imm13(B)
+    IOP_B           = 13,   // , imm19, R
+    IOP_BE          = 14,   // imm15(B), R
+    IOP_BR          = 15,   // B, R
+    IOP_BV          = 16,   // B, A, R
+    IOP_BB          = 17,   // R, pos | SAR, imm13
+    IOP_CBR         = 18,   // R, B, imm15
+    IOP_MFCR        = 19,   // R, C
+    IOP_MTCR        = 20,   // R, C, R
+    IOP_R           = 21,   // R
+    IOP_R_B         = 22,   // R, B
+    IOP_PRB         = 23,   // bit 14 ? R, B : R, B, A
+    IOP_OPC         = 24    // no operand format, shows the opcode
+};
+
+//----------------------------------------------------------------------------------------
+// The instruction description. The mnemonic is the name shown by the disassembler.
+// The names with "**" describe the invalid option field values of an opcode family.
+//
+//----------------------------------------------------------------------------------------
+struct T64InstrDesc {
+
+    const char      *name;
+    uint32_t        instr;
+    uint32_t        mask;
+    uint32_t        optFmt;
+    InstrOprFmt     oprFmt;
+};
+
+//----------------------------------------------------------------------------------------
+// The instruction description table. The first matching entry describes an
+// instruction, so the entries for specific option field values come before the
+// entry for the opcode family. An instruction without a matching entry is shown
+// with its opcode number.
+//
+//----------------------------------------------------------------------------------------
+constexpr T64InstrDesc InstrDescTab[ ] = {
+
+    //------------------------------------------------------------------------------------
+    // ALU group.
+    //
+    //------------------------------------------------------------------------------------
+    { "NOP",        OPG_ALU | OPF_NOP,                  OPM_FAM,
+                    IOF_NIL,                            IOP_NIL         },
+    { "ADD",        OPG_ALU | OPF_ADD,                  OPM_FAM,
+                    IOF_NIL,                            IOP_ALU         },
+    { "SUB",        OPG_ALU | OPF_SUB,                  OPM_FAM,
+                    IOF_NIL,                            IOP_ALU         },
+    { "AND",        OPG_ALU | OPF_AND,                  OPM_FAM,
+                    IOF_C | IOF_N,                      IOP_ALU         },
+    { "OR",         OPG_ALU | OPF_OR,                   OPM_FAM,
+                    IOF_C | IOF_N,                      IOP_ALU         },
+    { "XOR",        OPG_ALU | OPF_XOR,                  OPM_FAM,
+                    IOF_BAD_20 | IOF_N,                 IOP_ALU         },
+    { "CMP",        OPG_ALU | OPF_CMP_A,                OPM_FAM,
+                    IOF_COND,                           IOP_R_B_A       },
+    { "CMP",        OPG_ALU | OPF_CMP_B,                OPM_FAM,
+                    IOF_COND,                           IOP_R_B_IMM     },
+    { "EXTR",       OPG_ALU | OPF_BITOP | OPM_FLD_0,    OPM_FAM_FLD,
+                    IOF_S,                              IOP_EXTR        },
+    { "DEP",        OPG_ALU | OPF_BITOP | OPM_FLD_1,    OPM_FAM_FLD,
+                    IOF_Z,                              IOP_DEP         },
+    { "DSR",        OPG_ALU | OPF_BITOP | OPM_FLD_2,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_DSR         },
+    { "**BITOP**",  OPG_ALU | OPF_BITOP,                OPM_FAM,
+                    IOF_NIL,                            IOP_BITOP       },
+    { "SHL",        OPG_ALU | OPF_SHAOP | OPM_FLD_0,    OPM_FAM_FLD_HI,
+                    IOF_SHA,                            IOP_ALU         },
+    { "SHR",        OPG_ALU | OPF_SHAOP | OPM_FLD_2,    OPM_FAM_FLD_HI,
+                    IOF_SHA,                            IOP_ALU         },
+    { "**SHAOP**",  OPG_ALU | OPF_SHAOP,                OPM_FAM,
+                    IOF_NIL,                            IOP_ALU         },
+    { "ADDIL",      OPG_ALU | OPF_IMMOP | OPM_FLD_0,    OPM_FAM_FLD_HI,
+                    IOF_NIL,                            IOP_R_IMM20     },
+    { "LDI.L",      OPG_ALU | OPF_IMMOP | OPM_FLD_2,    OPM_FAM_FLD_HI,
+                    IOF_NIL,                            IOP_R_IMM20     },
+    { "LDI.S",      OPG_ALU | OPF_IMMOP | OPM_FLD_4,    OPM_FAM_FLD_HI,
+                    IOF_NIL,                            IOP_R_IMM20     },
+    { "LDI.U",      OPG_ALU | OPF_IMMOP | OPM_FLD_6,    OPM_FAM_FLD_HI,
+                    IOF_NIL,                            IOP_R_IMM20     },
+    { "LDO",        OPG_ALU | OPF_LDO   | OPM_FLD_0,    OPM_FAM_FLD,
+                    IOF_DW,                             IOP_MEM         },
+    { "LDO",        OPG_ALU | OPF_LDO,                  OPM_FAM,
+                    IOF_NIL,                            IOP_MEM         },
+
+    //------------------------------------------------------------------------------------
+    // MEM group.
+    //
+    //------------------------------------------------------------------------------------
+    { "ADD",        OPG_MEM | OPF_ADD,                  OPM_FAM,
+                    IOF_DW,                             IOP_MEM         },
+    { "SUB",        OPG_MEM | OPF_SUB,                  OPM_FAM,
+                    IOF_DW,                             IOP_MEM         },
+    { "AND",        OPG_MEM | OPF_AND,                  OPM_FAM,
+                    IOF_DW | IOF_C | IOF_N,             IOP_MEM         },
+    { "OR",         OPG_MEM | OPF_OR,                   OPM_FAM,
+                    IOF_DW | IOF_C | IOF_N,             IOP_MEM         },
+    { "XOR",        OPG_MEM | OPF_XOR,                  OPM_FAM,
+                    IOF_DW | IOF_BAD_20 | IOF_N,        IOP_MEM         },
+    { "CMP",        OPG_MEM | OPF_CMP_A,                OPM_FAM,
+                    IOF_COND | IOF_DW,                  IOP_MEM_OFS     },
+    { "CMP",        OPG_MEM | OPF_CMP_B,                OPM_FAM,
+                    IOF_COND | IOF_DW,                  IOP_MEM_IDX     },
+    { "LD",         OPG_MEM | OPF_LD,                   OPM_FAM,
+                    IOF_U | IOF_DW,                     IOP_MEM         },
+    { "ST",         OPG_MEM | OPF_ST,                   OPM_FAM,
+                    IOF_DW,                             IOP_MEM         },
+    { "LDR",        OPG_MEM | OPF_LDR,                  OPM_FAM,
+                    IOF_U,                              IOP_MEM         },
+    { "STC",        OPG_MEM | OPF_STC   | OPM_FLD_0,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_MEM         },
+    { "STC",        OPG_MEM | OPF_STC,                  OPM_FAM,
+                    IOF_BAD,                            IOP_MEM         },
+
+    //------------------------------------------------------------------------------------
+    // BR group.
+    //
+    //------------------------------------------------------------------------------------
+    { "B",          OPG_BR  | OPF_B,                    OPM_FAM,
+                    IOF_BAD_20_21 | IOF_G,              IOP_B           },
+    { "BE",         OPG_BR  | OPF_BE,                   OPM_FAM,
+                    IOF_BAD_20_21 | IOF_G,              IOP_BE          },
+    { "BR",         OPG_BR  | OPF_BR,                   OPM_FAM,
+                    IOF_NIL,                            IOP_BR          },
+    { "BV",         OPG_BR  | OPF_BV,                   OPM_FAM,
+                    IOF_NIL,                            IOP_BV          },
+    { "BB",         OPG_BR  | OPF_BB,                   OPM_FAM,
+                    IOF_BAD_21 | IOF_TF,                IOP_BB          },
+    { "CBR",        OPG_BR  | OPF_CBR,                  OPM_FAM,
+                    IOF_BAD_19 | IOF_COND,              IOP_CBR         },
+    { "MBR",        OPG_BR  | OPF_MBR,                  OPM_FAM,
+                    IOF_BAD_19 | IOF_COND,              IOP_CBR         },
+    { "ABR",        OPG_BR  | OPF_ABR,                  OPM_FAM,
+                    IOF_BAD_19 | IOF_COND,              IOP_OPC         },
+
+    //------------------------------------------------------------------------------------
+    // SYS group.
+    //
+    //------------------------------------------------------------------------------------
+    { "MFCR ",      OPG_SYS | OPF_MR    | OPM_FLD_0,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_MFCR        },
+    { "MTCR ",      OPG_SYS | OPF_MR    | OPM_FLD_1,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_MTCR        },
+    { "MFIA ",      OPG_SYS | OPF_MR    | OPM_FLD_2,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R           },
+    { "**MROP**",   OPG_SYS | OPF_MR,                   OPM_FAM,
+                    IOF_NIL,                            IOP_MEM_IDX     },
+    { "LPA",        OPG_SYS | OPF_LPA   | OPM_FLD_0,    OPM_FAM_FLD,
+                    IOF_DW,                             IOP_LPA         },
+    { "**LPAOP**",  OPG_SYS | OPF_LPA,                  OPM_FAM,
+                    IOF_DW,                             IOP_MEM_IDX     },
+    { "PRB",        OPG_SYS | OPF_PRB   | OPM_FLD_0,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_PRB         },
+    { "**PRBOP**",  OPG_SYS | OPF_PRB,                  OPM_FAM,
+                    IOF_NIL,                            IOP_PRB         },
+    { "IITLB",      OPG_SYS | OPF_TLB   | OPM_FLD_0,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R_B_A       },
+    { "IDTLB",      OPG_SYS | OPF_TLB   | OPM_FLD_1,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R_B_A       },
+    { "PITLB",      OPG_SYS | OPF_TLB   | OPM_FLD_2,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R_B_A       },
+    { "PDTLB",      OPG_SYS | OPF_TLB   | OPM_FLD_3,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R_B_A       },
+    { "**TLB**",    OPG_SYS | OPF_TLB,                  OPM_FAM,
+                    IOF_NIL,                            IOP_R_B_A       },
+    { "PICA",       OPG_SYS | OPF_CA    | OPM_FLD_0,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R_B         },
+    { "PDCA",       OPG_SYS | OPF_CA    | OPM_FLD_1,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R_B         },
+    { "FICA",       OPG_SYS | OPF_CA    | OPM_FLD_2,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R_B         },
+    { "FDCA",       OPG_SYS | OPF_CA    | OPM_FLD_3,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R_B         },
+    { "**CA**",     OPG_SYS | OPF_CA,                   OPM_FAM,
+                    IOF_NIL,                            IOP_R_B         },
+    { "RSM",        OPG_SYS | OPF_MST   | OPM_FLD_0,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R           },
+    { "SSM",        OPG_SYS | OPF_MST   | OPM_FLD_1,    OPM_FAM_FLD,
+                    IOF_NIL,                            IOP_R           },
+    { "**MST**",    OPG_SYS | OPF_MST,                  OPM_FAM,
+                    IOF_NIL,                            IOP_R           },
+    { "RFI",        OPG_SYS | OPF_RFI,                  OPM_FAM,
+                    IOF_NIL,                            IOP_NIL         },
+    { "TRAP",       OPG_SYS | OPF_TRAP,                 OPM_FAM,
+                    IOF_NIL,                            IOP_NIL         },
+    { "DIAG",       OPG_SYS | OPF_DIAG,                 OPM_FAM,
+                    IOF_NIL,                            IOP_R_B_A       }
+};
+
+constexpr int MAX_INSTR_DESC_TAB = sizeof( InstrDescTab ) / sizeof( T64InstrDesc );
+
+//----------------------------------------------------------------------------------------
+// The decode table. The index is built from the group, family and option field bits.
+// Each slot holds the index of the first matching description, or -1. The table is
+// built by the compiler from the description table.
+//
+//----------------------------------------------------------------------------------------
+constexpr uint32_t instrDecodeIndex( uint32_t instr ) {
+
+    return((( instr >> 23 ) & 0x1F8 ) | (( instr >> 19 ) & 0x7 ));
+}
+
+struct T64InstrDecodeTab {
+
+    static constexpr int SLOTS = 512;
+
+    int8_t  slots[ SLOTS ] = { };
+
+    constexpr T64InstrDecodeTab( ) {
+
+        for ( int i = 0; i < SLOTS; i++ ) {
+
+            uint32_t instr = (((uint32_t) i & 0x1F8 ) << 23 ) | (((uint32_t) i & 0x7 ) << 19 );
+
+            slots[ i ] = -1;
+
+            for ( int k = 0; k < MAX_INSTR_DESC_TAB; k++ ) {
+
+                if (( instr & InstrDescTab[ k ].mask ) == InstrDescTab[ k ].instr ) {
+
+                    slots[ i ] = (int8_t) k;
+                    break;
+                }
+            }
+        }
+    }
+
+    constexpr int lookup( uint32_t instr ) const {
+
+        return( slots[ instrDecodeIndex( instr ) ] );
+    }
+};
+
+constexpr T64InstrDecodeTab InstrDecodeTab = T64InstrDecodeTab( );
+
+#endif // T64_InstrDesc_h
@@ -49,7 +49,7 @@ T64Memory::T64Memory( T64System     *sys,
                       T64MemKind    mKind,
                       T64MemType    mType,
                       T64Word       spaAdr,
-                      int           spaLen ) : 
+                      T64Word       spaLen ) : 
 
                       T64Module(    MT_MEM, 
                                     modNum,
@@ -66,6 +66,7 @@ T64Memory::T64Memory( T64System     *sys,
 
 T64Memory:: ~T64Memory( ) {
 
+    if ( memData != nullptr ) free( memData );
 }
 
 //----------------------------------------------------------------------------------------
@@ -86,6 +87,21 @@ void T64Memory::step( ) {
     
 }
 
+//----------------------------------------------------------------------------------------
+// Save and restore the memory content for a record and replay snapshot. The whole
+// SPA range is copied.
+//
+//----------------------------------------------------------------------------------------
+void T64Memory::saveState( T64StateBuf *buf ) {
+
+    if ( memData != nullptr ) buf -> put( memData, spaLen );
+}
+
+void T64Memory::restoreState( T64StateBuf *buf ) {
+
+    if ( memData != nullptr ) buf -> get( memData, spaLen );
+}
+
 //----------------------------------------------------------------------------------------
 // Read function. We read a block of data from memory. The address the physical address
 // and we compute the offset on our SPA range. The address needs to be aligned with 
@@ -100,13 +116,12 @@ bool T64Memory::read( T64Word adr, uint8_t *data, int len ) {
 
     if ( isInIoAdrRange( adr )) {
 
-         // for now ...
-        *data = 0;
+        // for now ...
         return ( false );
     }
     else {
 
-        if ( adr + len >= spaAdr + spaLen ) return( false );
+        if (( adr < spaAdr ) || ( adr + len > spaAdr + spaLen )) return( false );
         if ( ! isAlignedDataAdr( adr, len )) return( false );
 
         uint8_t *srcPtr = &memData[ adr - spaAdr ];
@@ -128,13 +143,12 @@ bool T64Memory::write( T64Word adr, uint8_t *data, int len ) {
 
     if ( isInIoAdrRange( adr )) {
 
-         // for now ...
-        *data = 0;
+        // for now ... the data belongs to the writer, leave it untouched.
         return ( false );
     }
     else {
 
-        if ( adr + len >= spaAdr + spaLen ) return( false );
+        if (( adr < spaAdr ) || ( adr + len > spaAdr + spaLen )) return( false );
         if ( ! isAlignedDataAdr( adr, len )) return( false );
         if ( spaReadOnly ) return ( false );
 
@@ -143,6 +157,31 @@ bool T64Memory::write( T64Word adr, uint8_t *data, int len ) {
     }
 }
 
+//----------------------------------------------------------------------------------------
+// Block read and write functions. A block is a cache line. The cache keeps the line
+// in the big endian byte order of the memory array, so the block is just copied. The
+// address needs to be aligned with the length parameter.
+//
+//----------------------------------------------------------------------------------------
+bool T64Memory::readBlock( T64Word adr, uint8_t *data, int len ) {
+
+    if (( adr < spaAdr ) || ( adr + len > spaAdr + spaLen )) return( false );
+    if (( adr & ( len - 1 )) != 0 ) return( false );
+
+    memcpy( data, &memData[ adr - spaAdr ], len );
+    return( true );
+}
+
+bool T64Memory::writeBlock( T64Word adr, uint8_t *data, int len ) {
+
+    if (( adr < spaAdr ) || ( adr + len > spaAdr + spaLen )) return( false );
+    if (( adr & ( len - 1 )) != 0 ) return( false );
+    if ( spaReadOnly ) return ( false );
+
+    memcpy( &memData[ adr - spaAdr ], data, len );
+    return( true );
+}
+
 //----------------------------------------------------------------------------------------
 // A memory address range can be set road only, This is used when we model a ROM.
 //
@@ -152,6 +191,30 @@ void  T64Memory::setSpaReadOnly( bool arg ) {
     spaReadOnly = arg;
 }
 
+//----------------------------------------------------------------------------------------
+// Load a memory image file. The file contains the memory content in big endian byte
+// order, which is exactly how the memory array stores the data. The file is therefore
+// just copied to the start of the memory range. The file must not be larger than
+// the module and all of its bytes must be read, a short read fails the load.
+//
+//----------------------------------------------------------------------------------------
+bool T64Memory::loadImage( const char *fileName ) {
+
+    FILE *fp = fopen( fileName, "rb" );
+    if ( fp == nullptr ) return( false );
+
+    long fileLen = -1;
+    if ( fseek( fp, 0, SEEK_END ) == 0 ) fileLen = ftell( fp );
+
+    bool rStat = ( fileLen >= 0 ) &&
+                 ((T64Word) fileLen <= spaLen ) &&
+                 ( fseek( fp, 0, SEEK_SET ) == 0 ) &&
+                 ( fread( memData, 1, fileLen, fp ) == (size_t) fileLen );
+    
+    fclose( fp );
+    return( rStat );
+}
+
 //----------------------------------------------------------------------------------------
 // Getters for memory kind and type.
 //
@@ -203,7 +266,7 @@ bool T64Memory::busOpReadSharedBlock( int     srcModNum,
                                       uint8_t *data, 
                                       int     len ) {
 
-    return( read( pAdr, data, len ));
+    return( readBlock( pAdr, data, len ));
 }
 
 bool T64Memory::busOpReadPrivateBlock( int     srcModNum, 
@@ -211,7 +274,7 @@ bool T64Memory::busOpReadPrivateBlock( int     srcModNum,
                                        uint8_t *data, 
                                        int     len ) {
 
-    return( read( pAdr, data, len ));
+    return( readBlock( pAdr, data, len ));
 }
 
 bool T64Memory::busOpWriteBlock( int     srcModNum,
@@ -219,5 +282,34 @@ bool T64Memory::busOpWriteBlock( int     srcModNum,
                                  uint8_t *data, 
                                  int     len ) {
 
-    return( write( pAdr, data, len ));
+    return( writeBlock( pAdr, data, len ));
+}
+
+//----------------------------------------------------------------------------------------
+// DMA transfers. The memory array is in big endian byte order, which is also the 
+// byte order of the DMA data stream. The block is copied in one piece. The system
+// has already checked that the block is covered by this module.
+//
+//----------------------------------------------------------------------------------------
+bool T64Memory::busOpDmaRead( int     srcModNum,
+                              T64Word pAdr, 
+                              uint8_t *data, 
+                              T64Word len ) {
+
+    if (( pAdr < spaAdr ) || ( pAdr + len > spaAdr + spaLen )) return( false );
+    
+    memcpy( data, &memData[ pAdr - spaAdr ], len );
+    return( true );
+}
+
+bool T64Memory::busOpDmaWrite( int     srcModNum,
+                               T64Word pAdr, 
+                               uint8_t *data, 
+                               T64Word len ) {
+
+    if (( pAdr < spaAdr ) || ( pAdr + len > spaAdr + spaLen )) return( false );
+    if ( spaReadOnly ) return ( false );
+    
+    memcpy( &memData[ pAdr - spaAdr ], data, len );
+    return( true );
 }
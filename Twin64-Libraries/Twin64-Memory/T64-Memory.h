@@ -27,6 +27,7 @@
 #include "T64-Util.h"
 #include "T64-Common.h"
 #include "T64-System.h"
+#include "T64-Replay.h"
 
 //----------------------------------------------------------------------------------------
 // Memory. There are two basic kinds of memory. ReadWrite and ReadOnly.
@@ -60,12 +61,14 @@ public:
                T64MemKind   mKind,
                T64MemType   mType,
                T64Word      spaAdr,
-               int          spaLen);
+               T64Word      spaLen );
 
     virtual     ~ T64Memory( );
     
     void        reset( );
     void        step( );
+    void        saveState( T64StateBuf *buf );
+    void        restoreState( T64StateBuf *buf );
     void        setSpaReadOnly( bool arg );
 
     T64MemKind  getMemKind( );
@@ -97,12 +100,26 @@ public:
                                 uint8_t *data, 
                                 int len );
 
-    // ??? routines to load/save memory ?
+    bool        busOpDmaRead( int srcModNum,
+                              T64Word pAdr, 
+                              uint8_t *data, 
+                              T64Word len );
+
+    bool        busOpDmaWrite( int srcModNum,
+                               T64Word pAdr, 
+                               uint8_t *data, 
+                               T64Word len );
+
+    bool        loadImage( const char *fileName );
+
+    // ??? routines to save memory ?
 
 private:
 
     bool        read( T64Word adr, uint8_t *data, int len );
     bool        write( T64Word adr, uint8_t *data, int len );
+    bool        readBlock( T64Word adr, uint8_t *data, int len );
+    bool        writeBlock( T64Word adr, uint8_t *data, int len );
     
     T64MemKind  mKind       = T64_MK_NIL;
     T64MemType  mType       = T64_MT_NIL;
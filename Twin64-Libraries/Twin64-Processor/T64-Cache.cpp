@@ -274,10 +274,10 @@ T64Cache::T64Cache( T64Processor    *proc,
     tagShift        = offsetBits + indexBits;
     cacheHits       = 0;
     cacheMiss       = 0;
-    plruState       = 0;
 
     cacheInfo = (T64CacheLineInfo *) malloc( ways * sets * sizeof( T64CacheLineInfo ));
     cacheData = (uint8_t *) malloc( ways * sets * lineSize );
+    plruState = (uint8_t *) malloc( sets );
 
     reset( );
 }
@@ -290,28 +290,54 @@ T64Cache:: ~T64Cache( ) {
 
     free( cacheInfo );
     free( cacheData );
+    free( plruState );
 }   
 
 //----------------------------------------------------------------------------------------
-// Reset. For now, clear the statistics.
+// Reset. Clear the statistics, the replacement state and invalidate all lines.
 //
 //----------------------------------------------------------------------------------------
 void T64Cache::reset( ) {
 
     cacheHits   = 0;
     cacheMiss   = 0;
-    plruState   = 0;
+
+    for ( int i = 0; i < sets; i++ ) plruState[ i ] = 0;
 
     for ( int i = 0; i < ( ways * sets ); i++ ) {
 
-        cacheInfo[ i ].valid    = false;
-        cacheInfo[ i ].modified = false;
-        cacheInfo[ i ].tag      = 0;
+        cacheInfo[ i ].valid        = false;
+        cacheInfo[ i ].exclusive    = false;
+        cacheInfo[ i ].modified     = false;
+        cacheInfo[ i ].tag          = 0;
     }
 }
 
 void T64Cache::step( ) { }
 
+//----------------------------------------------------------------------------------------
+// Save and restore the cache state. These are the line info, the line data, the 
+// replacement state and the counters.
+//
+//----------------------------------------------------------------------------------------
+void T64Cache::saveState( T64StateBuf *buf ) {
+
+    buf -> put( cacheInfo, ways * sets * sizeof( T64CacheLineInfo ));
+    buf -> put( cacheData, ways * sets * lineSize );
+    buf -> put( &cacheHits, sizeof( cacheHits ));
+    buf -> put( &cacheMiss, sizeof( cacheMiss ));
+    buf -> put( plruState, sets );
+}
+
+void T64Cache::restoreState( T64StateBuf *buf ) {
+
+    buf -> get( cacheInfo, ways * sets * sizeof( T64CacheLineInfo ));
+    buf -> get( cacheData, ways * sets * lineSize );
+    buf -> get( &cacheHits, sizeof( cacheHits ));
+    buf -> get( &cacheMiss, sizeof( cacheMiss ));
+    buf -> get( plruState, sets );
+}
+
 //----------------------------------------------------------------------------------------
 // Helper functions.
 //
@@ -346,9 +372,24 @@ int T64Cache::getWays( ) {
     return( lineSize );
  }
 
+int T64Cache::getRequestCount( ) {
+
+    return( cacheHits + cacheMiss );
+}
+
+int T64Cache::getHitCount( ) {
+
+    return( cacheHits );
+}
+
+int T64Cache::getMissCount( ) {
+
+    return( cacheMiss );
+}
+
 T64Word T64Cache:: pAdrFromTag( uint32_t tag, uint32_t index ) {
 
-    return(( tag << ( offsetBits + indexBits ) | ( index < indexShift )));
+    return((((T64Word) tag ) << tagShift ) | (((T64Word) index ) << indexShift ));
 }
 
 T64CacheKind T64Cache::getCacheKind( ) {
@@ -376,52 +417,54 @@ char *T64Cache::getCacheTypeString( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// The set associative cache uses a pseudo LRU scheme. There are two local routines,
-// select a victim and update the state. Depending on the number of ways, we call the
-// respective local routine.
+// The set associative cache uses a pseudo LRU scheme with one state per set. There 
+// are two local routines, select a victim and update the state with the way just 
+// used. Depending on the number of ways, we call the respective local routine.
 //
 //----------------------------------------------------------------------------------------
-int T64Cache::plruVictim( ) {
+int T64Cache::plruVictim( uint32_t set ) {
 
     switch( ways ) {
 
-        case 2: return( plru2Victim( plruState ));
-        case 4: return( plru4Victim( plruState ));
-        case 8: return( plru8Victim( plruState ));
+        case 2: return( plru2Victim( plruState[ set ] ));
+        case 4: return( plru4Victim( plruState[ set ] ));
+        case 8: return( plru8Victim( plruState[ set ] ));
         default: return( 0 );
     }
 }
 
-void T64Cache::plruUpdate( ) {
+void T64Cache::plruUpdate( uint32_t set, int way ) {
 
     switch( ways ) {
 
-        case 2:  plruState = plru2Update( plruState, ways ); break;
-        case 4:  plruState = plru4Update( plruState, ways ); break;
-        case 8:  plruState = plru8Update( plruState, ways ); break;
-        default: plruState = 0;
+        case 2:  plruState[ set ] = plru2Update( plruState[ set ], way ); break;
+        case 4:  plruState[ set ] = plru4Update( plruState[ set ], way ); break;
+        case 8:  plruState[ set ] = plru8Update( plruState[ set ], way ); break;
+        default: plruState[ set ] = 0;
     }
 }
 
 //----------------------------------------------------------------------------------------
 // "lookup" searches the cache sets. If we find a valid cache line with the matching
-// tag, we return the pointers to the line.
+// tag, we return the pointers to the line and optionally the way number.
 //
 //----------------------------------------------------------------------------------------
 bool T64Cache::lookupCache( T64Word          pAdr, 
                             T64CacheLineInfo **info, 
-                            uint8_t          **data ) {
+                            uint8_t          **data,
+                            int              *way ) {
 
     uint32_t  tag = getTag( pAdr );
     uint32_t  set = getSetIndex( pAdr );
 
     for ( int w = 0; w < ways; w++ ) {
 
-        T64CacheLineInfo *l = &cacheInfo[ w * set ];
+        T64CacheLineInfo *l = &cacheInfo[ ( w * sets ) + set ];
         if (( l -> valid ) && ( l -> tag == tag )) {
 
             *info = l;
             *data = &cacheData[ (( w * sets ) + set ) * lineSize ];
+            if ( way != nullptr ) *way = w;
             return( true );
         }
     }
@@ -439,16 +482,16 @@ bool T64Cache::getCacheLineByIndex( uint32_t         way,
                              T64CacheLineInfo **info, 
                              uint8_t       **data ) {
 
-    if (( way > ways ) || ( set > sets )) return ( false );
+    if (( way >= (uint32_t) ways ) || ( set >= (uint32_t) sets )) return ( false );
    
-    *info  = &cacheInfo[ way * set ];
+    *info  = &cacheInfo[ ( way * sets ) + set ];
     *data = &cacheData[ (( way * sets ) + set ) * lineSize ];
     return ( true );
 }
 
 bool T64Cache::purgeCacheLineByIndex( uint32_t way, uint32_t set ) {
 
-    if (( way > ways ) || ( set > sets )) return ( false );
+    if (( way >= (uint32_t) ways ) || ( set >= (uint32_t) sets )) return ( false );
 
     // ??? to do ...
 
@@ -457,7 +500,7 @@ bool T64Cache::purgeCacheLineByIndex( uint32_t way, uint32_t set ) {
 
 bool T64Cache::flushCacheLineByIndex( uint32_t way, uint32_t set ) {
 
-    if (( way > ways ) || ( set > sets )) return ( false );
+    if (( way >= (uint32_t) ways ) || ( set >= (uint32_t) sets )) return ( false );
 
     // ??? to do ...
 
@@ -468,7 +511,9 @@ bool T64Cache::flushCacheLineByIndex( uint32_t way, uint32_t set ) {
 // "getCacheLineData" copies data from the cache line. We expect a valid len argument.
 // We essentially copy data from the cache line to the target location. Care has to 
 // be taken about the endianess of the host CPU. Our simulator is big endian. 
-// Depending on the endianess of the host CPU, the data needs to be converted.
+// Depending on the endianess of the host CPU, the data needs to be converted. The 
+// caller already passes the target location for the data item, just as for an 
+// uncached memory read.
 // 
 //----------------------------------------------------------------------------------------
 bool T64Cache::getCacheLineData( uint8_t *line, 
@@ -476,8 +521,7 @@ bool T64Cache::getCacheLineData( uint8_t *line,
                                     int     len, 
                                     uint8_t *data ) {
 
-    int wOfs = sizeof( T64Word ) - len;
-    return ( copyToBigEndian(( data + wOfs ), &line[ lineOfs ], len )); 
+    return ( copyToBigEndian( data, &line[ lineOfs ], len )); 
 }
 
 //----------------------------------------------------------------------------------------
@@ -495,16 +539,64 @@ bool T64Cache::setCacheLineData( uint8_t *line,
     return( copyToBigEndian( &line[ lineOfs ], data, len ));
 }
 
+//----------------------------------------------------------------------------------------
+// "allocateCacheLine" selects the slot for a new cache line. An invalid way in the set
+// is used first, otherwise the pseudo LRU victim. If the victim line was modified, it
+// is written back first. The slot is returned invalid, the caller fills it in with a 
+// READ SHARED or READ PRIVATE request.
+//
+//----------------------------------------------------------------------------------------
+void T64Cache::allocateCacheLine( T64Word          pAdr,
+                                  T64CacheLineInfo **info,
+                                  uint8_t          **data ) {
+
+    uint32_t setIndex = getSetIndex( pAdr );
+    int      vWay     = -1;
+
+    for ( int w = 0; w < ways; w++ ) {
+
+        if ( ! cacheInfo[ ( w * sets ) + setIndex ].valid ) {
+            
+            vWay = w;
+            break;
+        }
+    }
+
+    if ( vWay < 0 ) vWay = plruVictim( setIndex );
+    plruUpdate( setIndex, vWay );
+
+    if ( ! getCacheLineByIndex( vWay, setIndex, info, data )) {
+        
+        throw( T64Trap( MACHINE_CHECK ));
+    }
+
+    if (( *info ) -> valid ) {
+
+        if (( *info ) -> modified ) {
+
+            if ( ! proc -> busOpWriteBlock( proc -> getModuleNum( ),
+                                            pAdrFromTag(( *info ) -> tag, setIndex ), 
+                                            *data, 
+                                            lineSize )) {        
+                
+                throw( T64Trap( MACHINE_CHECK ));
+            }
+        }
+    }
+
+    ( *info ) -> valid      = false;
+    ( *info ) -> exclusive  = false;
+    ( *info ) -> modified   = false;
+}
+
 //----------------------------------------------------------------------------------------
 // "readCacheData" is the routine to get the data from the cache. We first check for
 // any alignment errors. Next, lookup the cache. If the line is found, just return
 // the data.
 //
-// If the cache does not have the data, we need to get it. First select a victim line
-// to read in the cache line from memory. If we select an unused line, easy, just 
-// issue a shared read request to the T64 system. If the cache line is valid, we need
-// to check if it was modified. If so, we need to flush the data first. Then we READ 
-// SHARED the new cache line into this slot. Finally, we return the requested data.
+// If the cache does not have the data, we need to get it. We allocate a slot, which
+// writes back a modified victim line, and READ SHARED the new cache line into this 
+// slot. Finally, we return the requested data.
 //
 //----------------------------------------------------------------------------------------
 void T64Cache::readCacheData( T64Word pAdr, uint8_t *data, int len ) {
@@ -516,51 +608,28 @@ void T64Cache::readCacheData( T64Word pAdr, uint8_t *data, int len ) {
 
     T64CacheLineInfo *cInfo;
     uint8_t          *cData;
+    int              way;
 
-    if ( lookupCache( pAdr, &cInfo, &cData )) {
+    if ( lookupCache( pAdr, &cInfo, &cData, &way )) {
 
         cacheHits ++;
-        plruUpdate( );
-
-        getCacheLineData( cData, getLineOfs( pAdr ), len, data );
+        plruUpdate( getSetIndex( pAdr ), way );
     }
     else {
 
         cacheMiss ++;
-
-        int      vWay     = plruVictim( );
-        uint32_t setIndex = getSetIndex( pAdr );
-        plruUpdate( );
+        allocateCacheLine( pAdr, &cInfo, &cData );
         
-        if ( ! getCacheLineByIndex( vWay, setIndex, &cInfo, &cData )) {
-        
-            throw( T64Trap( MACHINE_CHECK ));
-        }
-    
-        if ( cInfo -> valid ) {
-
-            if ( cInfo -> modified ) {
-
-                if ( ! proc -> busOpReadSharedBlock( 
-                                            proc -> getModuleNum( ),
-                                            pAdrFromTag( cInfo -> tag, setIndex ), 
-                                            cData,
-                                            lineSize )) {
-
-                    throw( T64Trap( MACHINE_CHECK )); // ??? fill in ...
-                }
-            }
-
-            cInfo -> valid = false;
-        }
-
         if ( ! proc -> busOpReadSharedBlock( proc -> getModuleNum( ), 
-                                             pAdr, 
+                                             pAdr & ~offsetBitmask, 
                                              cData, 
                                              lineSize )) {
 
-            throw( T64Trap( MACHINE_CHECK )); // ??? fill in ...
+            throw( T64Trap( MACHINE_CHECK ));
         }
+
+        cInfo -> valid  = true;
+        cInfo -> tag    = getTag( pAdr );
     }
 
     getCacheLineData( cData, getLineOfs( pAdr ), len, data );
@@ -568,15 +637,14 @@ void T64Cache::readCacheData( T64Word pAdr, uint8_t *data, int len ) {
 
 //----------------------------------------------------------------------------------------
 // "writeCacheData" is the routine to write data to the cache. We first check for
-// any alignment errors. Next, lookup the cache. If the line is found, just update
-// the data in the cache line.
+// any alignment errors. Next, lookup the cache. If the line is found and we own it
+// exclusively, just update the data in the cache line. A shared line could also be
+// held by other caches, we READ PRIVATE it again so that all other copies are purged
+// and any reservation on the line is cancelled before the data is updated.
 //
-// If the cache does not have the cache line, we need to get it first. First select 
-// a victim line to read in the cache line from memory. If we select an unused line,
-// easy, just issue a shared private request to the T64 system. If the cache line is
-// valid, we need to check if it was modified. If so, we need to flush the data first.
-// Then we READ PRIVATE the new cache line into this slot. Finally, we update the 
-// cache line.
+// If the cache does not have the cache line, we need to get it first. We allocate a
+// slot, which writes back a modified victim line, and READ PRIVATE the new cache line
+// into this slot. Finally, we update the cache line.
 //
 //----------------------------------------------------------------------------------------
 void T64Cache::writeCacheData( T64Word pAdr, uint8_t *data, int len ) {
@@ -588,57 +656,42 @@ void T64Cache::writeCacheData( T64Word pAdr, uint8_t *data, int len ) {
 
     T64CacheLineInfo *cInfo;
     uint8_t          *cData;
+    int              way;
 
-    if ( lookupCache( pAdr, &cInfo, &cData )) {
+    if ( lookupCache( pAdr, &cInfo, &cData, &way )) {
 
         cacheHits ++;
-        plruUpdate( );
-        setCacheLineData( cData, getLineOfs( pAdr ), len, data );
+        plruUpdate( getSetIndex( pAdr ), way );
     }
     else {
 
-        int      vWay     = plruVictim( );
-        uint32_t setIndex = getSetIndex( pAdr );
-
         cacheMiss ++;
-        plruUpdate( );
-
-        if ( ! getCacheLineByIndex( vWay, setIndex, &cInfo, &cData )) {
-        
-            throw( T64Trap( MACHINE_CHECK ));
-        }
-
-        if ( cInfo -> valid ) {
-
-            if ( cInfo -> modified ) {
-
-                if ( ! proc -> busOpWriteBlock( proc -> getModuleNum( ),
-                                                pAdrFromTag( cInfo -> tag, setIndex ), 
-                                                cData, 
-                                                lineSize )) {        
-                    
-                    throw( T64Trap( MACHINE_CHECK ));
-                }
-            }
+        allocateCacheLine( pAdr, &cInfo, &cData );
+    }
 
-            cInfo -> valid = false;
-        }
+    if ( ! cInfo -> exclusive ) {
 
         if ( ! proc -> busOpReadPrivateBlock(  proc -> getModuleNum( ),
-                                               pAdr, 
+                                               pAdr & ~offsetBitmask, 
                                                cData, 
                                                lineSize )) {
 
             throw( T64Trap( MACHINE_CHECK ));
         }
+
+        cInfo -> valid      = true;
+        cInfo -> exclusive  = true;
+        cInfo -> tag        = getTag( pAdr );
     }
 
     setCacheLineData( cData, getLineOfs( pAdr ), len, data );
+    cInfo -> modified = true;
 }
 
 //----------------------------------------------------------------------------------------
 // "flushCacheLine" will write back a cache line to memory if it is modified. If we 
-// do not have such a cache line, the request is ignored. 
+// do not have such a cache line, the request is ignored. A flushed line may be read
+// by others, so it is no longer exclusive and the next write has to claim it again.
 //
 //----------------------------------------------------------------------------------------
 void T64Cache::flushCacheLine( T64Word pAdr ) {
@@ -652,7 +705,6 @@ void T64Cache::flushCacheLine( T64Word pAdr ) {
 
             uint32_t setIndex = getSetIndex( pAdr );
 
-            // ??? need to mask pAdr ? 
             if ( ! proc -> busOpWriteBlock( proc -> getModuleNum( ),
                                             pAdrFromTag( cInfo -> tag, setIndex ),  
                                             cData, 
@@ -663,6 +715,8 @@ void T64Cache::flushCacheLine( T64Word pAdr ) {
 
             cInfo -> modified = false;
         }
+
+        cInfo -> exclusive = false;
     }
 }
 
@@ -682,7 +736,6 @@ void T64Cache::purgeCacheLine( T64Word pAdr ) {
 
             uint32_t setIndex = getSetIndex( pAdr );
 
-            // ??? need to mask pAdr ? 
             if ( ! proc -> busOpWriteBlock( proc -> getModuleNum( ),
                                             pAdrFromTag( cInfo -> tag, setIndex ), 
                                             cData, 
@@ -694,21 +747,40 @@ void T64Cache::purgeCacheLine( T64Word pAdr ) {
             cInfo -> modified = false;
         }
 
-        cInfo -> valid  = false;
-        cInfo -> tag    = 0;
+        cInfo -> valid      = false;
+        cInfo -> exclusive  = false;
+        cInfo -> tag        = 0;
     }
 }
 
 //----------------------------------------------------------------------------------------
-// A cache read operation. For non-cached requests, we directly read the data from 
-// memory.
+// Set the trace writer. When set, every read and write request is recorded to the 
+// trace, regardless whether the request is cached or not. A null pointer disables
+// the trace.
+//
+//----------------------------------------------------------------------------------------
+void T64Cache::setTrace( T64TraceWriter *trace ) {
+
+    this -> trace = trace;
+}
+
+//----------------------------------------------------------------------------------------
+// A cache read operation. For non-cached requests and the I/O address range, we 
+// directly read the data from memory.
 //
 //----------------------------------------------------------------------------------------
 void T64Cache::read( T64Word pAdr, uint8_t *data, int len, bool cached ) {
     
-    if (( isInPhysMemAdrRange( pAdr ) || ( ! cached ))) {
+    if ( trace != nullptr ) {
+        
+        trace -> record((( cacheKind == T64_CK_INSTR_CACHE ) ? 
+                            T64_TRK_I_CACHE_READ : T64_TRK_D_CACHE_READ ),
+                        pAdr, len, ! cached );
+    }
+
+    if (( isInIoAdrRange( pAdr ) || ( ! cached ))) {
 
-        if ( proc -> busOpReadUncached( proc -> getModuleNum( ),
+        if ( ! proc -> busOpReadUncached( proc -> getModuleNum( ),
                                         pAdr, 
                                         data, 
                                         len )) {
@@ -720,13 +792,20 @@ void T64Cache::read( T64Word pAdr, uint8_t *data, int len, bool cached ) {
 }
 
 //----------------------------------------------------------------------------------------
-// A cache write operation. For non-cached requests, we directly write the data to 
-// memory.
+// A cache write operation. For non-cached requests and the I/O address range, we 
+// directly write the data to memory.
 //
 //----------------------------------------------------------------------------------------
 void T64Cache::write( T64Word pAdr, uint8_t *data, int len, bool cached ) {
 
-    if (( isInPhysMemAdrRange( pAdr ) || ( ! cached ))) {
+    if ( trace != nullptr ) {
+        
+        trace -> record((( cacheKind == T64_CK_INSTR_CACHE ) ? 
+                            T64_TRK_I_CACHE_WRITE : T64_TRK_D_CACHE_WRITE ),
+                        pAdr, len, ! cached );
+    }
+
+    if (( isInIoAdrRange( pAdr ) || ( ! cached ))) {
 
         if ( ! proc -> busOpWriteUncached( proc -> getModuleNum( ),
                                            pAdr, 
@@ -740,21 +819,21 @@ void T64Cache::write( T64Word pAdr, uint8_t *data, int len, bool cached ) {
 }
 
 //----------------------------------------------------------------------------------------
-// A cache flush operation. Only valid for virtual address ranges. The cache line
+// A cache flush operation. The I/O address range is never cached. The cache line
 // flush function will issue a write back when the line was modified.
 //
 //----------------------------------------------------------------------------------------
 void T64Cache::flush( T64Word pAdr ) {
 
-    if ( ! isInPhysMemAdrRange( pAdr )) flushCacheLine( pAdr );
+    if ( ! isInIoAdrRange( pAdr )) flushCacheLine( pAdr );
 }
 
 //----------------------------------------------------------------------------------------
-// A cache purge operation. Only valid for virtual address ranges. The cache line
+// A cache purge operation. The I/O address range is never cached. The cache line
 // purge function will invalidate the cache line entry.
 //
 //----------------------------------------------------------------------------------------
 void T64Cache::purge( T64Word pAdr ) {
 
-    if ( ! isInPhysMemAdrRange( pAdr )) purgeCacheLine( pAdr );   
+    if ( ! isInIoAdrRange( pAdr )) purgeCacheLine( pAdr );   
 }
\ No newline at end of file
@@ -76,11 +76,70 @@ void T64Cpu::reset( ) {
     for ( int i = 0; i < T64_MAX_CREGS; i++ ) cRegFile[ i ] = 0;
     for ( int i = 0; i < T64_MAX_GREGS; i++ ) gRegFile[ i ] = 0;
     
+    if ( recCntrEvt >= 0 ) proc -> sys -> cancelEvent( recCntrEvt );
+
     psrReg          = 0;
     instrReg        = 0;
     resvReg         = 0;
     lowerPhysMemAdr = 0;
     upperPhysMemAdr = T64_DEF_PHYS_MEM_LIMIT;
+    recCntrEvt      = -1;
+    recCntrDeadline = 0;
+    resvValid       = false;
+    resvLen         = 0;
+    resvCount       = 0;
+    stcSuccessCount = 0;
+    stcFailCount    = 0;
+    trapCount       = 0;
+    lastTrapCode    = NO_TRAP;
+    lastTrapAdr     = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// Save and restore the CPU state. The recovery counter event handle is saved along
+// with the system event queue, which keeps the event sequence numbers.
+//
+//----------------------------------------------------------------------------------------
+void T64Cpu::saveState( T64StateBuf *buf ) {
+
+    buf -> put( cRegFile, sizeof( cRegFile ));
+    buf -> put( gRegFile, sizeof( gRegFile ));
+    buf -> put( &psrReg, sizeof( psrReg ));
+    buf -> put( &instrReg, sizeof( instrReg ));
+    buf -> put( &resvReg, sizeof( resvReg ));
+    buf -> put( &lowerPhysMemAdr, sizeof( lowerPhysMemAdr ));
+    buf -> put( &upperPhysMemAdr, sizeof( upperPhysMemAdr ));
+    buf -> put( &recCntrEvt, sizeof( recCntrEvt ));
+    buf -> put( &recCntrDeadline, sizeof( recCntrDeadline ));
+    buf -> put( &resvValid, sizeof( resvValid ));
+    buf -> put( &resvLen, sizeof( resvLen ));
+    buf -> put( &resvCount, sizeof( resvCount ));
+    buf -> put( &stcSuccessCount, sizeof( stcSuccessCount ));
+    buf -> put( &stcFailCount, sizeof( stcFailCount ));
+    buf -> put( &trapCount, sizeof( trapCount ));
+    buf -> put( &lastTrapCode, sizeof( lastTrapCode ));
+    buf -> put( &lastTrapAdr, sizeof( lastTrapAdr ));
+}
+
+void T64Cpu::restoreState( T64StateBuf *buf ) {
+
+    buf -> get( cRegFile, sizeof( cRegFile ));
+    buf -> get( gRegFile, sizeof( gRegFile ));
+    buf -> get( &psrReg, sizeof( psrReg ));
+    buf -> get( &instrReg, sizeof( instrReg ));
+    buf -> get( &resvReg, sizeof( resvReg ));
+    buf -> get( &lowerPhysMemAdr, sizeof( lowerPhysMemAdr ));
+    buf -> get( &upperPhysMemAdr, sizeof( upperPhysMemAdr ));
+    buf -> get( &recCntrEvt, sizeof( recCntrEvt ));
+    buf -> get( &recCntrDeadline, sizeof( recCntrDeadline ));
+    buf -> get( &resvValid, sizeof( resvValid ));
+    buf -> get( &resvLen, sizeof( resvLen ));
+    buf -> get( &resvCount, sizeof( resvCount ));
+    buf -> get( &stcSuccessCount, sizeof( stcSuccessCount ));
+    buf -> get( &stcFailCount, sizeof( stcFailCount ));
+    buf -> get( &trapCount, sizeof( trapCount ));
+    buf -> get( &lastTrapCode, sizeof( lastTrapCode ));
+    buf -> get( &lastTrapAdr, sizeof( lastTrapAdr ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -101,12 +160,16 @@ void T64Cpu::setGeneralReg( int index, T64Word val ) {
 
 T64Word T64Cpu::getControlReg( int index ) {
     
+    if (( index % T64_MAX_CREGS ) == CTL_REG_REC_CNTR ) return( recCntrValue( curCycle( )));
+    
     return( cRegFile[ index % T64_MAX_CREGS ] );
 }
 
 void T64Cpu::setControlReg( int index, T64Word val ) {
     
+    recCntrStop( curCycle( ));
     cRegFile[ index % T64_MAX_CREGS ] = val;
+    recCntrStart( curCycle( ));
 }
 
 T64Word T64Cpu::getPsrReg( ) {
@@ -116,7 +179,9 @@ T64Word T64Cpu::getPsrReg( ) {
 
 void T64Cpu::setPsrReg( T64Word val ) {
     
+    recCntrStop( curCycle( ));
     psrReg = val;
+    recCntrStart( curCycle( ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -199,19 +264,18 @@ void T64Cpu::illegalInstrTrap( ) {
 //----------------------------------------------------------------------------------------
 bool T64Cpu::regionIdCheck( uint32_t rId, bool wMode ) {
 
-    if ( extractBit64( psrReg, 0 ) != 0 ) {
+    if ( extractBit64( psrReg, 0 ) == 0 ) return( true );
 
-        for ( int i = 4; i < 8; i++ ) {
+    for ( int i = 4; i < 8; i++ ) {
 
-            if ((( extractField64( cRegFile[ i ],  0, 20 ) == rId   ) &&
-                 ( extractField64( cRegFile[ i ], 31,  1 ) == wMode )) ||
-                (( extractField64( cRegFile[ i ], 32, 20 ) == rId   ) &&
-                 ( extractField64( cRegFile[ i ], 63,  1 ) == wMode ))) {
+        if ((( extractField64( cRegFile[ i ],  0, 20 ) == rId   ) &&
+             ( extractField64( cRegFile[ i ], 31,  1 ) == wMode )) ||
+            (( extractField64( cRegFile[ i ], 32, 20 ) == rId   ) &&
+             ( extractField64( cRegFile[ i ], 63,  1 ) == wMode ))) {
 
-                return( true );
-            }
-        }        
-    }   
+            return( true );
+        }
+    }        
 
     return( false );  
 }
@@ -269,12 +333,15 @@ void T64Cpu::nextInstr( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Check address for being in the configured physical memory address range.
+// Check address for being in the configured physical memory address range. The I/O
+// address range is a physical range as well, such that privileged code can access
+// the module HPA and SPA registers without a TLB entry.
 // 
 //----------------------------------------------------------------------------------------
 bool T64Cpu::isPhysMemAdr( T64Word vAdr ) {
 
-    return( isInRange( vAdr, lowerPhysMemAdr, upperPhysMemAdr ));
+    return( isInRange( vAdr, lowerPhysMemAdr, upperPhysMemAdr ) || 
+            isInIoAdrRange( vAdr ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -291,9 +358,9 @@ int T64Cpu::evalCond( int cond, T64Word val1, T64Word val2 ) {
         case 2: return (( val1          >  val2 ) ? 1 : 0 );  
         case 3: return ((( val1 & 0x1 ) == 0    ) ? 1 : 0 );  
         case 4: return (( val1          != val2 ) ? 1 : 0 ); 
-        case 5: return (( val1          <= val2 ) ? 1 : 0 ); 
-        case 6: return (( val1          >= val2 ) ? 1 : 0 ); 
-        case 7: return ((( val1 & 0x1 ) != 1    ) ? 1 : 0 ); 
+        case 5: return (( val1          >= val2 ) ? 1 : 0 ); 
+        case 6: return (( val1          <= val2 ) ? 1 : 0 ); 
+        case 7: return ((( val1 & 0x1 ) == 1    ) ? 1 : 0 ); 
         default: return( 0 );
     }
 }
@@ -334,10 +401,10 @@ T64Word T64Cpu::instrRead( T64Word vAdr ) {
         instrAccessRightsCheck( tlbPtr, ACC_EXECUTE );      
         instrRegionIdCheck( vAdr );
        
-        proc -> iCache -> read( tlbPtr -> pAdr, 
+        proc -> iCache -> read( tlbPtr -> pAdr + ( vAdr - tlbPtr -> vAdr ), 
                                 (uint8_t *) &instr, 
                                 4, 
-                                tlbPtr -> uncached );
+                                ! tlbPtr -> uncached );
     }
 
     return( instr );
@@ -348,12 +415,15 @@ T64Word T64Cpu::instrRead( T64Word vAdr ) {
 // and 8. The data is read from memory in the length given and stored right 
 // justified and sign extended in the return argument. We first check the address
 // range. For a physical address we must be in priv mode. For a virtual address, 
-// the TLB is consulted for the translation and security checking. 
+// the TLB is consulted for the translation and security checking. A completed 
+// access is checked against the watchpoints when its page has a watchpoint. When
+// requested, the physical address of the access is returned too.
 //
 //----------------------------------------------------------------------------------------
-T64Word T64Cpu::dataRead( T64Word vAdr, int len, bool sExt ) {
+T64Word T64Cpu::dataRead( T64Word vAdr, int len, bool sExt, T64Word *pAdr ) {
 
     T64Word data    = 0;
+    T64Word adr     = vAdr;
     int     wordOfs = sizeof( T64Word ) - len;
 
     dataAlignmentCheck( vAdr, len );
@@ -361,7 +431,7 @@ T64Word T64Cpu::dataRead( T64Word vAdr, int len, bool sExt ) {
     if ( isPhysMemAdr( vAdr )) { 
         
         privModeCheck( );
-        proc -> dCache -> read( vAdr, ((uint8_t *) &data ) + wordOfs, len, false );
+        proc -> dCache -> read( adr, ((uint8_t *) &data ) + wordOfs, len, false );
     }
     else {
 
@@ -371,10 +441,21 @@ T64Word T64Cpu::dataRead( T64Word vAdr, int len, bool sExt ) {
         dataAccessRightsCheck( tlbPtr, ACC_READ_ONLY );             
         dataRegionIdCheck( vAdr, false );
 
-        proc -> iCache -> read( tlbPtr -> pAdr, 
+        adr = tlbPtr -> pAdr + ( vAdr - tlbPtr -> vAdr );
+
+        proc -> dCache -> read( adr, 
                                 ((uint8_t *) &data ) + wordOfs, 
                                 len, 
-                                tlbPtr -> uncached );
+                                ! tlbPtr -> uncached );
+    }
+
+    if (( proc -> debug != nullptr ) && ( proc -> debug -> isWatchPage( vAdr ))) {
+
+        proc -> debug -> checkWatchpoint( proc -> moduleNum, 
+                                          extractField64( psrReg, 0, 52 ),
+                                          vAdr, 
+                                          len, 
+                                          false );
     }
 
     if ( sExt ) {
@@ -388,6 +469,7 @@ T64Word T64Cpu::dataRead( T64Word vAdr, int len, bool sExt ) {
         }
     }
 
+    if ( pAdr != nullptr ) *pAdr = adr;
     return( data );
 }
 
@@ -395,47 +477,66 @@ T64Word T64Cpu::dataRead( T64Word vAdr, int len, bool sExt ) {
 // Data memory write. We write the data item to memory. Valid lengths are 1, 2, 4
 // and 8. The data is stored in memory in the length given. We first check the
 // address range. For a physical address we must be in priv mode. For a virtual 
-// address, the TLB is consulted for the translation and security checking. 
+// address, the TLB is consulted for the translation and security checking. As for
+// the read, a completed access is checked against the watchpoints. A conditional
+// store passes the reservation check option. The data is then only written when
+// the reservation covers the physical address. We return whether the data was 
+// written.
 //
 //----------------------------------------------------------------------------------------
-void T64Cpu::dataWrite( T64Word vAdr, T64Word data, int len ) {
+bool T64Cpu::dataWrite( T64Word vAdr, T64Word data, int len, bool resvCheck ) {
 
-    int wordOfs = sizeof( T64Word ) - len;
+    T64Word     adr         = vAdr;
+    bool        cached      = false;
+    int         wordOfs     = sizeof( T64Word ) - len;
 
     dataAlignmentCheck( vAdr, len );
   
     if ( isPhysMemAdr( vAdr )) { 
         
         privModeCheck( );
-        proc -> dCache -> write( vAdr, ((uint8_t *) &data ) + wordOfs, len, false );           
     }
     else {
 
         T64TlbEntry *tlbPtr = proc -> dTlb -> lookup( vAdr );
-         if ( tlbPtr == nullptr ) dataTlbMissTrap( vAdr );
+        if ( tlbPtr == nullptr ) dataTlbMissTrap( vAdr );
 
         dataAccessRightsCheck( tlbPtr, ACC_READ_WRITE );
         dataRegionIdCheck( vAdr, true );
-        
-        proc -> dCache -> write( tlbPtr -> pAdr, 
-                                 ((uint8_t *) &data ) + wordOfs, 
-                                 len, 
-                                 tlbPtr -> uncached );
+
+        adr     = tlbPtr -> pAdr + ( vAdr - tlbPtr -> vAdr );
+        cached  = ! tlbPtr -> uncached;
+    }
+
+    if (( resvCheck ) && 
+        (( ! resvValid ) || ( rounddown( adr, resvLen ) != resvReg ))) return( false );
+
+    proc -> dCache -> write( adr, ((uint8_t *) &data ) + wordOfs, len, cached );
+
+    if (( proc -> debug != nullptr ) && ( proc -> debug -> isWatchPage( vAdr ))) {
+
+        proc -> debug -> checkWatchpoint( proc -> moduleNum, 
+                                          extractField64( psrReg, 0, 52 ),
+                                          vAdr, 
+                                          len, 
+                                          true );
     }
+
+    return( true );
 }
 
 //----------------------------------------------------------------------------------------
 // Read memory data based using RegB and the IMM-13 offset to form the address.
 //
 //----------------------------------------------------------------------------------------
-T64Word T64Cpu::dataReadRegBOfsImm13( uint32_t instr ) {
+T64Word T64Cpu::dataReadRegBOfsImm13( uint32_t instr, T64Word *pAdr ) {
     
     T64Word     adr     = getRegB( instr );
     int         dw      = extractInstrDwField( instr ); 
     T64Word     ofs     = extractInstrSignedScaledImm13( instr );
     int         len     = 1 << dw;
     
-    return( dataRead( addAdrOfs32( adr, ofs ), len, true ));
+    return( dataRead( addAdrOfs32( adr, ofs ), len, true, pAdr ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -454,10 +555,10 @@ T64Word T64Cpu::dataReadRegBOfsRegX( uint32_t instr ) {
 
 //----------------------------------------------------------------------------------------
 // Write data to memory based using RegB and the IMM-13 offset to form the 
-// address.
+// address. We return whether the data was written.
 //
 //----------------------------------------------------------------------------------------
-void T64Cpu::dataWriteRegBOfsImm13( uint32_t instr ) {
+bool T64Cpu::dataWriteRegBOfsImm13( uint32_t instr, bool resvCheck ) {
     
     T64Word     adr     = getRegB( instr );
     int         dw      = extractInstrDwField( instr );
@@ -465,7 +566,7 @@ void T64Cpu::dataWriteRegBOfsImm13( uint32_t instr ) {
     int         len     = 1 << dw;
     T64Word     val     = getRegR( instr );
     
-    dataWrite( addAdrOfs32( adr, ofs ), val, len );
+    return( dataWrite( addAdrOfs32( adr, ofs ), val, len, resvCheck ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -890,17 +991,24 @@ void T64Cpu::instrMemLdOp( T64Instr instr ) {
 }
 
 //----------------------------------------------------------------------------------------
-// MEM:LDR operation.
+// MEM:LDR operation. The load also sets the reservation for a following STC. The
+// reservation is the cache line that contains the physical address of the load.
 //
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrMemLdrOp( T64Instr instr ) {
           
     if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) illegalInstrTrap( );
+
+    T64Word pAdr = 0;
     
-    setRegR( instr, dataReadRegBOfsImm13( instr ));
-    nextInstr( );
+    setRegR( instr, dataReadRegBOfsImm13( instr, &pAdr ));
 
-    // ??? set reserved flag ?
+    resvLen     = proc -> dCache -> getCacheLineSize( );
+    resvReg     = rounddown( pAdr, resvLen );
+    resvValid   = true;
+    resvCount ++;
+
+    nextInstr( );
 }
 
 //----------------------------------------------------------------------------------------
@@ -919,17 +1027,33 @@ void T64Cpu::instrMemStOp( T64Instr instr ) {
 }
 
 //----------------------------------------------------------------------------------------
-// MEM:STC operation.
+// MEM:STC operation. The store is only carried out when the reservation of a prior
+// LDR is still valid and covers the store address. The target register is set to
+// one when the store was done and to zero when it failed. In both cases the 
+// reservation is gone afterwards. A successful store takes the cache line private
+// or writes memory, which cancels the reservations of the other processors.
 //
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrMemStcOp( T64Instr instr ) {
 
     if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) illegalInstrTrap( );
-        
-    dataWriteRegBOfsImm13( instr );
-    nextInstr( );
 
-    // ??? clear reserved flag ?
+    bool valid = resvValid && dataWriteRegBOfsImm13( instr, true );
+
+    resvValid = false;
+
+    if ( valid ) {
+
+        setRegR( instr, 1 );
+        stcSuccessCount ++;
+    }
+    else {
+
+        setRegR( instr, 0 );
+        stcFailCount ++;
+    }
+
+    nextInstr( );
 }
 
 //----------------------------------------------------------------------------------------
@@ -1052,7 +1176,7 @@ void T64Cpu::instrBrAbrOp( T64Instr instr ) {
     setRegR( instr, sum );
 
     if ( evalCond( extractInstrFieldU( instr, 19, 3 ), sum, 0 ))
-        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ));
+        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ) << 2 );
     else 
         nextInstr( );
 }
@@ -1067,7 +1191,7 @@ void T64Cpu::instrBrCbrOp( T64Instr instr ) {
     T64Word val2    = getRegB( instr );
 
     if ( evalCond( extractInstrFieldU( instr, 19, 3 ), val1, val2 ))
-        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ));
+        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ) << 2 );
     else 
         nextInstr( );
 }
@@ -1083,7 +1207,7 @@ void T64Cpu::instrBrMbrOp( T64Instr instr ) {
     setRegR( instr, val );
     
     if ( evalCond( extractInstrFieldU( instr, 19, 3 ), val, 0 ))
-        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ));
+        psrReg = addAdrOfs32( psrReg, extractInstrSignedImm15( instr ) << 2 );
     else 
         nextInstr( );
 }
@@ -1107,14 +1231,23 @@ void T64Cpu::instrSysMrOp( T64Instr instr ) {
         case 0:     {
             
             int cReg = extractInstrFieldU( instr, 0, 4 );
-            setRegR( instr, cRegFile[ cReg ] ); 
+
+            if ( cReg == CTL_REG_REC_CNTR ) setRegR( instr, recCntrValue( curCycle( ) + 1 ));
+            else                            setRegR( instr, cRegFile[ cReg ] ); 
             
         } break;
 
         case 1: {
 
             int cReg = extractInstrFieldU( instr, 0, 4 );
-            cRegFile[ cReg ] = getRegR( instr );
+
+            if ( cReg == CTL_REG_REC_CNTR ) {
+
+                recCntrStop( curCycle( ) + 1 );
+                cRegFile[ cReg ] = getRegR( instr );
+                recCntrStart( curCycle( ) + 1 );
+            }
+            else cRegFile[ cReg ] = getRegR( instr );
 
         } break;
 
@@ -1276,7 +1409,9 @@ void T64Cpu::instrSysCaOp( T64Instr instr ) {
 }
 
 //----------------------------------------------------------------------------------------
-// SYS:MST_OP operation.
+// SYS:MST_OP operation. The instruction value field is a mask for the eight PSR 
+// status bits, which are the PSR bits 56 to 63. The previous status bits are 
+// returned in the target register.
 //
 //  0 -> RSM
 //  1 -> SSM
@@ -1284,18 +1419,23 @@ void T64Cpu::instrSysCaOp( T64Instr instr ) {
 //----------------------------------------------------------------------------------------
 void T64Cpu::instrSysMstOp( T64Instr instr ) {
 
-    int opt = extractInstrFieldU( instr, 19, 3 );
+    int     opt     = extractInstrFieldU( instr, 19, 3 );
+    T64Word mask    = ((T64Word) extractInstrFieldU( instr, 0, 8 )) << 56;
 
-    if ( opt == 0 )   {
-                    
-        // RSM
-    }
-    else if (opt == 1 )   {
-        
-        // SSM
-    }
-    else illegalInstrTrap( );
+    privModeCheck( );
+
+    T64Word oldBits = extractField64( psrReg, 56, 8 );
+
+    if (( opt != 0 ) && ( opt != 1 )) illegalInstrTrap( );
+
+    recCntrStop( curCycle( ) + 1 );
+
+    if ( opt == 0 ) psrReg = psrReg & ( ~ mask );
+    else            psrReg = psrReg | mask;
+
+    recCntrStart( curCycle( ) + 1 );
     
+    setRegR( instr, oldBits );
     nextInstr( );
 }
 
@@ -1308,7 +1448,10 @@ void T64Cpu::instrSysRfiOp( T64Instr instr ) {
     if ( extractInstrFieldU( instr, 19, 3 ) != 0 ) illegalInstrTrap( );
 
     setRegR( instr, psrReg ); // ??? or + 4 ?
+
+    recCntrStop( curCycle( ) + 1 );
     psrReg = cRegFile[ CTL_REG_IPSR ];
+    recCntrStart( curCycle( ) + 1 );
 }
 
 //----------------------------------------------------------------------------------------
@@ -1349,7 +1492,7 @@ void T64Cpu::instrExecute( uint32_t instr ) {
     
     try {
         
-        switch ( extractInstrOpCode( instr ) ) {
+        switch ( extractInstrOpGroup( instr ) * 16 + extractInstrOpCode( instr )) {
                 
             case ( OPC_GRP_ALU * 16 + OPC_ADD ):    instrAluAddOp( instr );   break;
             case ( OPC_GRP_MEM * 16 + OPC_ADD ):    instrMemAddOp( instr );   break;
@@ -1397,6 +1540,10 @@ void T64Cpu::instrExecute( uint32_t instr ) {
 
         T64TrapCode code = t.trapCode;
 
+        trapCount ++;
+        lastTrapCode    = code;
+        lastTrapAdr     = t.instrAdr;
+
         // ??? we are here because we trapped some level deep...
         // ??? figure out if we trap inside an instruction or between instructions.
 
@@ -1411,6 +1558,169 @@ void T64Cpu::instrExecute( uint32_t instr ) {
     }
 }
 
+//----------------------------------------------------------------------------------------
+// Enter a trap handler between two instructions. The current PSR, which holds the 
+// address of the next instruction to execute, is saved to the IPSR control register
+// and the trap arguments are passed in IARG_0 and IARG_1. Execution continues in 
+// privileged mode with interrupts disabled and the recovery counter stopped at the
+// trap vector entry. A reservation of the interrupted code is cancelled. The handler
+// returns with RFI.
+//
+//----------------------------------------------------------------------------------------
+void T64Cpu::enterTrapHandler( T64TrapCode code, T64Word arg0, T64Word arg1 ) {
+
+    recCntrStop( curCycle( ));
+    resvValid = false;
+
+    cRegFile[ CTL_REG_IPSR   ] = psrReg;
+    cRegFile[ CTL_REG_IINSTR ] = 0;
+    cRegFile[ CTL_REG_IARG_0 ] = arg0;
+    cRegFile[ CTL_REG_IARG_1 ] = arg1;
+
+    T64Word vecAdr = cRegFile[ CTL_REG_IVA ] + ( code * T64_TRAP_VECTOR_SIZE );
+
+    psrReg = extractField64( vecAdr, 0, T64_VADR_BITS );
+    psrReg = depositField( psrReg, 61, 1, 1 );
+}
+
+//----------------------------------------------------------------------------------------
+// Deliver an external interrupt. The processor calls this routine only when there 
+// are pending interrupt bits. When the PSR interrupt enable bit is cleared, the 
+// interrupt stays pending. Otherwise we enter the external interrupt handler with
+// the pending bits in IARG_0. The handler clears the request bits in the processor
+// HPA.
+//
+//----------------------------------------------------------------------------------------
+bool T64Cpu::deliverInterrupt( T64Word pending ) {
+
+    if ( ! extractPsrIbit( psrReg )) return( false );
+
+    enterTrapHandler( EXTERNAL_INTERRUPT, pending, 0 );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Recovery counter. While the PSR R bit is set, the recovery counter control register
+// counts down by one for each instruction executed. When it reaches zero, the 
+// recovery counter trap is taken before the next instruction. The counter is not 
+// decremented on each instruction. When counting starts, we compute the cycle in
+// which the counter expires and schedule a processor event for that cycle. The system
+// run loop then executes the instructions up to that cycle without any further check.
+// While counting, the remaining count is computed from the expiry cycle, the control
+// register itself only holds the count of a stopped counter. Counting starts and
+// stops when the R bit or the counter register changes, i.e. on MTCR, SSM, RSM, RFI,
+// a trap entry and the simulator register access. The "cycle" argument is the cycle
+// in which the next instruction executes. A negative count is taken as zero.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64Cpu::curCycle( ) {
+
+    return( proc -> sys -> getCycleCount( ));
+}
+
+T64Word T64Cpu::recCntrValue( T64Word cycle ) {
+
+    if ( recCntrEvt < 0 ) return( cRegFile[ CTL_REG_REC_CNTR ] );
+    
+    return(( recCntrDeadline > cycle ) ? ( recCntrDeadline - cycle ) : 0 );
+}
+
+void T64Cpu::recCntrStart( T64Word cycle ) {
+
+    if (( recCntrEvt >= 0 ) || ( ! extractPsrRbit( psrReg ))) return;
+
+    T64Word cnt = cRegFile[ CTL_REG_REC_CNTR ];
+
+    if ( cnt < 0 ) cnt = 0;
+    if ( cnt > INT64_MAX - cycle ) cnt = INT64_MAX - cycle;
+
+    recCntrDeadline = cycle + cnt;
+    recCntrEvt      = proc -> sys -> scheduleEvent( proc, 
+                                                    recCntrDeadline - curCycle( ), 
+                                                    PROC_EVT_REC_CNTR );
+}
+
+void T64Cpu::recCntrStop( T64Word cycle ) {
+
+    if ( recCntrEvt < 0 ) return;
+
+    cRegFile[ CTL_REG_REC_CNTR ] = recCntrValue( cycle );
+
+    proc -> sys -> cancelEvent( recCntrEvt );
+    recCntrEvt = -1;
+}
+
+//----------------------------------------------------------------------------------------
+// Reservations. A LDR instruction reserves the cache line sized block that contains
+// the physical address of the data. The processor module calls the snoop routine 
+// when it observes a bus request of another module that takes a line for writing or
+// writes memory, i.e. a private block read, a block write, an uncached write or a
+// DMA write. When the request touches the reserved block, the reservation is lost.
+// This is a single compare on the observed requests, there is no search across the
+// processors on a store. A store to a line that is not held exclusively always 
+// reads the line private first, so every store to a line another processor has
+// reserved is observed.
+//
+//----------------------------------------------------------------------------------------
+void T64Cpu::snoopReservation( T64Word pAdr, T64Word len ) {
+
+    if (( resvValid ) && ( pAdr < resvReg + resvLen ) && ( pAdr + len > resvReg )) {
+
+        resvValid = false;
+    }
+}
+
+T64Word T64Cpu::getResvCount( ) {
+
+    return( resvCount );
+}
+
+T64Word T64Cpu::getStcSuccessCount( ) {
+
+    return( stcSuccessCount );
+}
+
+T64Word T64Cpu::getStcFailCount( ) {
+
+    return( stcFailCount );
+}
+
+//----------------------------------------------------------------------------------------
+// Traps raised by an instruction are not vectored yet. We count them and remember the
+// last trap code and instruction address, so that a caller can tell a trapping program
+// from one that runs or halted.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64Cpu::getTrapCount( ) {
+
+    return( trapCount );
+}
+
+T64TrapCode T64Cpu::getLastTrapCode( ) {
+
+    return( lastTrapCode );
+}
+
+T64Word T64Cpu::getLastTrapAdr( ) {
+
+    return( lastTrapAdr );
+}
+
+//----------------------------------------------------------------------------------------
+// The recovery counter expired. The processor calls this routine from the event 
+// handler, which runs before the instruction of the expiry cycle. When the R bit was
+// cleared by an instruction that does not stop the counter, such as a branch that 
+// replaces the entire PSR, there is no trap.
+//
+//----------------------------------------------------------------------------------------
+void T64Cpu::recCntrExpired( ) {
+
+    recCntrEvt                      = -1;
+    cRegFile[ CTL_REG_REC_CNTR ]    = 0;
+
+    if ( extractPsrRbit( psrReg )) enterTrapHandler( RECOVERY_COUNTER_TRAP, 0, 0 );
+}
+
 //----------------------------------------------------------------------------------------
 // The step routine is the entry point to the CPU for executing one or more 
 // instructions.
@@ -1428,6 +1738,9 @@ void T64Cpu::step( ) {
 
         // ??? we are here because we trapped at the instruction read or
         // instruction execution.
-        
+
+        trapCount ++;
+        lastTrapCode    = t.trapCode;
+        lastTrapAdr     = t.instrAdr;
     }
 }
\ No newline at end of file
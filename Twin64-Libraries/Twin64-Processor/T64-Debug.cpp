@@ -0,0 +1,482 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Breakpoints and watchpoints
+//
+//----------------------------------------------------------------------------------------
+// The breakpoint and watchpoint tables. A processor without a reference to the debug
+// object does not check anything. With a reference, each instruction address is looked
+// up in the breakpoint hash table and each data access tests the "has watch" bit of
+// its page. Only a set bit leads to the search of the watchpoint list.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Breakpoints and watchpoints
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You
+// should have received a copy of the GNU General Public License along with this
+// program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Debug.h"
+#include "T64-Processor.h"
+
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const int       BP_EMPTY_SLOT   = -1;
+const T64Word   NO_RESUME_ADR   = -1;
+
+//----------------------------------------------------------------------------------------
+// The breakpoint hash. Instruction addresses are word aligned, the low order bits
+// carry no information. The multiplication spreads neighbouring addresses across
+// the table.
+//
+//----------------------------------------------------------------------------------------
+int bpHashIndex( T64Word adr ) {
+
+    uint64_t h = ((uint64_t) adr >> 2 ) * 0x9E3779B97F4A7C15ULL;
+    return((int) ( h >> 32 ) & ( T64_BP_HASH_SIZE - 1 ));
+}
+
+} // namespace
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Debug object
+//
+//----------------------------------------------------------------------------------------
+// Object constructor.
+//
+//----------------------------------------------------------------------------------------
+T64Debug::T64Debug( T64System *sys ) {
+
+    this -> sys = sys;
+
+    clearBreakpoints( );
+    clearWatchpoints( );
+    clearStopInfo( );
+}
+
+//----------------------------------------------------------------------------------------
+// Breakpoints. A breakpoint is an instruction address, virtual or physical, just as
+// the instruction address in the PSR. Adding an existing breakpoint is not an error,
+// the new condition replaces the old one. Removing a breakpoint rebuilds the hash
+// table, which is simpler than deleting from an open addressing table and happens
+// rarely.
+//
+//----------------------------------------------------------------------------------------
+int T64Debug::findBreakpointSlot( T64Word adr ) {
+
+    int slot = bpHashIndex( adr );
+
+    while (( bpHash[ slot ] != BP_EMPTY_SLOT ) && ( bpList[ bpHash[ slot ]].adr != adr )) {
+
+        slot = ( slot + 1 ) & ( T64_BP_HASH_SIZE - 1 );
+    }
+
+    return( slot );
+}
+
+void T64Debug::rebuildBreakpointHash( ) {
+
+    for ( int i = 0; i < T64_BP_HASH_SIZE; i++ ) bpHash[ i ] = BP_EMPTY_SLOT;
+
+    for ( int i = 0; i < bpCount; i++ ) bpHash[ findBreakpointSlot( bpList[ i ].adr ) ] = i;
+}
+
+bool T64Debug::addBreakpoint( T64Word adr, T64StopCond *cond, const char *condText ) {
+
+    int slot    = findBreakpointSlot( adr );
+    int index   = bpHash[ slot ];
+
+    if ( index == BP_EMPTY_SLOT ) {
+
+        if ( bpCount >= T64_MAX_BREAKPOINTS ) return( false );
+
+        index           = bpCount++;
+        bpHash[ slot ]  = index;
+    }
+
+    bpList[ index ].adr = adr;
+
+    if ( cond != nullptr ) bpList[ index ].cond = *cond;
+    else                   bpList[ index ].cond.clear( );
+
+    if ( condText != nullptr ) {
+
+        strncpy( bpList[ index ].condText, condText, T64_MAX_COND_TEXT - 1 );
+        bpList[ index ].condText[ T64_MAX_COND_TEXT - 1 ] = '\0';
+    }
+    else bpList[ index ].condText[ 0 ] = '\0';
+
+    return( true );
+}
+
+bool T64Debug::removeBreakpoint( T64Word adr ) {
+
+    for ( int i = 0; i < bpCount; i++ ) {
+
+        if ( bpList[ i ].adr == adr ) {
+
+            bpList[ i ] = bpList[ --bpCount ];
+            rebuildBreakpointHash( );
+            return( true );
+        }
+    }
+
+    return( false );
+}
+
+void T64Debug::clearBreakpoints( ) {
+
+    bpCount = 0;
+    rebuildBreakpointHash( );
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) resumeAdr[ i ] = NO_RESUME_ADR;
+}
+
+int T64Debug::getBreakpointCount( ) {
+
+    return( bpCount );
+}
+
+T64Breakpoint *T64Debug::getBreakpoint( int index ) {
+
+    return((( index >= 0 ) && ( index < bpCount )) ? &bpList[ index ] : nullptr );
+}
+
+//----------------------------------------------------------------------------------------
+// Watchpoints. A watchpoint is identified by its start address, setting a watchpoint
+// for an existing start address replaces it. After each change, the watch page map
+// is rebuilt. A range that covers as many pages as there are page slots sets all
+// bits.
+//
+//----------------------------------------------------------------------------------------
+void T64Debug::rebuildWatchPageMap( ) {
+
+    for ( int i = 0; i < T64_WATCH_PAGE_SLOTS / 64; i++ ) watchPageMap[ i ] = 0;
+
+    for ( int i = 0; i < wpCount; i++ ) {
+
+        T64Word firstPage   = wpList[ i ].adr >> T64_PAGE_OFS_BITS;
+        T64Word lastPage    = ( wpList[ i ].adr + wpList[ i ].len - 1 ) >> T64_PAGE_OFS_BITS;
+        T64Word numPages    = lastPage - firstPage + 1;
+
+        if ( numPages > T64_WATCH_PAGE_SLOTS ) numPages = T64_WATCH_PAGE_SLOTS;
+
+        for ( T64Word p = 0; p < numPages; p++ ) {
+
+            int slot = (int) (( firstPage + p ) & ( T64_WATCH_PAGE_SLOTS - 1 ));
+            watchPageMap[ slot / 64 ] |= ( 1ULL << ( slot % 64 ));
+        }
+    }
+}
+
+bool T64Debug::addWatchpoint( T64Word adr, T64Word len, T64WatchMode mode ) {
+
+    if ( len <= 0 ) return( false );
+
+    int index = 0;
+
+    while (( index < wpCount ) && ( wpList[ index ].adr != adr )) index++;
+
+    if ( index == wpCount ) {
+
+        if ( wpCount >= T64_MAX_WATCHPOINTS ) return( false );
+        wpCount++;
+    }
+
+    wpList[ index ].adr     = adr;
+    wpList[ index ].len     = len;
+    wpList[ index ].mode    = mode;
+
+    rebuildWatchPageMap( );
+    return( true );
+}
+
+bool T64Debug::removeWatchpoint( T64Word adr ) {
+
+    for ( int i = 0; i < wpCount; i++ ) {
+
+        if ( wpList[ i ].adr == adr ) {
+
+            wpList[ i ] = wpList[ --wpCount ];
+            rebuildWatchPageMap( );
+            return( true );
+        }
+    }
+
+    return( false );
+}
+
+void T64Debug::clearWatchpoints( ) {
+
+    wpCount = 0;
+    rebuildWatchPageMap( );
+}
+
+int T64Debug::getWatchpointCount( ) {
+
+    return( wpCount );
+}
+
+T64Watchpoint *T64Debug::getWatchpoint( int index ) {
+
+    return((( index >= 0 ) && ( index < wpCount )) ? &wpList[ index ] : nullptr );
+}
+
+bool T64Debug::isEmpty( ) {
+
+    return(( bpCount == 0 ) && ( wpCount == 0 ));
+}
+
+//----------------------------------------------------------------------------------------
+// Check for a breakpoint at the instruction about to execute. When the processor
+// stopped at this instruction with the last breakpoint hit, the instruction is
+// executed this time. A breakpoint with a condition only hits when the condition
+// is true. A hit returns true, the caller does not execute the instruction.
+//
+//----------------------------------------------------------------------------------------
+bool T64Debug::checkBreakpoint( T64Processor *proc, T64Word instrAdr ) {
+
+    int modNum = proc -> getModuleNum( );
+
+    if (( modNum < 0 ) || ( modNum >= MAX_MOD_MAP_ENTRIES )) return( false );
+
+    if ( resumeAdr[ modNum ] != NO_RESUME_ADR ) {
+
+        bool resume = ( resumeAdr[ modNum ] == instrAdr );
+
+        resumeAdr[ modNum ] = NO_RESUME_ADR;
+        if ( resume ) return( false );
+    }
+
+    if ( bpCount == 0 ) return( false );
+
+    int index = bpHash[ findBreakpointSlot( instrAdr ) ];
+
+    if ( index == BP_EMPTY_SLOT ) return( false );
+    if ( ! bpList[ index ].cond.eval( sys, proc )) return( false );
+
+    resumeAdr[ modNum ] = instrAdr;
+    recordStop( T64_STOP_BREAKPOINT, modNum, instrAdr, 0, false );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Check a data access against the watchpoints. The caller already found the "has
+// watch" bit of the page set. A watchpoint hits when the access overlaps its range
+// and the access mode matches. The access itself completes, the system stops after
+// the current cycle.
+//
+//----------------------------------------------------------------------------------------
+void T64Debug::checkWatchpoint( int     modNum,
+                                T64Word instrAdr,
+                                T64Word dataAdr,
+                                int     len,
+                                bool    wMode ) {
+
+    int accMode = ( wMode ) ? T64_WATCH_WRITE : T64_WATCH_READ;
+
+    for ( int i = 0; i < wpCount; i++ ) {
+
+        T64Watchpoint *wp = &wpList[ i ];
+
+        if (( wp -> mode & accMode ) &&
+            ( dataAdr < wp -> adr + wp -> len ) &&
+            ( dataAdr + len > wp -> adr )) {
+
+            recordStop( T64_STOP_WATCHPOINT, modNum, instrAdr, dataAdr, wMode );
+            return;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Stop info. Only the first hit is recorded until the stop info is cleared. Any hit
+// asks the system to stop.
+//
+//----------------------------------------------------------------------------------------
+void T64Debug::recordStop( T64StopKind  kind,
+                           int          modNum,
+                           T64Word      instrAdr,
+                           T64Word      dataAdr,
+                           bool         wMode ) {
+
+    if ( stopInfo.kind == T64_STOP_NIL ) {
+
+        stopInfo.kind       = kind;
+        stopInfo.modNum     = modNum;
+        stopInfo.instrAdr   = instrAdr;
+        stopInfo.dataAdr    = dataAdr;
+        stopInfo.wMode      = wMode;
+    }
+
+    if ( sys != nullptr ) sys -> requestStop( );
+}
+
+T64StopInfo *T64Debug::getStopInfo( ) {
+
+    return( &stopInfo );
+}
+
+void T64Debug::clearStopInfo( ) {
+
+    stopInfo = T64StopInfo( );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Breakpoint conditions
+//
+//----------------------------------------------------------------------------------------
+// Build a condition. Adding an operation checks the program size and the stack depth
+// the operation results in. 
+//
+//----------------------------------------------------------------------------------------
+void T64StopCond::clear( ) {
+
+    numOps  = 0;
+    depth   = 0;
+}
+
+bool T64StopCond::isEmpty( ) {
+
+    return( numOps == 0 );
+}
+
+bool T64StopCond::addOp( T64CondOpCode opCode, T64Word val, int modNum, int regNum ) {
+
+    int newDepth = depth;
+
+    switch ( opCode ) {
+
+        case T64_COP_CONST:
+        case T64_COP_GREG:
+        case T64_COP_CREG:
+        case T64_COP_IA:
+        case T64_COP_ST:        newDepth ++;    break;
+
+        case T64_COP_NOT:
+        case T64_COP_NEG:       if ( depth < 1 ) return( false );
+                                break;
+
+        case T64_COP_NIL:       return( false );
+
+        default:                if ( depth < 2 ) return( false );
+                                newDepth --;
+    }
+
+    if (( numOps >= T64_MAX_COND_OPS ) || ( newDepth > T64_MAX_COND_STACK )) return( false );
+
+    T64CondOp *op = &ops[ numOps++ ];
+
+    op -> opCode    = opCode;
+    op -> val       = val;
+    op -> modNum    = modNum;
+    op -> regNum    = regNum;
+
+    depth = newDepth;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Evaluate the condition for the processor that reached the breakpoint. A register
+// of a module that is not a processor reads as zero, so does a division by zero and
+// the one division that overflows, the most negative value divided by minus one. The
+// condition is true when the final value is not zero.
+//
+//----------------------------------------------------------------------------------------
+bool T64StopCond::eval( T64System *sys, T64Processor *proc ) {
+
+    T64Word stack[ T64_MAX_COND_STACK ];
+    int     sp = 0;
+
+    if ( numOps == 0 ) return( true );
+
+    for ( int i = 0; i < numOps; i++ ) {
+
+        T64CondOp *op = &ops[ i ];
+
+        if ( op -> opCode <= T64_COP_ST ) {
+
+            T64Processor *p = proc;
+
+            if ( op -> modNum >= 0 ) {
+
+                T64Module *mPtr = sys -> lookupByModNum( op -> modNum );
+
+                if (( mPtr != nullptr ) && ( mPtr -> getModuleType( ) == MT_PROC )) {
+
+                    p = (T64Processor *) mPtr;
+                }
+                else p = nullptr;
+            }
+
+            T64Word val = 0;
+
+            if ( op -> opCode == T64_COP_CONST ) val = op -> val;
+            else if ( p != nullptr ) {
+
+                T64Cpu *cpu = p -> getCpuPtr( );
+
+                switch ( op -> opCode ) {
+
+                    case T64_COP_GREG:  val = cpu -> getGeneralReg( op -> regNum );  break;
+                    case T64_COP_CREG:  val = cpu -> getControlReg( op -> regNum );  break;
+                    case T64_COP_IA:    val = extractField64( cpu -> getPsrReg( ), 0, 52 );  break;
+                    case T64_COP_ST:    val = extractField64( cpu -> getPsrReg( ), 52, 12 ); break;
+                    default: ;
+                }
+            }
+
+            stack[ sp++ ] = val;
+            continue;
+        }
+
+        if ( op -> opCode == T64_COP_NOT ) { stack[ sp - 1 ] = ~ stack[ sp - 1 ]; continue; }
+        if ( op -> opCode == T64_COP_NEG ) { stack[ sp - 1 ] = - stack[ sp - 1 ]; continue; }
+
+        T64Word r = stack[ --sp ];
+        T64Word l = stack[ sp - 1 ];
+        T64Word res = 0;
+        bool    divOk = ( r != 0 ) && ! (( l == INT64_MIN ) && ( r == -1 ));
+
+        switch ( op -> opCode ) {
+
+            case T64_COP_ADD:       res = l + r;                        break;
+            case T64_COP_SUB:       res = l - r;                        break;
+            case T64_COP_MUL:       res = l * r;                        break;
+            case T64_COP_DIV:       res = ( divOk ) ? l / r : 0;        break;
+            case T64_COP_MOD:       res = ( divOk ) ? l % r : 0;        break;
+            case T64_COP_AND:       res = l & r;                        break;
+            case T64_COP_OR:        res = l | r;                        break;
+            case T64_COP_XOR:       res = l ^ r;                        break;
+            case T64_COP_EQ:        res = ( l == r );                   break;
+            case T64_COP_NE:        res = ( l != r );                   break;
+            case T64_COP_LT:        res = ( l < r );                    break;
+            case T64_COP_GT:        res = ( l > r );                    break;
+            case T64_COP_LE:        res = ( l <= r );                   break;
+            case T64_COP_GE:        res = ( l >= r );                   break;
+            case T64_COP_LOG_AND:   res = ( l != 0 ) && ( r != 0 );     break;
+            case T64_COP_LOG_OR:    res = ( l != 0 ) || ( r != 0 );     break;
+            default: ;
+        }
+
+        stack[ sp - 1 ] = res;
+    }
+
+    return(( sp > 0 ) && ( stack[ sp - 1 ] != 0 ));
+}
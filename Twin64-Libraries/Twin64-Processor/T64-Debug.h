@@ -0,0 +1,253 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Breakpoints and watchpoints
+//
+//----------------------------------------------------------------------------------------
+// The debug object holds the instruction breakpoints and the data watchpoints. The
+// processors hold a reference to the debug object. When a breakpoint or watchpoint
+// hits, the hit is recorded and the system is asked to stop at the end of the cycle.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Breakpoints and watchpoints
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You
+// should have received a copy of the GNU General Public License along with this
+// program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+
+//----------------------------------------------------------------------------------------
+// Forwards.
+//
+//----------------------------------------------------------------------------------------
+struct T64Processor;
+
+//----------------------------------------------------------------------------------------
+// Debug table limits. The breakpoint hash table has twice as many slots as there can
+// be breakpoints, so that a lookup ends after a few probes. The watch page map has
+// one bit for each of 4096 page slots, a page is mapped to a slot by the low order
+// bits of its page number.
+//
+//----------------------------------------------------------------------------------------
+const int   T64_MAX_BREAKPOINTS     = 64;
+const int   T64_BP_HASH_SIZE        = 128;
+const int   T64_MAX_WATCHPOINTS     = 16;
+const int   T64_WATCH_PAGE_SLOTS    = 4096;
+const int   T64_MAX_COND_OPS        = 64;
+const int   T64_MAX_COND_STACK      = 16;
+const int   T64_MAX_COND_TEXT       = 128;
+
+//----------------------------------------------------------------------------------------
+// Watchpoint access modes and the kind of stop.
+//
+//----------------------------------------------------------------------------------------
+enum T64WatchMode : int {
+
+    T64_WATCH_READ          = 1,
+    T64_WATCH_WRITE         = 2,
+    T64_WATCH_READ_WRITE    = 3
+};
+
+enum T64StopKind : int {
+
+    T64_STOP_NIL            = 0,
+    T64_STOP_BREAKPOINT     = 1,
+    T64_STOP_WATCHPOINT     = 2
+};
+
+//----------------------------------------------------------------------------------------
+// Breakpoint condition operations. A condition is a small program for a stack machine.
+// The leaf operations push a constant or a register value, the unary operations
+// replace the top of the stack and the binary operations replace the two top entries
+// with their result. Comparisons and the logical operations deliver zero or one.
+//
+//----------------------------------------------------------------------------------------
+enum T64CondOpCode : uint8_t {
+
+    T64_COP_NIL             = 0,
+    T64_COP_CONST           = 1,
+    T64_COP_GREG            = 2,
+    T64_COP_CREG            = 3,
+    T64_COP_IA              = 4,
+    T64_COP_ST              = 5,
+    T64_COP_NOT             = 6,
+    T64_COP_NEG             = 7,
+    T64_COP_ADD             = 8,
+    T64_COP_SUB             = 9,
+    T64_COP_MUL             = 10,
+    T64_COP_DIV             = 11,
+    T64_COP_MOD             = 12,
+    T64_COP_AND             = 13,
+    T64_COP_OR              = 14,
+    T64_COP_XOR             = 15,
+    T64_COP_EQ              = 16,
+    T64_COP_NE              = 17,
+    T64_COP_LT              = 18,
+    T64_COP_GT              = 19,
+    T64_COP_LE              = 20,
+    T64_COP_GE              = 21,
+    T64_COP_LOG_AND         = 22,
+    T64_COP_LOG_OR          = 23
+};
+
+//----------------------------------------------------------------------------------------
+// A condition operation. A register operation reads the register of the processor
+// module "modNum", a module number of -1 is the processor checking the breakpoint.
+//
+//----------------------------------------------------------------------------------------
+struct T64CondOp {
+
+    T64CondOpCode   opCode      = T64_COP_NIL;
+    int             modNum      = -1;
+    int             regNum      = 0;
+    T64Word         val         = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// A compiled breakpoint condition. The condition is translated once when the break
+// point is set, the translator appends the operations in postfix order. While adding
+// an operation, the stack depth is tracked. An operation that would exceed the program
+// or stack size is refused, so that the evaluation needs no further checks. An empty
+// condition is always true.
+//
+//----------------------------------------------------------------------------------------
+struct T64StopCond {
+
+    public:
+
+    void            clear( );
+    bool            isEmpty( );
+    bool            addOp( T64CondOpCode opCode, 
+                           T64Word val = 0, 
+                           int modNum = -1, 
+                           int regNum = 0 );
+
+    bool            eval( T64System *sys, T64Processor *proc );
+
+    private:
+
+    T64CondOp       ops[ T64_MAX_COND_OPS ];
+    int             numOps      = 0;
+    int             depth       = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// A breakpoint. Besides the instruction address, there is an optional condition and
+// its source text for the display.
+//
+//----------------------------------------------------------------------------------------
+struct T64Breakpoint {
+
+    T64Word         adr         = 0;
+    T64StopCond     cond;
+    char            condText[ T64_MAX_COND_TEXT ] = { 0 };
+};
+
+//----------------------------------------------------------------------------------------
+// A watchpoint covers the address range "adr" to "adr + len - 1". The stop info
+// describes the first hit since the last clear. For a watchpoint hit, the address is
+// the data address accessed, the instruction address is the instruction that did the
+// access.
+//
+//----------------------------------------------------------------------------------------
+struct T64Watchpoint {
+
+    T64Word         adr         = 0;
+    T64Word         len         = 0;
+    T64WatchMode    mode        = T64_WATCH_WRITE;
+};
+
+struct T64StopInfo {
+
+    T64StopKind     kind        = T64_STOP_NIL;
+    int             modNum      = 0;
+    T64Word         instrAdr    = 0;
+    T64Word         dataAdr     = 0;
+    bool            wMode       = false;
+};
+
+//----------------------------------------------------------------------------------------
+// The debug object. Breakpoints are kept in a list and in an open addressing hash
+// table of list indices for the lookup. The condition of a breakpoint is only
+// evaluated when the instruction address matches. Watchpoints are kept in a list, which is
+// only searched when the page of a data access has its "has watch" bit set. For each
+// processor, we remember the instruction address of the last breakpoint hit. This
+// instruction is executed on resume, the breakpoint does not hit again right away.
+//
+//----------------------------------------------------------------------------------------
+struct T64Debug {
+
+    public:
+
+    T64Debug( T64System *sys );
+
+    bool            addBreakpoint( T64Word adr, 
+                                   T64StopCond *cond = nullptr, 
+                                   const char *condText = nullptr );
+    bool            removeBreakpoint( T64Word adr );
+    void            clearBreakpoints( );
+    int             getBreakpointCount( );
+    T64Breakpoint   *getBreakpoint( int index );
+
+    bool            addWatchpoint( T64Word adr, T64Word len, T64WatchMode mode );
+    bool            removeWatchpoint( T64Word adr );
+    void            clearWatchpoints( );
+    int             getWatchpointCount( );
+    T64Watchpoint   *getWatchpoint( int index );
+
+    bool            isEmpty( );
+
+    bool            checkBreakpoint( T64Processor *proc, T64Word instrAdr );
+    void            checkWatchpoint( int modNum,
+                                     T64Word instrAdr,
+                                     T64Word dataAdr,
+                                     int len,
+                                     bool wMode );
+
+    T64StopInfo     *getStopInfo( );
+    void            clearStopInfo( );
+
+    bool isWatchPage( T64Word adr ) {
+
+        int slot = (int) (( adr >> T64_PAGE_OFS_BITS ) & ( T64_WATCH_PAGE_SLOTS - 1 ));
+        return(( watchPageMap[ slot / 64 ] >> ( slot % 64 )) & 1 );
+    }
+
+    private:
+
+    int             findBreakpointSlot( T64Word adr );
+    void            rebuildBreakpointHash( );
+    void            rebuildWatchPageMap( );
+    void            recordStop( T64StopKind kind,
+                                int modNum,
+                                T64Word instrAdr,
+                                T64Word dataAdr,
+                                bool wMode );
+
+    T64System       *sys            = nullptr;
+
+    T64Breakpoint   bpList[ T64_MAX_BREAKPOINTS ];
+    int             bpCount         = 0;
+    int             bpHash[ T64_BP_HASH_SIZE ];
+
+    T64Watchpoint   wpList[ T64_MAX_WATCHPOINTS ];
+    int             wpCount         = 0;
+    uint64_t        watchPageMap[ T64_WATCH_PAGE_SLOTS / 64 ];
+
+    T64Word         resumeAdr[ MAX_MOD_MAP_ENTRIES ];
+
+    T64StopInfo     stopInfo;
+};
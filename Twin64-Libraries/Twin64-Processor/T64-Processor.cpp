@@ -30,6 +30,28 @@
 //----------------------------------------------------------------------------------------
 namespace {
 
+//----------------------------------------------------------------------------------------
+// HPA registers are accessed as 8-byte words. The bus data buffer holds the value
+// in host byte order.
+//
+//----------------------------------------------------------------------------------------
+bool isHpaRegAccess( T64Word ofs, int len ) {
+
+    return(( len == sizeof( T64Word )) && (( ofs & ( sizeof( T64Word ) - 1 )) == 0 ));
+}
+
+T64Word getBusWord( uint8_t *data ) {
+
+    T64Word val;
+    memcpy( &val, data, sizeof( val ));
+    return( val );
+}
+
+void setBusWord( uint8_t *data, T64Word val ) {
+
+    memcpy( data, &val, sizeof( val ));
+}
+
 };
 
 //****************************************************************************************
@@ -52,7 +74,7 @@ T64Processor::T64Processor( T64System           *sys,
                             T64CacheType        iCacheType,
                             T64CacheType        dCacheType,
                             T64Word             spaAdr,
-                            int                 spaLen ) : 
+                            T64Word             spaLen ) : 
 
                             T64Module(      MT_PROC, 
                                             modNum,
@@ -100,6 +122,43 @@ void T64Processor::reset( ) {
 
     instructionCount    = 0;
     cycleCount          = 0;
+    intrPending         = 0;
+
+    updateAttention( );
+}
+
+//----------------------------------------------------------------------------------------
+// Save and restore the processor state for a record and replay snapshot. The state
+// consists of the processor counters, the pending interrupts and the state of the 
+// submodules. The trace and debug references are host settings and stay.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::saveState( T64StateBuf *buf ) {
+
+    buf -> put( &instructionCount, sizeof( instructionCount ));
+    buf -> put( &cycleCount, sizeof( cycleCount ));
+    buf -> put( &intrPending, sizeof( intrPending ));
+
+    cpu -> saveState( buf );
+    iTlb -> saveState( buf );
+    dTlb -> saveState( buf );
+    iCache -> saveState( buf );
+    dCache -> saveState( buf );
+}
+
+void T64Processor::restoreState( T64StateBuf *buf ) {
+
+    buf -> get( &instructionCount, sizeof( instructionCount ));
+    buf -> get( &cycleCount, sizeof( cycleCount ));
+    buf -> get( &intrPending, sizeof( intrPending ));
+
+    cpu -> restoreState( buf );
+    iTlb -> restoreState( buf );
+    dTlb -> restoreState( buf );
+    iCache -> restoreState( buf );
+    dCache -> restoreState( buf );
+
+    updateAttention( );
 }
 
 //----------------------------------------------------------------------------------------
@@ -131,6 +190,31 @@ T64Cache *T64Processor::getDCachePtr( ) {
     return( dCache );
 }
 
+//----------------------------------------------------------------------------------------
+// Cache and TLB access trace. The trace writer is passed to all TLBs and caches of
+// the processor. A null pointer stops the trace. The writer is owned by the caller.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::setTrace( T64TraceWriter *trace ) {
+
+    iTlb -> setTrace( trace );
+    dTlb -> setTrace( trace );
+    iCache -> setTrace( trace );
+    dCache -> setTrace( trace );
+}
+
+//----------------------------------------------------------------------------------------
+// Breakpoints and watchpoints. With a debug object set, the breakpoints and watchpoints
+// are checked. A null pointer turns the checks off. The debug object is owned by the
+// caller.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::setDebug( T64Debug *debug ) {
+
+    this -> debug = debug;
+    updateAttention( );
+}
+
 //----------------------------------------------------------------------------------------
 // System Bus operations interface routines. When a module issues a request, any 
 // other module will be informed. We can now check whether the bus transactions 
@@ -155,11 +239,14 @@ T64Cache *T64Processor::getDCachePtr( ) {
 //      Another module is writing back an exclusive copy if its cache block. By
 //      definition, we do not own that block in any case.
 //
-// For all cases, we first check that we are not the originator of that request. 
-// Just a little sanity check. Next, we lookup the responsible module by the physical 
-// address of the request. If we are not the address range owner, we perform the 
-// operations described above on our caches. If we are the owner, we simply carry 
-// the request.
+// For all cases, we first check whether we are the originator of that request. If 
+// so, the request was issued by our caches and is passed on to the system bus, which
+// informs all other modules and carries out the request at the target module. For a
+// request of another module, we lookup the module responsible for the physical
+// address. When that is not us, which is always the case for a memory address, we
+// flush or purge the block in our caches as described above. A request that takes
+// the block for writing also cancels a reservation of our CPU on that block. When
+// we are the owner, there is nothing to do.
 //
 // A processor cannot be the target of a cache operation. It does not own a physical
 // address range other then its HPA address range. And this range can only be accessed
@@ -171,7 +258,8 @@ bool T64Processor::busOpReadSharedBlock(  int      reqModNum,
                                           uint8_t  *data, 
                                           int      len ) {
 
-    if ( reqModNum == moduleNum ) return( false );
+    if ( reqModNum == moduleNum )
+        return( sys -> busOpReadSharedBlock( reqModNum, pAdr, data, len ));
 
     T64Processor *proc = (T64Processor *) sys -> lookupByAdr( pAdr );
     if ( proc == this ) {
@@ -194,7 +282,8 @@ bool T64Processor::busOpReadPrivateBlock( int     reqModNum,
                                           uint8_t *data, 
                                           int     len ) {
 
-    if ( reqModNum == moduleNum ) return( false );
+    if ( reqModNum == moduleNum )
+        return( sys -> busOpReadPrivateBlock( reqModNum, pAdr, data, len ));
 
     T64Processor *proc = (T64Processor *) sys -> lookupByAdr( pAdr );
     if ( proc == this ) {
@@ -207,6 +296,7 @@ bool T64Processor::busOpReadPrivateBlock( int     reqModNum,
 
         iCache -> purge( pAdr );
         dCache -> purge( pAdr );
+        cpu -> snoopReservation( pAdr, len );
     }
 
     return (true );
@@ -217,10 +307,12 @@ bool T64Processor::busOpWriteBlock( int     reqModNum,
                                     uint8_t *data, 
                                     int     len ) {
                
-    if ( reqModNum == moduleNum ) return( false );
+    if ( reqModNum == moduleNum )
+        return( sys -> busOpWriteBlock( reqModNum, pAdr, data, len ));
 
     // by definition, if someone is issuing a write block, the cache line 
     // is exclusive with the module. we ignore... ???
+    cpu -> snoopReservation( pAdr, len );
     return (true );
 }
 
@@ -238,33 +330,28 @@ bool T64Processor::busOpWriteBlock( int     reqModNum,
 //
 //      Another module issued an uncached write. We check wether this concerns our
 //      HPA address range. If so, we update the data in our HPA space.
-//    
-// ??? need a function to call for processor HPA data
+//
+// An access to our own HPA range is handled right here, also when our own CPU is
+// the requestor. Otherwise a request issued by us is passed on to the system bus.
 //
 //----------------------------------------------------------------------------------------
 bool T64Processor::busOpReadUncached( int     reqModNum, 
                                       T64Word pAdr, 
                                       uint8_t *data, 
                                       int     len ) {
-    
-    if ( reqModNum == moduleNum ) return( false );
 
-    T64Processor *proc = (T64Processor *) sys -> lookupByAdr( pAdr );
-    if ( proc == this ) {
+    if (( pAdr >= hpaAdr ) && ( pAdr < hpaAdr + hpaLen ))
+        return( hpaRead( pAdr - hpaAdr, data, len ));
+    
+    if ( reqModNum == moduleNum )
+        return( sys -> busOpReadUncached( reqModNum, pAdr, data, len ));
 
-        // ??? we are the target, deliver the data
-        *data = 0;
-        return (true );
-    }
-    else {
+    // ??? we could have that data in our caches... remove.
 
-         // ??? we could have that data in our caches... remove.
-
-        iCache -> flush( pAdr );
-        dCache -> flush( pAdr );
-        iCache -> purge( pAdr );
-        dCache -> purge( pAdr );
-    }
+    iCache -> flush( pAdr );
+    dCache -> flush( pAdr );
+    iCache -> purge( pAdr );
+    dCache -> purge( pAdr );
 
     return( true );
 }
@@ -274,36 +361,148 @@ bool T64Processor::busOpWriteUncached( int     reqModNum,
                                        uint8_t *data, 
                                        int     len ) {
 
-   if ( reqModNum == moduleNum ) return( false );
+    if (( pAdr >= hpaAdr ) && ( pAdr < hpaAdr + hpaLen ))
+        return( hpaWrite( pAdr - hpaAdr, data, len ));
 
-    T64Processor *proc = (T64Processor *) sys -> lookupByAdr( pAdr );
-    if ( proc == this ) {
+    if ( reqModNum == moduleNum )
+        return( sys -> busOpWriteUncached( reqModNum, pAdr, data, len ));
+
+    // ??? if we have a copy of that data, flush it first. delete the line.
+
+    iCache -> flush( pAdr );
+    dCache -> flush( pAdr );
+    iCache -> purge( pAdr );
+    dCache -> purge( pAdr );
+    cpu -> snoopReservation( pAdr, len );
+        
+    return( false );
+}
+
+//----------------------------------------------------------------------------------------
+// DMA bus operations. A processor is never the target of a DMA transfer. When an I/O
+// module reads a memory block, modified cache lines of that block are written back
+// first. When it writes a memory block, our copies of the block are removed and a
+// reservation on the block is lost.
+//
+//----------------------------------------------------------------------------------------
+bool T64Processor::busOpDmaRead( int     reqModNum, 
+                                 T64Word pAdr, 
+                                 uint8_t *data, 
+                                 T64Word len ) {
+
+    int lineSize = dCache -> getCacheLineSize( );
+
+    for ( T64Word adr = rounddown( pAdr, lineSize ); adr < pAdr + len; adr += lineSize ) {
 
-        // ??? we are the target, deliver the data
-        *data = 0;
-        return (true );
+        dCache -> flush( adr );
     }
-    else {
 
-        // ??? if we have a copy of that data, flush it first. delete the line.
+    return( true );
+}
 
-        iCache -> flush( pAdr );
-        dCache -> flush( pAdr );
-        iCache -> purge( pAdr );
-        dCache -> purge( pAdr );
+bool T64Processor::busOpDmaWrite( int     reqModNum, 
+                                  T64Word pAdr, 
+                                  uint8_t *data, 
+                                  T64Word len ) {
+
+    int lineSize = dCache -> getCacheLineSize( );
+
+    for ( T64Word adr = rounddown( pAdr, lineSize ); adr < pAdr + len; adr += lineSize ) {
+
+        iCache -> purge( adr );
+        dCache -> purge( adr );
     }
-        
-    return( false );
+
+    cpu -> snoopReservation( pAdr, len );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// HPA register read. Reading the interrupt request register returns the pending
+// interrupt bits. Registers not implemented read as zero.
+//
+//----------------------------------------------------------------------------------------
+bool T64Processor::hpaRead( T64Word ofs, uint8_t *data, int len ) {
+
+    if ( ! isHpaRegAccess( ofs, len )) return( false );
+
+    switch ( ofs / sizeof( T64Word )) {
+
+        case PROC_HPA_REG_HPA_ADR:      setBusWord( data, hpaAdr );         break;
+        case PROC_HPA_REG_SPA_ADR:      setBusWord( data, spaAdr );         break;
+        case PROC_HPA_REG_SPA_LEN:      setBusWord( data, spaLen );         break;
+        case PROC_HPA_REG_INTR_REQUEST: setBusWord( data, intrPending );    break;
+        default:                        setBusWord( data, 0 );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// HPA register write. A write to the interrupt request register sets the written
+// bits in the pending interrupt word, a write to the interrupt clear register 
+// removes them. All other registers ignore a write.
+//
+//----------------------------------------------------------------------------------------
+bool T64Processor::hpaWrite( T64Word ofs, uint8_t *data, int len ) {
+
+    if ( ! isHpaRegAccess( ofs, len )) return( false );
+
+    switch ( ofs / sizeof( T64Word )) {
+
+        case PROC_HPA_REG_INTR_REQUEST: intrPending |= getBusWord( data );      break;
+        case PROC_HPA_REG_INTR_CLEAR:   intrPending &= ~ getBusWord( data );    break;
+        default: ;
+    }
+
+    updateAttention( );
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// The attention flag is set when there is work to do before the next instruction. It
+// must be updated whenever the pending interrupts or the debug object change.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::updateAttention( ) {
+
+    attention = ( intrPending != 0 ) || ( debug != nullptr );
+}
+
+//----------------------------------------------------------------------------------------
+// Get the pending external interrupt bits.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64Processor::getIntrPending( ) {
+
+    return( intrPending );
 }
 
 //----------------------------------------------------------------------------------------
 // The step routine is the entry point to the processor for executing one or more 
-// instructions.
+// instructions. Before the next instruction, we check for pending external 
+// interrupts and for a breakpoint. This is a single test of the attention flag, 
+// the slow path is only taken when an interrupt is actually pending or a debug
+// object is set. The breakpoint is checked after the interrupt delivery, so that
+// a breakpoint in the interrupt handler hits. An instruction at a breakpoint is not
+// executed.
 //
 //----------------------------------------------------------------------------------------
 void T64Processor::step( ) {
 
     try {
+
+        if ( attention ) {
+
+            if ( intrPending != 0 ) cpu -> deliverInterrupt( intrPending );
+
+            if (( debug != nullptr ) && 
+                ( debug -> checkBreakpoint( this, 
+                                            extractField64( cpu -> getPsrReg( ), 0, 52 )))) {
+                
+                return;
+            }
+        }
         
         cpu -> step( );
     }
@@ -312,3 +511,21 @@ void T64Processor::step( ) {
         
     }
 }
+
+//----------------------------------------------------------------------------------------
+// Processor events. The only event is the expiry of the CPU recovery counter.
+//
+//----------------------------------------------------------------------------------------
+void T64Processor::handleEvent( int eventId ) {
+
+    if ( eventId == PROC_EVT_REC_CNTR ) cpu -> recCntrExpired( );
+}
+
+//----------------------------------------------------------------------------------------
+// A processor executes an instruction on every system step. It is a clocked module.
+//
+//----------------------------------------------------------------------------------------
+bool T64Processor::isClocked( ) {
+
+    return ( true );
+}
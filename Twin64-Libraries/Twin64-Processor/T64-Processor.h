@@ -27,6 +27,9 @@
 #include "T64-Common.h"
 #include "T64-Util.h"
 #include "T64-System.h"
+#include "T64-Replay.h"
+#include "T64-Trace.h"
+#include "T64-Debug.h"
 
 //----------------------------------------------------------------------------------------
 // Forwards.
@@ -107,12 +110,15 @@ enum T64CacheType : int {
 };
 
 //----------------------------------------------------------------------------------------
-// Cache line info consisting of valid, modified and the cache tag.
+// Cache line info consisting of valid, exclusive, modified and the cache tag. A line
+// obtained with a read private request is exclusive. Only an exclusive line may be
+// modified without informing the other caches.
 //
 //----------------------------------------------------------------------------------------
 struct T64CacheLineInfo {
 
     bool        valid;
+    bool        exclusive;
     bool        modified;
     uint32_t    tag;
 };
@@ -137,6 +143,8 @@ struct T64Cache {
 
     void                reset( );
     void                step( );
+    void                saveState( T64StateBuf *buf );
+    void                restoreState( T64StateBuf *buf );
 
     void                read( T64Word pAdr, uint8_t *data, int len, bool cached = true);
     void                write( T64Word pAdr, uint8_t *data, int len, bool cached = true );
@@ -151,6 +159,11 @@ struct T64Cache {
     bool                purgeCacheLineByIndex( uint32_t way, uint32_t set );
     bool                flushCacheLineByIndex( uint32_t way, uint32_t set );
 
+    int                 plruVictim( uint32_t set );
+    void                plruUpdate( uint32_t set, int way );
+
+    void                setTrace( T64TraceWriter *trace );
+
     int                 getRequestCount( );
     int                 getHitCount( );
     int                 getMissCount( );
@@ -165,7 +178,12 @@ struct T64Cache {
 
     bool                lookupCache( T64Word          pAdr, 
                                      T64CacheLineInfo **info, 
-                                     uint8_t          **data );
+                                     uint8_t          **data,
+                                     int              *way = nullptr );
+
+    void                allocateCacheLine( T64Word          pAdr,
+                                           T64CacheLineInfo **info,
+                                           uint8_t          **data );
 
     void                readCacheData( T64Word pAdr, uint8_t *data, int len );
     void                writeCacheData( T64Word pAdr, uint8_t *data, int len );
@@ -186,8 +204,6 @@ struct T64Cache {
     uint32_t            getSetIndex( T64Word  paAdr );
     uint32_t            getLineOfs( T64Word  paAdr );
     T64Word             pAdrFromTag( uint32_t tag, uint32_t index );
-    int                 plruVictim( );
-    void                plruUpdate( );
 
     private: 
 
@@ -198,6 +214,7 @@ struct T64Cache {
     uint8_t             *cacheData      = nullptr;
     T64Processor        *proc           = nullptr;
     T64System           *sys            = nullptr;
+    T64TraceWriter      *trace          = nullptr;
 
     int                 ways            = 0;
     int                 sets            = 0;
@@ -210,7 +227,7 @@ struct T64Cache {
     int                 tagShift        = 0;
     int                 cacheHits       = 0;
     int                 cacheMiss       = 0;
-    uint8_t             plruState       = 0;
+    uint8_t             *plruState      = nullptr;
 };
 
 //----------------------------------------------------------------------------------------
@@ -252,6 +269,8 @@ struct T64Tlb {
     virtual         ~ T64Tlb( );
     
     void            reset( );
+    void            saveState( T64StateBuf *buf );
+    void            restoreState( T64StateBuf *buf );
     T64TlbEntry     *lookup( T64Word vAdr );
     
     bool            insert( T64Word vAdr, T64Word info );
@@ -267,6 +286,12 @@ struct T64Tlb {
     T64TlbType      getTlbType( );
     char           *getTlbTypeString( );
 
+    T64Word         getRequestCount( );
+    T64Word         getHitCount( );
+    T64Word         getMissCount( );
+
+    void            setTrace( T64TraceWriter *trace );
+
     private:
     
     T64TlbKind      tlbKind         = T64_TK_NIL;
@@ -274,7 +299,10 @@ struct T64Tlb {
     T64TlbEntry     *map            = nullptr; 
     int             tlbEntries      = 0;
     T64Word         timeCounter     = 0;
+    T64Word         tlbLookups      = 0;
+    T64Word         tlbMisses       = 0;
     T64Processor    *proc           = nullptr;
+    T64TraceWriter  *trace          = nullptr;
 };
 
 //----------------------------------------------------------------------------------------
@@ -292,6 +320,8 @@ struct T64Cpu {
 
     void            reset( );
     void            step( );
+    void            saveState( T64StateBuf *buf );
+    void            restoreState( T64StateBuf *buf );
 
     T64Word         getGeneralReg( int index );
     void            setGeneralReg( int index, T64Word val );
@@ -302,8 +332,26 @@ struct T64Cpu {
     T64Word         getPsrReg( );
     void            setPsrReg( T64Word val );
 
+    bool            deliverInterrupt( T64Word pending );
+    void            recCntrExpired( );
+
+    void            snoopReservation( T64Word pAdr, T64Word len );
+    T64Word         getResvCount( );
+    T64Word         getStcSuccessCount( );
+    T64Word         getStcFailCount( );
+
+    T64Word         getTrapCount( );
+    T64TrapCode     getLastTrapCode( );
+    T64Word         getLastTrapAdr( );
+
     private: 
 
+    void            enterTrapHandler( T64TrapCode code, T64Word arg0, T64Word arg1 );
+    void            recCntrStart( T64Word cycle );
+    void            recCntrStop( T64Word cycle );
+    T64Word         recCntrValue( T64Word cycle );
+    T64Word         curCycle( );
+
     bool            isPhysMemAdr( T64Word vAdr );
     int             evalCond( int cond, T64Word val1, T64Word val2 );
 
@@ -336,12 +384,12 @@ struct T64Cpu {
     void            setRegR( uint32_t instr, T64Word val );
    
     T64Word         instrRead( T64Word vAdr );
-    T64Word         dataRead( T64Word vAdr, int len, bool sExt );
-    T64Word         dataReadRegBOfsImm13( uint32_t instr );
+    T64Word         dataRead( T64Word vAdr, int len, bool sExt, T64Word *pAdr = nullptr );
+    T64Word         dataReadRegBOfsImm13( uint32_t instr, T64Word *pAdr = nullptr );
     T64Word         dataReadRegBOfsRegX( uint32_t instr );
 
-    void            dataWrite( T64Word vAdr, T64Word val, int len );
-    void            dataWriteRegBOfsImm13( uint32_t instr );
+    bool            dataWrite( T64Word vAdr, T64Word val, int len, bool resvCheck = false );
+    bool            dataWriteRegBOfsImm13( uint32_t instr, bool resvCheck = false );
     void            dataWriteRegBOfsRegX( uint32_t instr );
 
     void            instrAluAddOp( T64Instr instr );
@@ -397,6 +445,19 @@ struct T64Cpu {
    
     T64Word         lowerPhysMemAdr = 0;
     T64Word         upperPhysMemAdr = T64_MAX_PHYS_MEM_LIMIT;
+
+    T64Word         recCntrEvt      = -1;
+    T64Word         recCntrDeadline = 0;
+
+    bool            resvValid       = false;
+    T64Word         resvLen         = 0;
+    T64Word         resvCount       = 0;
+    T64Word         stcSuccessCount = 0;
+    T64Word         stcFailCount    = 0;
+
+    T64Word         trapCount       = 0;
+    T64TrapCode     lastTrapCode    = NO_TRAP;
+    T64Word         lastTrapAdr     = 0;
 };
 
 //----------------------------------------------------------------------------------------
@@ -418,7 +479,36 @@ struct T64Cpu {
 // The processor participates in the cache coherence protocol and has methods that
 // are called from the system object.
 //
+// External interrupts are posted by other modules with an uncached bus write to the
+// processor HPA interrupt request register. The written bits are added to the 
+// pending interrupt word, which the processor checks before each instruction. The
+// interrupt handler acknowledges the interrupt by writing the bits it handled to
+// the interrupt clear register.
+//
+// With a debug object set, the processor checks for a breakpoint before each
+// instruction and the CPU checks each data access against the watchpoints. Pending
+// interrupts and the debug checks are summarized in the attention flag, so that an
+// instruction without either pays for a single test.
+//
+//----------------------------------------------------------------------------------------
+enum T64ProcHpaReg : int {
+
+    PROC_HPA_REG_STATUS         = 0,
+    PROC_HPA_REG_COMMAND        = 1,
+    PROC_HPA_REG_HPA_ADR        = 2,
+    PROC_HPA_REG_SPA_ADR        = 3,
+    PROC_HPA_REG_SPA_LEN        = 4,
+    PROC_HPA_REG_INTR_REQUEST   = 8,
+    PROC_HPA_REG_INTR_CLEAR     = 9
+};
+
+//----------------------------------------------------------------------------------------
+// Processor events. The recovery counter schedules an event for the cycle in which it
+// expires.
+//
 //----------------------------------------------------------------------------------------
+const int PROC_EVT_REC_CNTR = 1;
+
 struct T64Processor : T64Module {
     
     public:
@@ -432,12 +522,16 @@ struct T64Processor : T64Module {
                   T64CacheType      iCacheType,
                   T64CacheType      dCacheType,
                   T64Word           spaAdr,
-                  int               spaLen );
+                  T64Word           spaLen );
     
     virtual        ~ T64Processor( );
     
     void            reset( );
     void            step( );
+    bool            isClocked( );
+    void            handleEvent( int eventId );
+    void            saveState( T64StateBuf *buf );
+    void            restoreState( T64StateBuf *buf );
 
     bool            busOpReadSharedBlock( int reqModNum, 
                                           T64Word pAdr, 
@@ -464,24 +558,45 @@ struct T64Processor : T64Module {
                                         uint8_t *data, 
                                         int len );
 
+    bool            busOpDmaRead( int reqModNum, 
+                                  T64Word adr, 
+                                  uint8_t *data, 
+                                  T64Word len );
+
+    bool            busOpDmaWrite( int reqModNum, 
+                                   T64Word adr, 
+                                   uint8_t *data, 
+                                   T64Word len );
+
     T64Cpu          *getCpuPtr( );
     T64Tlb          *getITlbPtr( );
     T64Tlb          *getDTlbPtr( );
     T64Cache        *getICachePtr( );
     T64Cache        *getDCachePtr( );
+
+    void            setTrace( T64TraceWriter *trace );
+    void            setDebug( T64Debug *debug );
+    T64Word         getIntrPending( );
     
 private:
 
     friend struct   T64Cpu;
 
+    bool            hpaRead( T64Word ofs, uint8_t *data, int len );
+    bool            hpaWrite( T64Word ofs, uint8_t *data, int len );
+    void            updateAttention( );
+
     T64System       *sys                = nullptr;
     T64Cpu          *cpu                = nullptr;
     T64Tlb          *iTlb               = nullptr;
     T64Tlb          *dTlb               = nullptr;
     T64Cache        *iCache             = nullptr;
     T64Cache        *dCache             = nullptr;
+    T64Debug        *debug              = nullptr;
 
     int             modNum              = 0;
     T64Word         instructionCount    = 0;
     T64Word         cycleCount          = 0;
+    T64Word         intrPending         = 0;
+    bool            attention           = false;
 };
@@ -37,7 +37,7 @@ namespace {
 // Maximum TLB size.
 //
 //----------------------------------------------------------------------------------------
-const int T64_MAX_TLB_SIZE = 64;
+const int T64_MAX_TLB_SIZE = 128;
 
 //----------------------------------------------------------------------------------------
 // Calculate the page size from the size field in the TLB entry. Currently, there
@@ -69,10 +69,13 @@ T64Tlb::T64Tlb( T64Processor *proc, T64TlbKind tlbKind, T64TlbType tlbType ) {
 
     switch ( tlbType ) {
 
-        case T64_TT_FA_64S:     tlbEntries = 64; break;
+        case T64_TT_FA_64S:     tlbEntries = 64;  break;
+        case T64_TT_FA_128S:    tlbEntries = 128; break;
         default:                tlbEntries = 64;
     }
 
+    if ( tlbEntries > T64_MAX_TLB_SIZE ) tlbEntries = T64_MAX_TLB_SIZE;
+
     map = (T64TlbEntry *) malloc( tlbEntries * sizeof( T64TlbEntry ));
     reset( );
 }
@@ -92,7 +95,7 @@ T64Tlb::~T64Tlb( ) {
 //----------------------------------------------------------------------------------------
 void T64Tlb::reset( ) {
     
-    for ( int i = 0; i < T64_MAX_TLB_SIZE; i++ ) {
+    for ( int i = 0; i < tlbEntries; i++ ) {
         
         map[ i ].valid = false;
         map[ i ].locked       = false;
@@ -108,6 +111,28 @@ void T64Tlb::reset( ) {
     }
 
     timeCounter = 0;
+    tlbLookups  = 0;
+    tlbMisses   = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// Save and restore the TLB state. These are the entries and the counters.
+//
+//----------------------------------------------------------------------------------------
+void T64Tlb::saveState( T64StateBuf *buf ) {
+
+    buf -> put( map, tlbEntries * sizeof( T64TlbEntry ));
+    buf -> put( &timeCounter, sizeof( timeCounter ));
+    buf -> put( &tlbLookups, sizeof( tlbLookups ));
+    buf -> put( &tlbMisses, sizeof( tlbMisses ));
+}
+
+void T64Tlb::restoreState( T64StateBuf *buf ) {
+
+    buf -> get( map, tlbEntries * sizeof( T64TlbEntry ));
+    buf -> get( &timeCounter, sizeof( timeCounter ));
+    buf -> get( &tlbLookups, sizeof( tlbLookups ));
+    buf -> get( &tlbMisses, sizeof( tlbMisses ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -118,19 +143,28 @@ void T64Tlb::reset( ) {
 T64TlbEntry *T64Tlb::lookup( T64Word vAdr ) {
 
     timeCounter ++;
+    tlbLookups ++;
+
+    if ( trace != nullptr ) {
+
+        trace -> record((( tlbKind == T64_TK_INSTR_TLB ) ? 
+                            T64_TRK_I_TLB_LOOKUP : T64_TRK_D_TLB_LOOKUP ),
+                        vAdr, sizeof( T64Word ), false );
+    }
     
-    for ( int i = 0; i < T64_MAX_TLB_SIZE; i++ ) {
+    for ( int i = 0; i < tlbEntries; i++ ) {
         
         T64TlbEntry *ptr = &map[ i ];
        
         if (( ptr -> valid ) && 
-            ( isInRange( vAdr, ptr ->vAdr, ptr -> vAdr + ptr -> pSize ))) {
+            ( isInRange( vAdr, ptr -> vAdr, ptr -> vAdr + ptr -> pSize - 1 ))) {
          
             ptr -> lastUsed = timeCounter;
             return( ptr );
         }
     }
     
+    tlbMisses ++;
     return( nullptr );
 }
 
@@ -160,7 +194,7 @@ bool T64Tlb::insert( T64Word vAdr, T64Word info ) {
     if ( ! isAlignedPageAdr( vAdr, pSize )) return ( false );
     if ( ! isAlignedPageAdr( pAdr, pSize )) return ( false );
 
-    for ( int i = 0; i < T64_MAX_TLB_SIZE; i++ ) {
+    for ( int i = 0; i < tlbEntries; i++ ) {
     
         T64TlbEntry *ptr = &map[ i] ;
         if ( ! ptr -> valid ) continue;
@@ -176,7 +210,7 @@ bool T64Tlb::insert( T64Word vAdr, T64Word info ) {
         }
     }
 
-    for ( int i = 0; i < T64_MAX_TLB_SIZE; i++ ) {
+    for ( int i = 0; i < tlbEntries; i++ ) {
 
         if ( ! map[ i ].valid ) {
             
@@ -187,7 +221,7 @@ bool T64Tlb::insert( T64Word vAdr, T64Word info ) {
 
     if ( entry == nullptr ) {
 
-        for ( int i = 0; i < T64_MAX_TLB_SIZE; i++ ) {
+        for ( int i = 0; i < tlbEntries; i++ ) {
 
             T64TlbEntry *ptr = &map[ i ];
             if (( ptr -> valid ) && ( ! ptr -> locked )) {
@@ -226,12 +260,12 @@ bool T64Tlb::insert( T64Word vAdr, T64Word info ) {
 //----------------------------------------------------------------------------------------
 bool T64Tlb::purge( T64Word vAdr ) {
     
-    for ( int i = 0; i < T64_MAX_TLB_SIZE; i++ ) {
+    for ( int i = 0; i < tlbEntries; i++ ) {
         
         T64TlbEntry *ptr = &map[ i ];
         
         if (( ptr -> valid ) && 
-            ( isInRange( vAdr, ptr ->vAdr, ptr -> vAdr + ptr -> pSize ))) {
+            ( isInRange( vAdr, ptr -> vAdr, ptr -> vAdr + ptr -> pSize - 1 ))) {
         
             ptr -> valid = false;
         }
@@ -246,13 +280,13 @@ bool T64Tlb::purge( T64Word vAdr ) {
 //----------------------------------------------------------------------------------------
 T64TlbEntry *T64Tlb::getTlbEntry( int index ) {
     
-    if ( isInRange( index, 0, T64_MAX_TLB_SIZE - 1 )) return( &map[ index ] );
-    else                                              return( nullptr );
+    if ( isInRange( index, 0, tlbEntries - 1 )) return( &map[ index ] );
+    else                                         return( nullptr );
 }
 
 int T64Tlb::getTlbSize( ) {
 
-    return ( T64_MAX_TLB_SIZE );
+    return ( tlbEntries );
 }
 
 T64TlbKind T64Tlb::getTlbKind( ) {
@@ -265,11 +299,41 @@ T64TlbType T64Tlb::getTlbType( ) {
     return ( tlbType );
 }
 
+//----------------------------------------------------------------------------------------
+// TLB statistics. We count the lookup requests and the misses.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64Tlb::getRequestCount( ) {
+
+    return( tlbLookups );
+}
+
+T64Word T64Tlb::getHitCount( ) {
+
+    return( tlbLookups - tlbMisses );
+}
+
+T64Word T64Tlb::getMissCount( ) {
+
+    return( tlbMisses );
+}
+
 char *T64Tlb::getTlbTypeString( ) {
 
     switch ( tlbType ) {
 
         case T64_TT_FA_64S:     return ( (char *) "FA_64S" );
+        case T64_TT_FA_128S:    return ( (char *) "FA_128S" );
         default:                return ( (char *) "Unknown TLB Type" );
     }
 }
+
+//----------------------------------------------------------------------------------------
+// Set the trace writer. When set, every lookup is recorded to the trace. A null 
+// pointer disables the trace.
+//
+//----------------------------------------------------------------------------------------
+void T64Tlb::setTrace( T64TraceWriter *trace ) {
+
+    this -> trace = trace;
+}
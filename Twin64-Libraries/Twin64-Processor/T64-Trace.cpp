@@ -0,0 +1,306 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Cache and TLB trace
+//
+//----------------------------------------------------------------------------------------
+// The trace writer and reader for the cache and TLB access trace. See the header
+// file for the trace file layout.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Cache and TLB trace
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You
+// should have received a copy of the GNU General Public License along with this
+// program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Trace.h"
+
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// The access size is stored as a power of two. Sizes are 1 to 128 bytes.
+//
+//----------------------------------------------------------------------------------------
+int sizeToLog2( int len ) {
+
+    int log2 = 0;
+    while (( log2 < 7 ) && (( 1 << log2 ) < len )) log2 ++;
+    return( log2 );
+}
+
+//----------------------------------------------------------------------------------------
+// Zigzag encoding maps small negative and positive deltas to small unsigned values.
+//
+//----------------------------------------------------------------------------------------
+uint64_t zigzagEncode( int64_t val ) {
+
+    return((uint64_t)( val << 1 ) ^ (uint64_t)( val >> 63 ));
+}
+
+int64_t zigzagDecode( uint64_t val ) {
+
+    return((int64_t)( val >> 1 ) ^ -(int64_t)( val & 1 ));
+}
+
+//----------------------------------------------------------------------------------------
+// Trace file header. The version is written little endian, byte by byte.
+//
+//----------------------------------------------------------------------------------------
+void buildHeader( uint8_t *hdr ) {
+
+    memset( hdr, 0, T64_TRACE_HEADER_SIZE );
+    memcpy( hdr, T64_TRACE_MAGIC, 8 );
+
+    for ( int i = 0; i < 4; i++ ) hdr[ 8 + i ] = ( T64_TRACE_VERSION >> ( i * 8 )) & 0xFF;
+}
+
+} // namespace
+
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Trace writer
+//
+//----------------------------------------------------------------------------------------
+// Object constructor and destructor. A writer that is still open is closed, such
+// that the buffered records are not lost.
+//
+//----------------------------------------------------------------------------------------
+T64TraceWriter::T64TraceWriter( ) {
+
+    for ( int i = 0; i < T64_TRACE_MAX_KINDS; i++ ) lastAdr[ i ] = 0;
+}
+
+T64TraceWriter::~T64TraceWriter( ) {
+
+    close( );
+}
+
+//----------------------------------------------------------------------------------------
+// Open the trace file and write the header. An already open trace is closed first.
+//
+//----------------------------------------------------------------------------------------
+bool T64TraceWriter::open( const char *fileName ) {
+
+    uint8_t hdr[ T64_TRACE_HEADER_SIZE ];
+
+    close( );
+
+    traceFile = fopen( fileName, "wb" );
+    if ( traceFile == nullptr ) return( false );
+
+    buildHeader( hdr );
+    if ( fwrite( hdr, 1, sizeof( hdr ), traceFile ) != sizeof( hdr )) {
+
+        fclose( traceFile );
+        traceFile = nullptr;
+        return( false );
+    }
+
+    for ( int i = 0; i < T64_TRACE_MAX_KINDS; i++ ) lastAdr[ i ] = 0;
+    bufPos      = 0;
+    recordCount = 0;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Close the trace file. Any buffered records are written first.
+//
+//----------------------------------------------------------------------------------------
+void T64TraceWriter::close( ) {
+
+    if ( traceFile != nullptr ) {
+
+        flushBuffer( );
+        fclose( traceFile );
+        traceFile = nullptr;
+    }
+}
+
+bool T64TraceWriter::isOpen( ) {
+
+    return( traceFile != nullptr );
+}
+
+T64Word T64TraceWriter::getRecordCount( ) {
+
+    return( recordCount );
+}
+
+void T64TraceWriter::flushBuffer( ) {
+
+    if (( traceFile != nullptr ) && ( bufPos > 0 )) {
+
+        fwrite( buf, 1, bufPos, traceFile );
+    }
+
+    bufPos = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// Add a record. A record needs at most eleven bytes, one header byte and up to ten
+// varint bytes. We flush the buffer when there is not enough room left.
+//
+//----------------------------------------------------------------------------------------
+void T64TraceWriter::record( T64TraceKind kind, T64Word adr, int len, bool uncached ) {
+
+    if ( traceFile == nullptr ) return;
+
+    if ( bufPos > T64_TRACE_BUF_SIZE - 16 ) flushBuffer( );
+
+    int      kIndex = kind & 0x7;
+    uint64_t delta  = zigzagEncode((int64_t)((uint64_t) adr - 
+                                             (uint64_t) lastAdr[ kIndex ] ));
+
+    lastAdr[ kIndex ] = adr;
+
+    buf[ bufPos++ ] = (uint8_t)( kIndex |
+                                 (( uncached ) ? 0x8 : 0 ) |
+                                 ( sizeToLog2( len ) << 4 ));
+
+    while ( delta >= 0x80 ) {
+
+        buf[ bufPos++ ] = (uint8_t)( delta | 0x80 );
+        delta >>= 7;
+    }
+
+    buf[ bufPos++ ] = (uint8_t) delta;
+    recordCount ++;
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Trace reader
+//
+//----------------------------------------------------------------------------------------
+// Object constructor and destructor.
+//
+//----------------------------------------------------------------------------------------
+T64TraceReader::T64TraceReader( ) {
+
+    for ( int i = 0; i < T64_TRACE_MAX_KINDS; i++ ) lastAdr[ i ] = 0;
+}
+
+T64TraceReader::~T64TraceReader( ) {
+
+    close( );
+}
+
+//----------------------------------------------------------------------------------------
+// Open a trace file. We check the header magic word and version.
+//
+//----------------------------------------------------------------------------------------
+bool T64TraceReader::open( const char *fileName ) {
+
+    uint8_t hdr[ T64_TRACE_HEADER_SIZE ];
+    uint8_t expected[ T64_TRACE_HEADER_SIZE ];
+
+    close( );
+
+    traceFile = fopen( fileName, "rb" );
+    if ( traceFile == nullptr ) return( false );
+
+    buildHeader( expected );
+    if (( fread( hdr, 1, sizeof( hdr ), traceFile ) != sizeof( hdr )) ||
+        ( memcmp( hdr, expected, 12 ) != 0 )) {
+
+        fclose( traceFile );
+        traceFile = nullptr;
+        return( false );
+    }
+
+    rewind( );
+    return( true );
+}
+
+void T64TraceReader::close( ) {
+
+    if ( traceFile != nullptr ) {
+
+        fclose( traceFile );
+        traceFile = nullptr;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Position the reader to the first record.
+//
+//----------------------------------------------------------------------------------------
+void T64TraceReader::rewind( ) {
+
+    if ( traceFile != nullptr ) fseek( traceFile, T64_TRACE_HEADER_SIZE, SEEK_SET );
+
+    for ( int i = 0; i < T64_TRACE_MAX_KINDS; i++ ) lastAdr[ i ] = 0;
+    bufPos = 0;
+    bufLen = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// Get the next byte from the buffer, refill when empty. A negative value indicates
+// the end of the file.
+//
+//----------------------------------------------------------------------------------------
+int T64TraceReader::getByte( ) {
+
+    if ( bufPos >= bufLen ) {
+
+        if ( traceFile == nullptr ) return( -1 );
+
+        bufLen = (int) fread( buf, 1, sizeof( buf ), traceFile );
+        bufPos = 0;
+        if ( bufLen <= 0 ) return( -1 );
+    }
+
+    return( buf[ bufPos++ ] );
+}
+
+//----------------------------------------------------------------------------------------
+// Read and decode the next record. We return false at the end of the trace or when
+// the last record is truncated.
+//
+//----------------------------------------------------------------------------------------
+bool T64TraceReader::next( T64TraceRecord *rec ) {
+
+    int hdr = getByte( );
+    if ( hdr < 0 ) return( false );
+
+    uint64_t delta = 0;
+    int      shift = 0;
+    int      ch    = 0;
+
+    do {
+
+        ch = getByte( );
+        if (( ch < 0 ) || ( shift > 63 )) return( false );
+
+        delta |= (uint64_t)( ch & 0x7F ) << shift;
+        shift += 7;
+
+    } while ( ch & 0x80 );
+
+    int kIndex = hdr & 0x7;
+
+    lastAdr[ kIndex ] = (T64Word)((uint64_t) lastAdr[ kIndex ] + 
+                                  (uint64_t) zigzagDecode( delta ));
+
+    rec -> kind     = (T64TraceKind) kIndex;
+    rec -> uncached = ( hdr & 0x8 ) != 0;
+    rec -> len      = 1 << (( hdr >> 4 ) & 0x7 );
+    rec -> adr      = lastAdr[ kIndex ];
+    return( true );
+}
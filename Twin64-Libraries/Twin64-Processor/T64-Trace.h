@@ -0,0 +1,138 @@
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Cache and TLB trace
+//
+//----------------------------------------------------------------------------------------
+// The cache and TLB trace records the stream of accesses hitting the cache read and
+// write methods and the TLB lookup method. The trace is written to a compact binary
+// file, which can be replayed offline against many cache and TLB configurations
+// without running the guest program again.
+//
+// The trace file starts with a small header followed by the records. Each record
+// has a header byte and a variable length address delta:
+//
+//      bits 0 .. 2  -> record kind
+//      bit  3       -> uncached access
+//      bits 4 .. 6  -> log2 of the access size in bytes
+//      bit  7       -> reserved
+//
+// The address is stored as the difference to the previous address of the same
+// record kind, zigzag encoded and written as a little endian base-128 varint.
+// Sequential accesses will thus typically need two or three bytes per record.
+//
+//----------------------------------------------------------------------------------------
+//
+// T64 - A 64-bit Processor - Cache and TLB trace
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You
+// should have received a copy of the GNU General Public License along with this
+// program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include "T64-Common.h"
+#include "T64-Util.h"
+
+//----------------------------------------------------------------------------------------
+// Trace file constants. The buffer size is the unit in which records are written
+// to and read from the file.
+//
+//----------------------------------------------------------------------------------------
+const char      T64_TRACE_MAGIC[ ]      = "T64TRACE";
+const uint32_t  T64_TRACE_VERSION       = 1;
+const int       T64_TRACE_HEADER_SIZE   = 16;
+const int       T64_TRACE_BUF_SIZE      = 64 * 1024;
+const int       T64_TRACE_MAX_KINDS     = 8;
+
+//----------------------------------------------------------------------------------------
+// Trace record kinds. There is a kind for each cache and TLB access path.
+//
+//----------------------------------------------------------------------------------------
+enum T64TraceKind : uint8_t {
+
+    T64_TRK_NIL             = 0,
+    T64_TRK_I_CACHE_READ    = 1,
+    T64_TRK_I_CACHE_WRITE   = 2,
+    T64_TRK_D_CACHE_READ    = 3,
+    T64_TRK_D_CACHE_WRITE   = 4,
+    T64_TRK_I_TLB_LOOKUP    = 5,
+    T64_TRK_D_TLB_LOOKUP    = 6
+};
+
+//----------------------------------------------------------------------------------------
+// A decoded trace record.
+//
+//----------------------------------------------------------------------------------------
+struct T64TraceRecord {
+
+    T64TraceKind    kind        = T64_TRK_NIL;
+    bool            uncached    = false;
+    int             len         = 0;
+    T64Word         adr         = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// The trace writer. The cache and TLB objects hold a reference to a trace writer.
+// When the reference is set, each access is recorded. Records are collected in a
+// buffer, which is written to the file when full or when the trace is closed.
+//
+//----------------------------------------------------------------------------------------
+struct T64TraceWriter {
+
+    public:
+
+    T64TraceWriter( );
+    ~ T64TraceWriter( );
+
+    bool            open( const char *fileName );
+    void            close( );
+    bool            isOpen( );
+
+    void            record( T64TraceKind kind, T64Word adr, int len, bool uncached );
+    T64Word         getRecordCount( );
+
+    private:
+
+    void            flushBuffer( );
+
+    FILE            *traceFile      = nullptr;
+    int             bufPos          = 0;
+    T64Word         recordCount     = 0;
+    T64Word         lastAdr[ T64_TRACE_MAX_KINDS ];
+    uint8_t         buf[ T64_TRACE_BUF_SIZE ];
+};
+
+//----------------------------------------------------------------------------------------
+// The trace reader. Used by the replay tools to read a trace record by record.
+//
+//----------------------------------------------------------------------------------------
+struct T64TraceReader {
+
+    public:
+
+    T64TraceReader( );
+    ~ T64TraceReader( );
+
+    bool            open( const char *fileName );
+    void            close( );
+    void            rewind( );
+    bool            next( T64TraceRecord *rec );
+
+    private:
+
+    int             getByte( );
+
+    FILE            *traceFile      = nullptr;
+    int             bufPos          = 0;
+    int             bufLen          = 0;
+    T64Word         lastAdr[ T64_TRACE_MAX_KINDS ];
+    uint8_t         buf[ T64_TRACE_BUF_SIZE ];
+};
@@ -0,0 +1,678 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System - Record and replay
+//
+//----------------------------------------------------------------------------------------
+// The state buffer and the recorder and replay object. See the header file for the
+// log layout and how a replay works.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System - Record and replay
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Replay.h"
+
+//----------------------------------------------------------------------------------------
+// Name space for local routines.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const T64Word NO_SYNC_CYCLE = INT64_MAX;
+
+//----------------------------------------------------------------------------------------
+// Pushed inputs are delivered between cycles, all other inputs are pulled by a module
+// during a cycle.
+//
+//----------------------------------------------------------------------------------------
+bool isPushKind( T64ReplayKind kind ) {
+
+    return ( kind == T64_RPK_CONSOLE_IN );
+}
+
+//----------------------------------------------------------------------------------------
+// Grow a buffer to hold at least "len" bytes. The size doubles, so that appending
+// is cheap on average.
+//
+//----------------------------------------------------------------------------------------
+bool growBuffer( uint8_t **buf, T64Word *bufSize, T64Word len ) {
+
+    if ( len <= *bufSize ) return ( true );
+
+    T64Word newSize = ( *bufSize > 0 ) ? *bufSize : 4096;
+    while ( newSize < len ) newSize *= 2;
+
+    uint8_t *newBuf = (uint8_t *) realloc( *buf, newSize );
+    if ( newBuf == nullptr ) return ( false );
+
+    *buf     = newBuf;
+    *bufSize = newSize;
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Log file header. The version and the start cycle are written little endian, byte
+// by byte.
+//
+//----------------------------------------------------------------------------------------
+void buildHeader( uint8_t *hdr, T64Word startCycle ) {
+
+    memset( hdr, 0, T64_REPLAY_HEADER_SIZE );
+    memcpy( hdr, T64_REPLAY_MAGIC, 8 );
+
+    for ( int i = 0; i < 4; i++ ) hdr[ 8 + i ]  = ( T64_REPLAY_VERSION >> ( i * 8 )) & 0xFF;
+    for ( int i = 0; i < 8; i++ ) hdr[ 16 + i ] = ((uint64_t) startCycle >> ( i * 8 )) & 0xFF;
+}
+
+bool checkHeader( uint8_t *hdr, T64Word *startCycle ) {
+
+    uint32_t version = 0;
+    uint64_t cycle   = 0;
+
+    if ( memcmp( hdr, T64_REPLAY_MAGIC, 8 ) != 0 ) return ( false );
+
+    for ( int i = 0; i < 4; i++ ) version |= (uint32_t) hdr[ 8 + i ] << ( i * 8 );
+    for ( int i = 0; i < 8; i++ ) cycle   |= (uint64_t) hdr[ 16 + i ] << ( i * 8 );
+
+    *startCycle = (T64Word) cycle;
+    return ( version == T64_REPLAY_VERSION );
+}
+
+} // namespace
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// State buffer
+//
+//----------------------------------------------------------------------------------------
+// Object constructor and destructor.
+//
+//----------------------------------------------------------------------------------------
+T64StateBuf::T64StateBuf( ) { }
+
+T64StateBuf::~T64StateBuf( ) {
+
+    if ( buf != nullptr ) free( buf );
+}
+
+//----------------------------------------------------------------------------------------
+// "clear" empties the buffer for saving a new state, "rewind" starts reading the
+// saved state from the beginning. The allocated memory is kept for the next state.
+//
+//----------------------------------------------------------------------------------------
+void T64StateBuf::clear( ) {
+
+    bufLen = 0;
+    bufPos = 0;
+}
+
+void T64StateBuf::rewind( ) {
+
+    bufPos = 0;
+}
+
+T64Word T64StateBuf::getSize( ) {
+
+    return ( bufLen );
+}
+
+//----------------------------------------------------------------------------------------
+// Append data to the buffer and read it back. Reading past the end of the saved
+// state delivers zeroes and returns false.
+//
+//----------------------------------------------------------------------------------------
+void T64StateBuf::put( const void *data, T64Word len ) {
+
+    if ( ! growBuffer( &buf, &bufSize, bufLen + len )) return;
+
+    memcpy( buf + bufLen, data, len );
+    bufLen += len;
+}
+
+bool T64StateBuf::get( void *data, T64Word len ) {
+
+    if ( bufPos + len > bufLen ) {
+
+        memset( data, 0, len );
+        bufPos = bufLen;
+        return ( false );
+    }
+
+    memcpy( data, buf + bufPos, len );
+    bufPos += len;
+    return ( true );
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Record and replay
+//
+//----------------------------------------------------------------------------------------
+// Object constructor and destructor. The object registers itself with the system.
+//
+//----------------------------------------------------------------------------------------
+T64Replay::T64Replay( T64System *sys ) {
+
+    this -> sys = sys;
+    sys -> setReplay( this );
+}
+
+T64Replay::~T64Replay( ) {
+
+    if ( sys -> getReplay( ) == this ) sys -> setReplay( nullptr );
+
+    clearSnapshots( );
+    if ( logBuf != nullptr ) free( logBuf );
+}
+
+//----------------------------------------------------------------------------------------
+// Start a recording. The log starts empty at the current cycle and the first
+// snapshot is taken right away.
+//
+//----------------------------------------------------------------------------------------
+bool T64Replay::startRecording( T64Word snapInterval ) {
+
+    stop( );
+
+    startCycle      = sys -> getCycleCount( );
+    lastCycle       = startCycle;
+    logLen          = 0;
+    logPos          = 0;
+    recordCount     = 0;
+    diverged        = false;
+    next.valid      = false;
+
+    this -> snapInterval = ( snapInterval > 0 ) ? snapInterval : T64_REPLAY_DEF_SNAP_INTERVAL;
+
+    mode = T64_RPM_RECORD;
+    takeSnapshot( startCycle );
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Start a replay of the log. The system must be in the state in which the recording
+// was started, at least it has to be at the same cycle. Snapshots are taken as in a
+// recording, so a replay can also be reverse stepped.
+//
+//----------------------------------------------------------------------------------------
+bool T64Replay::startReplay( T64Word snapInterval ) {
+
+    stop( );
+
+    if ( sys -> getCycleCount( ) != startCycle ) return ( false );
+
+    lastCycle       = startCycle;
+    logPos          = 0;
+    diverged        = false;
+
+    this -> snapInterval = ( snapInterval > 0 ) ? snapInterval : T64_REPLAY_DEF_SNAP_INTERVAL;
+
+    mode = T64_RPM_REPLAY;
+    takeSnapshot( startCycle );
+    decodeNext( );
+
+    if ( ! next.valid ) mode = T64_RPM_RECORD;
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Stop recording or replaying. The log is kept, so it can still be saved. The
+// snapshots are released.
+//
+//----------------------------------------------------------------------------------------
+void T64Replay::stop( ) {
+
+    mode = T64_RPM_OFF;
+    clearSnapshots( );
+}
+
+//----------------------------------------------------------------------------------------
+// Save the log to a file and load it from a file. A loaded log replaces the current
+// log, the record count is found by walking the records.
+//
+//----------------------------------------------------------------------------------------
+bool T64Replay::saveLog( const char *fileName ) {
+
+    uint8_t hdr[ T64_REPLAY_HEADER_SIZE ];
+    FILE    *logFile = fopen( fileName, "wb" );
+
+    if ( logFile == nullptr ) return ( false );
+
+    buildHeader( hdr, startCycle );
+
+    bool ok = ( fwrite( hdr, 1, sizeof( hdr ), logFile ) == sizeof( hdr ));
+    if (( ok ) && ( logLen > 0 )) ok = ( fwrite( logBuf, 1, logLen, logFile ) == (size_t) logLen );
+
+    fclose( logFile );
+    return ( ok );
+}
+
+bool T64Replay::loadLog( const char *fileName ) {
+
+    uint8_t hdr[ T64_REPLAY_HEADER_SIZE ];
+    FILE    *logFile = fopen( fileName, "rb" );
+
+    if ( logFile == nullptr ) return ( false );
+
+    stop( );
+
+    bool ok = ( fread( hdr, 1, sizeof( hdr ), logFile ) == sizeof( hdr )) &&
+              ( checkHeader( hdr, &startCycle ));
+
+    logLen = 0;
+
+    while ( ok ) {
+
+        if ( ! growBuffer( &logBuf, &logSize, logLen + 4096 )) ok = false;
+        else {
+
+            size_t n = fread( logBuf + logLen, 1, logSize - logLen, logFile );
+            if ( n == 0 ) break;
+            logLen += n;
+        }
+    }
+
+    fclose( logFile );
+
+    if ( ! ok ) {
+
+        logLen = 0;
+        return ( false );
+    }
+
+    recordCount = 0;
+    lastCycle   = startCycle;
+    logPos      = 0;
+
+    for ( decodeNext( ); next.valid; recordCount++ ) {
+
+        logPos    = next.endPos;
+        lastCycle = next.cycle;
+        decodeNext( );
+    }
+
+    return ( logPos == logLen );
+}
+
+//----------------------------------------------------------------------------------------
+// Getters. The diverged status stays set until it is cleared or a new recording or
+// replay is started, so the simulator can report it once.
+//
+//----------------------------------------------------------------------------------------
+T64ReplayMode T64Replay::getMode( ) {
+
+    return ( mode );
+}
+
+bool T64Replay::isDiverged( ) {
+
+    return ( diverged );
+}
+
+void T64Replay::clearDiverged( ) {
+
+    diverged = false;
+}
+
+T64Word T64Replay::getDivergeCycle( ) {
+
+    return ( divergeCycle );
+}
+
+T64Word T64Replay::getStartCycle( ) {
+
+    return ( startCycle );
+}
+
+T64Word T64Replay::getRecordCount( ) {
+
+    return ( recordCount );
+}
+
+T64Word T64Replay::getLogSize( ) {
+
+    return ( logLen );
+}
+
+int T64Replay::getSnapshotCount( ) {
+
+    return ( snapCount );
+}
+
+T64Word T64Replay::getFirstSnapshotCycle( ) {
+
+    return (( snapCount > 0 ) ? snaps[ 0 ].cycle : 0 );
+}
+
+//----------------------------------------------------------------------------------------
+// Log encoding. The log buffer grows as needed. When it cannot grow any further, the
+// recording stops, since a log with missing inputs is of no use.
+//
+//----------------------------------------------------------------------------------------
+void T64Replay::putByte( uint8_t val ) {
+
+    if ( ! growBuffer( &logBuf, &logSize, logLen + 1 )) {
+
+        mode = T64_RPM_OFF;
+        return;
+    }
+
+    logBuf[ logLen++ ] = val;
+}
+
+void T64Replay::putVarint( uint64_t val ) {
+
+    while ( val >= 0x80 ) {
+
+        putByte((uint8_t)( val | 0x80 ));
+        val >>= 7;
+    }
+
+    putByte((uint8_t) val );
+}
+
+bool T64Replay::getVarint( T64Word *pos, uint64_t *val ) {
+
+    int shift = 0;
+
+    *val = 0;
+
+    while (( *pos < logLen ) && ( shift < 64 )) {
+
+        uint8_t b = logBuf[ ( *pos )++ ];
+
+        *val |= (uint64_t)( b & 0x7F ) << shift;
+        if (( b & 0x80 ) == 0 ) return ( true );
+        shift += 7;
+    }
+
+    return ( false );
+}
+
+//----------------------------------------------------------------------------------------
+// Record an input. The record is added at the end of the log, the log position stays
+// at the end while recording.
+//
+//----------------------------------------------------------------------------------------
+void T64Replay::record( int modNum, T64ReplayKind kind, const uint8_t *data, int len ) {
+
+    if ( mode != T64_RPM_RECORD ) return;
+
+    T64Word cycle = sys -> getCycleCount( );
+
+    putVarint((uint64_t)( cycle - lastCycle ));
+    putByte((uint8_t) modNum );
+    putByte((uint8_t) kind );
+    putVarint((uint64_t) len );
+
+    if ( len > 0 ) {
+
+        if ( growBuffer( &logBuf, &logSize, logLen + len )) {
+
+            memcpy( logBuf + logLen, data, len );
+            logLen += len;
+        }
+        else mode = T64_RPM_OFF;
+    }
+
+    lastCycle = cycle;
+    logPos    = logLen;
+    recordCount ++;
+}
+
+//----------------------------------------------------------------------------------------
+// Decode the next record at the log position. A record that does not fit into the log
+// ends the log.
+//
+//----------------------------------------------------------------------------------------
+void T64Replay::decodeNext( ) {
+
+    T64Word     pos = logPos;
+    uint64_t    delta;
+    uint64_t    len;
+
+    next.valid = false;
+
+    if ( ! getVarint( &pos, &delta )) return;
+    if ( pos + 2 > logLen ) return;
+
+    next.modNum = logBuf[ pos++ ];
+    next.kind   = (T64ReplayKind) logBuf[ pos++ ];
+
+    if ( ! getVarint( &pos, &len )) return;
+    if ( len > (uint64_t) ( logLen - pos )) return;
+
+    next.cycle      = lastCycle + (T64Word) delta;
+    next.len        = (int) len;
+    next.dataPos    = pos;
+    next.endPos     = pos + (T64Word) len;
+    next.valid      = true;
+}
+
+//----------------------------------------------------------------------------------------
+// Move past the next record. At the end of the log, the replay is over and recording
+// continues from here. The snapshots taken so far stay valid.
+//
+//----------------------------------------------------------------------------------------
+void T64Replay::consumeNext( ) {
+
+    logPos    = next.endPos;
+    lastCycle = next.cycle;
+    decodeNext( );
+
+    if ( ! next.valid ) {
+
+        logPos = logLen;
+        mode   = T64_RPM_RECORD;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The run no longer follows the log. We stop the replay and ask the system to stop,
+// so that the user can look at the state.
+//
+//----------------------------------------------------------------------------------------
+void T64Replay::diverge( T64Word cycle ) {
+
+    stop( );
+
+    diverged     = true;
+    divergeCycle = cycle;
+    sys -> requestStop( );
+}
+
+//----------------------------------------------------------------------------------------
+// Replay a pulled input. The next record must be for this module and input kind, and
+// it must be due in this cycle. The recorded data is copied when the length matches,
+// a recorded length of zero means that the host input failed in the recording.
+//
+//----------------------------------------------------------------------------------------
+bool T64Replay::replay( int modNum, T64ReplayKind kind, uint8_t *data, int len ) {
+
+    if ( mode != T64_RPM_REPLAY ) return ( false );
+
+    T64Word cycle = sys -> getCycleCount( );
+
+    if (( ! next.valid ) ||
+        ( next.cycle  != cycle  ) ||
+        ( next.modNum != modNum ) ||
+        ( next.kind   != kind   ) ||
+        (( next.len   != len    ) && ( next.len != 0 ))) {
+
+        diverge( cycle );
+        return ( false );
+    }
+
+    bool ok = ( next.len == len );
+    if ( ok ) memcpy( data, logBuf + next.dataPos, len );
+
+    consumeNext( );
+    return ( ok );
+}
+
+//----------------------------------------------------------------------------------------
+// The system calls "sync" between cycles. In a replay, the pushed inputs due in this
+// cycle are delivered to their modules. A record still pending for an earlier cycle
+// means that the run no longer follows the log. Next, a snapshot is taken when one
+// is due. Snapshots that exist already from an earlier pass are kept. We return the
+// next cycle at which we need to be called. For a pulled input, this is the cycle
+// after the one in which it is due.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64Replay::sync( T64Word cycle ) {
+
+    if ( mode == T64_RPM_REPLAY ) {
+
+        while (( mode == T64_RPM_REPLAY ) &&
+               ( next.valid ) &&
+               ( isPushKind( next.kind )) &&
+               ( next.cycle == cycle )) {
+
+            T64Module *mPtr = sys -> lookupByModNum( next.modNum );
+            if ( mPtr != nullptr ) mPtr -> replayInput( next.kind, logBuf + next.dataPos, next.len );
+
+            consumeNext( );
+        }
+
+        if (( mode == T64_RPM_REPLAY ) && ( next.valid ) && ( next.cycle < cycle )) {
+
+            diverge( cycle );
+            return ( NO_SYNC_CYCLE );
+        }
+    }
+
+    if (( mode == T64_RPM_OFF ) || ( snapCount == 0 )) return ( NO_SYNC_CYCLE );
+
+    T64Word syncCycle = snaps[ snapCount - 1 ].cycle + snapInterval;
+
+    if ( cycle >= syncCycle ) {
+
+        takeSnapshot( cycle );
+        syncCycle = snaps[ snapCount - 1 ].cycle + snapInterval;
+    }
+
+    if (( mode == T64_RPM_REPLAY ) && ( next.valid )) {
+
+        T64Word recCycle = ( isPushKind( next.kind )) ? next.cycle : next.cycle + 1;
+        if ( recCycle < syncCycle ) syncCycle = recCycle;
+    }
+
+    return ( syncCycle );
+}
+
+//----------------------------------------------------------------------------------------
+// Take a snapshot. When the table is full, it is thinned out first. The state buffers
+// are reused.
+//
+//----------------------------------------------------------------------------------------
+void T64Replay::takeSnapshot( T64Word cycle ) {
+
+    if ( snapCount == T64_REPLAY_MAX_SNAPSHOTS ) thinSnapshots( );
+
+    T64Snapshot *snap = &snaps[ snapCount ];
+
+    if ( snap -> state == nullptr ) snap -> state = new T64StateBuf( );
+
+    snap -> state -> clear( );
+    sys -> saveState( snap -> state );
+
+    snap -> cycle       = cycle;
+    snap -> logPos      = logPos;
+    snap -> lastCycle   = lastCycle;
+    snapCount ++;
+}
+
+//----------------------------------------------------------------------------------------
+// Thin out the snapshots. Every second snapshot is dropped, the first one is always
+// kept. The remaining snapshots are twice the interval apart, which becomes the new
+// interval. The buffers of the dropped snapshots move to the free end of the table.
+//
+//----------------------------------------------------------------------------------------
+void T64Replay::thinSnapshots( ) {
+
+    int n = 0;
+
+    for ( int i = 0; i < snapCount; i += 2 ) {
+
+        T64Snapshot tmp = snaps[ n ];
+
+        snaps[ n ] = snaps[ i ];
+        snaps[ i ] = tmp;
+        n ++;
+    }
+
+    snapCount    = n;
+    snapInterval = snapInterval * 2;
+}
+
+//----------------------------------------------------------------------------------------
+// Release the snapshot memory.
+//
+//----------------------------------------------------------------------------------------
+void T64Replay::clearSnapshots( ) {
+
+    for ( int i = 0; i < T64_REPLAY_MAX_SNAPSHOTS; i++ ) {
+
+        delete snaps[ i ].state;
+        snaps[ i ].state = nullptr;
+    }
+
+    snapCount = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// Go to a cycle. For an earlier cycle, the last snapshot at or before the cycle is
+// restored and the log position is set back to where it was at the snapshot. Then
+// the system runs forward to the cycle, replaying the log. We return false when
+// there is no snapshot for the cycle, the system no longer matches the snapshot, or
+// when the replay diverged on the way.
+//
+//----------------------------------------------------------------------------------------
+bool T64Replay::gotoCycle( T64Word cycle ) {
+
+    if (( mode == T64_RPM_OFF ) || ( snapCount == 0 ) || ( cycle < snaps[ 0 ].cycle ))
+        return ( false );
+
+    if ( cycle < sys -> getCycleCount( )) {
+
+        int k = snapCount - 1;
+        while (( k > 0 ) && ( snaps[ k ].cycle > cycle )) k--;
+
+        if ( ! sys -> restoreState( snaps[ k ].state )) return ( false );
+
+        mode      = T64_RPM_REPLAY;
+        logPos    = snaps[ k ].logPos;
+        lastCycle = snaps[ k ].lastCycle;
+        decodeNext( );
+
+        if ( ! next.valid ) {
+
+            logPos = logLen;
+            mode   = T64_RPM_RECORD;
+        }
+    }
+
+    while (( sys -> getCycleCount( ) < cycle ) && ( ! diverged )) {
+
+        T64Word steps = cycle - sys -> getCycleCount( );
+        if ( steps > INT32_MAX ) steps = INT32_MAX;
+
+        sys -> step((int) steps );
+    }
+
+    return ( ! diverged );
+}
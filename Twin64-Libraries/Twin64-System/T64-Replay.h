@@ -0,0 +1,209 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System - Record and replay
+//
+//----------------------------------------------------------------------------------------
+// The system steps all processors in a fixed order in one host thread, so the bus
+// arbitration between processors and the completion of I/O commands, which are
+// scheduled events, do not vary from run to run. A run only depends on the inputs
+// from the host. These are the characters typed at the console, the wall clock
+// register of the timer and the data read from a disk image. The recorder logs these
+// inputs with the cycle in which they arrived. A replay starts from the same system
+// state and feeds the logged inputs instead of the host inputs, the run is then
+// repeated exactly. The replay only takes action at the cycles of the logged inputs
+// and runs at full speed in between.
+//
+// There are two kinds of inputs. A pushed input, such as a typed character, is given
+// to a module between two cycles. The replay delivers it to the module when the
+// system reaches the cycle. A pulled input, such as a clock register read, is asked
+// for by a module during a cycle. The replay returns the logged value instead. When
+// the module asks for a different input, or the logged input is not consumed in its
+// cycle, the replay has diverged. It is then stopped and the system is asked to stop.
+//
+// The log is a byte buffer, each record is:
+//
+//      varint  -> cycle delta to the previous record
+//      byte    -> module number
+//      byte    -> input kind
+//      varint  -> data length
+//      bytes   -> data
+//
+// The varints are little endian base-128 numbers. The log file has a header with
+// a magic string, the version and the cycle at which recording started, followed
+// by the log bytes.
+//
+// During recording and replay, the system state is saved every "snapInterval"
+// cycles. Reverse stepping restores the last snapshot before the target cycle and
+// replays the log from there. When the snapshot table is full, every second
+// snapshot is dropped and the interval doubles, so the snapshots always cover the
+// whole run. A replay, also the one after a reverse step, turns into a recording when
+// it reaches the end of the log. The inputs from then on are added to the log. 
+// Changes made to the system state by the simulator user are not inputs and are not
+// recorded.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - System - Record and replay
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#pragma once
+
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-System.h"
+
+//----------------------------------------------------------------------------------------
+// Record and replay constants.
+//
+//----------------------------------------------------------------------------------------
+const char      T64_REPLAY_MAGIC[ ]             = "T64RPLOG";
+const uint32_t  T64_REPLAY_VERSION              = 1;
+const int       T64_REPLAY_HEADER_SIZE          = 24;
+const int       T64_REPLAY_MAX_SNAPSHOTS        = 16;
+const T64Word   T64_REPLAY_DEF_SNAP_INTERVAL    = 1000000;
+
+//----------------------------------------------------------------------------------------
+// Record and replay modes.
+//
+//----------------------------------------------------------------------------------------
+enum T64ReplayMode : int {
+
+    T64_RPM_OFF         = 0,
+    T64_RPM_RECORD      = 1,
+    T64_RPM_REPLAY      = 2
+};
+
+//----------------------------------------------------------------------------------------
+// The state buffer. A module saves its state by appending its fields to the buffer
+// and restores it by reading them back in the same order. The buffer grows as
+// needed.
+//
+//----------------------------------------------------------------------------------------
+struct T64StateBuf {
+
+    public:
+
+    T64StateBuf( );
+    ~ T64StateBuf( );
+
+    void            clear( );
+    void            rewind( );
+    T64Word         getSize( );
+
+    void            put( const void *data, T64Word len );
+    bool            get( void *data, T64Word len );
+
+    private:
+
+    uint8_t         *buf        = nullptr;
+    T64Word         bufSize     = 0;
+    T64Word         bufLen      = 0;
+    T64Word         bufPos      = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// A snapshot is the system state at a cycle, along with the log position.
+//
+//----------------------------------------------------------------------------------------
+struct T64Snapshot {
+
+    T64Word         cycle       = 0;
+    T64Word         logPos      = 0;
+    T64Word         lastCycle   = 0;
+    T64StateBuf     *state      = nullptr;
+};
+
+//----------------------------------------------------------------------------------------
+// The next record in the log, decoded by the replay.
+//
+//----------------------------------------------------------------------------------------
+struct T64ReplayRecord {
+
+    bool            valid       = false;
+    T64Word         cycle       = 0;
+    int             modNum      = 0;
+    T64ReplayKind   kind        = T64_RPK_NIL;
+    int             len         = 0;
+    T64Word         dataPos     = 0;
+    T64Word         endPos      = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// The recorder and replay object. The system holds a reference to it and calls the
+// "sync" routine between cycles. "sync" delivers the pushed inputs that are due,
+// takes a snapshot when one is due and returns the next cycle at which it needs
+// to be called again.
+//
+//----------------------------------------------------------------------------------------
+struct T64Replay {
+
+    public:
+
+    T64Replay( T64System *sys );
+    ~ T64Replay( );
+
+    bool            startRecording( T64Word snapInterval = T64_REPLAY_DEF_SNAP_INTERVAL );
+    bool            startReplay( T64Word snapInterval = T64_REPLAY_DEF_SNAP_INTERVAL );
+    void            stop( );
+
+    bool            saveLog( const char *fileName );
+    bool            loadLog( const char *fileName );
+
+    bool            gotoCycle( T64Word cycle );
+
+    T64ReplayMode   getMode( );
+    bool            isDiverged( );
+    void            clearDiverged( );
+    T64Word         getDivergeCycle( );
+    T64Word         getStartCycle( );
+    T64Word         getRecordCount( );
+    T64Word         getLogSize( );
+    int             getSnapshotCount( );
+    T64Word         getFirstSnapshotCycle( );
+
+    T64Word         sync( T64Word cycle );
+    void            record( int modNum, T64ReplayKind kind, const uint8_t *data, int len );
+    bool            replay( int modNum, T64ReplayKind kind, uint8_t *data, int len );
+
+    private:
+
+    void            putByte( uint8_t val );
+    void            putVarint( uint64_t val );
+    bool            getVarint( T64Word *pos, uint64_t *val );
+    void            decodeNext( );
+    void            consumeNext( );
+    void            diverge( T64Word cycle );
+
+    void            takeSnapshot( T64Word cycle );
+    void            thinSnapshots( );
+    void            clearSnapshots( );
+
+    T64System       *sys            = nullptr;
+    T64ReplayMode   mode            = T64_RPM_OFF;
+    bool            diverged        = false;
+    T64Word         divergeCycle    = 0;
+
+    uint8_t         *logBuf         = nullptr;
+    T64Word         logSize         = 0;
+    T64Word         logLen          = 0;
+    T64Word         logPos          = 0;
+    T64Word         lastCycle       = 0;
+    T64Word         startCycle      = 0;
+    T64Word         recordCount     = 0;
+    T64ReplayRecord next;
+
+    T64Snapshot     snaps[ T64_REPLAY_MAX_SNAPSHOTS ];
+    int             snapCount       = 0;
+    T64Word         snapInterval    = T64_REPLAY_DEF_SNAP_INTERVAL;
+};
@@ -24,6 +24,7 @@
 //
 //----------------------------------------------------------------------------------------
 #include "T64-System.h"
+#include "T64-Replay.h"
 
 //----------------------------------------------------------------------------------------
 // Name space for local routines.
@@ -77,6 +78,54 @@ bool overlap( T64Module *a, T64Module *b ) {
     return ( ovlSpa || ovlHpa );
 }
 
+//----------------------------------------------------------------------------------------
+// The event queue is a binary heap, ordered by deadline and for equal deadlines by 
+// the sequence number. The next event due is always the first entry. "siftUp" and
+// "siftDown" restore the heap order after an entry was added or replaced.
+//
+//----------------------------------------------------------------------------------------
+bool isBefore( const T64Event *a, const T64Event *b ) {
+
+    if ( a -> deadline != b -> deadline ) return ( a -> deadline < b -> deadline );
+    else                                  return ( a -> seqNum < b -> seqNum );
+}
+
+void siftUp( T64Event *events, int index ) {
+
+    T64Event evt = events[ index ];
+
+    while ( index > 0 ) {
+
+        int parent = ( index - 1 ) / 2;
+
+        if ( ! isBefore( &evt, &events[ parent ] )) break;
+
+        events[ index ] = events[ parent ];
+        index           = parent;
+    }
+
+    events[ index ] = evt;
+}
+
+void siftDown( T64Event *events, int count, int index ) {
+
+    T64Event evt = events[ index ];
+
+    while ( true ) {
+
+        int child = ( 2 * index ) + 1;
+
+        if ( child >= count ) break;
+        if (( child + 1 < count ) && ( isBefore( &events[ child + 1 ], &events[ child ] ))) child++;
+        if ( ! isBefore( &events[ child ], &evt )) break;
+
+        events[ index ] = events[ child ];
+        index           = child;
+    }
+
+    events[ index ] = evt;
+}
+
 };
 
 //----------------------------------------------------------------------------------------
@@ -96,6 +145,22 @@ void T64System::initModuleMap( ) {
     }
 
     moduleMapHwm = 0;
+    clockMapHwm  = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// The clock map lists the modules which are called on every system step, in module
+// map order. It is rebuilt whenever the module map changes.
+//
+//----------------------------------------------------------------------------------------
+void T64System::buildClockMap( ) {
+
+    clockMapHwm = 0;
+
+    for ( int i = 0; i < moduleMapHwm; i++ ) {
+
+        if ( moduleMap[ i ] -> isClocked( )) clockMap[ clockMapHwm++ ] = moduleMap[ i ];
+    }
 }
 
 //----------------------------------------------------------------------------------------
@@ -117,7 +182,7 @@ int T64System::getSystemState( ) {
 int T64System::addToModuleMap( T64Module *module ) {
 
     if (( module -> getModuleNum( ) < 0 ) || 
-        ( module -> getModuleNum( ) > MAX_MOD_MAP_ENTRIES )) return ( -1 );
+        ( module -> getModuleNum( ) >= MAX_MOD_MAP_ENTRIES )) return ( -1 );
 
     for ( int i = 0; i < moduleMapHwm; ++i ) {
 
@@ -133,6 +198,7 @@ int T64System::addToModuleMap( T64Module *module ) {
     moduleMap[ pos ] = module;
     moduleMapHwm ++;
 
+    buildClockMap( );
     return ( 0 );
 }
 
@@ -163,6 +229,8 @@ int T64System::removeFromModuleMap( T64Module *module ) {
 
     moduleMapHwm--;
 
+    buildClockMap( );
+    cancelModuleEvents( module );
     return ( 0 );
 }
 
@@ -218,11 +286,17 @@ T64ModuleType T64System::getModuleType( int modNum ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Reset the system. We just invoke the module handler for each registered module.
+// Reset the system. The simulated time starts again at zero and all pending events
+// are removed. We then invoke the module handler for each registered module, which
+// may schedule its first events.
 //
 //----------------------------------------------------------------------------------------
 void T64System::reset( ) {
 
+    eventCount  = 0;
+    cycleCount  = 0;
+    runLimit    = 0;
+
     for ( int i = 0; i < moduleMapHwm; i++ ) {
 
         if ( moduleMap[ i ] != nullptr ) moduleMap[ i ] -> reset( ); 
@@ -240,15 +314,330 @@ void T64System::run( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Single step. 
+// Step the system. Each step is one cycle, in which every clocked module does one 
+// unit of work. For a processor module this is the execution of one instruction. 
+// Modules that are not clocked are not called at all. Instead of checking for due
+// events on every cycle, we run the clocked modules in bulk up to the deadline of
+// the next event, handle the due events and continue. An event scheduled during
+// the bulk run, for example by a processor storing to a device register, shortens
+// the run limit when it is due earlier. A stop request ends the stepping after the
+// current cycle. A replay object is called after the due events, it also shortens 
+// the run limit to the next cycle it needs to see.
 //
 //----------------------------------------------------------------------------------------
 void T64System::step( int steps ) {
 
+    T64Word stepLimit = cycleCount + steps;
+
+    stopRequested = false;
+
+    while (( cycleCount < stepLimit ) && ( ! stopRequested )) {
+
+        dispatchEvents( );
+        if ( stopRequested ) break;
+
+        runLimit = stepLimit;
+
+        if (( eventCount > 0 ) && ( events[ 0 ].deadline < runLimit )) {
+
+            runLimit = events[ 0 ].deadline;
+        }
+
+        if ( replay != nullptr ) {
+
+            T64Word syncCycle = replay -> sync( cycleCount );
+
+            if ( stopRequested ) break;
+            if ( syncCycle < runLimit ) runLimit = syncCycle;
+        }
+
+        if ( clockMapHwm == 0 ) {
+
+            cycleCount = runLimit;
+        }
+        else if ( clockMapHwm == 1 ) {
+
+            T64Module *mPtr = clockMap[ 0 ];
+
+            while ( cycleCount < runLimit ) {
+                
+                mPtr -> step( );
+                cycleCount++;
+            }
+        }
+        else {
+
+            while ( cycleCount < runLimit ) {
+
+                for ( int i = 0; i < clockMapHwm; i++ ) clockMap[ i ] -> step( );
+                cycleCount++;
+            }
+        }
+    }
+
+    dispatchEvents( );
+}
+
+//----------------------------------------------------------------------------------------
+// Stop request. A module, for example a processor hitting a breakpoint, asks to stop
+// the stepping. The cycle in progress is completed, all clocked modules are called
+// for it. The request stays visible until the next call to step.
+//
+//----------------------------------------------------------------------------------------
+void T64System::requestStop( ) {
+
+    stopRequested   = true;
+    runLimit        = cycleCount + 1;
+}
+
+bool T64System::isStopRequested( ) {
+
+    return( stopRequested );
+}
+
+//----------------------------------------------------------------------------------------
+// Record and replay. The modules pass their host inputs through these routines. When
+// recording, the input is added to the log. When replaying, a pulled input is taken
+// from the log and the host input is not used. "inputWord" is the short form for a
+// word sized pulled input.
+//
+//----------------------------------------------------------------------------------------
+void T64System::setReplay( T64Replay *replay ) {
+
+    this -> replay = replay;
+}
+
+T64Replay *T64System::getReplay( ) {
+
+    return ( replay );
+}
+
+bool T64System::isReplaying( ) {
+
+    return (( replay != nullptr ) && ( replay -> getMode( ) == T64_RPM_REPLAY ));
+}
+
+void T64System::recordData( int modNum, T64ReplayKind kind, const uint8_t *data, int len ) {
+
+    if (( replay != nullptr ) && ( replay -> getMode( ) == T64_RPM_RECORD )) {
+
+        replay -> record( modNum, kind, data, len );
+    }
+}
+
+bool T64System::replayData( int modNum, T64ReplayKind kind, uint8_t *data, int len ) {
+
+    if ( ! isReplaying( )) return ( false );
+    return ( replay -> replay( modNum, kind, data, len ));
+}
+
+T64Word T64System::inputWord( int modNum, T64ReplayKind kind, T64Word hostVal ) {
+
+    if ( replay == nullptr ) return ( hostVal );
+
+    T64Word val = hostVal;
+
+    if ( replay -> getMode( ) == T64_RPM_REPLAY ) {
+
+        if ( ! replay -> replay( modNum, kind, (uint8_t *) &val, sizeof( val ))) val = hostVal;
+    }
+    else recordData( modNum, kind, (uint8_t *) &val, sizeof( val ));
+
+    return ( val );
+}
+
+//----------------------------------------------------------------------------------------
+// Save and restore the system state. The state starts with the module list, so that
+// a restore can check that the system still has the same modules before changing 
+// anything. Then follow the simulated time, the event queue and the module states in
+// module map order. An event refers to its module by module number. 
+//
+//----------------------------------------------------------------------------------------
+void T64System::saveState( T64StateBuf *buf ) {
+
+    buf -> put( &moduleMapHwm, sizeof( moduleMapHwm ));
+
     for ( int i = 0; i < moduleMapHwm; i++ ) {
 
-        if ( moduleMap[ i ] != nullptr ) moduleMap[ i ] -> step( ); 
+        int             modNum  = moduleMap[ i ] -> getModuleNum( );
+        T64ModuleType   modType = moduleMap[ i ] -> getModuleType( );
+
+        buf -> put( &modNum, sizeof( modNum ));
+        buf -> put( &modType, sizeof( modType ));
+    }
+
+    buf -> put( &cycleCount, sizeof( cycleCount ));
+    buf -> put( &eventSeqNum, sizeof( eventSeqNum ));
+    buf -> put( &eventCount, sizeof( eventCount ));
+
+    for ( int i = 0; i < eventCount; i++ ) {
+
+        int modNum = events[ i ].module -> getModuleNum( );
+
+        buf -> put( &events[ i ].deadline, sizeof( events[ i ].deadline ));
+        buf -> put( &events[ i ].seqNum, sizeof( events[ i ].seqNum ));
+        buf -> put( &modNum, sizeof( modNum ));
+        buf -> put( &events[ i ].eventId, sizeof( events[ i ].eventId ));
     }
+
+    for ( int i = 0; i < moduleMapHwm; i++ ) moduleMap[ i ] -> saveState( buf );
+}
+
+bool T64System::restoreState( T64StateBuf *buf ) {
+
+    int hwm = 0;
+
+    buf -> rewind( );
+    buf -> get( &hwm, sizeof( hwm ));
+    if ( hwm != moduleMapHwm ) return ( false );
+
+    for ( int i = 0; i < moduleMapHwm; i++ ) {
+
+        int             modNum  = 0;
+        T64ModuleType   modType = MT_NIL;
+
+        buf -> get( &modNum, sizeof( modNum ));
+        buf -> get( &modType, sizeof( modType ));
+
+        if (( modNum  != moduleMap[ i ] -> getModuleNum( )) ||
+            ( modType != moduleMap[ i ] -> getModuleType( ))) return ( false );
+    }
+
+    buf -> get( &cycleCount, sizeof( cycleCount ));
+    buf -> get( &eventSeqNum, sizeof( eventSeqNum ));
+    buf -> get( &eventCount, sizeof( eventCount ));
+
+    for ( int i = 0; i < eventCount; i++ ) {
+
+        int modNum = 0;
+
+        buf -> get( &events[ i ].deadline, sizeof( events[ i ].deadline ));
+        buf -> get( &events[ i ].seqNum, sizeof( events[ i ].seqNum ));
+        buf -> get( &modNum, sizeof( modNum ));
+        buf -> get( &events[ i ].eventId, sizeof( events[ i ].eventId ));
+
+        events[ i ].module = lookupByModNum( modNum );
+    }
+
+    for ( int i = 0; i < moduleMapHwm; i++ ) moduleMap[ i ] -> restoreState( buf );
+
+    runLimit        = cycleCount;
+    stopRequested   = false;
+    return ( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Handle all events that are due. An event handler may schedule further events, also
+// for the current cycle. They are handled in the same call.
+//
+//----------------------------------------------------------------------------------------
+void T64System::dispatchEvents( ) {
+
+    while (( eventCount > 0 ) && ( events[ 0 ].deadline <= cycleCount )) {
+
+        T64Event evt = events[ 0 ];
+
+        removeEvent( 0 );
+        evt.module -> handleEvent( evt.eventId );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Schedule an event for a module. The event is due "delay" cycles from now. A delay
+// of zero is due before the next instruction executes. We return the event handle, 
+// or -1 if the event queue is full.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64System::scheduleEvent( T64Module *module, T64Word delay, int eventId ) {
+
+    if (( module == nullptr ) || ( eventCount >= MAX_EVENTS )) return ( -1 );
+    if ( delay < 0 ) delay = 0;
+
+    T64Event *evt   = &events[ eventCount ];
+    T64Word  handle = eventSeqNum++;
+
+    evt -> deadline = cycleCount + delay;
+    evt -> seqNum   = handle;
+    evt -> module   = module;
+    evt -> eventId  = eventId;
+
+    if ( evt -> deadline < runLimit ) runLimit = evt -> deadline;
+
+    siftUp( events, eventCount++ );
+    return ( handle );
+}
+
+//----------------------------------------------------------------------------------------
+// Remove an event from the queue. The last entry takes the place of the removed one
+// and is moved up or down to restore the heap order.
+//
+//----------------------------------------------------------------------------------------
+void T64System::removeEvent( int index ) {
+
+    eventCount --;
+    if ( index == eventCount ) return;
+
+    events[ index ] = events[ eventCount ];
+
+    if (( index > 0 ) && ( isBefore( &events[ index ], &events[ ( index - 1 ) / 2 ] ))) 
+        siftUp( events, index );
+    else 
+        siftDown( events, eventCount, index );
+}
+
+//----------------------------------------------------------------------------------------
+// Cancel an event by its handle. We return false if the event is not pending, i.e. 
+// it was already handled or cancelled.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::cancelEvent( T64Word handle ) {
+
+    for ( int i = 0; i < eventCount; i++ ) {
+
+        if ( events[ i ].seqNum == handle ) {
+
+            removeEvent( i );
+            return ( true );
+        }
+    }
+
+    return ( false );
+}
+
+//----------------------------------------------------------------------------------------
+// Cancel all events of a module. Used when a module is removed from the system. We
+// compact the queue in place, keeping the events of all other modules, and then 
+// rebuild the heap order bottom up. Removing entries one by one while scanning would
+// miss an entry that the removal moves to an index already passed.
+//
+//----------------------------------------------------------------------------------------
+void T64System::cancelModuleEvents( T64Module *module ) {
+
+    int count = 0;
+
+    for ( int i = 0; i < eventCount; i++ ) {
+
+        if ( events[ i ].module != module ) events[ count++ ] = events[ i ];
+    }
+
+    eventCount = count;
+
+    for ( int i = ( eventCount / 2 ) - 1; i >= 0; i-- ) siftDown( events, eventCount, i );
+}
+
+//----------------------------------------------------------------------------------------
+// Simulated time access functions. Without a pending event, the next event cycle is
+// the largest possible cycle count.
+//
+//----------------------------------------------------------------------------------------
+T64Word T64System::getCycleCount( ) {
+
+    return ( cycleCount );
+}
+
+T64Word T64System::getNextEventCycle( ) {
+
+    return (( eventCount > 0 ) ? events[ 0 ].deadline : INT64_MAX );
 }
 
 //----------------------------------------------------------------------------------------
@@ -267,7 +656,7 @@ bool T64System::busOpReadUncached( int     reqModNum,
                                  int        len ) {
 
     T64Module *mPtr = lookupByAdr( pAdr );
-    if ( mPtr != nullptr ) return ( false );
+    if ( mPtr == nullptr ) return ( false );
  
     for ( int i = 0; i < moduleMapHwm; i++ ) {
 
@@ -361,6 +750,55 @@ bool T64System::busOpWriteBlock( int     reqModNum,
     return ( mPtr -> busOpWriteBlock( reqModNum, pAdr, data, len ));
 }
 
+//----------------------------------------------------------------------------------------
+// DMA bus operations. An I/O module reads or writes a block of memory data with one
+// request instead of word by word. The block must be covered by one module. As with
+// the other bus operations, all other modules are informed first, so that processors
+// can write back or remove any cached copies of the block.
+//
+//----------------------------------------------------------------------------------------
+bool T64System::busOpDmaRead( int     reqModNum,
+                              T64Word pAdr, 
+                              uint8_t *data, 
+                              T64Word len ) {
+
+    T64Module *mPtr = lookupByAdr( pAdr );
+    if (( mPtr == nullptr ) || ( len <= 0 )) return ( false );
+    if ( lookupByAdr( pAdr + len - 1 ) != mPtr ) return ( false );
+
+    for ( int i = 0; i < moduleMapHwm; i++ ) {
+
+        if (( moduleMap[ i ] -> getModuleNum( ) != reqModNum ) && 
+            ( moduleMap[ i ] -> getModuleNum( ) != mPtr -> getModuleNum( ))) {
+
+             moduleMap[ i ] -> busOpDmaRead( reqModNum, pAdr, data, len );
+        }
+    }
+
+    return ( mPtr -> busOpDmaRead( reqModNum, pAdr, data, len ));
+}
+
+bool T64System::busOpDmaWrite( int     reqModNum,
+                               T64Word pAdr, 
+                               uint8_t *data, 
+                               T64Word len ) {
+
+    T64Module *mPtr = lookupByAdr( pAdr );
+    if (( mPtr == nullptr ) || ( len <= 0 )) return ( false );
+    if ( lookupByAdr( pAdr + len - 1 ) != mPtr ) return ( false );
+
+    for ( int i = 0; i < moduleMapHwm; i++ ) {
+
+        if (( moduleMap[ i ] -> getModuleNum( ) != reqModNum ) && 
+            ( moduleMap[ i ] -> getModuleNum( ) != mPtr -> getModuleNum( ))) {
+
+             moduleMap[ i ] -> busOpDmaWrite( reqModNum, pAdr, data, len );
+        }
+    }
+
+    return ( mPtr -> busOpDmaWrite( reqModNum, pAdr, data, len ));
+}
+
 //----------------------------------------------------------------------------------------
 // "readMem" and "writeMem" are routines for the simulator commands and windows to
 // access physical memory. We will need to find the handling module and the perform
@@ -399,7 +837,7 @@ bool T64System::writeMem( T64Word pAdr, uint8_t *data, int len ) {
 T64Module::T64Module( T64ModuleType    modType, 
                       int              modNum,
                       T64Word          spaAdr,
-                      int              spaLen ) {
+                      T64Word          spaLen ) {
 
     this -> moduleTyp   = modType;
     this -> moduleNum   = modNum;
@@ -415,6 +853,43 @@ int T64Module::getModuleNum( ) {
     return ( moduleNum );
 }
 
+//----------------------------------------------------------------------------------------
+// A module is by default not clocked and ignores events. Modules which need to do 
+// work on every step or on scheduled events override these routines.
+//
+//----------------------------------------------------------------------------------------
+bool T64Module::isClocked( ) {
+
+    return ( false );
+}
+
+void T64Module::handleEvent( int eventId ) { }
+
+//----------------------------------------------------------------------------------------
+// A module by default has no state to save and takes no pushed host inputs.
+//
+//----------------------------------------------------------------------------------------
+void T64Module::saveState( T64StateBuf *buf ) { }
+
+void T64Module::restoreState( T64StateBuf *buf ) { }
+
+void T64Module::replayInput( T64ReplayKind kind, uint8_t *data, int len ) { }
+
+//----------------------------------------------------------------------------------------
+// A module by default does not take part in DMA transfers. As an observer it has 
+// nothing to do, as a target it refuses the request.
+//
+//----------------------------------------------------------------------------------------
+bool T64Module::busOpDmaRead( int srcModNum, T64Word pAdr, uint8_t *data, T64Word len ) {
+
+    return ( false );
+}
+
+bool T64Module::busOpDmaWrite( int srcModNum, T64Word pAdr, uint8_t *data, T64Word len ) {
+
+    return ( false );
+}
+
 T64ModuleType T64Module::getModuleType( ) {
 
     return ( moduleTyp );
@@ -451,7 +926,7 @@ T64Word T64Module::getSpaAdr( )  {
     return ( spaAdr );
 }
 
-int T64Module::getSpaLen( )  {
+T64Word T64Module::getSpaLen( )  {
 
     return ( spaLen );
 }
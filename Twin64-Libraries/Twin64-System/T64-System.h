@@ -30,11 +30,6 @@
 #include "T64-Common.h"
 #include "T64-Util.h"
 
-// ??? on a step, all processor modules advance.
-// ??? after that each module is give a change to do processing. I.e. check for
-// a key pressed, etc.
-// ??? we also need to handle interrupts too...
-
 //----------------------------------------------------------------------------------------
 // The architecture defines 64 module on the system bus so far. Typically the number
 // of imaginary boards is much smaller. However, a board could have several modules on
@@ -44,6 +39,35 @@
 const int MAX_MODULES           = 16;
 const int MAX_MOD_MAP_ENTRIES   = MAX_MODULES;
 
+//----------------------------------------------------------------------------------------
+// The system keeps the simulated time as a cycle count. One system step is one cycle,
+// in which each processor executes one instruction. Modules that need to do work at
+// a later point in time schedule an event for a cycle instead of checking on every
+// step. The pending events are kept in a fixed size queue.
+//
+//----------------------------------------------------------------------------------------
+const int MAX_EVENTS            = 64;
+
+//----------------------------------------------------------------------------------------
+// Forwards. The record and replay declarations are in "T64-Replay.h".
+//
+//----------------------------------------------------------------------------------------
+struct T64StateBuf;
+struct T64Replay;
+
+//----------------------------------------------------------------------------------------
+// The inputs from the host, which a recording logs. Console input is pushed to a
+// module, the other inputs are pulled by a module during a cycle.
+//
+//----------------------------------------------------------------------------------------
+enum T64ReplayKind : uint8_t {
+
+    T64_RPK_NIL             = 0,
+    T64_RPK_CONSOLE_IN      = 1,
+    T64_RPK_WALL_CLOCK      = 2,
+    T64_RPK_DISK_READ       = 3
+};
+
 //----------------------------------------------------------------------------------------
 // Modules have a type, submodules a subtype.
 //
@@ -72,6 +96,9 @@ enum T64ModuleType {
 // 6 - module hardware version 
 // 7 - module software version
 // 8 - interrupt target ( when sending an interrupt -> processor + mask )
+//
+// A module sends an external interrupt with an uncached write of the interrupt 
+// mask to the interrupt request register of the target processor HPA.
 
 // ?? the HPA also has a the IODC, a piece that describes the IO Module and 
 // code to execute module specific functions.
@@ -89,7 +116,19 @@ enum T64ModuleType {
 
 // ??? need to rework this. A module "sees" both OP and EVT. As OP target, it reacts.
 // ??? as EVT it optionally reacts if it needs to.
-// ??? EVT routines should be virtual, and we have a dummy in the module object.
+//
+// Only clocked modules, such as a processor, are called on every system step. All
+// other modules do their work in the event handler, called when a scheduled event
+// is due. The default handlers do nothing.
+//
+// The DMA bus operations move a block of data between an I/O module and memory in 
+// one operation. The data is a byte stream in memory order. Only memory modules 
+// carry out a DMA request, all other modules just observe it.
+//
+// For the record and replay snapshots, a module saves its state to a state buffer
+// and restores it. Host settings, such as an attached file, are not part of the
+// state. A module that takes pushed host inputs gets them back in a replay through
+// the replay input handler.
 
 //----------------------------------------------------------------------------------------
 struct T64Module {
@@ -99,10 +138,16 @@ struct T64Module {
     T64Module( T64ModuleType    modType, 
                int              modNum,
                T64Word          spaAdr,
-               int              spaLen  );
+               T64Word          spaLen  );
 
     virtual void    reset( ) = 0;
     virtual void    step( ) = 0;
+    virtual bool    isClocked( );
+    virtual void    handleEvent( int eventId );
+
+    virtual void    saveState( T64StateBuf *buf );
+    virtual void    restoreState( T64StateBuf *buf );
+    virtual void    replayInput( T64ReplayKind kind, uint8_t *data, int len );
 
     virtual bool    busOpReadUncached( int     srcModNum,
                                        T64Word pAdr, 
@@ -129,13 +174,23 @@ struct T64Module {
                                 uint8_t *data, 
                                 int len ) = 0;
 
+    virtual bool    busOpDmaRead( int     srcModNum,
+                                  T64Word pAdr, 
+                                  uint8_t *data, 
+                                  T64Word len );
+
+    virtual bool    busOpDmaWrite( int     srcModNum,
+                                   T64Word pAdr, 
+                                   uint8_t *data, 
+                                   T64Word len );
+
     T64ModuleType   getModuleType( );
     int             getModuleNum( );
     const char      *getModuleTypeName( );
     T64Word         getHpaAdr( );
     int             getHpaLen( );
     T64Word         getSpaAdr( );
-    int             getSpaLen( );
+    T64Word         getSpaLen( );
 
     protected: 
 
@@ -144,7 +199,7 @@ struct T64Module {
     T64Word         hpaAdr      = 0;
     int             hpaLen      = 0;
     T64Word         spaAdr      = 0;
-    int             spaLen      = 0;
+    T64Word         spaLen      = 0;
     T64Word         spaLimit    = 0;
 };
 
@@ -158,11 +213,29 @@ struct T64ModuleMapEntry {
     T64Module *module = nullptr;
 };
 
+//----------------------------------------------------------------------------------------
+// A scheduled event. The event is due when the system cycle count reaches the 
+// deadline. Events with the same deadline are handled in the order they were
+// scheduled, the sequence number is also the handle to cancel an event.
+//
+//----------------------------------------------------------------------------------------
+struct T64Event {
+
+    T64Word     deadline    = 0;
+    T64Word     seqNum      = 0;
+    T64Module   *module     = nullptr;
+    int         eventId     = 0;
+};
+
 //----------------------------------------------------------------------------------------
 // A T64 system is a bus where you plug in modules. A module represents an entity such
 // as a processor, a memory module, an I/O module and so on. At program start we create
 // the module objects and add them to the systemMap and moduleMap. 
 //
+// With a replay object set, the modules pass their host inputs through the system,
+// which records them or returns the recorded inputs in a replay. Without a replay 
+// object, the host input is just passed back.
+//
 //----------------------------------------------------------------------------------------
 struct T64System {
 
@@ -183,6 +256,28 @@ struct T64System {
     void                run( );
     void                step( int steps = 1 );
 
+    T64Word             getCycleCount( );
+    T64Word             getNextEventCycle( );
+    T64Word             scheduleEvent( T64Module *module, T64Word delay, int eventId );
+    bool                cancelEvent( T64Word handle );
+    void                cancelModuleEvents( T64Module *module );
+
+    void                requestStop( );
+    bool                isStopRequested( );
+
+    void                setReplay( T64Replay *replay );
+    T64Replay           *getReplay( );
+    bool                isReplaying( );
+    void                recordData( int             modNum, 
+                                    T64ReplayKind   kind, 
+                                    const uint8_t   *data, 
+                                    int             len );
+    bool                replayData( int modNum, T64ReplayKind kind, uint8_t *data, int len );
+    T64Word             inputWord( int modNum, T64ReplayKind kind, T64Word hostVal );
+
+    void                saveState( T64StateBuf *buf );
+    bool                restoreState( T64StateBuf *buf );
+
     bool                busOpReadUncached( int     reqModNum,
                                            T64Word pAdr, 
                                            uint8_t *data, 
@@ -208,6 +303,15 @@ struct T64System {
                                          uint8_t *data, 
                                          int     len );
 
+    bool                busOpDmaRead( int     reqModNum,
+                                      T64Word pAdr, 
+                                      uint8_t *data, 
+                                      T64Word len );
+
+    bool                busOpDmaWrite( int     reqModNum,
+                                       T64Word pAdr, 
+                                       uint8_t *data, 
+                                       T64Word len );
     
     bool                readMem( T64Word pAdr, uint8_t *data, int len );
     bool                writeMem( T64Word pAdr, uint8_t *data, int len );
@@ -215,6 +319,9 @@ struct T64System {
     private:
 
     void                initModuleMap( );
+    void                buildClockMap( );
+    void                dispatchEvents( );
+    void                removeEvent( int index );
 
     int                 addToSystemMap( T64Module  *module,
                                         T64Word    start,
@@ -222,6 +329,18 @@ struct T64System {
                                    
     T64Module           *moduleMap[ MAX_MOD_MAP_ENTRIES ];
     int                 moduleMapHwm = 0;
+
+    T64Module           *clockMap[ MAX_MOD_MAP_ENTRIES ];
+    int                 clockMapHwm = 0;
+
+    T64Event            events[ MAX_EVENTS ];
+    int                 eventCount  = 0;
+    T64Word             eventSeqNum = 0;
+    T64Word             cycleCount  = 0;
+    T64Word             runLimit    = 0;
+    bool                stopRequested = false;
+
+    T64Replay           *replay     = nullptr;
 };
 
 #endif
\ No newline at end of file
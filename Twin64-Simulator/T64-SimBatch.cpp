@@ -0,0 +1,368 @@
+//----------------------------------------------------------------------------------------
+//
+//  Twin64Sim - A 64-bit CPU Simulator - Batch mode
+//
+//----------------------------------------------------------------------------------------
+// The batch mode runs the simulator without the window display. The system is built
+// as usual, an ELF file is loaded and all processors start at the ELF entry address.
+// The system is then stepped until all processors halted, a processor trapped or the
+// step limit is reached. A processor is considered halted when it branches to itself.
+// Traps are not vectored yet, so a trapping processor does not move either and is
+// detected by its trap count instead. There is no terminal interaction at all, so that many batch runs can be started in parallel
+// without a TTY. The results and statistics are written to the output file or to
+// standard output. The batch mode is invoked as follows:
+//
+//  Twin64-Simulator --batch --elffile=<file> [ --outfile=<file> ] [ --maxsteps=<num> ]
+//
+// The program exit code is zero when all processors halted, one for an error, two
+// when the step limit was reached and three when a processor trapped.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin64Sim - A 64-bit CPU Simulator - Batch mode
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You should
+//  have received a copy of the GNU General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-SimDeclarations.h"
+
+#include <chrono>
+
+//----------------------------------------------------------------------------------------
+// Local name space.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// Batch mode constants. The system is stepped in chunks. After each chunk, we do one
+// more step to check whether all processors branch to themselves.
+//
+//----------------------------------------------------------------------------------------
+const T64Word   BATCH_DEF_MAX_STEPS     = 1000000000;
+const int       BATCH_STEP_CHUNK        = 4096;
+
+const int       BATCH_EXIT_HALTED       = 0;
+const int       BATCH_EXIT_ERROR        = 1;
+const int       BATCH_EXIT_STEP_LIMIT   = 2;
+const int       BATCH_EXIT_TRAPPED      = 3;
+
+//----------------------------------------------------------------------------------------
+// Print the statistics of one cache or TLB.
+//
+//----------------------------------------------------------------------------------------
+void printCacheStats( FILE *out, const char *name, T64Cache *c ) {
+
+    fprintf( out, "  %-8s requests: %lld, hits: %lld, misses: %lld\n",
+             name,
+             (long long) c -> getRequestCount( ),
+             (long long) c -> getHitCount( ),
+             (long long) c -> getMissCount( ));
+}
+
+void printTlbStats( FILE *out, const char *name, T64Tlb *t ) {
+
+    fprintf( out, "  %-8s requests: %lld, hits: %lld, misses: %lld\n",
+             name,
+             (long long) t -> getRequestCount( ),
+             (long long) t -> getHitCount( ),
+             (long long) t -> getMissCount( ));
+}
+
+//----------------------------------------------------------------------------------------
+// Print the batch run results. For each processor we list the PSR, the general
+// registers, the cache and TLB statistics, the LDR / STC reservation counts and the
+// trap count along with the last trap taken.
+//
+//----------------------------------------------------------------------------------------
+void printResults( FILE         *out,
+                   SimGlobals   *glb,
+                   T64Processor **procs,
+                   int          numProcs,
+                   const char   *result,
+                   T64Word      steps,
+                   double       wallTimeSec ) {
+
+    T64Word instr = steps * numProcs;
+    double  mips  = ( wallTimeSec > 0.0 ) ? ( instr / wallTimeSec / 1.0e6 ) : 0.0;
+
+    fprintf( out, "Twin64 Simulator Version %s, PatchLevel %d, batch run\n",
+             SIM_VERSION, SIM_PATCH_LEVEL );
+    fprintf( out, "ELF file:     %s\n", glb -> elfFileName );
+    fprintf( out, "Result:       %s\n", result );
+    fprintf( out, "Steps:        %lld\n", (long long) steps );
+    fprintf( out, "Instructions: %lld\n", (long long) instr );
+    fprintf( out, "Wall time:    %.3f s\n", wallTimeSec );
+    fprintf( out, "MIPS:         %.2f\n", mips );
+
+    for ( int i = 0; i < numProcs; i++ ) {
+
+        T64Cpu *cpu = procs[ i ] -> getCpuPtr( );
+
+        fprintf( out, "Processor %d:\n", procs[ i ] -> getModuleNum( ));
+        fprintf( out, "  PSR: 0x%016llx\n", (unsigned long long) cpu -> getPsrReg( ));
+
+        for ( int r = 0; r < T64_MAX_GREGS; r++ ) {
+
+            fprintf( out, "  R%-2d: 0x%016llx",
+                     r, (unsigned long long) cpu -> getGeneralReg( r ));
+
+            if (( r % 4 ) == 3 ) fprintf( out, "\n" );
+        }
+
+        printCacheStats( out, "I-Cache:", procs[ i ] -> getICachePtr( ));
+        printCacheStats( out, "D-Cache:", procs[ i ] -> getDCachePtr( ));
+        printTlbStats( out, "I-TLB:", procs[ i ] -> getITlbPtr( ));
+        printTlbStats( out, "D-TLB:", procs[ i ] -> getDTlbPtr( ));
+
+        fprintf( out, "  LDR/STC  reservations: %lld, STC success: %lld, STC fail: %lld\n",
+                 (long long) cpu -> getResvCount( ),
+                 (long long) cpu -> getStcSuccessCount( ),
+                 (long long) cpu -> getStcFailCount( ));
+
+        fprintf( out, "  Traps:   %lld, last trap: %d at 0x%016llx\n",
+                 (long long) cpu -> getTrapCount( ),
+                 (int) cpu -> getLastTrapCode( ),
+                 (unsigned long long) cpu -> getLastTrapAdr( ));
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Check whether a processor trapped. The CPU does not vector traps yet, it counts
+// them and leaves the PSR unchanged.
+//
+//----------------------------------------------------------------------------------------
+bool anyProcessorTrapped( T64Processor **procs, int numProcs ) {
+
+    for ( int i = 0; i < numProcs; i++ ) {
+
+        if ( procs[ i ] -> getCpuPtr( ) -> getTrapCount( ) > 0 ) return( true );
+    }
+
+    return( false );
+}
+
+//----------------------------------------------------------------------------------------
+// Drain the console UART output. A UART with an output file writes to its file, all
+// others write to the standard output. The characters are written in blocks.
+//
+//----------------------------------------------------------------------------------------
+void drainUartOutput( T64Uart **uarts, int numUarts ) {
+
+    char buf[ T64_UART_DRAIN_SIZE ];
+    int  len;
+
+    for ( int i = 0; i < numUarts; i++ ) {
+
+        if ( uarts[ i ] -> hasOutputFile( )) uarts[ i ] -> flushOutput( );
+        else {
+
+            while (( len = uarts[ i ] -> drainTx( buf, sizeof( buf ))) > 0 ) {
+
+                fwrite( buf, 1, len, stdout );
+            }
+        }
+    }
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------------------
+// Collect the processor modules and the console UART modules of the system. These
+// routines are also used by the RUN command.
+//
+//----------------------------------------------------------------------------------------
+int getProcessorModules( T64System *sys, T64Processor **procs ) {
+
+    int numProcs = 0;
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        T64Module *mPtr = sys -> lookupByModNum( i );
+
+        if (( mPtr != nullptr ) && ( mPtr -> getModuleType( ) == MT_PROC )) {
+
+            procs[ numProcs++ ] = (T64Processor *) mPtr;
+        }
+    }
+
+    return( numProcs );
+}
+
+int getUartModules( T64System *sys, T64Uart **uarts ) {
+
+    int numUarts = 0;
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        T64Module *mPtr = sys -> lookupByModNum( i );
+
+        if (( mPtr != nullptr ) && 
+            ( mPtr -> getModuleType( ) == MT_IO ) &&
+            ((( T64IoModule *) mPtr ) -> getIoType( ) == T64_IO_UART )) {
+
+            uarts[ numUarts++ ] = (T64Uart *) mPtr;
+        }
+    }
+
+    return( numUarts );
+}
+
+//----------------------------------------------------------------------------------------
+// Check whether all processors halted. We remember the instruction addresses, do one
+// step and compare. A processor branching to itself is halted. A processor stopped at
+// a breakpoint did not move, but is not halted.
+//
+//----------------------------------------------------------------------------------------
+bool allProcessorsHalted( T64System *sys, T64Processor **procs, int numProcs ) {
+
+    T64Word ia[ MAX_MOD_MAP_ENTRIES ];
+
+    for ( int i = 0; i < numProcs; i++ ) {
+
+        ia[ i ] = procs[ i ] -> getCpuPtr( ) -> getPsrReg( );
+    }
+
+    sys -> step( 1 );
+    if ( sys -> isStopRequested( )) return( false );
+
+    for ( int i = 0; i < numProcs; i++ ) {
+
+        if ( procs[ i ] -> getCpuPtr( ) -> getPsrReg( ) != ia[ i ] ) return( false );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// The batch runner. We load the ELF file, set the entry address for all processors
+// and run the system until all processors halted, a processor trapped or the step
+// limit is reached. The trap check comes first, since a trapping processor does not
+// move and would otherwise look halted. Only the stepping is timed. The console
+// output is drained after each chunk.
+//
+//----------------------------------------------------------------------------------------
+int runBatch( SimGlobals *glb ) {
+
+    T64Processor    *procs[ MAX_MOD_MAP_ENTRIES ];
+    T64Uart         *uarts[ MAX_MOD_MAP_ENTRIES ];
+    int             numProcs    = getProcessorModules( glb -> system, procs );
+    int             numUarts    = getUartModules( glb -> system, uarts );
+    T64Word         maxSteps    = ( glb -> batchMaxSteps > 0 ) ?
+                                    glb -> batchMaxSteps : BATCH_DEF_MAX_STEPS;
+    T64Word         steps       = 0;
+    T64Word         entry       = 0;
+    bool            halted      = false;
+    bool            trapped     = false;
+    FILE            *out        = stdout;
+
+    if ( glb -> elfFileName[ 0 ] == '\0' ) {
+
+        fprintf( stderr, "Error: --batch requires an ELF file\n" );
+        return( BATCH_EXIT_ERROR );
+    }
+
+    if ( numProcs == 0 ) {
+
+        fprintf( stderr, "Error: no processor configured\n" );
+        return( BATCH_EXIT_ERROR );
+    }
+
+    try {
+
+        entry = loadElfFileIntoMemory( glb -> system, glb -> elfFileName, nullptr );
+    }
+    catch ( SimErrMsgId errNum ) {
+
+        fprintf( stderr, "ELF file load error: %d\n", errNum );
+        return( BATCH_EXIT_ERROR );
+    }
+
+    if ( glb -> outFileName[ 0 ] != '\0' ) {
+
+        out = fopen( glb -> outFileName, "w" );
+        if ( out == nullptr ) {
+
+            fprintf( stderr, "Error: cannot open output file: \"%s\"\n",
+                     glb -> outFileName );
+            return( BATCH_EXIT_ERROR );
+        }
+    }
+
+    for ( int i = 0; i < numProcs; i++ ) {
+
+        procs[ i ] -> getCpuPtr( ) -> setPsrReg(( 1ULL << 61 ) | entry );
+    }
+
+    auto start = std::chrono::steady_clock::now( );
+
+    while ( steps < maxSteps ) {
+
+        T64Word chunk = BATCH_STEP_CHUNK;
+        if ( chunk > maxSteps - steps ) chunk = maxSteps - steps;
+
+        glb -> system -> step((int) chunk );
+        steps += chunk;
+
+        if ( numUarts > 0 ) drainUartOutput( uarts, numUarts );
+
+        if ( anyProcessorTrapped( procs, numProcs )) {
+
+            trapped = true;
+            break;
+        }
+
+        if ( steps >= maxSteps ) break;
+
+        steps ++;
+        halted = allProcessorsHalted( glb -> system, procs, numProcs );
+
+        if ( anyProcessorTrapped( procs, numProcs )) {
+
+            halted  = false;
+            trapped = true;
+            break;
+        }
+
+        if ( halted ) break;
+    }
+
+    auto stop = std::chrono::steady_clock::now( );
+
+    if ( numUarts > 0 ) {
+
+        drainUartOutput( uarts, numUarts );
+        fflush( stdout );
+    }
+
+    const char      *result     = "STEP LIMIT";
+    int             exitCode    = BATCH_EXIT_STEP_LIMIT;
+
+    if ( trapped ) {
+
+        result   = "TRAPPED";
+        exitCode = BATCH_EXIT_TRAPPED;
+    }
+    else if ( halted ) {
+
+        result   = "HALTED";
+        exitCode = BATCH_EXIT_HALTED;
+    }
+
+    printResults( out, glb, procs, numProcs,
+                  result,
+                  steps,
+                  std::chrono::duration<double>( stop - start ).count( ));
+
+    if ( out != stdout ) fclose( out );
+    return( exitCode );
+}
@@ -0,0 +1,552 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin64Sim - A 64-bit CPU Simulator - Compiled command files
+//
+//----------------------------------------------------------------------------------------
+// Command files are executed with the XF command. Test drivers tend to run the same
+// command files many times with tens of thousands of commands. Instead of reading,
+// scanning and looking up each line every time, a command file is compiled once into
+// a list of operations. Each source line becomes one operation. A command line keeps
+// its command Id and the list of argument tokens. Control lines become jumps. The
+// compiled files are kept in a small cache. The cache key is a hash of the file
+// content, so that an edited file is compiled again.
+//
+//  IF <expr>       -> JUMP_FALSE   after ELSE or ENDIF
+//  ELSE            -> JUMP         after ENDIF
+//  ENDIF           -> NOP
+//  WHILE <expr>    -> JUMP_FALSE   after ENDWHILE
+//  ENDWHILE        -> JUMP         to WHILE
+//  LOOP <expr>     -> LOOP         after ENDLOOP if the count is not positive
+//  ENDLOOP         -> END_LOOP     after LOOP while the count is not exhausted
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin64Sim - A 64-bit CPU Simulator - Compiled command files
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE.  See the GNU General Public License for more details. You
+// should have received a copy of the GNU General Public License along with this
+// program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-SimDeclarations.h"
+#include "T64-SimTables.h"
+
+//----------------------------------------------------------------------------------------
+// Local namespace. These routines are not visible outside this source file.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+//----------------------------------------------------------------------------------------
+// The maximum number of tokens in a line. A token is at least one character, so a
+// command line cannot have more.
+//
+//----------------------------------------------------------------------------------------
+const int MAX_LINE_TOKENS       = MAX_CMD_LINE_SIZE;
+const int INIT_TOK_LIST_SIZE    = 1024;
+const int INIT_STR_POOL_SIZE    = 1024;
+
+//----------------------------------------------------------------------------------------
+// The open control statements during compilation.
+//
+//----------------------------------------------------------------------------------------
+struct CtrlStackEntry {
+
+    SimTokId    cmdId;
+    int         opIndex;
+    int         lineNum;
+};
+
+//----------------------------------------------------------------------------------------
+// The file content hash. A 64-bit FNV-1a hash.
+//
+//----------------------------------------------------------------------------------------
+uint64_t hashCmdFile( char *src, size_t srcSize ) {
+
+    uint64_t hash = 14695981039346656037ULL;
+
+    for ( size_t i = 0; i < srcSize; i++ ) {
+
+        hash ^= (uint8_t) src[ i ];
+        hash *= 1099511628211ULL;
+    }
+
+    return( hash );
+}
+
+//----------------------------------------------------------------------------------------
+// Get the next line from the file content. We break the content into lines just
+// like "fgets" would for the command line buffer size and remove the line end
+// characters. Just like the "feof" loop this replaces, an empty last line is
+// returned when the content does not end right at the end of a line read.
+//
+//----------------------------------------------------------------------------------------
+bool nextSrcLine( char *src, size_t srcSize, size_t *pos, bool *eof, char *lineBuf ) {
+
+    int len = 0;
+
+    if ( *eof ) return( false );
+
+    while ( len < MAX_CMD_LINE_SIZE - 1 ) {
+
+        if ( *pos >= srcSize ) {
+
+            *eof = true;
+            break;
+        }
+
+        char ch = src[ ( *pos )++ ];
+        lineBuf[ len++ ] = ch;
+        if ( ch == '\n' ) break;
+    }
+
+    lineBuf[ len ] = '\0';
+    lineBuf[ strcspn( lineBuf, "\r\n" ) ] = '\0';
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Add a string to the compiled file text and return its offset.
+//
+//----------------------------------------------------------------------------------------
+int addText( SimCmdFile *cmdFile, size_t *textLen, char *str ) {
+
+    int ofs = (int) *textLen;
+
+    strcpy( cmdFile -> text + ofs, str );
+    *textLen += strlen( str ) + 1;
+    return( ofs );
+}
+
+//----------------------------------------------------------------------------------------
+// Add the tokens of a command line to the token list. String values are copied to the
+// string pool. As the pool may move while growing, we first record the string offset
+// and fix the pointers when the compilation is done.
+//
+//----------------------------------------------------------------------------------------
+int addTokens( SimCmdFile   *cmdFile,
+               int          *tokMax,
+               size_t       *strLen,
+               size_t       *strMax,
+               SimToken     *lineToks,
+               int          lineTokCount ) {
+
+    int index = cmdFile -> tokCount;
+
+    if ( index + lineTokCount > *tokMax ) {
+
+        while ( index + lineTokCount > *tokMax ) *tokMax *= 2;
+
+        cmdFile -> toks =
+            (SimToken *) realloc( cmdFile -> toks, *tokMax * sizeof( SimToken ));
+    }
+
+    for ( int i = 0; i < lineTokCount; i++ ) {
+
+        SimToken *tp = &cmdFile -> toks[ index + i ];
+
+        *tp = lineToks[ i ];
+
+        if ( tp -> tid == TOK_STR ) {
+
+            size_t len = strlen( tp -> u.str ) + 1;
+
+            if ( *strLen + len > *strMax ) {
+
+                while ( *strLen + len > *strMax ) *strMax *= 2;
+                cmdFile -> strPool = (char *) realloc( cmdFile -> strPool, *strMax );
+            }
+
+            memcpy( cmdFile -> strPool + *strLen, tp -> u.str, len );
+            tp -> u.val = (T64Word) *strLen;
+            *strLen     += len;
+        }
+    }
+
+    cmdFile -> tokCount += lineTokCount;
+    return( index );
+}
+
+//----------------------------------------------------------------------------------------
+// Scan a command line into a token list. The tokenizer returns all strings in the 
+// same buffer, so each string is copied to the line string buffer. The strings in a
+// line cannot be longer than the line itself. Any scanning error lets the caller keep
+// the line as text.
+//
+//----------------------------------------------------------------------------------------
+bool scanCmdLine( SimTokenizerFromString    *tok, 
+                  char                      *cmdBuf, 
+                  SimToken                  *lineToks, 
+                  char                      *lineStrBuf,
+                  int                       *count ) {
+
+    size_t strLen = 0;
+
+    *count = 0;
+
+    try {
+
+        tok -> setupTokenizer( cmdBuf );
+        tok -> nextToken( );
+
+        while ( ! tok -> isToken( TOK_EOS )) {
+
+            if ( *count >= MAX_LINE_TOKENS ) return( false );
+
+            SimToken *tp = &lineToks[ ( *count )++ ];
+
+            *tp = tok -> token( );
+
+            if ( tp -> tid == TOK_STR ) {
+
+                strcpy( lineStrBuf + strLen, tp -> u.str );
+                tp -> u.str = lineStrBuf + strLen;
+                strLen      += strlen( tp -> u.str ) + 1;
+            }
+
+            tok -> nextToken( );
+        }
+
+        return( true );
+    }
+
+    catch ( SimErrMsgId errNum ) {
+
+        return( false );
+    }
+}
+
+}; // namespace
+
+//----------------------------------------------------------------------------------------
+// A little helper function to remove the comment part of a command line. We do
+// the changes on the buffer passed in by just setting the end of string at the
+// position of the "#" comment indicator. A "#" inside a string is ignored.
+//
+//----------------------------------------------------------------------------------------
+int removeComment( char *cmdBuf ) {
+
+    if ( strlen ( cmdBuf ) > 0 ) {
+
+        char *ptr = cmdBuf;
+
+        bool inQuotes = false;
+
+        while ( *ptr ) {
+
+            if ( *ptr == '"' ) {
+
+                inQuotes = ! inQuotes;
+            }
+            else if ( *ptr == '#' && !inQuotes ) {
+
+                *ptr = '\0';
+                break;
+            }
+
+            ptr++;
+        }
+    }
+
+    return ((int) strlen( cmdBuf ));
+}
+
+//****************************************************************************************
+//****************************************************************************************
+//
+// Object methods - SimCmdFileCache
+//
+//----------------------------------------------------------------------------------------
+// Object constructor and destructor.
+//
+//----------------------------------------------------------------------------------------
+SimCmdFileCache::SimCmdFileCache( ) { }
+
+SimCmdFileCache::~SimCmdFileCache( ) {
+
+    for ( int i = 0; i < MAX_CMD_FILE_CACHE; i++ ) {
+
+        if ( entries[ i ] != nullptr ) freeCmdFile( entries[ i ] );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Get the compiled command file. We read the file content and look for a cached
+// entry with the same content. If there is none, the file is compiled and entered
+// into the cache, replacing the least recently used entry not in use. When all
+// entries are in use, the compiled file is not cached and released after use. Any
+// file error or control statement error is thrown. For the latter, the source line
+// number is returned too.
+//
+//----------------------------------------------------------------------------------------
+SimCmdFile *SimCmdFileCache::getCmdFile( char *fileName, int *errLine ) {
+
+    FILE *f = fopen( fileName, "r" );
+    if ( f == nullptr ) throw ( ERR_OPEN_EXEC_FILE );
+
+    fseek( f, 0, SEEK_END );
+    long fileSize = ftell( f );
+    rewind( f );
+
+    if ( fileSize < 0 ) {
+
+        fclose( f );
+        throw ( ERR_OPEN_EXEC_FILE );
+    }
+
+    char    *src        = (char *) malloc( fileSize + 1 );
+    size_t  srcSize     = fread( src, 1, fileSize, f );
+    uint64_t hash       = hashCmdFile( src, srcSize );
+
+    fclose( f );
+
+    for ( int i = 0; i < MAX_CMD_FILE_CACHE; i++ ) {
+
+        SimCmdFile *cf = entries[ i ];
+
+        if (( cf != nullptr ) &&
+            ( cf -> hash == hash ) &&
+            ( cf -> srcSize == srcSize ) &&
+            ( memcmp( cf -> src, src, srcSize ) == 0 )) {
+
+            free( src );
+            cf -> useCount ++;
+            cf -> lastUse = ++ useClock;
+            return( cf );
+        }
+    }
+
+    SimCmdFile *cmdFile = compile( src, srcSize, errLine );
+    if ( cmdFile == nullptr ) throw ( ERR_CMD_FILE_STRUCTURE );
+
+    cmdFile -> hash     = hash;
+    cmdFile -> useCount = 1;
+    cmdFile -> lastUse  = ++ useClock;
+
+    int slot = -1;
+
+    for ( int i = 0; i < MAX_CMD_FILE_CACHE; i++ ) {
+
+        if ( entries[ i ] == nullptr ) {
+
+            slot = i;
+            break;
+        }
+        else if (( entries[ i ] -> useCount == 0 ) &&
+                 (( slot < 0 ) || ( entries[ i ] -> lastUse < entries[ slot ] -> lastUse ))) {
+
+            slot = i;
+        }
+    }
+
+    if ( slot >= 0 ) {
+
+        if ( entries[ slot ] != nullptr ) freeCmdFile( entries[ slot ] );
+
+        entries[ slot ]     = cmdFile;
+        cmdFile -> cached   = true;
+    }
+
+    return( cmdFile );
+}
+
+//----------------------------------------------------------------------------------------
+// Release the compiled file after use. A file that is not in the cache is freed.
+//
+//----------------------------------------------------------------------------------------
+void SimCmdFileCache::releaseCmdFile( SimCmdFile *cmdFile ) {
+
+    cmdFile -> useCount --;
+
+    if (( ! cmdFile -> cached ) && ( cmdFile -> useCount == 0 )) freeCmdFile( cmdFile );
+}
+
+//----------------------------------------------------------------------------------------
+// Free a compiled file.
+//
+//----------------------------------------------------------------------------------------
+void SimCmdFileCache::freeCmdFile( SimCmdFile *cmdFile ) {
+
+    free( cmdFile -> src );
+    free( cmdFile -> text );
+    free( cmdFile -> ops );
+    free( cmdFile -> toks );
+    free( cmdFile -> strPool );
+    delete cmdFile;
+}
+
+//----------------------------------------------------------------------------------------
+// Compile the file content. We first count the lines to allocate the operations and
+// the text buffer. Each line is stored as is for the echo and without the comment
+// for the command history. Each line is then scanned. A line with a command becomes
+// a command operation with the argument tokens. A line that does not scan or does
+// not start with a command is passed at run time to the command line interpreter,
+// which reports the error. The control statements are kept on a stack until their
+// closing line sets the jump targets. On an unbalanced control statement, we return
+// a nullptr and the source line number. The content buffer becomes part of the
+// compiled file.
+//
+//----------------------------------------------------------------------------------------
+SimCmdFile *SimCmdFileCache::compile( char *src, size_t srcSize, int *errLine ) {
+
+    char            lineBuf[ MAX_CMD_LINE_SIZE ];
+    char            cmdBuf[ MAX_CMD_LINE_SIZE ];
+    SimToken        lineToks[ MAX_LINE_TOKENS ];
+    char            lineStrBuf[ MAX_CMD_LINE_SIZE ];
+    CtrlStackEntry  ctrlStack[ MAX_CMD_FILE_NESTING ];
+    SimTokenizerFromString tok;
+    int             ctrlTop     = 0;
+    int             lineCount   = 0;
+    int             lineNum     = 0;
+    int             tokMax      = INIT_TOK_LIST_SIZE;
+    size_t          strMax      = INIT_STR_POOL_SIZE;
+    size_t          strLen      = 0;
+    size_t          textLen     = 0;
+    size_t          pos         = 0;
+    bool            eof         = false;
+
+    *errLine = 0;
+
+    while ( nextSrcLine( src, srcSize, &pos, &eof, lineBuf )) lineCount ++;
+
+    SimCmdFile *cmdFile = new SimCmdFile( );
+
+    cmdFile -> src      = src;
+    cmdFile -> srcSize  = srcSize;
+    cmdFile -> text     = (char *) malloc( 2 * ( srcSize + lineCount ) + 1 );
+    cmdFile -> ops      = (SimCmdFileOp *) calloc( lineCount + 1, sizeof( SimCmdFileOp ));
+    cmdFile -> toks     = (SimToken *) malloc( tokMax * sizeof( SimToken ));
+    cmdFile -> strPool  = (char *) malloc( strMax );
+
+    pos = 0;
+    eof = false;
+
+    while ( nextSrcLine( src, srcSize, &pos, &eof, lineBuf )) {
+
+        SimCmdFileOp    *op         = &cmdFile -> ops[ cmdFile -> opCount ];
+        int             opIndex     = cmdFile -> opCount;
+        int             tokCount    = 0;
+
+        lineNum ++;
+        cmdFile -> opCount ++;
+
+        strcpy( cmdBuf, lineBuf );
+        removeComment( cmdBuf );
+
+        op -> op            = CF_OP_NOP;
+        op -> cmdId         = TOK_NIL;
+        op -> srcLineOfs    = addText( cmdFile, &textLen, lineBuf );
+        op -> cmdLineOfs    = addText( cmdFile, &textLen, cmdBuf );
+
+        if ( strlen( cmdBuf ) == 0 ) continue;
+
+        if (( ! scanCmdLine( &tok, cmdBuf, lineToks, lineStrBuf, &tokCount )) ||
+            (( lineToks[ 0 ].typ != TYP_CMD ) && ( lineToks[ 0 ].typ != TYP_WCMD ))) {
+
+            op -> op = CF_OP_LINE;
+            continue;
+        }
+
+        op -> cmdId     = lineToks[ 0 ].tid;
+        op -> tokIndex  = addTokens( cmdFile, &tokMax, &strLen, &strMax,
+                                     lineToks + 1, tokCount - 1 );
+        op -> tokCount  = tokCount - 1;
+
+        switch ( op -> cmdId ) {
+
+            case CMD_IF:
+            case CMD_WHILE:
+            case CMD_LOOP: {
+
+                if ( ctrlTop >= MAX_CMD_FILE_NESTING ) {
+
+                    *errLine = lineNum;
+                    break;
+                }
+
+                ctrlStack[ ctrlTop++ ] = { op -> cmdId, opIndex, lineNum };
+                op -> op = ( op -> cmdId == CMD_LOOP ) ? CF_OP_LOOP : CF_OP_JUMP_FALSE;
+
+            } break;
+
+            case CMD_ELSE: {
+
+                if (( ctrlTop == 0 ) ||
+                    ( ctrlStack[ ctrlTop - 1 ].cmdId != CMD_IF ) ||
+                    ( op -> tokCount > 0 )) {
+
+                    *errLine = lineNum;
+                    break;
+                }
+
+                cmdFile -> ops[ ctrlStack[ ctrlTop - 1 ].opIndex ].target = opIndex + 1;
+                ctrlStack[ ctrlTop - 1 ] = { CMD_ELSE, opIndex, lineNum };
+                op -> op = CF_OP_JUMP;
+
+            } break;
+
+            case CMD_ENDIF:
+            case CMD_ENDWHILE:
+            case CMD_ENDLOOP: {
+
+                SimTokId openCmdId = TOK_NIL;
+
+                if ( ctrlTop > 0 ) openCmdId = ctrlStack[ ctrlTop - 1 ].cmdId;
+
+                if ((( op -> cmdId == CMD_ENDIF ) &&
+                     ( openCmdId != CMD_IF ) && ( openCmdId != CMD_ELSE )) ||
+                    (( op -> cmdId == CMD_ENDWHILE ) && ( openCmdId != CMD_WHILE )) ||
+                    (( op -> cmdId == CMD_ENDLOOP ) && ( openCmdId != CMD_LOOP )) ||
+                    ( op -> tokCount > 0 )) {
+
+                    *errLine = lineNum;
+                    break;
+                }
+
+                int openIndex = ctrlStack[ --ctrlTop ].opIndex;
+
+                cmdFile -> ops[ openIndex ].target = opIndex + 1;
+
+                if ( op -> cmdId == CMD_ENDWHILE ) {
+
+                    op -> op        = CF_OP_JUMP;
+                    op -> target    = openIndex;
+                }
+                else if ( op -> cmdId == CMD_ENDLOOP ) {
+
+                    op -> op        = CF_OP_END_LOOP;
+                    op -> target    = openIndex + 1;
+                }
+
+            } break;
+
+            default: op -> op = CF_OP_CMD;
+        }
+
+        if ( *errLine > 0 ) break;
+    }
+
+    if (( *errLine == 0 ) && ( ctrlTop > 0 )) *errLine = ctrlStack[ ctrlTop - 1 ].lineNum;
+
+    if ( *errLine > 0 ) {
+
+        freeCmdFile( cmdFile );
+        return( nullptr );
+    }
+
+    for ( int i = 0; i < cmdFile -> tokCount; i++ ) {
+
+        SimToken *tp = &cmdFile -> toks[ i ];
+
+        if ( tp -> tid == TOK_STR ) tp -> u.str = cmdFile -> strPool + tp -> u.val;
+    }
+
+    return( cmdFile );
+}
@@ -3,7 +3,54 @@
 //  Twin64Sim - A 64-bit CPU Simulator - Configuration 
 //
 //----------------------------------------------------------------------------------------
-// 
+// This module contains the command line option processing and the configuration file
+// parser. The configuration file describes the system topology, i.e. the processor,
+// memory and I/O modules to create at startup. The file consists of sections, each
+// section describes one module with "key = value" lines. Comments start with a "#" 
+// or ";" character. Numbers are decimal or hex with a "0x" prefix and may have a 
+// "K", "M" or "G" suffix. An example:
+//
+//  # One processor, the PDC ROM and a 4 GB memory above the I/O space.
+//
+//  [processor]
+//  mod     = 3
+//  itlb    = FA_64S
+//  dtlb    = FA_64S
+//  icache  = 2W_128S_4L
+//  dcache  = 8W_128S_4L
+//
+//  [memory]
+//  mod     = 0
+//  type    = ROM
+//  adr     = 0xF0000000
+//  len     = 16K
+//  file    = pdc.bin
+//
+//  [memory]
+//  mod     = 1
+//  type    = RAM
+//  adr     = 0x100000000
+//  len     = 4G
+//
+// The TLB types are FA_64S and FA_128S. The cache types are 2W, 4W, 8W with either 
+// 128S_4L or 64S_8L. The memory "file" key is optional and names a memory image file
+// in big endian byte order. The "[io]" section describes an I/O module with the "mod"
+// and "type" key. An I/O module has its device registers at "adr" in the I/O SPA 
+// range, "len" defaults to one page. A "DISK" module takes the disk image from the 
+// "file" key. A "UART" module is the console, the optional "file" key names a file 
+// that receives the console output instead of the screen. A "TIMER" module is the
+// interval timer and real time clock. There is a limit of MAX_MODULES modules.
+//
+//  [io]
+//  mod     = 4
+//  type    = DISK
+//  adr     = 0xF1000000
+//  file    = disk.img
+//
+//  [io]
+//  mod     = 5
+//  type    = UART
+//  adr     = 0xF1001000
 //
 //----------------------------------------------------------------------------------------
 //
@@ -33,6 +80,388 @@ namespace {
     int  optIndex = 1;  
 }
 
+//----------------------------------------------------------------------------------------
+// Local data and helper functions for configuration file parsing.
+//
+//----------------------------------------------------------------------------------------
+namespace {
+
+const int MAX_CONFIG_LINE_SIZE = 256;
+
+enum ConfigSectionKind : int {
+
+    CFG_SEC_NIL     = 0,
+    CFG_SEC_PROC    = 1,
+    CFG_SEC_MEM     = 2,
+    CFG_SEC_IO      = 3
+};
+
+struct ConfigNameVal {
+
+    const char  *name;
+    int         val;
+};
+
+const ConfigNameVal tlbTypeTab[ ] = {
+
+    { "FA_64S",         T64_TT_FA_64S       },
+    { "FA_128S",        T64_TT_FA_128S      },
+    { nullptr,          0                   }
+};
+
+const ConfigNameVal cacheTypeTab[ ] = {
+
+    { "2W_128S_4L",     T64_CT_2W_128S_4L   },
+    { "4W_128S_4L",     T64_CT_4W_128S_4L   },
+    { "8W_128S_4L",     T64_CT_8W_128S_4L   },
+    { "2W_64S_8L",      T64_CT_2W_64S_8L    },
+    { "4W_64S_8L",      T64_CT_4W_64S_8L    },
+    { "8W_64S_8L",      T64_CT_8W_64S_8L    },
+    { nullptr,          0                   }
+};
+
+const ConfigNameVal memTypeTab[ ] = {
+
+    { "RAM",            T64_MT_RAM          },
+    { "ROM",            T64_MT_ROM          },
+    { nullptr,          0                   }
+};
+
+const ConfigNameVal ioTypeTab[ ] = {
+
+    { "DISK",           T64_IO_DISK         },
+    { "UART",           T64_IO_UART         },
+    { "TIMER",          T64_IO_TIMER        },
+    { nullptr,          0                   }
+};
+
+//----------------------------------------------------------------------------------------
+// The section data collected while parsing. A section is built into a module when the
+// next section starts or the file ends.
+//
+//----------------------------------------------------------------------------------------
+struct ConfigSection {
+
+    ConfigSectionKind   kind        = CFG_SEC_NIL;
+    int                 lineNum     = 0;
+    int                 modNum      = -1;
+    T64TlbType          iTlbType    = T64_TT_FA_64S;
+    T64TlbType          dTlbType    = T64_TT_FA_64S;
+    T64CacheType        iCacheType  = T64_CT_2W_128S_4L;
+    T64CacheType        dCacheType  = T64_CT_8W_128S_4L;
+    T64MemType          memType     = T64_MT_RAM;
+    T64Word             spaAdr      = -1;
+    T64Word             spaLen      = 0;
+    char                typeName[ MAX_CONFIG_LINE_SIZE ]    = { 0 };
+    char                fileName[ MAX_FILE_PATH_SIZE ]      = { 0 };
+};
+
+//----------------------------------------------------------------------------------------
+// Error reporting. All messages carry the file name and line number.
+//
+//----------------------------------------------------------------------------------------
+bool configError( const char *fileName, int lineNum, const char *msg, const char *arg ) {
+
+    fprintf( stderr, "Config file %s, line %d: %s", fileName, lineNum, msg );
+    if ( arg != nullptr ) fprintf( stderr, ": \"%s\"", arg );
+    fprintf( stderr, "\n" );
+    return( false );
+}
+
+//----------------------------------------------------------------------------------------
+// Strip leading and trailing white space in place.
+//
+//----------------------------------------------------------------------------------------
+char *trimString( char *str ) {
+
+    while ( isspace((unsigned char) *str )) str++;
+
+    char *end = str + strlen( str );
+    while (( end > str ) && ( isspace((unsigned char) end[ -1 ] ))) end--;
+    *end = '\0';
+
+    return( str );
+}
+
+//----------------------------------------------------------------------------------------
+// Compare two names ignoring the case. We do not rely on the POSIX "strcasecmp", which
+// is not available on all platforms.
+//
+//----------------------------------------------------------------------------------------
+bool isSameName( const char *a, const char *b ) {
+
+    while (( *a != '\0' ) && 
+           ( toupper((unsigned char) *a ) == toupper((unsigned char) *b ))) {
+        
+        a++; 
+        b++;
+    }
+
+    return( toupper((unsigned char) *a ) == toupper((unsigned char) *b ));
+}
+
+//----------------------------------------------------------------------------------------
+// Look up a name in a name / value table. The lookup is case insensitive.
+//
+//----------------------------------------------------------------------------------------
+bool lookupConfigName( const ConfigNameVal *tab, const char *name, int *val ) {
+
+    for ( int i = 0; tab[ i ].name != nullptr; i++ ) {
+
+        if ( isSameName( tab[ i ].name, name )) {
+
+            *val = tab[ i ].val;
+            return( true );
+        }
+    }
+
+    return( false );
+}
+
+//----------------------------------------------------------------------------------------
+// Parse a number. We accept decimal and hex numbers with an optional "K", "M" or "G" 
+// size suffix.
+//
+//----------------------------------------------------------------------------------------
+bool parseConfigNum( const char *str, T64Word *val ) {
+
+    char                *endPtr = nullptr;
+    unsigned long long  num     = strtoull( str, &endPtr, 0 );
+
+    if ( endPtr == str ) return( false );
+
+    switch ( toupper((unsigned char) *endPtr )) {
+
+        case 'K': num <<= 10; endPtr++; break;
+        case 'M': num <<= 20; endPtr++; break;
+        case 'G': num <<= 30; endPtr++; break;
+        default: ;
+    }
+
+    if ( *endPtr != '\0' ) return( false );
+
+    *val = (T64Word) num;
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Store a "key = value" pair in the current section.
+//
+//----------------------------------------------------------------------------------------
+bool setConfigKey( ConfigSection    *sec, 
+                   const char       *fName, 
+                   int              lineNum, 
+                   const char       *key, 
+                   const char       *val ) {
+
+    int     tmp = 0;
+    T64Word num = 0;
+
+    if ( isSameName( key, "mod" )) {
+
+        if (( ! parseConfigNum( val, &num )) || ( num < 0 ) || ( num >= MAX_MODULES ))
+            return( configError( fName, lineNum, "Invalid module number", val ));
+
+        sec -> modNum = (int) num;
+    }
+    else if (( sec -> kind == CFG_SEC_PROC ) && ( isSameName( key, "itlb" ))) {
+
+        if ( ! lookupConfigName( tlbTypeTab, val, &tmp ))
+            return( configError( fName, lineNum, "Invalid TLB type", val ));
+
+        sec -> iTlbType = (T64TlbType) tmp;
+    }
+    else if (( sec -> kind == CFG_SEC_PROC ) && ( isSameName( key, "dtlb" ))) {
+
+        if ( ! lookupConfigName( tlbTypeTab, val, &tmp ))
+            return( configError( fName, lineNum, "Invalid TLB type", val ));
+
+        sec -> dTlbType = (T64TlbType) tmp;
+    }
+    else if (( sec -> kind == CFG_SEC_PROC ) && ( isSameName( key, "icache" ))) {
+
+        if ( ! lookupConfigName( cacheTypeTab, val, &tmp ))
+            return( configError( fName, lineNum, "Invalid cache type", val ));
+
+        sec -> iCacheType = (T64CacheType) tmp;
+    }
+    else if (( sec -> kind == CFG_SEC_PROC ) && ( isSameName( key, "dcache" ))) {
+
+        if ( ! lookupConfigName( cacheTypeTab, val, &tmp ))
+            return( configError( fName, lineNum, "Invalid cache type", val ));
+
+        sec -> dCacheType = (T64CacheType) tmp;
+    }
+    else if (( sec -> kind == CFG_SEC_MEM ) && ( isSameName( key, "type" ))) {
+
+        if ( ! lookupConfigName( memTypeTab, val, &tmp ))
+            return( configError( fName, lineNum, "Invalid memory type", val ));
+
+        sec -> memType = (T64MemType) tmp;
+    }
+    else if ((( sec -> kind == CFG_SEC_MEM ) || ( sec -> kind == CFG_SEC_IO )) && 
+             ( isSameName( key, "adr" ))) {
+
+        if ( ! parseConfigNum( val, &sec -> spaAdr ))
+            return( configError( fName, lineNum, "Invalid address", val ));
+    }
+    else if ((( sec -> kind == CFG_SEC_MEM ) || ( sec -> kind == CFG_SEC_IO )) && 
+             ( isSameName( key, "len" ))) {
+
+        if ( ! parseConfigNum( val, &sec -> spaLen ))
+            return( configError( fName, lineNum, "Invalid length", val ));
+    }
+    else if ((( sec -> kind == CFG_SEC_MEM ) || ( sec -> kind == CFG_SEC_IO )) && 
+             ( isSameName( key, "file" ))) {
+
+        strncpy( sec -> fileName, val, MAX_FILE_PATH_SIZE - 1 );
+        sec -> fileName[ MAX_FILE_PATH_SIZE - 1 ] = '\0';
+    }
+    else if (( sec -> kind == CFG_SEC_IO ) && ( isSameName( key, "type" ))) {
+
+        strncpy( sec -> typeName, val, MAX_CONFIG_LINE_SIZE - 1 );
+        sec -> typeName[ MAX_CONFIG_LINE_SIZE - 1 ] = '\0';
+    }
+    else return( configError( fName, lineNum, "Unknown key", key ));
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Build the module described by a section and add it to the system. Memory modules
+// are checked for page alignment and the physical address range. A memory image is
+// loaded before a ROM is set read only.
+//
+//----------------------------------------------------------------------------------------
+bool buildConfigModule( T64System *sys, ConfigSection *sec, const char *fName ) {
+
+    T64Module *mPtr = nullptr;
+
+    if ( sec -> kind == CFG_SEC_NIL ) return( true );
+
+    if ( sec -> modNum < 0 ) 
+        return( configError( fName, sec -> lineNum, "Missing module number", nullptr ));
+
+    switch ( sec -> kind ) {
+
+        case CFG_SEC_PROC: {
+
+            mPtr = new T64Processor( sys,
+                                     sec -> modNum,
+                                     T64_PO_NIL,
+                                     T64_CPU_T_NIL,
+                                     sec -> iTlbType,
+                                     sec -> dTlbType,
+                                     sec -> iCacheType,
+                                     sec -> dCacheType,
+                                     0,
+                                     0 );
+        } break;
+
+        case CFG_SEC_MEM: {
+
+            if (( sec -> spaAdr < 0 ) || ( sec -> spaLen <= 0 )) 
+                return( configError( fName, sec -> lineNum, 
+                                     "Missing memory address or length", nullptr ));
+
+            if ((( sec -> spaAdr % T64_PAGE_SIZE_BYTES ) != 0 ) ||
+                (( sec -> spaLen % T64_PAGE_SIZE_BYTES ) != 0 ))
+                return( configError( fName, sec -> lineNum, 
+                                     "Memory range is not page aligned", nullptr ));
+
+            if (( sec -> spaAdr > T64_MAX_PHYS_MEM_LIMIT ) ||
+                ( sec -> spaLen - 1 > T64_MAX_PHYS_MEM_LIMIT - sec -> spaAdr ))
+                return( configError( fName, sec -> lineNum, 
+                                     "Memory range exceeds physical memory", nullptr ));
+
+            T64Memory *mem = new T64Memory( sys,
+                                            sec -> modNum,
+                                            T64_MK_NIL,
+                                            sec -> memType,
+                                            sec -> spaAdr,
+                                            sec -> spaLen );
+
+            if (( sec -> fileName[ 0 ] != '\0' ) && ( ! mem -> loadImage( sec -> fileName ))) {
+
+                delete mem;
+                return( configError( fName, sec -> lineNum, 
+                                     "Cannot load memory image", sec -> fileName ));
+            }
+
+            if ( sec -> memType == T64_MT_ROM ) mem -> setSpaReadOnly( true );
+            mPtr = mem;
+
+        } break;
+
+        case CFG_SEC_IO: {
+
+            int ioType = T64_IO_NIL;
+
+            if ( sec -> typeName[ 0 ] == '\0' )
+                return( configError( fName, sec -> lineNum, "Missing I/O module type", nullptr ));
+            
+            if ( ! lookupConfigName( ioTypeTab, sec -> typeName, &ioType ))
+                return( configError( fName, sec -> lineNum, 
+                                     "Unknown I/O module type", sec -> typeName ));
+
+            if ( sec -> spaLen == 0 ) sec -> spaLen = T64_PAGE_SIZE_BYTES;
+
+            if (( sec -> spaAdr < T64_IO_SPA_MEM_START ) || 
+                ( sec -> spaAdr + sec -> spaLen - 1 > T64_IO_SPA_MEM_LIMIT ))
+                return( configError( fName, sec -> lineNum, 
+                                     "I/O module range not in I/O SPA space", nullptr ));
+
+            if ( ioType == T64_IO_DISK ) {
+
+                T64Disk *disk = new T64Disk( sys, sec -> modNum, sec -> spaAdr, sec -> spaLen );
+
+                if (( sec -> fileName[ 0 ] != '\0' ) && ( ! disk -> attachImage( sec -> fileName ))) {
+
+                    delete disk;
+                    return( configError( fName, sec -> lineNum, 
+                                         "Cannot open disk image", sec -> fileName ));
+                }
+
+                mPtr = disk;
+            }
+            else if ( ioType == T64_IO_TIMER ) {
+
+                mPtr = new T64Timer( sys, sec -> modNum, sec -> spaAdr, sec -> spaLen );
+            }
+            else {
+
+                T64Uart *uart = new T64Uart( sys, sec -> modNum, sec -> spaAdr, sec -> spaLen );
+
+                if (( sec -> fileName[ 0 ] != '\0' ) && ( ! uart -> setOutputFile( sec -> fileName ))) {
+
+                    delete uart;
+                    return( configError( fName, sec -> lineNum, 
+                                         "Cannot open console output file", sec -> fileName ));
+                }
+
+                mPtr = uart;
+            }
+
+        } break;
+
+        default: ;
+    }
+
+    if ( sys -> addToModuleMap( mPtr ) != 0 ) {
+
+        if      ( mPtr -> getModuleType( ) == MT_PROC ) delete (T64Processor *) mPtr;
+        else if ( mPtr -> getModuleType( ) == MT_IO )   delete (T64IoModule *) mPtr;
+        else delete (T64Memory *) mPtr;
+
+        return( configError( fName, sec -> lineNum, 
+                             "Module number or address range conflict", nullptr ));
+    }
+
+    return( true );
+}
+
+} // namespace
+
 //----------------------------------------------------------------------------------------
 // "parseCmdLineOptions" function to parse long command line options. This routine 
 // is called repeatedly to parse all command line options. It returns the value field
@@ -125,6 +554,10 @@ void processCmdLineOptions( SimGlobals *glb, int argc, char *argv[ ] ) {
                 printf( "  --configfile=<file>  : specify configuration file\n" );
                 printf( "  --logfile=<file>     : specify log file\n" );
                 printf( "  --initfile=<file>    : specify init file\n" );
+                printf( "  --batch              : run without the window display\n" );
+                printf( "  --elffile=<file>     : batch mode ELF file to run\n" );
+                printf( "  --outfile=<file>     : batch mode result file\n" );
+                printf( "  --maxsteps=<num>     : batch mode step limit\n" );
                 exit( 0 );
             
             } break;
@@ -182,6 +615,39 @@ void processCmdLineOptions( SimGlobals *glb, int argc, char *argv[ ] ) {
 
             } break; 
 
+            case CL_ARG_VAL_BATCH: {
+
+                glb -> batchFlag = true;
+
+            } break;
+
+            case CL_ARG_VAL_ELF_FILE: {
+
+                strncpy( glb -> elfFileName, optArg, MAX_FILE_PATH_SIZE - 1 );
+                glb -> elfFileName[ MAX_FILE_PATH_SIZE - 1 ] = '\0';
+
+            } break;
+
+            case CL_ARG_VAL_OUT_FILE: {
+
+                strncpy( glb -> outFileName, optArg, MAX_FILE_PATH_SIZE - 1 );
+                glb -> outFileName[ MAX_FILE_PATH_SIZE - 1 ] = '\0';
+
+            } break;
+
+            case CL_ARG_VAL_MAX_STEPS: {
+
+                char *endPtr = nullptr;
+
+                glb -> batchMaxSteps = strtoll( optArg, &endPtr, 0 );
+                if (( *endPtr != '\0' ) || ( glb -> batchMaxSteps <= 0 )) {
+
+                    printf( "Error: --maxsteps requires a positive number\n" );
+                    exit( 1 );
+                }
+
+            } break;
+
             default: {
 
                 printf( "Invalid command parameter option, use help\n" );
@@ -190,3 +656,93 @@ void processCmdLineOptions( SimGlobals *glb, int argc, char *argv[ ] ) {
         }
     }
 }
+
+//----------------------------------------------------------------------------------------
+// "setupSystemFromConfigFile" reads the configuration file and builds the system 
+// modules. The file is processed line by line. A section header starts a new module
+// description, the previous section is built at this point. Any error terminates the
+// processing. Modules built so far remain in the system, the simulator will not start
+// anyway.
+//
+//----------------------------------------------------------------------------------------
+bool setupSystemFromConfigFile( SimGlobals *glb, const char *fileName ) {
+
+    char            lineBuf[ MAX_CONFIG_LINE_SIZE ];
+    int             lineNum = 0;
+    ConfigSection   sec;
+    FILE            *fp     = fopen( fileName, "r" );
+
+    if ( fp == nullptr ) {
+
+        fprintf( stderr, "Cannot open config file: \"%s\"\n", fileName );
+        return( false );
+    }
+
+    while ( fgets( lineBuf, sizeof( lineBuf ), fp ) != nullptr ) {
+
+        lineNum ++;
+
+        char *comment = strpbrk( lineBuf, "#;" );
+        if ( comment != nullptr ) *comment = '\0';
+
+        char *line = trimString( lineBuf );
+        if ( *line == '\0' ) continue;
+
+        if ( *line == '[' ) {
+
+            char *end = strchr( line, ']' );
+            if (( end == nullptr ) || ( *trimString( end + 1 ) != '\0' )) {
+
+                fclose( fp );
+                return( configError( fileName, lineNum, "Invalid section header", line ));
+            }
+
+            *end = '\0';
+            char *name = trimString( line + 1 );
+
+            if ( ! buildConfigModule( glb -> system, &sec, fileName )) {
+
+                fclose( fp );
+                return( false );
+            }
+
+            sec         = ConfigSection( );
+            sec.lineNum = lineNum;
+
+            if      ( isSameName( name, "processor" )) sec.kind = CFG_SEC_PROC;
+            else if ( isSameName( name, "memory" ))    sec.kind = CFG_SEC_MEM;
+            else if ( isSameName( name, "io" ))        sec.kind = CFG_SEC_IO;
+            else {
+
+                fclose( fp );
+                return( configError( fileName, lineNum, "Unknown section", name ));
+            }
+
+            continue;
+        }
+
+        char *eq = strchr( line, '=' );
+        if ( eq == nullptr ) {
+
+            fclose( fp );
+            return( configError( fileName, lineNum, "Expected \"key = value\"", line ));
+        }
+
+        if ( sec.kind == CFG_SEC_NIL ) {
+
+            fclose( fp );
+            return( configError( fileName, lineNum, "Key outside of a section", line ));
+        }
+
+        *eq = '\0';
+        
+        if ( ! setConfigKey( &sec, fileName, lineNum, trimString( line ), trimString( eq + 1 ))) {
+
+            fclose( fp );
+            return( false );
+        }
+    }
+
+    fclose( fp );
+    return( buildConfigModule( glb -> system, &sec, fileName ));
+}
@@ -36,6 +36,7 @@
 #include "T64-System.h"
 #include "T64-Processor.h"
 #include "T64-Memory.h"
+#include "T64-IO.h"
 
 //----------------------------------------------------------------------------------------
 // When we say windows, don't think about a modern graphical window system. The 
@@ -185,7 +186,8 @@ enum SimTokId : uint16_t {
     TOK_REM,                    TOK_NEG,                    TOK_AND,
     TOK_OR,                     TOK_XOR,                    TOK_EQ,
     TOK_NE,                     TOK_LT,                     TOK_GT,
-    TOK_LE,                     TOK_GE,
+    TOK_LE,                     TOK_GE,                     TOK_LOG_AND,
+    TOK_LOG_OR,
 
     //------------------------------------------------------------------------------------
     // Token symbols.
@@ -200,7 +202,8 @@ enum SimTokId : uint16_t {
     TOK_CACHE_SA_2W_128S_4L,    TOK_CACHE_SA_4W_128S_4L,    TOK_CACHE_SA_8W_128S_4L,
     TOK_CACHE_SA_2W_64S_8L,     TOK_CACHE_SA_4W_64S_8L,     TOK_CACHE_SA_8W_64S_8L,
     TOK_MEM_READ_ONLY,          TOK_MEM_READ_WRITE,         TOK_MOD_SPA_ADR,
-    TOK_MOD_SPA_LEN,
+    TOK_MOD_SPA_LEN,            TOK_MOD_TYPE,               TOK_MOD_FILE,
+    TOK_IO_DISK,                TOK_IO_UART,                TOK_IO_TIMER,
 
     //------------------------------------------------------------------------------------
     // Line Commands.
@@ -215,7 +218,12 @@ enum SimTokId : uint16_t {
     CMD_DA,                     CMD_MA,                     CMD_ITLB_I,
     CMD_ITLB_D,                 CMD_PTLB_I,                 CMD_PTLB_D,
     CMD_PCA_I,                  CMD_PCA_D,                  CMD_FCA_I,
-    CMD_FCA_D,
+    CMD_FCA_D,                  CMD_TRACE,                  CMD_IF,
+    CMD_ELSE,                   CMD_ENDIF,                  CMD_WHILE,
+    CMD_ENDWHILE,               CMD_LOOP,                   CMD_ENDLOOP,
+    CMD_BP,                     CMD_WP,                     CMD_BL,
+    CMD_BC,                     CMD_REC,                    CMD_REPLAY,
+    CMD_RS,
 
     //------------------------------------------------------------------------------------
     // Window Commands Tokens.
@@ -333,6 +341,7 @@ enum SimErrMsgId : int {
     
     ERR_FILE_NOT_FOUND              = 350,
     ERR_UNEXPECTED_EOS              = 351,
+    ERR_OPEN_TRACE_FILE             = 352,
     
     ERR_ENV_VAR_NOT_FOUND           = 400,
     ERR_ENV_VALUE_EXPR              = 401,
@@ -355,9 +364,21 @@ enum SimErrMsgId : int {
     ERR_WIN_TYPE_NOT_CONFIGURED     = 416,
     
     ERR_UNDEFINED_PFUNC             = 417,
+    ERR_CMD_FILE_ONLY               = 418,
+    ERR_CMD_FILE_STRUCTURE          = 419,
 
     ERR_NUMERIC_RANGE               = 420,
 
+    ERR_DEBUG_TABLE_FULL            = 421,
+    ERR_INVALID_WATCH_MODE          = 422,
+    ERR_DEBUG_ENTRY_NOT_FOUND       = 423,
+    ERR_COND_TOO_COMPLEX            = 424,
+
+    ERR_OPEN_REPLAY_FILE            = 425,
+    ERR_REPLAY_NOT_ACTIVE           = 426,
+    ERR_REPLAY_START_CYCLE          = 427,
+    ERR_REPLAY_CYCLE_RANGE          = 428,
+
     ERR_TLB_TYPE                    = 500,
     ERR_TLB_PURGE_OP                = 501,
     ERR_TLB_INSERT_OP               = 502,
@@ -377,6 +398,8 @@ enum SimErrMsgId : int {
 
     ERR_CREATE_PROC_MODULE          = 701,
     ERR_CREATE_MEM_MODULE           = 702,
+    ERR_CREATE_IO_MODULE            = 704,
+    ERR_NO_PROC_MODULE              = 705,
 
     ERR_INVALID_TLB_ACC_FLAG        = 800
 };
@@ -404,6 +427,24 @@ const char ENV_WORDS_PER_LINE [ ]       = "WORDS_PER_LINE";
 const char ENV_WIN_MIN_ROWS[ ]          = "WIN_MIN_ROWS";
 const char ENV_WIN_TEXT_LINE_WIDTH[ ]   = "WIN_TEXT_WIDTH";
 
+//----------------------------------------------------------------------------------------
+// Handles for the predefined environment variables that are read on each command or
+// each redraw. The handles are set up together with the predefined variables. Access
+// through a handle does not need a name lookup.
+//
+//----------------------------------------------------------------------------------------
+enum SimEnvHandle : int {
+
+    ENV_HDL_SHOW_CMD_CNT        = 0,
+    ENV_HDL_CMD_CNT             = 1,
+    ENV_HDL_ECHO_CMD_INPUT      = 2,
+    ENV_HDL_EXIT_CODE           = 3,
+    ENV_HDL_RDX_DEFAULT         = 4,
+    ENV_HDL_WIN_MIN_ROWS        = 5,
+    ENV_HDL_WIN_TEXT_LINE_WIDTH = 6,
+    ENV_HDL_MAX                 = 7
+};
+
 //----------------------------------------------------------------------------------------
 // Forward declaration of the globals structure. Every object will have access to 
 // the globals structure, so we do not have to pass around references to all the
@@ -432,7 +473,11 @@ enum SimCmdLineArgVal : int {
     CL_ARG_VAL_VERSION,
     CL_ARG_VAL_VERBOSE,        
     CL_ARG_VAL_CONFIG_FILE,      
-    CL_ARG_VAL_LOG_FILE
+    CL_ARG_VAL_LOG_FILE,
+    CL_ARG_VAL_BATCH,
+    CL_ARG_VAL_ELF_FILE,
+    CL_ARG_VAL_OUT_FILE,
+    CL_ARG_VAL_MAX_STEPS
 };
 
 struct SimCmdLineOptions {
@@ -502,7 +547,8 @@ struct SimTokenizer {
 
     SimTokenizer( );
 
-    void            setupTokenizer( char *lineBuf, SimToken *tokTab );
+    void            setupTokenizer( char *lineBuf );
+    void            setupTokenList( SimToken *tokList, int tokListLen );
     void            nextToken( );
     
     bool            isToken( SimTokId tokId );
@@ -534,8 +580,11 @@ struct SimTokenizer {
     protected:
 
     char            currentChar     = ' ';
-    SimToken        *tokTab         = nullptr;   
     SimToken        currentToken;
+
+    SimToken        *tokList        = nullptr;
+    int             tokListLen      = 0;
+    int             tokListIndex    = 0;
      
 };
 
@@ -550,7 +599,7 @@ struct SimTokenizerFromString : public SimTokenizer {
     public:
     
     SimTokenizerFromString( );
-    void setupTokenizer( char *lineBuf, SimToken *tokTab ); 
+    void setupTokenizer( char *lineBuf ); 
     
     private:
 
@@ -574,7 +623,7 @@ struct SimTokenizerFromFile : public SimTokenizer {
     SimTokenizerFromFile( );
     virtual ~SimTokenizerFromFile( );
 
-    void    setupTokenizer( char *filePath, SimToken *tokTab );
+    void    setupTokenizer( char *filePath );
     int     getCurrentLineIndex( );
     int     getCurrentCharPos( );
     
@@ -609,7 +658,10 @@ struct SimExpr {
 
 //----------------------------------------------------------------------------------------
 // The expression evaluator object. We use the "parseExpr" routine wherever we expect
-// an expression in the command line. The evaluator raises exceptions.
+// an expression in the command line. The evaluator raises exceptions. A condition, 
+// i.e. an expression with comparisons and logical operators, is either evaluated 
+// right away or compiled into a breakpoint condition, which the debug object 
+// evaluates when the breakpoint address is reached.
 //
 //----------------------------------------------------------------------------------------
 struct SimExprEvaluator {
@@ -619,16 +671,27 @@ struct SimExprEvaluator {
     SimExprEvaluator( SimGlobals *glb, SimTokenizer *tok );
     
     void            setTokenizer( SimTokenizer *tok );
+    void            parseCond( SimExpr *rExpr );
     void            parseExpr( SimExpr *rExpr );
     T64Word         acceptNumExpr( SimErrMsgId errCode, 
                                    T64Word low = INT64_MIN, 
                                    T64Word high = INT64_MAX );
+
+    void            compileCond( T64StopCond *cond );
     
     private:
     
+    void            parseAndCond( SimExpr *rExpr );
+    void            parseRelExpr( SimExpr *rExpr );
     void            parseTerm( SimExpr *rExpr );
     void            parseFactor( SimExpr *rExpr );
 
+    void            compileAndCond( T64StopCond *cond );
+    void            compileRelExpr( T64StopCond *cond );
+    void            compileExpr( T64StopCond *cond );
+    void            compileTerm( T64StopCond *cond );
+    void            compileFactor( T64StopCond *cond );
+
     void            parsePredefinedFunction( SimToken funcId, SimExpr *rExpr );    
     void            pFuncAssemble( SimExpr *rExpr );
     void            pFuncDisAssemble( SimExpr *rExpr );
@@ -650,6 +713,7 @@ struct SimExprEvaluator {
 struct SimEnvTabEntry {
     
     char            name[ MAX_ENV_NAME_SIZE ]   = { 0 };
+    uint32_t        hash                        = 0;
     bool            valid                       = false;
     bool            predefined                  = false;
     bool            readOnly                    = false;
@@ -667,7 +731,8 @@ struct SimEnvTabEntry {
 //----------------------------------------------------------------------------------------
 // Environment variables. The simulator has a global table where all variables are 
 // kept. It is a simple array with a high water mark concept. The table will be 
-// allocated at simulator start.
+// allocated at simulator start. Variables are found through an open addressing hash
+// table of table indexes, keyed by the variable name hash value.
 //
 //----------------------------------------------------------------------------------------
 struct SimEnv {
@@ -681,11 +746,14 @@ struct SimEnv {
     void            setEnvVar( char *name, T64Word val );
     void            setEnvVar( char *name, bool val );
     void            setEnvVar( char *name, char *str );
+    void            setEnvVar( SimEnvHandle hdl, T64Word val );
     void            removeEnvVar( char *name );
     
     bool            getEnvVarBool( char *name,bool def = false );
     T64Word         getEnvVarInt( char *name, T64Word def = 0 );
     char            *getEnvVarStr( char *name, char *def = nullptr );
+    bool            getEnvVarBool( SimEnvHandle hdl );
+    T64Word         getEnvVarInt( SimEnvHandle hdl );
     SimEnvTabEntry  *getEnvEntry( char *name );
     SimEnvTabEntry  *getEnvEntry( int index );
 
@@ -701,26 +769,35 @@ struct SimEnv {
     
     int             lookupEntry( char *name );
     int             findFreeEntry( );
+    void            hashInsert( int index );
+    void            hashRebuild( );
+    
+    SimEnvTabEntry  *enterVar( char *name, 
+                               T64Word val, 
+                               bool predefined = false, 
+                               bool rOnly = false );
+
+    SimEnvTabEntry  *enterVar( char *name, 
+                               bool val, 
+                               bool predefined = false, 
+                               bool rOnly = false );
+
+    SimEnvTabEntry  *enterVar( char *name, 
+                               char *str, 
+                               bool predefined = false, 
+                               bool rOnly = false );
+   
+    SimEnvTabEntry  *table      = nullptr;
+    SimEnvTabEntry  *hwm        = nullptr;
+    SimEnvTabEntry  *limit      = nullptr;
+    int             freeCnt     = 0;
     
-    void            enterVar( char *name, 
-                              T64Word val, 
-                              bool predefined = false, 
-                              bool rOnly = false );
+    int             *hashTab    = nullptr;
+    int             hashMask    = 0;
+    int             hashDelCnt  = 0;
 
-    void            enterVar( char *name, 
-                              bool val, 
-                              bool predefined = false, 
-                              bool rOnly = false );
-
-    void            enterVar( char *name, 
-                              char *str, 
-                              bool predefined = false, 
-                              bool rOnly = false );
-   
-    SimEnvTabEntry  *table  = nullptr;
-    SimEnvTabEntry  *hwm    = nullptr;
-    SimEnvTabEntry  *limit  = nullptr;
-    SimGlobals      *glb    = nullptr;
+    SimEnvTabEntry  *handles[ ENV_HDL_MAX ] = { nullptr };
+    SimGlobals      *glb        = nullptr;
 };
 
 //----------------------------------------------------------------------------------------
@@ -757,6 +834,85 @@ struct SimCmdHistory {
     SimCmdHistEntry history[ MAX_CMD_HIST ];
 };
 
+//----------------------------------------------------------------------------------------
+// Compiled command files. A command file executed with the XF command is compiled 
+// once into a list of operations, one for each source line. A command line is kept 
+// as its command Id and the scanned tokens of its arguments. Running the file again
+// will therefore neither read characters nor look up reserved words. A line that 
+// does not scan is kept as text and passed to the command line interpreter at run
+// time, which reports the error just like before. Command files also offer the IF, 
+// ELSE, ENDIF, WHILE, ENDWHILE, LOOP and ENDLOOP control lines. They are compiled 
+// into conditional and unconditional jumps. The compiled files are kept in a small 
+// cache, keyed by a hash of the file content.
+//
+//----------------------------------------------------------------------------------------
+const int MAX_CMD_FILE_CACHE        = 8;
+const int MAX_CMD_FILE_NESTING      = 16;
+
+enum SimCmdFileOpId : int {
+
+    CF_OP_NOP           = 0,
+    CF_OP_CMD           = 1,
+    CF_OP_LINE          = 2,
+    CF_OP_JUMP          = 3,
+    CF_OP_JUMP_FALSE    = 4,
+    CF_OP_LOOP          = 5,
+    CF_OP_END_LOOP      = 6
+};
+
+struct SimCmdFileOp {
+
+    SimCmdFileOpId  op;
+    SimTokId        cmdId;
+    int             srcLineOfs;
+    int             cmdLineOfs;
+    int             tokIndex;
+    int             tokCount;
+    int             target;
+};
+
+struct SimCmdFile {
+
+    uint64_t        hash        = 0;
+    size_t          srcSize     = 0;
+    char            *src        = nullptr;
+    char            *text       = nullptr;
+    SimCmdFileOp    *ops        = nullptr;
+    int             opCount     = 0;
+    SimToken        *toks       = nullptr;
+    int             tokCount    = 0;
+    char            *strPool    = nullptr;
+    int             useCount    = 0;
+    uint64_t        lastUse     = 0;
+    bool            cached      = false;
+};
+
+struct SimCmdFileCache {
+
+    public:
+
+    SimCmdFileCache( );
+    ~SimCmdFileCache( );
+
+    SimCmdFile      *getCmdFile( char *fileName, int *errLine );
+    void            releaseCmdFile( SimCmdFile *cmdFile );
+
+    private:
+
+    SimCmdFile      *compile( char *src, size_t srcSize, int *errLine );
+    void            freeCmdFile( SimCmdFile *cmdFile );
+
+    SimCmdFile      *entries[ MAX_CMD_FILE_CACHE ] = { nullptr };
+    uint64_t        useClock    = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// Remove the comment part of a command line. Used by the command line input and the
+// command file compiler.
+//
+//----------------------------------------------------------------------------------------
+int removeComment( char *cmdBuf );
+
 //----------------------------------------------------------------------------------------
 // Command and Console Window output buffer. The output buffer will store all output
 // from the command window to support scrolling. This is the price you pay when normal
@@ -1106,7 +1262,9 @@ struct SimWinCache : SimWinScrollable {
 //----------------------------------------------------------------------------------------
 // Text Window. It may be handy to also display an ordinary ASCII text file. One day
 // this will allow us to display for example the source code to a running program 
-// when symbolic debugging is supported.
+// when symbolic debugging is supported. The file is mapped into memory and a line
+// offset index is built in chunks as we go, so that any line is found directly. When
+// the file grows, the window picks up the new lines, which allows to tail log files.
 //
 //----------------------------------------------------------------------------------------
 struct SimWinText : SimWinScrollable {
@@ -1123,11 +1281,20 @@ struct SimWinText : SimWinScrollable {
     private:
 
     bool    openTextFile( );
-    int     readTextFileLine( int linePos, char *lineBuf, int bufLen );
-    
-    FILE    *textFile          = nullptr;
-    int     fileSizeLines      = 0;
-    int     lastLinePos        = 0;
+    void    closeTextFile( );
+    bool    mapTextFile( );
+    void    updateTextFile( );
+    void    indexTextFile( T64Word lineLimit, size_t byteLimit );
+    int     readTextFileLine( T64Word linePos, char *lineBuf, int bufLen );
+    T64Word getTextFileLines( );
+    
+    int     textFile           = -1;
+    char    *fileData          = nullptr;
+    size_t  fileDataSize       = 0;
+    size_t  *lineStart         = nullptr;
+    T64Word lineStartCnt       = 0;
+    T64Word lineStartMax       = 0;
+    size_t  scanPos            = 0;
     char    fileName[ MAX_FILE_PATH_SIZE ] = { 0 };
 };
 
@@ -1208,6 +1375,9 @@ private:
     void            loadElfFile( char *fileName );
     void            writeLineCmd( );
     void            execCmdsFromFile( char* fileName );
+    void            runCmdFile( SimCmdFile *cmdFile );
+    T64Word         evalCmdFileExpr( SimCmdFile *cmdFile, SimCmdFileOp *op );
+    void            evalCmd( char *cmdBuf );
     
     void            histCmd( );
     void            doCmd( );
@@ -1227,6 +1397,15 @@ private:
     void            resetCmd( );
     void            runCmd( );
     void            stepCmd( );
+    void            traceCmd( );
+    void            recordCmd( );
+    void            replayCmd( );
+    void            reverseStepCmd( );
+
+    void            setBreakpointCmd( char *cmdBuf );
+    void            setWatchpointCmd( );
+    void            listStopPointsCmd( );
+    void            clearStopPointsCmd( );
    
     void            modifyRegCmd( );
     
@@ -1269,6 +1448,7 @@ private:
     SimCmdHistory           *hist       = nullptr;
     SimTokenizerFromString  *tok        = nullptr;
     SimExprEvaluator        *eval       = nullptr;
+    SimCmdFileCache         *cmdFiles   = nullptr;
     SimWinOutBuffer         *winOut     = nullptr;
     T64Assemble             *inlineAsm  = nullptr;
     T64DisAssemble          *disAsm     = nullptr;   
@@ -1384,10 +1564,18 @@ struct SimGlobals {
     SimEnv              *env            = nullptr;
     SimWinDisplay       *winDisplay     = nullptr;
     T64System           *system         = nullptr;
+    T64TraceWriter      *trace          = nullptr;
+    T64Debug            *debug          = nullptr;
+    T64Replay           *replay         = nullptr;
 
     bool                verboseFlag                             = false;
+    bool                batchFlag                               = false;
+    T64Word             batchMaxSteps                           = 0;
     char                configFileName[ MAX_FILE_PATH_SIZE ]    = { 0 };
     char                logFileName[ MAX_FILE_PATH_SIZE ]       = { 0 };
+    char                elfFileName[ MAX_FILE_PATH_SIZE ]       = { 0 };
+    char                outFileName[ MAX_FILE_PATH_SIZE ]       = { 0 };
+    char                recFileName[ MAX_FILE_PATH_SIZE ]       = { 0 };
 };
 
 //----------------------------------------------------------------------------------------
@@ -1395,3 +1583,33 @@ struct SimGlobals {
 //
 //----------------------------------------------------------------------------------------
 void processCmdLineOptions( SimGlobals *glb, int argc, char *argv[ ] );
+
+//----------------------------------------------------------------------------------------
+// Build the system modules from a configuration file. Errors are reported on the
+// standard error channel and a false is returned.
+//
+//----------------------------------------------------------------------------------------
+bool setupSystemFromConfigFile( SimGlobals *glb, const char *fileName );
+
+//----------------------------------------------------------------------------------------
+// The ELF file loader. The file segments are loaded into physical memory and the
+// entry address is returned. Errors are thrown. The output buffer is optional.
+//
+//----------------------------------------------------------------------------------------
+T64Word loadElfFileIntoMemory( T64System *sys, char *fileName, SimWinOutBuffer *winOut );
+
+//----------------------------------------------------------------------------------------
+// The batch mode entry. The simulator runs without the window display and returns
+// the program exit code.
+//
+//----------------------------------------------------------------------------------------
+int runBatch( SimGlobals *glb );
+
+//----------------------------------------------------------------------------------------
+// Module helpers shared by the batch mode and the RUN command. A processor is 
+// considered halted when it branches to itself.
+//
+//----------------------------------------------------------------------------------------
+int  getProcessorModules( T64System *sys, T64Processor **procs );
+int  getUartModules( T64System *sys, T64Uart **uarts );
+bool allProcessorsHalted( T64System *sys, T64Processor **procs, int numProcs );
@@ -4,7 +4,9 @@
 //
 //----------------------------------------------------------------------------------------
 // The simulator environment has a set of environment variables. They are simple
-// "name = value" pairs for integers, booleans and strings.
+// "name = value" pairs for integers, booleans and strings. The variables are kept 
+// in a table and found through a hash table. Frequently read predefined variables 
+// can also be accessed through a handle.
 //
 //----------------------------------------------------------------------------------------
 //
@@ -26,11 +28,36 @@
 
 //----------------------------------------------------------------------------------------
 // Local name space. We try to keep utility functions local to the file.  
-// None so far.
 //
 //----------------------------------------------------------------------------------------
 namespace {
 
+//----------------------------------------------------------------------------------------
+// Hash table slot values. A slot is either empty, deleted or contains the index of 
+// the variable in the table. Deleted slots keep a probe sequence intact. The hash 
+// table has at least twice the number of table entries, rounded up to a power of 2.
+//
+//----------------------------------------------------------------------------------------
+const int ENV_HASH_EMPTY    = -1;
+const int ENV_HASH_DELETED  = -2;
+
+//----------------------------------------------------------------------------------------
+// The variable name hash function. We use the FNV-1a hash.
+//
+//----------------------------------------------------------------------------------------
+uint32_t hashEnvName( const char *name ) {
+
+    uint32_t hash = 2166136261u;
+
+    while ( *name != '\0' ) {
+
+        hash ^= (uint8_t) *name++;
+        hash *= 16777619u;
+    }
+
+    return( hash );
+}
+
 }; // namespace
 
 
@@ -54,15 +81,24 @@ namespace {
 
 //----------------------------------------------------------------------------------------
 // The ENV variable object. The table is dynamically allocated, the HWM and limit 
-// pointer are used to manage the search, add and remove functions.
+// pointer are used to manage the add and remove functions. The hash table is 
+// allocated along with the table.
 //
 //----------------------------------------------------------------------------------------
 SimEnv::SimEnv( SimGlobals *glb, int size ) {
    
+    int hashSize = 1;
+    
+    while ( hashSize < 2 * size ) hashSize <<= 1;
+
     table       = (SimEnvTabEntry *) calloc( size, sizeof( SimEnvTabEntry ));
     hwm         = table;
     limit       = &table[ size ];
+    hashTab     = (int *) malloc( hashSize * sizeof( int ));
+    hashMask    = hashSize - 1;
     this -> glb = glb;
+
+    for ( int i = 0; i < hashSize; i++ ) hashTab[ i ] = ENV_HASH_EMPTY;
 }
 
 //----------------------------------------------------------------------------------------
@@ -112,44 +148,89 @@ int SimEnv::getEnvHwm( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Look a variable. We just do a linear search up to the HWM. If not found, a -1 is 
-// returned. Straightforward.
+// Look up a variable. We hash the name and probe the hash table linearly until we 
+// find the entry or an empty slot. The name is only compared when the hash values 
+// match. If not found, a -1 is returned.
 //
 //----------------------------------------------------------------------------------------
 int SimEnv::lookupEntry( char *name ) {
     
-    SimEnvTabEntry *entry = table;
+    uint32_t hash = hashEnvName( name );
+    int      slot = hash & hashMask;
     
-    while ( entry < hwm ) {
-        
-        if (( entry -> valid ) && ( strcmp( entry -> name, name ) == 0 )) 
-            return((int) ( entry - table ));
-        else entry ++;
+    for ( int i = 0; i <= hashMask; i++ ) {
+
+        int index = hashTab[ slot ];
+
+        if ( index == ENV_HASH_EMPTY ) break;
+
+        if (( index >= 0 ) && 
+            ( table[ index ].hash == hash ) && 
+            ( strcmp( table[ index ].name, name ) == 0 )) return( index );
+
+        slot = ( slot + 1 ) & hashMask;
     }
     
     return( -1 );
 }
 
 //----------------------------------------------------------------------------------------
-// Find a free slot for a variable. First we look for a free entry in the range up to 
-// the HWM. If there is none, we try to increase the HWM. If all fails, the table is
-// full.
+// Enter a table entry into the hash table. The first empty or deleted slot in the 
+// probe sequence is used. There is always one, the hash table is larger than the 
+// variable table.
+//
+//----------------------------------------------------------------------------------------
+void SimEnv::hashInsert( int index ) {
+
+    int slot = table[ index ].hash & hashMask;
+
+    while ( hashTab[ slot ] >= 0 ) slot = ( slot + 1 ) & hashMask;
+
+    if ( hashTab[ slot ] == ENV_HASH_DELETED ) hashDelCnt --;
+    hashTab[ slot ] = index;
+}
+
+//----------------------------------------------------------------------------------------
+// Removed variables leave deleted slots in the hash table, which make the probe 
+// sequences longer. Once there are too many of them, the hash table is built anew 
+// from the valid table entries.
+//
+//----------------------------------------------------------------------------------------
+void SimEnv::hashRebuild( ) {
+
+    for ( int i = 0; i <= hashMask; i++ ) hashTab[ i ] = ENV_HASH_EMPTY;
+    hashDelCnt = 0;
+
+    for ( SimEnvTabEntry *entry = table; entry < hwm; entry++ ) {
+
+        if ( entry -> valid ) hashInsert((int) ( entry - table ));
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Find a free slot for a variable. If there are free entries below the HWM, we look
+// for one of them. If there is none, we try to increase the HWM. If all fails, the 
+// table is full.
 //
 //----------------------------------------------------------------------------------------
 int SimEnv::findFreeEntry( ) {
     
-    SimEnvTabEntry *entry = table;
-    
-    while ( entry < hwm ) {
+    if ( freeCnt > 0 ) {
+
+        for ( SimEnvTabEntry *entry = table; entry < hwm; entry++ ) {
         
-        if ( ! entry -> valid ) return((int) ( entry - table ));
-        else entry ++;
+            if ( ! entry -> valid ) {
+
+                freeCnt --;
+                return((int) ( entry - table ));
+            }
+        }
     }
     
     if ( hwm < limit ) {
         
         hwm ++;
-        return((int) ( entry - table ));
+        return((int) ( hwm - table - 1 ));
     }
     else throw( ERR_ENV_TABLE_FULL );
 }
@@ -195,7 +276,7 @@ void SimEnv::setEnvVar( char *name, bool val )  {
         
         SimEnvTabEntry *ptr = &table[ index ];
         
-        if (( ptr -> predefined ) && ( ptr -> typ != TYP_NUM )) {
+        if (( ptr -> predefined ) && ( ptr -> typ != TYP_BOOL )) {
             
             throw ( ERR_ENV_VALUE_EXPR );
         }
@@ -236,6 +317,16 @@ void SimEnv::setEnvVar( char *name, char *str )  {
     else enterVar( name, str );
 }
 
+//----------------------------------------------------------------------------------------
+// Set a predefined numeric variable through its handle. The type of a predefined 
+// variable cannot change, so we just store the value.
+//
+//----------------------------------------------------------------------------------------
+void SimEnv::setEnvVar( SimEnvHandle hdl, T64Word val ) {
+
+    handles[ hdl ] -> u.iVal = val;
+}
+
 //----------------------------------------------------------------------------------------
 // Environment variables getter functions. Just look up the entry and return the value.
 // If the entry does not exist, we return an optional default.
@@ -265,72 +356,82 @@ char *SimEnv::getEnvVarStr( char *name, char *def ) {
     else                return (def );
 }
 
+bool SimEnv::getEnvVarBool( SimEnvHandle hdl ) {
+
+    return( handles[ hdl ] -> u.bVal );
+}
+
+T64Word SimEnv::getEnvVarInt( SimEnvHandle hdl ) {
+
+    return( handles[ hdl ] -> u.iVal );
+}
+
 //----------------------------------------------------------------------------------------
 // A set of helper function to enter a variable. The variable can be a user or predefined
 // one. If it is a predefined variable, the readonly flag marks the variable read only 
-// for the ENV command.
+// for the ENV command. The new entry is added to the hash table and returned.
 //
 //----------------------------------------------------------------------------------------
-void SimEnv::enterVar( char *name, T64Word  val, bool predefined, bool rOnly ) {
+SimEnvTabEntry *SimEnv::enterVar( char *name, T64Word  val, bool predefined, bool rOnly ) {
     
     int index = findFreeEntry( );
     
-    if ( index >= 0 ) {
-    
-        SimEnvTabEntry tmp;
-        strcpy ( tmp.name, name );
-        tmp.typ         = TYP_NUM;
-        tmp.valid       = true;
-        tmp.predefined  = predefined;
-        tmp.readOnly    = rOnly;
-        tmp.u.iVal      = val;
-        table[ index ]  = tmp;
-    }
-    else throw( ERR_ENV_TABLE_FULL );
+    SimEnvTabEntry tmp;
+    strcpy ( tmp.name, name );
+    tmp.hash        = hashEnvName( name );
+    tmp.typ         = TYP_NUM;
+    tmp.valid       = true;
+    tmp.predefined  = predefined;
+    tmp.readOnly    = rOnly;
+    tmp.u.iVal      = val;
+    table[ index ]  = tmp;
+
+    hashInsert( index );
+    return( &table[ index ] );
 }
 
-void SimEnv::enterVar( char *name, bool val, bool predefined, bool rOnly ) {
+SimEnvTabEntry *SimEnv::enterVar( char *name, bool val, bool predefined, bool rOnly ) {
     
     int index = findFreeEntry( );
     
-    if ( index >= 0 ) {
-    
-        SimEnvTabEntry tmp;
-        strcpy ( tmp.name, name );
-        tmp.typ         = TYP_BOOL;
-        tmp.valid       = true;
-        tmp.predefined  = predefined;
-        tmp.readOnly    = rOnly;
-        tmp.u.bVal      = val;
-        table[ index ]  = tmp;
-    }
-    else throw( ERR_ENV_TABLE_FULL );
+    SimEnvTabEntry tmp;
+    strcpy ( tmp.name, name );
+    tmp.hash        = hashEnvName( name );
+    tmp.typ         = TYP_BOOL;
+    tmp.valid       = true;
+    tmp.predefined  = predefined;
+    tmp.readOnly    = rOnly;
+    tmp.u.bVal      = val;
+    table[ index ]  = tmp;
+
+    hashInsert( index );
+    return( &table[ index ] );
 }
 
-void SimEnv::enterVar( char *name, char *str, bool predefined, bool rOnly ) {
+SimEnvTabEntry *SimEnv::enterVar( char *name, char *str, bool predefined, bool rOnly ) {
     
     int index = findFreeEntry( );
-    
-    if ( index >= 0 ) {
         
-        SimEnvTabEntry tmp;
-        strcpy ( tmp.name, name );
-        tmp.valid       = true;
-        tmp.typ         = TYP_STR;
-        tmp.predefined  = predefined;
-        tmp.readOnly    = rOnly;
-        tmp.u.strVal    = (char *) calloc( strlen( str ), sizeof( char ));
-        strcpy( tmp.u.strVal, str );
-        table[ index ]  = tmp;
-    }
-    else throw( ERR_ENV_TABLE_FULL );
+    SimEnvTabEntry tmp;
+    strcpy ( tmp.name, name );
+    tmp.hash        = hashEnvName( name );
+    tmp.valid       = true;
+    tmp.typ         = TYP_STR;
+    tmp.predefined  = predefined;
+    tmp.readOnly    = rOnly;
+    tmp.u.strVal    = (char *) calloc( strlen( str ) + 1, sizeof( char ));
+    strcpy( tmp.u.strVal, str );
+    table[ index ]  = tmp;
+
+    hashInsert( index );
+    return( &table[ index ] );
 }
 
 //----------------------------------------------------------------------------------------
 // Remove a user defined ENV variable. If the ENV variable is predefined it is an 
 // error. If the ENV variable type is a string, free the string space. The entry 
-// is marked invalid, i.e. free. Finally, if the entry was at the high water mark, 
-// adjust the HWM.
+// is marked invalid, i.e. free, and its hash table slot is marked deleted. Finally, 
+// if the entry was at the high water mark, adjust the HWM.
 //
 //----------------------------------------------------------------------------------------
 void SimEnv::removeEnvVar( char *name ) {
@@ -348,11 +449,25 @@ void SimEnv::removeEnvVar( char *name ) {
     
     ptr -> valid    = false;
     ptr -> typ      = TYP_NIL;
+    freeCnt ++;
+
+    for ( int slot = ptr -> hash & hashMask; ; slot = ( slot + 1 ) & hashMask ) {
+
+        if ( hashTab[ slot ] == index ) {
+
+            hashTab[ slot ] = ENV_HASH_DELETED;
+            hashDelCnt ++;
+            break;
+        }
+    }
     
-    if ( ptr == hwm - 1 ) {
+    while (( hwm > table ) && ( ! ( hwm - 1 ) -> valid )) {
         
-        while (( ptr >= table ) && ( ptr -> valid )) hwm --;
+        hwm --;
+        freeCnt --;
     } 
+
+    if ( hashDelCnt > ( hashMask + 1 ) / 4 ) hashRebuild( );
 }
 
 //----------------------------------------------------------------------------------------
@@ -417,7 +532,8 @@ int SimEnv::formatEnvEntry( int index, char *buf, int bufLen ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Enter the predefined entries.
+// Enter the predefined entries. Predefined variables are never removed and the table
+// is never moved, so the handles stay valid for the lifetime of the object.
 //
 //----------------------------------------------------------------------------------------
 void SimEnv::setupPredefined( ) {
@@ -429,14 +545,21 @@ void SimEnv::setupPredefined( ) {
     enterVar((char *) ENV_GIT_BRANCH, (char *) SIM_GIT_BRANCH, true, false );
     enterVar((char *) ENV_PATCH_LEVEL, (T64Word) SIM_PATCH_LEVEL, true, false );
     
-    enterVar((char *) ENV_SHOW_CMD_CNT, true, true, false );
-    enterVar((char *) ENV_CMD_CNT, (T64Word) 0, true, true );
-    enterVar((char *) ENV_ECHO_CMD_INPUT, false, true, false );
-    enterVar((char *) ENV_EXIT_CODE, (T64Word) 0, true, false );
-    
-    enterVar((char *) ENV_RDX_DEFAULT, (T64Word) 16, true, false );
+    handles[ ENV_HDL_SHOW_CMD_CNT ] = 
+        enterVar((char *) ENV_SHOW_CMD_CNT, true, true, false );
+    handles[ ENV_HDL_CMD_CNT ] = 
+        enterVar((char *) ENV_CMD_CNT, (T64Word) 0, true, true );
+    handles[ ENV_HDL_ECHO_CMD_INPUT ] = 
+        enterVar((char *) ENV_ECHO_CMD_INPUT, false, true, false );
+    handles[ ENV_HDL_EXIT_CODE ] = 
+        enterVar((char *) ENV_EXIT_CODE, (T64Word) 0, true, false );
+    
+    handles[ ENV_HDL_RDX_DEFAULT ] = 
+        enterVar((char *) ENV_RDX_DEFAULT, (T64Word) 16, true, false );
     enterVar((char *) ENV_WORDS_PER_LINE, (T64Word) 8, true, false );
     
-    enterVar((char *) ENV_WIN_MIN_ROWS, (T64Word) 24, true, false );
-    enterVar((char *) ENV_WIN_TEXT_LINE_WIDTH, (T64Word) 90, true, false );
+    handles[ ENV_HDL_WIN_MIN_ROWS ] = 
+        enterVar((char *) ENV_WIN_MIN_ROWS, (T64Word) 24, true, false );
+    handles[ ENV_HDL_WIN_TEXT_LINE_WIDTH ] = 
+        enterVar((char *) ENV_WIN_TEXT_LINE_WIDTH, (T64Word) 90, true, false );
 }
@@ -50,6 +50,17 @@
 //      <expr>      ->  [ ( "+" | "-" ) ] <term> { <exprOp> <term> }
 //      <exprOp>    ->  "+" | "-" | "|" | "^"
 //
+//      <relExpr>   ->  <expr> [ <relOp> <expr> ]
+//      <relOp>     ->  "==" | "!=" | "<" | ">" | "<=" | ">="
+//
+//      <andCond>   ->  <relExpr> { "&&" <relExpr> }
+//      <cond>      ->  <andCond> { "||" <andCond> }
+//
+// A parenthesized factor is a condition. Without any comparison or logical operator,
+// a condition is just the expression. A condition can also be compiled into a small
+// program, which evaluates the condition later without parsing it again. This is 
+// used for breakpoint conditions.
+//
 // If a command is called, there is no output other than what the command was issuing.
 // If a function is called in the command place, the function result will be printed. 
 // If an argument represents a function, its return value will be the argument in the
@@ -270,6 +281,109 @@ void logicalOp( SimExpr *rExpr, SimExpr *lExpr, logicalOpId op ) {
     }
 }
 
+//----------------------------------------------------------------------------------------
+// Comparison operation. Numbers are compared as signed values, booleans can only be
+// compared for equality. The result is a boolean.
+//
+//----------------------------------------------------------------------------------------
+void relOp( SimExpr *rExpr, SimExpr *lExpr, SimTokId op ) {
+
+    bool res = false;
+
+    if (( rExpr -> typ == TYP_NUM ) && ( lExpr -> typ == TYP_NUM )) {
+
+        T64Word l = rExpr -> u.val;
+        T64Word r = lExpr -> u.val;
+
+        switch ( op ) {
+
+            case TOK_EQ:    res = ( l == r );   break;
+            case TOK_NE:    res = ( l != r );   break;
+            case TOK_LT:    res = ( l < r );    break;
+            case TOK_GT:    res = ( l > r );    break;
+            case TOK_LE:    res = ( l <= r );   break;
+            case TOK_GE:    res = ( l >= r );   break;
+            default: ;
+        }
+    }
+    else if (( rExpr -> typ == TYP_BOOL ) && ( lExpr -> typ == TYP_BOOL )) {
+
+        if      ( op == TOK_EQ ) res = ( rExpr -> u.bVal == lExpr -> u.bVal );
+        else if ( op == TOK_NE ) res = ( rExpr -> u.bVal != lExpr -> u.bVal );
+        else throw ( ERR_EXPR_TYPE_MATCH );
+    }
+    else throw ( ERR_EXPR_TYPE_MATCH );
+
+    rExpr -> typ    = TYP_BOOL;
+    rExpr -> u.bVal = res;
+}
+
+//----------------------------------------------------------------------------------------
+// Logical "&&" and "||" operation. A number is true when not zero. The result is a 
+// boolean.
+//
+//----------------------------------------------------------------------------------------
+bool isTrue( SimExpr *expr ) {
+
+    if      ( expr -> typ == TYP_BOOL ) return( expr -> u.bVal );
+    else if ( expr -> typ == TYP_NUM  ) return( expr -> u.val != 0 );
+    else throw ( ERR_EXPR_TYPE_MATCH );
+}
+
+void condOp( SimExpr *rExpr, SimExpr *lExpr, SimTokId op ) {
+
+    bool l = isTrue( rExpr );
+    bool r = isTrue( lExpr );
+
+    rExpr -> typ    = TYP_BOOL;
+    rExpr -> u.bVal = ( op == TOK_LOG_AND ) ? ( l && r ) : ( l || r );
+}
+
+//----------------------------------------------------------------------------------------
+// Condition compiler helpers. The stop condition refuses an operation when the program
+// or the evaluation stack would become too large. For the operators, we map the token
+// to the operation code.
+//
+//----------------------------------------------------------------------------------------
+void emitOp( T64StopCond *cond, 
+             T64CondOpCode opCode, 
+             T64Word val = 0, 
+             int modNum = -1, 
+             int regNum = 0 ) {
+
+    if ( ! cond -> addOp( opCode, val, modNum, regNum )) throw ( ERR_COND_TOO_COMPLEX );
+}
+
+T64CondOpCode condOpCode( SimTokId op ) {
+
+    switch ( op ) {
+
+        case TOK_PLUS:      return( T64_COP_ADD );
+        case TOK_MINUS:     return( T64_COP_SUB );
+        case TOK_MULT:      return( T64_COP_MUL );
+        case TOK_DIV:       return( T64_COP_DIV );
+        case TOK_MOD:       return( T64_COP_MOD );
+        case TOK_AND:       return( T64_COP_AND );
+        case TOK_OR:        return( T64_COP_OR );
+        case TOK_XOR:       return( T64_COP_XOR );
+        case TOK_EQ:        return( T64_COP_EQ );
+        case TOK_NE:        return( T64_COP_NE );
+        case TOK_LT:        return( T64_COP_LT );
+        case TOK_GT:        return( T64_COP_GT );
+        case TOK_LE:        return( T64_COP_LE );
+        case TOK_GE:        return( T64_COP_GE );
+        case TOK_LOG_AND:   return( T64_COP_LOG_AND );
+        case TOK_LOG_OR:    return( T64_COP_LOG_OR );
+        default:            return( T64_COP_NIL );
+    }
+}
+
+bool isRelOp( SimTokId op ) {
+
+    return(( op == TOK_EQ ) || ( op == TOK_NE ) || ( op == TOK_LT ) || 
+           ( op == TOK_GT ) || ( op == TOK_LE ) || ( op == TOK_GE ));
+}
+
 }; // namespace
 
 
@@ -295,7 +409,7 @@ SimExprEvaluator::SimExprEvaluator( SimGlobals *glb, SimTokenizer *tok ) {
 //                  <gRegId>    [ ":" <proc> ]      |
 //                  <cRegId>    [ ":" <proc> ]      |
 //                  "~" <factor>                    |
-//                  "(" <expr> ")"
+//                  "(" <cond> ")"
 //
 //----------------------------------------------------------------------------------------
 void SimExprEvaluator::parseFactor( SimExpr *rExpr ) {
@@ -375,7 +489,7 @@ void SimExprEvaluator::parseFactor( SimExpr *rExpr ) {
     else if ( tok -> isToken( TOK_LPAREN )) {
         
         tok -> nextToken( );
-        parseExpr( rExpr );
+        parseCond( rExpr );
             
         if ( tok -> isToken( TOK_RPAREN )) tok -> nextToken( );
         else throw ( ERR_EXPECTED_RPAREN );
@@ -497,6 +611,65 @@ void SimExprEvaluator::parseExpr( SimExpr *rExpr ) {
     }
 }
 
+//----------------------------------------------------------------------------------------
+// "parseCond" parses the condition syntax. The logical operators have a lower 
+// precedence than the comparisons, "&&" binds stronger than "||". 
+//
+//      <cond>      ->  <andCond> { "||" <andCond> }
+//      <andCond>   ->  <relExpr> { "&&" <relExpr> }
+//      <relExpr>   ->  <expr> [ <relOp> <expr> ]
+//
+//----------------------------------------------------------------------------------------
+void SimExprEvaluator::parseCond( SimExpr *rExpr ) {
+
+    SimExpr lExpr;
+
+    parseAndCond( rExpr );
+
+    while ( tok -> isToken( TOK_LOG_OR )) {
+
+        tok -> nextToken( );
+        parseAndCond( &lExpr );
+
+        if ( lExpr.typ == TYP_NIL ) throw ( ERR_UNEXPECTED_EOS );
+        condOp( rExpr, &lExpr, TOK_LOG_OR );
+    }
+}
+
+void SimExprEvaluator::parseAndCond( SimExpr *rExpr ) {
+
+    SimExpr lExpr;
+
+    parseRelExpr( rExpr );
+
+    while ( tok -> isToken( TOK_LOG_AND )) {
+
+        tok -> nextToken( );
+        parseRelExpr( &lExpr );
+
+        if ( lExpr.typ == TYP_NIL ) throw ( ERR_UNEXPECTED_EOS );
+        condOp( rExpr, &lExpr, TOK_LOG_AND );
+    }
+}
+
+void SimExprEvaluator::parseRelExpr( SimExpr *rExpr ) {
+
+    SimExpr lExpr;
+
+    parseExpr( rExpr );
+
+    if ( isRelOp( tok -> tokId( ))) {
+
+        SimTokId op = tok -> tokId( );
+
+        tok -> nextToken( );
+        parseExpr( &lExpr );
+
+        if ( lExpr.typ == TYP_NIL ) throw ( ERR_UNEXPECTED_EOS );
+        relOp( rExpr, &lExpr, op );
+    }
+}
+
 //----------------------------------------------------------------------------------------
 // We often expect a numeric value. A little helper function.
 //
@@ -513,3 +686,159 @@ T64Word SimExprEvaluator::acceptNumExpr( SimErrMsgId errCode, T64Word low, T64Wo
      }
      else throw ( errCode );
 }
+
+//----------------------------------------------------------------------------------------
+// "compileCond" translates a condition into a stop condition program. The syntax is
+// the same as for "parseCond", the routines mirror the parsing routines. Instead of 
+// computing a value, each routine appends the operations that compute the value to 
+// the program in postfix order. Numbers and environment variables are constants, 
+// their value is taken when the condition is compiled. A register without a module
+// number refers to the processor that reaches the breakpoint. Strings and predefined
+// functions are not allowed in a condition.
+//
+//----------------------------------------------------------------------------------------
+void SimExprEvaluator::compileCond( T64StopCond *cond ) {
+
+    compileAndCond( cond );
+
+    while ( tok -> isToken( TOK_LOG_OR )) {
+
+        tok -> nextToken( );
+        compileAndCond( cond );
+        emitOp( cond, T64_COP_LOG_OR );
+    }
+}
+
+void SimExprEvaluator::compileAndCond( T64StopCond *cond ) {
+
+    compileRelExpr( cond );
+
+    while ( tok -> isToken( TOK_LOG_AND )) {
+
+        tok -> nextToken( );
+        compileRelExpr( cond );
+        emitOp( cond, T64_COP_LOG_AND );
+    }
+}
+
+void SimExprEvaluator::compileRelExpr( T64StopCond *cond ) {
+
+    compileExpr( cond );
+
+    if ( isRelOp( tok -> tokId( ))) {
+
+        SimTokId op = tok -> tokId( );
+
+        tok -> nextToken( );
+        compileExpr( cond );
+        emitOp( cond, condOpCode( op ));
+    }
+}
+
+void SimExprEvaluator::compileExpr( T64StopCond *cond ) {
+
+    if ( tok -> isToken( TOK_PLUS )) {
+
+        tok -> nextToken( );
+        compileTerm( cond );
+    }
+    else if ( tok -> isToken( TOK_MINUS )) {
+
+        tok -> nextToken( );
+        compileTerm( cond );
+        emitOp( cond, T64_COP_NEG );
+    }
+    else compileTerm( cond );
+
+    while (( tok -> isToken( TOK_PLUS   )) ||
+           ( tok -> isToken( TOK_MINUS  )) ||
+           ( tok -> isToken( TOK_OR     )) ||
+           ( tok -> isToken( TOK_XOR    ))) {
+
+        SimTokId op = tok -> tokId( );
+
+        tok -> nextToken( );
+        compileTerm( cond );
+        emitOp( cond, condOpCode( op ));
+    }
+}
+
+void SimExprEvaluator::compileTerm( T64StopCond *cond ) {
+
+    compileFactor( cond );
+
+    while (( tok -> tokId( ) == TOK_MULT )   ||
+           ( tok -> tokId( ) == TOK_DIV  )   ||
+           ( tok -> tokId( ) == TOK_MOD  )   ||
+           ( tok -> tokId( ) == TOK_AND  ))  {
+
+        SimTokId op = tok -> tokId( );
+
+        tok -> nextToken( );
+        compileFactor( cond );
+        emitOp( cond, condOpCode( op ));
+    }
+}
+
+void SimExprEvaluator::compileFactor( T64StopCond *cond ) {
+
+    if ( tok -> isTokenTyp( TYP_NUM )) {
+
+        emitOp( cond, T64_COP_CONST, tok -> tokVal( ));
+        tok -> nextToken( );
+    }
+    else if (( tok -> isTokenTyp( TYP_GREG )) || 
+             ( tok -> isTokenTyp( TYP_CREG )) ||
+             ( tok -> isTokenTyp( TYP_PREG )))  {
+
+        SimTokTypeId regType    = tok -> tokTyp( );
+        int          regId      = (int) tok -> tokVal( );
+        int          modNum     = -1;
+
+        tok -> nextToken( );
+        if ( tok -> isToken( TOK_COLON )) {
+
+            tok -> nextToken( );
+            if ( tok -> isTokenTyp( TYP_NUM )) modNum = (int) tok -> tokVal( );
+            else throw( ERR_EXPECTED_NUMERIC ); 
+
+            if ( glb -> system -> getModuleType( modNum ) != MT_PROC ) 
+                throw ( ERR_INVALID_MODULE_TYPE );
+
+            tok -> nextToken( );
+        }
+
+        if      ( regType == TYP_GREG ) emitOp( cond, T64_COP_GREG, 0, modNum, regId );
+        else if ( regType == TYP_CREG ) emitOp( cond, T64_COP_CREG, 0, modNum, regId );
+        else if ( regId == 1 )          emitOp( cond, T64_COP_IA, 0, modNum );
+        else if ( regId == 2 )          emitOp( cond, T64_COP_ST, 0, modNum );
+        else throw ( ERR_INVALID_REG_ID );
+    }
+    else if ( tok -> isToken( TOK_NEG )) {
+        
+        tok -> nextToken( );
+        compileFactor( cond );
+        emitOp( cond, T64_COP_NOT );
+    }
+    else if ( tok -> isToken( TOK_LPAREN )) {
+        
+        tok -> nextToken( );
+        compileCond( cond );
+            
+        if ( tok -> isToken( TOK_RPAREN )) tok -> nextToken( );
+        else throw ( ERR_EXPECTED_RPAREN );
+    }
+    else if ( tok -> isToken( TOK_IDENT )) {
+    
+        SimEnvTabEntry *entry = glb -> env -> getEnvEntry( tok -> tokName( ));
+        if ( entry == nullptr ) throw( ERR_ENV_VAR_NOT_FOUND );
+
+        if      ( entry -> typ == TYP_NUM  ) emitOp( cond, T64_COP_CONST, entry -> u.iVal );
+        else if ( entry -> typ == TYP_BOOL ) emitOp( cond, T64_COP_CONST, entry -> u.bVal );
+        else throw ( ERR_EXPR_TYPE_MATCH );
+       
+        tok -> nextToken( );
+    }
+    else if ( tok -> isToken( TOK_EOS )) throw ( ERR_UNEXPECTED_EOS );
+    else throw ( ERR_EXPR_FACTOR );
+}
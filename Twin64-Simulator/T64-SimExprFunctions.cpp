@@ -159,7 +159,7 @@ void SimExprEvaluator::pFuncDisAssemble( SimExpr *rExpr ) {
     
     SimExpr     lExpr;
     uint32_t    instr = 0;
-    int         rdx   = glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT );
+    int         rdx   = glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT );
     static char        asmStr[ MAX_CMD_LINE_SIZE ];
     
     tok -> nextToken( );
@@ -38,6 +38,10 @@ static struct SimCmdLineOptions optionTable[ ] = {
         { "verbose",    CL_OPT_NO_ARGUMENT,        CL_ARG_VAL_VERBOSE },
         { "configfile", CL_OPT_REQUIRED_ARGUMENT,  CL_ARG_VAL_CONFIG_FILE },
         { "logfile",    CL_OPT_REQUIRED_ARGUMENT,  CL_ARG_VAL_LOG_FILE },
+        { "batch",      CL_OPT_NO_ARGUMENT,        CL_ARG_VAL_BATCH },
+        { "elffile",    CL_OPT_REQUIRED_ARGUMENT,  CL_ARG_VAL_ELF_FILE },
+        { "outfile",    CL_OPT_REQUIRED_ARGUMENT,  CL_ARG_VAL_OUT_FILE },
+        { "maxsteps",   CL_OPT_REQUIRED_ARGUMENT,  CL_ARG_VAL_MAX_STEPS },
         {0,             CL_OPT_NO_ARGUMENT,        0}
     };
 
@@ -48,7 +52,7 @@ static struct SimCmdLineOptions optionTable[ ] = {
 // for a constant token. The parser can directly use the value in expressions.
 //
 //----------------------------------------------------------------------------------------
-const SimToken cmdTokTab[ ] = {
+constexpr SimToken cmdTokTab[ ] = {
     
     //------------------------------------------------------------------------------------
     // General tokens.
@@ -116,6 +120,25 @@ const SimToken cmdTokTab[ ] = {
     { .name = "PDCA",       .typ = TYP_CMD,     .tid = CMD_PCA_D                    },
     { .name = "FICA",       .typ = TYP_CMD,     .tid = CMD_FCA_I                    },
     { .name = "FDCA",       .typ = TYP_CMD,     .tid = CMD_FCA_D                    },
+
+    { .name = "TRACE",      .typ = TYP_CMD,     .tid = CMD_TRACE                    },
+
+    { .name = "BP",         .typ = TYP_CMD,     .tid = CMD_BP                       },
+    { .name = "WP",         .typ = TYP_CMD,     .tid = CMD_WP                       },
+    { .name = "BL",         .typ = TYP_CMD,     .tid = CMD_BL                       },
+    { .name = "BC",         .typ = TYP_CMD,     .tid = CMD_BC                       },
+
+    { .name = "REC",        .typ = TYP_CMD,     .tid = CMD_REC                      },
+    { .name = "REPLAY",     .typ = TYP_CMD,     .tid = CMD_REPLAY                   },
+    { .name = "RS",         .typ = TYP_CMD,     .tid = CMD_RS                       },
+
+    { .name = "IF",         .typ = TYP_CMD,     .tid = CMD_IF                       },
+    { .name = "ELSE",       .typ = TYP_CMD,     .tid = CMD_ELSE                     },
+    { .name = "ENDIF",      .typ = TYP_CMD,     .tid = CMD_ENDIF                    },
+    { .name = "WHILE",      .typ = TYP_CMD,     .tid = CMD_WHILE                    },
+    { .name = "ENDWHILE",   .typ = TYP_CMD,     .tid = CMD_ENDWHILE                 },
+    { .name = "LOOP",       .typ = TYP_CMD,     .tid = CMD_LOOP                     },
+    { .name = "ENDLOOP",    .typ = TYP_CMD,     .tid = CMD_ENDLOOP                  },
     
     //------------------------------------------------------------------------------------
     // Window command tokens.
@@ -270,11 +293,26 @@ const SimToken cmdTokTab[ ] = {
       .tid = TOK_MOD_SPA_ADR,               .u = { .val = 0 }},
 
     { .name = "SPA_LEN",            .typ = TYP_SYM, 
-      .tid = TOK_MOD_SPA_LEN,               .u = { .val = 0 }}
+      .tid = TOK_MOD_SPA_LEN,               .u = { .val = 0 }},
+
+    { .name = "TYPE",                       .typ = TYP_SYM, 
+      .tid = TOK_MOD_TYPE,                  .u = { .val = 0 }},
+
+    { .name = "FILE",                       .typ = TYP_SYM, 
+      .tid = TOK_MOD_FILE,                  .u = { .val = 0 }},
+
+    { .name = "DISK",                       .typ = TYP_SYM, 
+      .tid = TOK_IO_DISK,                   .u = { .val = 0 }},
+
+    { .name = "UART",                       .typ = TYP_SYM, 
+      .tid = TOK_IO_UART,                   .u = { .val = 0 }},
+
+    { .name = "TIMER",                      .typ = TYP_SYM, 
+      .tid = TOK_IO_TIMER,                  .u = { .val = 0 }}
 
 };
 
-const int MAX_CMD_TOKEN_TAB = sizeof( cmdTokTab ) / sizeof( SimToken );
+constexpr int MAX_CMD_TOKEN_TAB = sizeof( cmdTokTab ) / sizeof( SimToken );
 
 //----------------------------------------------------------------------------------------
 // The error message table. Each entry has the error number and the 
@@ -407,6 +445,9 @@ const SimErrMsgTabEntry errMsgTab [ ] = {
     { .errNum = ERR_UNEXPECTED_EOS,             
       .errStr = (char *) "Unexpected end of command line" },
 
+    { .errNum = ERR_OPEN_TRACE_FILE,             
+      .errStr = (char *) "Error while opening trace file" },
+
     { .errNum = ERR_NOT_IN_WIN_MODE,            
       .errStr = (char *) "Command only valid in Windows mode" },
 
@@ -440,6 +481,36 @@ const SimErrMsgTabEntry errMsgTab [ ] = {
     { .errNum = ERR_UNDEFINED_PFUNC,            
       .errStr = (char *) "Unknown predefined function" },
 
+    { .errNum = ERR_CMD_FILE_ONLY,            
+      .errStr = (char *) "Command only valid in command files" },
+
+    { .errNum = ERR_CMD_FILE_STRUCTURE,            
+      .errStr = (char *) "Unbalanced IF, WHILE or LOOP in command file" },
+
+    { .errNum = ERR_DEBUG_TABLE_FULL,            
+      .errStr = (char *) "Breakpoint or watchpoint table full" },
+
+    { .errNum = ERR_INVALID_WATCH_MODE,            
+      .errStr = (char *) "Expected READ, WRITE or ANY watch mode" },
+
+    { .errNum = ERR_DEBUG_ENTRY_NOT_FOUND,            
+      .errStr = (char *) "No breakpoint or watchpoint at this address" },
+
+    { .errNum = ERR_COND_TOO_COMPLEX,            
+      .errStr = (char *) "Breakpoint condition too complex" },
+
+    { .errNum = ERR_OPEN_REPLAY_FILE,            
+      .errStr = (char *) "Error while opening replay log file" },
+
+    { .errNum = ERR_REPLAY_NOT_ACTIVE,            
+      .errStr = (char *) "No recording or replay active" },
+
+    { .errNum = ERR_REPLAY_START_CYCLE,            
+      .errStr = (char *) "Replay log does not start at the current cycle" },
+
+    { .errNum = ERR_REPLAY_CYCLE_RANGE,            
+      .errStr = (char *) "Cycle not covered by the recording" },
+
     { .errNum = ERR_IN_ASM_PFUNC,            
       .errStr = (char *) "Error in ASM function" },
 
@@ -516,7 +587,13 @@ const SimErrMsgTabEntry errMsgTab [ ] = {
       .errStr = (char *) "Create processor module error" }, 
 
     { .errNum = ERR_CREATE_MEM_MODULE,              
-      .errStr = (char *) "Create memory module error" }
+      .errStr = (char *) "Create memory module error" },
+
+    { .errNum = ERR_CREATE_IO_MODULE,              
+      .errStr = (char *) "Create I/O module error" },
+
+    { .errNum = ERR_NO_PROC_MODULE,              
+      .errStr = (char *) "No processor module configured" }
    
 };
 
@@ -601,7 +678,7 @@ const SimHelpMsgEntry cmdHelpTab[ ] = {
         .helpTypeId = TYP_CMD,  .helpTokId  = CMD_RUN,
         .cmdNameStr     = (char *) "run",
         .cmdSyntaxStr   = (char *) "run",
-        .helpStr        = (char *) "run the system ( all CPUs )"
+        .helpStr        = (char *) "run the system ( all CPUs ), Ctrl-E stops"
     },
     
     {
@@ -610,6 +687,83 @@ const SimHelpMsgEntry cmdHelpTab[ ] = {
         .cmdSyntaxStr   = (char *) "s [ <steps> ]",
         .helpStr        = (char *) "single step the system"
     },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_TRACE,
+        .cmdNameStr     = (char *) "trace",
+        .cmdSyntaxStr   = (char *) "trace [ \"<filePath>\" ]",
+        .helpStr        = (char *) "starts or stops the cache and TLB access trace"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_BP,
+        .cmdNameStr     = (char *) "bp",
+        .cmdSyntaxStr   = (char *) "bp <adr> [ , <cond> ]",
+        .helpStr        = (char *) "sets a breakpoint with an optional condition"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_WP,
+        .cmdNameStr     = (char *) "wp",
+        .cmdSyntaxStr   = (char *) "wp <adr> [ , <len> [ , ( READ | WRITE | ANY ) ]]",
+        .helpStr        = (char *) "sets a watchpoint on a data address range"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_BL,
+        .cmdNameStr     = (char *) "bl",
+        .cmdSyntaxStr   = (char *) "bl",
+        .helpStr        = (char *) "lists the breakpoints and watchpoints"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_BC,
+        .cmdNameStr     = (char *) "bc",
+        .cmdSyntaxStr   = (char *) "bc [ <adr> ]",
+        .helpStr        = (char *) "clears a breakpoint or watchpoint, or all of them"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_REC,
+        .cmdNameStr     = (char *) "rec",
+        .cmdSyntaxStr   = (char *) "rec [ \"<filePath>\" ]",
+        .helpStr        = (char *) "starts a recording or stops and saves it"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_REPLAY,
+        .cmdNameStr     = (char *) "replay",
+        .cmdSyntaxStr   = (char *) "replay [ \"<filePath>\" ]",
+        .helpStr        = (char *) "starts or stops the replay of a recording"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_RS,
+        .cmdNameStr     = (char *) "rs",
+        .cmdSyntaxStr   = (char *) "rs [ <cycles> ]",
+        .helpStr        = (char *) "reverse steps a recording or replay"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_IF,
+        .cmdNameStr     = (char *) "if",
+        .cmdSyntaxStr   = (char *) "if <expr> ... [ else ... ] endif",
+        .helpStr        = (char *) "command file conditional, expr is a bool or num"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_WHILE,
+        .cmdNameStr     = (char *) "while",
+        .cmdSyntaxStr   = (char *) "while <expr> ... endwhile",
+        .helpStr        = (char *) "command file loop while expr is true"
+    },
+
+    {
+        .helpTypeId = TYP_CMD,  .helpTokId  = CMD_LOOP,
+        .cmdNameStr     = (char *) "loop",
+        .cmdSyntaxStr   = (char *) "loop <count> ... endloop",
+        .helpStr        = (char *) "command file loop executed count times"
+    },
     
     {
         .helpTypeId = TYP_CMD,  .helpTokId  = CMD_WRITE_LINE,
@@ -24,6 +24,7 @@
 //----------------------------------------------------------------------------------------
 #include "T64-SimDeclarations.h"
 #include "T64-SimTables.h"
+#include "T64-KeywordHash.h"
 
 //----------------------------------------------------------------------------------------
 // Local namespace. These routines are not visible outside this source file.
@@ -41,41 +42,21 @@ const char  EOS_CHAR        = 0;
 char        strTokenBuf[ MAX_TOK_STR_SIZE ] = { 0 };
 
 //----------------------------------------------------------------------------------------
-//
+// The lookup function. The reserved words are found through a perfect hash table,
+// which the compiler builds from the command token table. The hash and the name 
+// compare ignore the case of the input string. We return the index into the 
+// command token table.
 //
 //----------------------------------------------------------------------------------------
-void upshiftStr( char *str ) {
-    
-    size_t len = strlen( str );
-    
-    if ( len > 0 ) {
-        
-        for ( size_t i = 0; i < len; i++ ) {
-            
-            str[ i ] = (char) toupper((int) str[ i ] );
-        }
-    }
-}
+constexpr auto cmdTokHash = T64KeywordHash<MAX_CMD_TOKEN_TAB>( cmdTokTab );
 
-//----------------------------------------------------------------------------------------
-// The lookup function. We just do a linear search for now.
-//
-//----------------------------------------------------------------------------------------
-int lookupToken( char *inputStr, SimToken *tokTab ) {
+int lookupToken( char *inputStr ) {
 
-    char tempStr[ TOK_NAME_SIZE + 1 ] = { 0 };
-    strncpy( tempStr, inputStr, TOK_NAME_SIZE );
-    upshiftStr( tempStr );
+    size_t len = strlen( inputStr );
 
-    if (( strlen( tempStr ) == 0 ) || 
-        ( strlen ( tempStr ) > TOK_NAME_SIZE )) return( -1 );
-    
-    for ( int i = 0; i < MAX_CMD_TOKEN_TAB; i++  ) {
-        
-        if ( strcmp( tempStr, tokTab[ i ].name ) == 0 ) return( i );
-    }
+    if (( len == 0 ) || ( len > TOK_NAME_SIZE )) return( -1 );
     
-    return( -1 );
+    return( cmdTokHash.lookup( cmdTokTab, inputStr ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -102,6 +83,20 @@ void addChar( char *buf, int size, char ch ) {
 //----------------------------------------------------------------------------------------
 SimTokenizer::SimTokenizer( ) { }
 
+//----------------------------------------------------------------------------------------
+// A tokenizer can also return the tokens from a list of already scanned tokens. The
+// compiled command files keep the tokens of each command line in such a list. When
+// the list is exhausted, the end of string token is returned. Setting up the 
+// tokenizer for a new input line will switch back to scanning characters.
+//
+//----------------------------------------------------------------------------------------
+void SimTokenizer::setupTokenList( SimToken *tokList, int tokListLen ) {
+
+    this -> tokList         = tokList;
+    this -> tokListLen      = tokListLen;
+    this -> tokListIndex    = 0;
+}
+
 //----------------------------------------------------------------------------------------
 // helper functions for the current token.
 //
@@ -380,7 +375,7 @@ void SimTokenizer::parseIdent( ) {
         nextChar( );
     }
     
-    int index = lookupToken( identBuf, tokTab );
+    int index = lookupToken( identBuf );
     
     if ( index == - 1 ) {
         
@@ -388,16 +383,34 @@ void SimTokenizer::parseIdent( ) {
         currentToken.typ    = TYP_IDENT;
         currentToken.tid    = TOK_IDENT;
     }
-    else currentToken = tokTab[ index ];
+    else currentToken = cmdTokTab[ index ];
 }
 
 //----------------------------------------------------------------------------------------
 // "nextToken" is the entry point to the token business. It returns the next token from
-// the input string.
+// the input string. The comparison and logical operators of a condition are two 
+// character symbols, such as "==" or "&&", we look at the next character to tell 
+// them from "=" and "&".
 //
 //----------------------------------------------------------------------------------------
 void SimTokenizer::nextToken( ) {
 
+    if ( tokList != nullptr ) {
+
+        if ( tokListIndex < tokListLen ) {
+            
+            currentToken = tokList[ tokListIndex++ ];
+        }
+        else {
+
+            currentToken.typ    = TYP_NIL;
+            currentToken.tid    = TOK_EOS;
+            currentToken.u.val  = 0;
+        }
+
+        return;
+    }
+
     currentToken.typ    = TYP_NIL;
     currentToken.tid    = TOK_NIL;
     currentToken.u.val  = 0;
@@ -433,6 +446,49 @@ void SimTokenizer::nextToken( ) {
         currentToken.typ   = TYP_SYM;
         currentToken.tid   = TOK_EQUAL;
         nextChar( );
+
+        if ( currentChar == '=' ) {
+
+            currentToken.tid = TOK_EQ;
+            nextChar( );
+        }
+    }
+    else if ( currentChar == '!' ) {
+
+        currentToken.typ   = TYP_SYM;
+        currentToken.tid   = TOK_NE;
+        nextChar( );
+
+        if ( currentChar == '=' ) nextChar( );
+        else {
+
+            currentToken.tid = TOK_ERR;
+            throw ( ERR_INVALID_EXPR );
+        }
+    }
+    else if ( currentChar == '<' ) {
+
+        currentToken.typ   = TYP_SYM;
+        currentToken.tid   = TOK_LT;
+        nextChar( );
+
+        if ( currentChar == '=' ) {
+
+            currentToken.tid = TOK_LE;
+            nextChar( );
+        }
+    }
+    else if ( currentChar == '>' ) {
+
+        currentToken.typ   = TYP_SYM;
+        currentToken.tid   = TOK_GT;
+        nextChar( );
+
+        if ( currentChar == '=' ) {
+
+            currentToken.tid = TOK_GE;
+            nextChar( );
+        }
     }
     else if ( currentChar == '+' ) {
         
@@ -468,12 +524,24 @@ void SimTokenizer::nextToken( ) {
         currentToken.typ    = TYP_SYM;
         currentToken.tid    = TOK_AND;
         nextChar( );
+
+        if ( currentChar == '&' ) {
+
+            currentToken.tid = TOK_LOG_AND;
+            nextChar( );
+        }
     }
     else if ( currentChar == '|' ) {
         
         currentToken.typ    = TYP_SYM;
         currentToken.tid    = TOK_OR;
         nextChar( );
+
+        if ( currentChar == '|' ) {
+
+            currentToken.tid = TOK_LOG_OR;
+            nextChar( );
+        }
     }
     else if ( currentChar == '^' ) {
         
@@ -583,11 +651,11 @@ SimTokenizerFromString::SimTokenizerFromString(  ) : SimTokenizer( ) { }
 // called.
 //
 //----------------------------------------------------------------------------------------
-void SimTokenizerFromString::setupTokenizer( char *lineBuf, SimToken *tokTab ) {
+void SimTokenizerFromString::setupTokenizer( char *lineBuf ) {
 
     strncpy( tokenLine, lineBuf, strlen( lineBuf ) + 1 );
     
-    this -> tokTab                  = tokTab;
+    this -> tokList                 = nullptr;
     this -> currentLineLen          = (int) strlen( tokenLine );
     this -> currentCharIndex        = 0;
     this -> currentChar             = ' ';
@@ -626,9 +694,9 @@ SimTokenizerFromFile::~SimTokenizerFromFile( ) {
 // called.
 //
  
-void SimTokenizerFromFile::setupTokenizer( char *filePath, SimToken *tokTab ) {
+void SimTokenizerFromFile::setupTokenizer( char *filePath ) {
 
-    this -> tokTab          = tokTab;
+    this -> tokList         = nullptr;
     this -> currentChar     = ' ';
 
     openFile( filePath );
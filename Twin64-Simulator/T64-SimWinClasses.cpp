@@ -56,6 +56,21 @@ const int DEF_WIN_ROW_TEXT      = 10;
 const int DEF_WIN_COL_CONSOLE   = 112;
 const int DEF_WIN_ROW_CONSOLE   = 24;
 
+//----------------------------------------------------------------------------------------
+// Text window file index. The line offset index is built at most one chunk of file 
+// bytes per redraw, unless a line further down is requested. A large file thus shows
+// up right away and the index completes over the next few redraws.
+//
+//----------------------------------------------------------------------------------------
+const size_t  TEXT_INDEX_CHUNK_SIZE = 64 * 1024 * 1024;
+const T64Word TEXT_INDEX_INIT_LINES = 4096;
+
+#if __APPLE__ || __linux__
+const int     TEXT_FILE_OPEN_FLAGS  = O_RDONLY;
+#else
+const int     TEXT_FILE_OPEN_FLAGS  = O_RDONLY | O_BINARY;
+#endif
+
 //----------------------------------------------------------------------------------------
 // Routine for creating the page type string.
 //
@@ -163,7 +178,7 @@ SimWinCpuState::SimWinCpuState( SimGlobals *glb, int modNum ) : SimWin( glb ) {
 void SimWinCpuState::setDefaults( ) {
     
     setWinType( WT_CPU_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT ));
 
     setWinToggleLimit( 3 );
     setWinDefSize( 0, DEF_WIN_ROW_CPU_STATE ,DEF_WIN_COL_CPU_STATE );
@@ -376,7 +391,7 @@ SimWinAbsMem::SimWinAbsMem( SimGlobals *glb, int modNum, T64Word adr ) :
 void SimWinAbsMem::setDefaults( ) {
     
     setWinType( WT_MEM_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT ));
 
     setWinToggleLimit( 4 );
     setWinDefSize( 0, DEF_WIN_ROW_ABS_MEM, DEF_WIN_COL_ABS_MEM );
@@ -538,7 +553,7 @@ SimWinCode::  ~  SimWinCode( ) {
 void SimWinCode::setDefaults( ) {
      
     setWinType( WT_CODE_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT ));
 
     setWinToggleLimit( 1 );
     setWinDefSize( 0, DEF_WIN_ROW_CODE_MEM, DEF_WIN_COL_CODE_MEM );
@@ -657,7 +672,7 @@ SimWinTlb::SimWinTlb( SimGlobals *glb,
 void SimWinTlb::setDefaults( ) {
     
     setWinType( WT_TLB_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT ));
 
     setWinToggleLimit( 1 );
     setWinDefSize( 0, DEF_WIN_ROW_TLB, DEF_WIN_COL_TLB );
@@ -764,7 +779,7 @@ SimWinCache::SimWinCache( SimGlobals    *glb,
 void SimWinCache::setDefaults( ) {
 
     setWinType( WT_CACHE_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT ));
 
     setWinToggleLimit( cache -> getWays( ));
 
@@ -897,7 +912,7 @@ void SimWinCache::drawLine( T64Word index ) {
 //----------------------------------------------------------------------------------------
 // Object constructor. We are passed the globals and the file path. All we do right
 // now is to remember the file name. The text window has a destructor method as 
-// well. We need to close a potentially opened file.
+// well. We need to unmap and close a potentially opened file.
 //
 //----------------------------------------------------------------------------------------
 SimWinText::SimWinText( SimGlobals *glb, char *fName ) : SimWinScrollable( glb ) {
@@ -911,7 +926,7 @@ SimWinText::SimWinText( SimGlobals *glb, char *fName ) : SimWinScrollable( glb )
 
 SimWinText:: ~SimWinText( ) {
     
-    if ( textFile != nullptr ) fclose( textFile );
+    closeTextFile( );
 }
 
 //----------------------------------------------------------------------------------------
@@ -921,7 +936,7 @@ SimWinText:: ~SimWinText( ) {
 //----------------------------------------------------------------------------------------
 void SimWinText::setDefaults( ) {
 
-    int txWidth = glb -> env -> getEnvVarInt((char *) ENV_WIN_TEXT_LINE_WIDTH );
+    int txWidth = glb -> env -> getEnvVarInt( ENV_HDL_WIN_TEXT_LINE_WIDTH );
     
     setWinType( WT_TEXT_WIN );
     
@@ -941,15 +956,17 @@ void SimWinText::setDefaults( ) {
 // The banner line for the text window. It contains the open file name and the 
 // current line and home line number. The file path may be a bit long for listing
 // it completely, so we will truncate it on the left side. The routine will print
-// the filename, and the position into the file. The banner method also sets the 
-// preliminary line size of the window. This value is used until we know the actual
-// number of lines in the file. Lines shown on the display start with one, 
-// internally we start at zero.
+// the filename, and the position into the file. The banner is drawn before the 
+// body, so this is also the place where we check the file for growth and extend 
+// the line index. Lines shown on the display start with one, internally we start 
+// at zero.
 //
 //----------------------------------------------------------------------------------------
 void SimWinText::drawBanner( ) {
     
     uint32_t fmtDesc = FMT_BOLD | FMT_INVERSE;
+
+    if ( openTextFile( )) updateTextFile( );
     
     setWinCursor( 1, 1 );
     printWindowIdField( fmtDesc );
@@ -964,9 +981,7 @@ void SimWinText::drawBanner( ) {
 // The draw line method for the text file window. We print the file content line 
 // by line. A line consists of the line number followed by the text. This routine
 // will first check whether the file is already open. If we cannot open the file, 
-// we would now print an error message into the screen. This is also the time where
-// we actually figure out how many lines are on the file so that we can set the 
-// limitItemAdr field of the window object.
+// we would now print an error message into the screen.
 //
 //----------------------------------------------------------------------------------------
 void SimWinText::drawLine( T64Word index ) {
@@ -980,7 +995,7 @@ void SimWinText::drawLine( T64Word index ) {
         printNumericField( index + 1, ( fmtDesc | FMT_DEC ));
         printTextField((char *) ": " );
   
-        lineSize = readTextFileLine( index + 1, lineBuf, sizeof( lineBuf ));
+        lineSize = readTextFileLine( index, lineBuf, sizeof( lineBuf ));
         if ( lineSize > 0 ) {
             
             printTextField( lineBuf, fmtDesc, lineSize );
@@ -993,69 +1008,230 @@ void SimWinText::drawLine( T64Word index ) {
 
 //----------------------------------------------------------------------------------------
 // "openTextFile" is called every time we want to print a line. If the file is not
-// opened yet, it will be opened now and while we are at it, we will also count the
-// source lines for setting the limit in the scrollable window.
+// opened yet, it will be opened and mapped now. The line index starts out with the
+// first line at offset zero, the remaining lines are indexed as we go.
 //
 //----------------------------------------------------------------------------------------
 bool SimWinText::openTextFile( ) {
     
-    if ( textFile == nullptr ) {
+    if ( textFile < 0 ) {
         
-        textFile = fopen( fileName, "r" );
-        if ( textFile != nullptr ) {
-           
-            while( ! feof( textFile )) {
-                
-                if( fgetc( textFile ) == '\n' ) fileSizeLines++;
-            }
-            
-            lastLinePos = 0;
-            rewind( textFile );
-            setLimitItemAdr( fileSizeLines );
+        textFile = open( fileName, TEXT_FILE_OPEN_FLAGS );
+        if ( textFile < 0 ) return( false );
+
+        lineStart       = (size_t *) malloc( TEXT_INDEX_INIT_LINES * sizeof( size_t ));
+        lineStartMax    = TEXT_INDEX_INIT_LINES;
+        lineStart[ 0 ]  = 0;
+        lineStartCnt    = 1;
+        scanPos         = 0;
+
+        if ( ! mapTextFile( )) {
+
+            closeTextFile( );
+            return( false );
         }
     }
     
-    return( textFile != nullptr );
+    return( true );
 }
 
 //----------------------------------------------------------------------------------------
-// "readTextFileLine" will get a line from the text file. Unfortunately, we do not 
-// have a line concept in a text file. In the worst case, we read from the beginning
-// of the file, counting the lines read. To speed up a little, we remember the last
-// line position read. If the requested line position is larger than the last position,
-// we just read ahead. If it is smaller, no luck, we start to read from zero until we
-// match. If equal, we just re-read the current line.
+// Close the text file. We release the mapped file data and the line index.
 //
 //----------------------------------------------------------------------------------------
-int SimWinText::readTextFileLine( int linePos, char *lineBuf, int bufLen  ) {
- 
-    if ( textFile != nullptr ) {
-        
-        if ( linePos > lastLinePos ) {
-            
-            while ( lastLinePos < linePos ) {
-                
-                lastLinePos ++;
-                fgets( lineBuf, bufLen, textFile );
-            }
+void SimWinText::closeTextFile( ) {
+
+#if __APPLE__ || __linux__
+    if ( fileData != nullptr ) munmap( fileData, fileDataSize );
+#else
+    if ( fileData != nullptr ) free( fileData );
+#endif
+
+    if ( lineStart != nullptr ) free( lineStart );
+    if ( textFile >= 0 ) close( textFile );
+
+    textFile        = -1;
+    fileData        = nullptr;
+    fileDataSize    = 0;
+    lineStart       = nullptr;
+    lineStartCnt    = 0;
+    lineStartMax    = 0;
+    scanPos         = 0;
+}
+
+//----------------------------------------------------------------------------------------
+// "mapTextFile" maps the current file content into memory. The routine is called 
+// when the file is opened and again when it has grown. On a POSIX system we just
+// map the file again with the new size. Otherwise, we read the new part of the 
+// file into a growing buffer. An empty file is not mapped at all.
+//
+//----------------------------------------------------------------------------------------
+bool SimWinText::mapTextFile( ) {
+
+    struct stat fileStat;
+
+    if ( fstat( textFile, &fileStat ) != 0 ) return( false );
+
+    size_t newSize = (size_t) fileStat.st_size;
+    if ( newSize == fileDataSize ) return( true );
+
+#if __APPLE__ || __linux__
+    if ( fileData != nullptr ) munmap( fileData, fileDataSize );
+
+    fileData        = nullptr;
+    fileDataSize    = 0;
+
+    if ( newSize > 0 ) {
+
+        void *ptr = mmap( nullptr, newSize, PROT_READ, MAP_PRIVATE, textFile, 0 );
+        if ( ptr == MAP_FAILED ) return( false );
+
+        fileData        = (char *) ptr;
+        fileDataSize    = newSize;
+    }
+#else
+    if ( newSize < fileDataSize ) return( false );
+
+    char *ptr = (char *) realloc( fileData, newSize );
+    if ( ptr == nullptr ) return( false );
+
+    fileData = ptr;
+
+    while ( fileDataSize < newSize ) {
+
+        int len = read( textFile, fileData + fileDataSize, (unsigned) ( newSize - fileDataSize ));
+        if ( len <= 0 ) break;
+        fileDataSize += len;
+    }
+#endif
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// "updateTextFile" is called on each redraw of the window. When the file has grown,
+// we map it again. When it shrunk, the file was rewritten and we start over with the
+// index at the first line. Next, we index one more chunk of the file. The line limit
+// of the window is set to the lines known so far. When the file was completely 
+// indexed and the last line was visible, we move the window along with the new 
+// lines, so that a log file can be tailed.
+//
+//----------------------------------------------------------------------------------------
+void SimWinText::updateTextFile( ) {
+
+    struct stat fileStat;
+    T64Word     oldLines    = getTextFileLines( );
+    T64Word     itemsPerWin = getRows( ) - 1;
+    bool        tailFile    = ( oldLines > 0 ) &&
+                              ( scanPos >= fileDataSize ) &&
+                              ( getCurrentItemAdr( ) + itemsPerWin >= oldLines );
+    
+    if ( fstat( textFile, &fileStat ) == 0 ) {
+
+        if ((size_t) fileStat.st_size < fileDataSize ) {
+
+            closeTextFile( );
+            setCurrentItemAdr( 0 );
+            if ( ! openTextFile( )) return;
         }
-        else if ( linePos < lastLinePos ) {
-            
-            lastLinePos = 0;
-            rewind( textFile );
-            
-            while ( lastLinePos < linePos ) {
-                
-                lastLinePos ++;
-                fgets( lineBuf, bufLen, textFile );
-            }
+        else if ( ! mapTextFile( )) {
+
+            closeTextFile( );
+            return;
         }
-        else fgets( lineBuf, bufLen, textFile );
-            
-        lineBuf[ strcspn( lineBuf, "\r\n") ] = 0;
-        return((int) strlen ( lineBuf ));
     }
-    else return ( 0 );
+
+    indexTextFile( 0, TEXT_INDEX_CHUNK_SIZE );
+
+    T64Word newLines = getTextFileLines( );
+
+    if (( tailFile ) && ( newLines > getCurrentItemAdr( ) + itemsPerWin )) {
+
+        setCurrentItemAdr( newLines - itemsPerWin );
+    }
+
+    setLimitItemAdr(( newLines > 0 ) ? newLines : 1 );
+}
+
+//----------------------------------------------------------------------------------------
+// "indexTextFile" scans the mapped file for line ends, starting where the last scan
+// stopped. Each line end adds the start offset of the following line to the index. 
+// The scan stops when the line limit is in the index, or when the byte limit was 
+// scanned. A partial line at the end of the file is not scanned again when the file
+// grows, there was simply no line end in that part.
+//
+//----------------------------------------------------------------------------------------
+void SimWinText::indexTextFile( T64Word lineLimit, size_t byteLimit ) {
+
+    size_t scanLimit = fileDataSize;
+
+    if (( byteLimit > 0 ) && ( scanPos + byteLimit < scanLimit )) {
+
+        scanLimit = scanPos + byteLimit;
+    }
+
+    while ( scanPos < scanLimit ) {
+
+        if (( lineLimit > 0 ) && ( lineStartCnt > lineLimit )) break;
+
+        char *ptr = (char *) memchr( fileData + scanPos, '\n', scanLimit - scanPos );
+        if ( ptr == nullptr ) {
+
+            scanPos = scanLimit;
+            break;
+        }
+
+        if ( lineStartCnt >= lineStartMax ) {
+
+            size_t *tmp = (size_t *) realloc( lineStart, lineStartMax * 2 * sizeof( size_t ));
+            if ( tmp == nullptr ) break;
+
+            lineStart       = tmp;
+            lineStartMax    = lineStartMax * 2;
+        }
+
+        scanPos = ( ptr - fileData ) + 1;
+        lineStart[ lineStartCnt++ ] = scanPos;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// The number of lines known so far. The last entry in the index is the start of 
+// the line following the last line end. It only counts when there is text in it.
+//
+//----------------------------------------------------------------------------------------
+T64Word SimWinText::getTextFileLines( ) {
+
+    if ( lineStartCnt == 0 ) return( 0 );
+    
+    if ( lineStart[ lineStartCnt - 1 ] < fileDataSize ) return( lineStartCnt );
+    else return( lineStartCnt - 1 );
+}
+
+//----------------------------------------------------------------------------------------
+// "readTextFileLine" will get a line from the text file. When the line is not in 
+// the index yet, we index up to it first. The line is then just copied from the 
+// mapped file data, with the line end removed and truncated to the buffer size.
+//
+//----------------------------------------------------------------------------------------
+int SimWinText::readTextFileLine( T64Word linePos, char *lineBuf, int bufLen  ) {
+ 
+    if (( fileData == nullptr ) || ( linePos < 0 )) return( 0 );
+    
+    if ( linePos + 1 >= lineStartCnt ) indexTextFile( linePos + 1, 0 );
+    if ( linePos >= getTextFileLines( )) return( 0 );
+
+    size_t start    = lineStart[ linePos ];
+    size_t end      = ( linePos + 1 < lineStartCnt ) ? lineStart[ linePos + 1 ] : fileDataSize;
+
+    while (( end > start ) && 
+           (( fileData[ end - 1 ] == '\n' ) || ( fileData[ end - 1 ] == '\r' ))) end--;
+
+    int len = (int) (( end - start < (size_t) bufLen ) ? ( end - start ) : ( bufLen - 1 ));
+    
+    memcpy( lineBuf, fileData + start, len );
+    lineBuf[ len ] = 0;
+    return( len );
 }
 
 //****************************************************************************************
@@ -1083,7 +1259,7 @@ SimWinConsole::SimWinConsole( SimGlobals *glb ) : SimWin( glb ) {
 void SimWinConsole::setDefaults( ) {
     
     setWinType( WT_CONSOLE_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT ));
 
     setWinToggleLimit( 1 );
     setWinDefSize( 0, DEF_WIN_ROW_CONSOLE, DEF_WIN_COL_CONSOLE );
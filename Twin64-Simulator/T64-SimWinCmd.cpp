@@ -32,6 +32,8 @@
 #include "T64-SimDeclarations.h"
 #include "T64-SimTables.h"
 
+#include <chrono>
+
 //----------------------------------------------------------------------------------------
 // Local name space. We try to keep utility functions local to the file.
 //
@@ -50,6 +52,107 @@ int internalWinNum( int num ) {
     else return ( -1 );
 }
 
+//----------------------------------------------------------------------------------------
+// RUN command settings. The system is stepped in large quanta. Between the quanta we 
+// check the keyboard for the interrupt key and refresh the windows at a bounded rate.
+// The interrupt key is Ctrl-E, since Ctrl-C would terminate the simulator.
+//
+//----------------------------------------------------------------------------------------
+const int   RUN_STEP_QUANTUM    = 16384;
+const int   RUN_REFRESH_MS      = 100;
+const int   RUN_INTERRUPT_KEY   = 0x05;
+
+//----------------------------------------------------------------------------------------
+// Move the console UART output to the command window. The characters are taken from
+// the transmit FIFO in blocks of a line buffer size. A UART with an output file 
+// writes to its file instead.
+//
+//----------------------------------------------------------------------------------------
+void drainUartOutput( SimWinOutBuffer *winOut, T64Uart **uarts, int numUarts ) {
+
+    char buf[ MAX_WIN_OUT_LINE_SIZE ];
+    int  len;
+
+    for ( int i = 0; i < numUarts; i++ ) {
+
+        if ( uarts[ i ] -> hasOutputFile( )) uarts[ i ] -> flushOutput( );
+        else {
+
+            while (( len = uarts[ i ] -> drainTx( buf, sizeof( buf ) - 1 )) > 0 ) {
+
+                buf[ len ] = '\0';
+                winOut -> writeChars( "%s", buf );
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Breakpoints and watchpoints. Before the system is stepped, the debug object is
+// passed to all processors. Without any breakpoint or watchpoint set, the processors
+// get a null pointer and run without any checks. After stepping, a stop caused by a
+// breakpoint or watchpoint is reported in the command window. A replay that no 
+// longer follows its log also stops the system and is reported too.
+//
+//----------------------------------------------------------------------------------------
+void setProcDebug( SimGlobals *glb, T64Debug *debug ) {
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        T64Module *mPtr = glb -> system -> lookupByModNum( i );
+
+        if (( mPtr != nullptr ) && ( mPtr -> getModuleType( ) == MT_PROC )) {
+
+            ((T64Processor *) mPtr ) -> setDebug( debug );
+        }
+    }
+}
+
+void attachDebug( SimGlobals *glb ) {
+
+    T64Debug *debug = nullptr;
+
+    if (( glb -> debug != nullptr ) && ( ! glb -> debug -> isEmpty( ))) debug = glb -> debug;
+
+    setProcDebug( glb, debug );
+}
+
+bool reportStop( SimWinOutBuffer *winOut, SimGlobals *glb ) {
+
+    if ( ! glb -> system -> isStopRequested( )) return( false );
+
+    if (( glb -> replay != nullptr ) && ( glb -> replay -> isDiverged( ))) {
+
+        winOut -> writeChars( "Replay diverged at cycle %lld, replay stopped\n",
+                              (long long) glb -> replay -> getDivergeCycle( ));
+        glb -> replay -> clearDiverged( );
+    }
+
+    if ( glb -> debug == nullptr ) return( true );
+
+    T64StopInfo *info = glb -> debug -> getStopInfo( );
+
+    if ( info -> kind == T64_STOP_BREAKPOINT ) {
+
+        winOut -> writeChars( "Breakpoint, proc %d, IA: ", info -> modNum );
+        winOut -> printNumber( info -> instrAdr, FMT_PREFIX_0X | FMT_HEX_4_4_4_4 );
+        winOut -> writeChars( "\n" );
+    }
+    else if ( info -> kind == T64_STOP_WATCHPOINT ) {
+
+        winOut -> writeChars( "Watchpoint %s, proc %d, adr: ", 
+                              ( info -> wMode ) ? "write" : "read",
+                              info -> modNum );
+        winOut -> printNumber( info -> dataAdr, FMT_PREFIX_0X | FMT_HEX_4_4_4_4 );
+        winOut -> writeChars( ", IA: " );
+        winOut -> printNumber( info -> instrAdr, FMT_PREFIX_0X | FMT_HEX_4_4_4_4 );
+        winOut -> writeChars( "\n" );
+    }
+
+    glb -> debug -> clearStopInfo( );
+    return( true );
+}
+
 //----------------------------------------------------------------------------------------
 // Little helper functions.
 //
@@ -79,39 +182,6 @@ bool isLeftBracketChar( int ch ) {
     return ( ch == '[' );
 }
 
-//----------------------------------------------------------------------------------------
-// A little helper function to remove the comment part of a command line. We do 
-// the changes on the buffer passed in by just setting the end of string at the
-// position of the "#" comment indicator. A "#" inside a string is ignored.
-//
-//----------------------------------------------------------------------------------------
-int removeComment( char *cmdBuf ) {
-    
-    if ( strlen ( cmdBuf ) > 0 ) {
-        
-        char *ptr = cmdBuf;
-        
-        bool inQuotes = false;
-        
-        while ( *ptr ) {
-            
-            if ( *ptr == '"' ) {
-                
-                inQuotes = ! inQuotes;
-            }
-            else if ( *ptr == '#' && !inQuotes ) {
-                
-                *ptr = '\0';
-                break;
-            }
-            
-            ptr++;
-        }
-    }
-    
-    return ((int) strlen( cmdBuf ));
-}
-
 //----------------------------------------------------------------------------------------
 // "removeChar" will removes the character from the input buffer left of the 
 // cursor position and adjust the input buffer string size accordingly. If the 
@@ -220,6 +290,34 @@ void sanitizeLine( const char *inputStr, char *outputStr ) {
     *dst = '\0';
 }
 
+//----------------------------------------------------------------------------------------
+// The breakpoint command keeps the condition text for the display. The condition 
+// starts after the first comma, which is not inside a string or a parenthesized 
+// expression. Leading blanks are skipped.
+//
+//----------------------------------------------------------------------------------------
+char *findCondText( char *cmdBuf ) {
+
+    int  parenLevel = 0;
+    bool inStr      = false;
+
+    for ( char *ptr = cmdBuf; *ptr != '\0'; ptr++ ) {
+
+        if      ( *ptr == '"' )         inStr = ! inStr;
+        else if ( inStr )               continue;
+        else if ( *ptr == '(' )         parenLevel++;
+        else if ( *ptr == ')' )         parenLevel--;
+        else if (( *ptr == ',' ) && ( parenLevel == 0 )) {
+
+            ptr++;
+            while (( *ptr == ' ' ) || ( *ptr == '\t' )) ptr++;
+            return( ptr );
+        }
+    }
+
+    return( nullptr );
+}
+
 }; // namespace
 
 
@@ -337,6 +435,7 @@ SimCommandsWin::SimCommandsWin( SimGlobals *glb ) : SimWin( glb ) {
     tok        = new SimTokenizerFromString( );
     eval        = new SimExprEvaluator( glb, tok );
     hist        = new SimCmdHistory( );
+    cmdFiles    = new SimCmdFileCache( );
     winOut      = new SimWinOutBuffer( );
     disAsm      = new T64DisAssemble( );
     inlineAsm   = new T64Assemble( );
@@ -352,7 +451,7 @@ SimCommandsWin::SimCommandsWin( SimGlobals *glb ) : SimWin( glb ) {
 void SimCommandsWin::setDefaults( ) {
     
     setWinType( WT_CMD_WIN );
-    setRadix( glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT ));
+    setRadix( glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT ));
 
     setWinToggleLimit( 1 );
     setWinDefSize( 0, 24, 100 );
@@ -602,7 +701,7 @@ int SimCommandsWin::readCmdLine( char *cmdBuf, int initialCmdBufLen, char *promp
                     case 'A': {
                         
                         winOut -> scrollUp( );
-                        reDraw( );
+                        glb -> winDisplay -> reDraw( );
                         setWinCursor( 0, promptBufLen );
                         
                     } break;
@@ -610,7 +709,7 @@ int SimCommandsWin::readCmdLine( char *cmdBuf, int initialCmdBufLen, char *promp
                     case 'B': {
                         
                         winOut -> scrollDown( );
-                        reDraw( );
+                        glb -> winDisplay -> reDraw( );
                         setWinCursor( 0, promptBufLen  );
                         
                     } break;
@@ -649,7 +748,7 @@ int SimCommandsWin::readCmdLine( char *cmdBuf, int initialCmdBufLen, char *promp
                     case 'H' : {
                         
                         winOut -> scrollUp( );
-                        reDraw( );
+                        glb -> winDisplay -> reDraw( );
                         setWinCursor( 0, promptBufLen );
                         
                     } break;
@@ -657,7 +756,7 @@ int SimCommandsWin::readCmdLine( char *cmdBuf, int initialCmdBufLen, char *promp
                     case 'P': {
                         
                         winOut -> scrollDown( );
-                        reDraw( );
+                        glb -> winDisplay -> reDraw( );
                         setWinCursor( 0, promptBufLen  );
                         
                     } break;
@@ -801,7 +900,7 @@ void SimCommandsWin::printStackInfoField( uint32_t fmtDesc, int row, int col ) {
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::printWelcome( ) {
     
-    glb -> env -> setEnvVar((char *) ENV_EXIT_CODE, (T64Word) 0 );
+    glb -> env -> setEnvVar( ENV_HDL_EXIT_CODE, (T64Word) 0 );
     
     if ( glb -> console -> isConsole( )) {
         
@@ -835,11 +934,11 @@ void SimCommandsWin::printWelcome( ) {
 //----------------------------------------------------------------------------------------
 int SimCommandsWin::buildCmdPrompt( char *promptStr, int promptStrLen ) {
     
-    if ( glb -> env -> getEnvVarBool((char *) ENV_SHOW_CMD_CNT )) {
+    if ( glb -> env -> getEnvVarBool( ENV_HDL_SHOW_CMD_CNT )) {
             
         return ( snprintf( promptStr, promptStrLen,
                            "(%i) ->",
-                           (int) glb -> env -> getEnvVarInt((char *) ENV_CMD_CNT )));
+                           (int) glb -> env -> getEnvVarInt( ENV_HDL_CMD_CNT )));
         }
     else return ( snprintf( promptStr, promptStrLen, "->" ));
 }
@@ -1141,8 +1240,124 @@ void SimCommandsWin::addMemModule( ) {
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::addIoModule( ) {
 
-    // ??? analog to mem...
+    int         modNum  = -1;
+    T64IoType   ioType  = T64_IO_NIL;
+    T64Word     spaAdr  = -1;
+    T64Word     spaLen  = T64_PAGE_SIZE_BYTES;
+    char        fileName[ MAX_FILE_PATH_SIZE ] = { 0 };
+
+    tok -> nextToken( );
+    while ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+
+        switch ( tok -> tokId( )) {
+
+            case TOK_MOD: {
+
+                tok -> nextToken( );
+                tok -> acceptEqual( );
+                if ( tok -> tokTyp( ) == TYP_NUM ) {
+
+                    modNum = eval -> acceptNumExpr( ERR_INVALID_ARG, 
+                                                    0, MAX_MODULES );
+                }
+                else throw( ERR_INVALID_ARG );
+                
+            } break;
+
+            case TOK_MOD_TYPE: {
+
+                tok -> nextToken( );
+                tok -> acceptEqual( );
+
+                if      ( tok -> isToken( TOK_IO_DISK )) ioType = T64_IO_DISK;
+                else if ( tok -> isToken( TOK_IO_UART )) ioType = T64_IO_UART;
+                else if ( tok -> isToken( TOK_IO_TIMER )) ioType = T64_IO_TIMER;
+                else throw( ERR_INVALID_ARG );
 
+            } break;
+
+            case TOK_MOD_SPA_ADR: {
+
+                tok -> nextToken( );
+                tok -> acceptEqual( );
+
+                if ( tok -> tokTyp( ) == TYP_NUM ) {
+
+                    spaAdr = eval -> acceptNumExpr( ERR_INVALID_ARG, 
+                                                    T64_IO_SPA_MEM_START, 
+                                                    T64_IO_SPA_MEM_LIMIT );
+                }
+                else throw( ERR_INVALID_ARG );
+
+            } break;
+
+            case TOK_MOD_SPA_LEN: {
+
+                tok -> nextToken( );
+                tok -> acceptEqual( );
+
+                if ( tok -> tokTyp( ) == TYP_NUM ) {
+
+                    spaLen = eval -> acceptNumExpr( ERR_INVALID_ARG, 
+                                                    0, UINT32_MAX );
+                }
+                else throw( ERR_INVALID_ARG );
+
+            } break;
+
+            case TOK_MOD_FILE: {
+
+                tok -> nextToken( );
+                tok -> acceptEqual( );
+
+                if ( tok -> tokTyp( ) == TYP_STR ) {
+
+                    strncpy( fileName, tok -> tokStr( ), MAX_FILE_PATH_SIZE - 1 );
+                }
+                else throw( ERR_EXPECTED_FILE_NAME );
+
+            } break;
+
+            default: throw( ERR_INVALID_MODULE_TYPE );
+        }
+
+        tok -> nextToken( );
+    }
+
+    tok -> checkEOS( );
+
+    if ( modNum == -1 ) throw( SimErrMsgId( ERR_EXPECTED_MOD_NUM ));
+    if (( ioType == T64_IO_NIL ) || ( spaAdr < 0 )) throw( SimErrMsgId( ERR_CREATE_IO_MODULE ));
+
+    T64IoModule *m      = nullptr;
+    bool        fileOk  = true;
+
+    if ( ioType == T64_IO_DISK ) {
+
+        T64Disk *d = new T64Disk( glb -> system, modNum, spaAdr, spaLen );
+        
+        if ( fileName[ 0 ] != '\0' ) fileOk = d -> attachImage( fileName );
+        m = d;
+    }
+    else if ( ioType == T64_IO_TIMER ) {
+
+        m = new T64Timer( glb -> system, modNum, spaAdr, spaLen );
+    }
+    else {
+
+        T64Uart *u = new T64Uart( glb -> system, modNum, spaAdr, spaLen );
+
+        if ( fileName[ 0 ] != '\0' ) fileOk = u -> setOutputFile( fileName );
+        m = u;
+    }
+
+    if (( ! fileOk ) || ( glb -> system -> addToModuleMap( m ) != 0 )) {
+
+        delete m;
+        throw( SimErrMsgId( ERR_CREATE_IO_MODULE )); 
+    }    
 }
 
 //----------------------------------------------------------------------------------------
@@ -1200,29 +1415,45 @@ void  SimCommandsWin::displayAbsMemContent( T64Word ofs, T64Word len, int rdx )
 
 //----------------------------------------------------------------------------------------
 // Display absolute memory content as code shown in assembler syntax. There is one
-// word per line.
+// word per line. The words are read and disassembled in blocks, the disassembler 
+// formats a whole block with one call. Words that cannot be read are marked.
 //
 //----------------------------------------------------------------------------------------
 void  SimCommandsWin::displayAbsMemContentAsCode( T64Word adr, T64Word len ) {
     
-    T64Word  index  = rounddown( adr, 4 );
-    T64Word  limit  = roundup(( index + len ), 4 );
-    T64Word  instr  = 0;
-    char     buf[ MAX_TEXT_FIELD_LEN ];
+    const int   BLOCK_SIZE  = 64;
+    const int   LINE_LEN    = MAX_TEXT_FIELD_LEN;
+    
+    T64Word     index       = rounddown( adr, 4 );
+    T64Word     limit       = roundup(( index + len ), 4 );
+    uint32_t    instr[ BLOCK_SIZE ];
+    bool        valid[ BLOCK_SIZE ];
+    char        buf[ BLOCK_SIZE * LINE_LEN ];
 
     while ( index < limit ) {
 
-        winOut -> printNumber( index, FMT_HEX_2_4_4 );
-        winOut -> writeChars( ": " );
+        int count = BLOCK_SIZE;
+        if ( count > ( limit - index ) / 4 ) count = (int) (( limit - index ) / 4 );
+        
+        for ( int i = 0; i < count; i++ ) {
+            
+            instr[ i ] = 0;
+            valid[ i ] = glb -> system -> readMem( index + ( i * 4 ), 
+                                                   (uint8_t *) &instr[ i ], 4 );
+        }
+        
+        disAsm -> formatInstrBlock( buf, LINE_LEN, instr, count, 16 );
+        
+        for ( int i = 0; i < count; i++ ) {
 
-        if ( glb -> system -> readMem( index, (uint8_t *) &instr, 4 )) {
+            winOut -> printNumber( index, FMT_HEX_2_4_4 );
+            winOut -> writeChars( ": " );
 
-            disAsm -> formatInstr( buf, sizeof( buf ), instr, 16 );
-            winOut -> writeChars( "%s\n", buf ); 
-        }
-        else winOut -> writeChars( "******\n" );
+            if ( valid[ i ] ) winOut -> writeChars( "%s\n", buf + ( i * LINE_LEN ));
+            else              winOut -> writeChars( "******\n" );
 
-        index += sizeof( uint32_t );
+            index += sizeof( uint32_t );
+        }
     }
     
     winOut -> writeChars( "\n" );
@@ -1282,40 +1513,26 @@ void SimCommandsWin::parseWinNumRange( int *winNumStart, int *winNumEnd ) {
 }
 
 //----------------------------------------------------------------------------------------
-// "execCmdsFromFile" will open a text file and interpret each line as a command. 
-// This routine is used by the "XF" command and also as the handler for the program
-// argument option to execute a file before entering the command loop.
+// "execCmdsFromFile" will execute the commands in a text file. This routine is used by
+// the "XF" command and also as the handler for the program argument option to execute
+// a file before entering the command loop. The file is compiled once and kept in the
+// command file cache. See the "SimCmdFileCache" for details.
 //
 // XF "<file-path>"
 //
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::execCmdsFromFile( char* fileName ) {
     
-    char cmdLineBuf[ MAX_CMD_LINE_SIZE ] = "";
+    int errLine = 0;
     
     try {
         
         if ( strlen( fileName ) > 0 ) {
             
-            FILE *f = fopen( fileName, "r" );
-            if ( f != nullptr ) {
-                
-                while ( ! feof( f )) {
-                    
-                    strcpy( cmdLineBuf, "" );
-                    fgets( cmdLineBuf, sizeof( cmdLineBuf ), f );
-                    cmdLineBuf[ strcspn( cmdLineBuf, "\r\n" ) ] = 0;
-                    
-                    if ( glb -> env -> getEnvVarBool((char *) ENV_ECHO_CMD_INPUT )) {
-                        
-                        winOut -> writeChars( "%s\n", cmdLineBuf );
-                    }
-                    
-                    removeComment( cmdLineBuf );
-                    evalInputLine( cmdLineBuf );
-                }
-            }
-            else throw( ERR_OPEN_EXEC_FILE );
+            SimCmdFile *cmdFile = cmdFiles -> getCmdFile( fileName, &errLine );
+            
+            runCmdFile( cmdFile );
+            cmdFiles -> releaseCmdFile( cmdFile );
         }
         else throw ( ERR_EXPECTED_FILE_NAME  );
     }
@@ -1329,12 +1546,124 @@ void SimCommandsWin::execCmdsFromFile( char* fileName ) {
                 winOut -> writeChars( "Error in opening file: \"%s\"", fileName );
                 
             } break;
+
+            case ERR_CMD_FILE_STRUCTURE: {
+
+                winOut -> writeChars( "Unbalanced IF, WHILE or LOOP in file: \"%s\", line %d\n",
+                                      fileName, errLine );
+
+            } break;
                 
             default: throw ( errNum );
         }
     }
 }
 
+//----------------------------------------------------------------------------------------
+// "runCmdFile" executes the operations of a compiled command file. A command 
+// operation sets up the tokenizer with the argument token list and then executes the
+// command just like "evalInputLine" would. Each line is echoed when it is executed, 
+// if enabled. The LOOP counters are kept on a small stack. Errors are reported and 
+// the execution continues with the next line.
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::runCmdFile( SimCmdFile *cmdFile ) {
+
+    T64Word loopCnt[ MAX_CMD_FILE_NESTING ];
+    int     loopTop = 0;
+    int     opIndex = 0;
+
+    while ( opIndex < cmdFile -> opCount ) {
+
+        SimCmdFileOp *op = &cmdFile -> ops[ opIndex++ ];
+
+        if ( glb -> env -> getEnvVarBool( ENV_HDL_ECHO_CMD_INPUT )) {
+                        
+            winOut -> writeChars( "%s\n", cmdFile -> text + op -> srcLineOfs );
+        }
+
+        switch ( op -> op ) {
+
+            case CF_OP_NOP:                                                 break;
+            case CF_OP_LINE: evalInputLine( cmdFile -> text + op -> cmdLineOfs ); break;
+            case CF_OP_JUMP: opIndex = op -> target;                        break;
+
+            case CF_OP_CMD: {
+
+                try {
+
+                    tok -> setupTokenList( cmdFile -> toks + op -> tokIndex, 
+                                           op -> tokCount );
+                    tok -> nextToken( );
+
+                    currentCmd = op -> cmdId;
+                    evalCmd( cmdFile -> text + op -> cmdLineOfs );
+                }
+
+                catch ( SimErrMsgId errNum ) {
+        
+                    glb -> env -> setEnvVar( ENV_HDL_EXIT_CODE, (T64Word) -1 );
+                    cmdLineError( errNum );
+                }
+
+            } break;
+
+            case CF_OP_JUMP_FALSE: {
+
+                if ( evalCmdFileExpr( cmdFile, op ) == 0 ) opIndex = op -> target;
+                
+            } break;
+
+            case CF_OP_LOOP: {
+
+                T64Word cnt = evalCmdFileExpr( cmdFile, op );
+
+                if ( cnt > 0 ) loopCnt[ loopTop++ ] = cnt;
+                else opIndex = op -> target;
+
+            } break;
+
+            case CF_OP_END_LOOP: {
+
+                if ( -- loopCnt[ loopTop - 1 ] > 0 ) opIndex = op -> target;
+                else loopTop --;
+
+            } break;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Evaluate the expression of an IF, WHILE or LOOP line. A boolean value is returned as
+// zero or one. An expression error is reported and the result is zero.
+//
+//----------------------------------------------------------------------------------------
+T64Word SimCommandsWin::evalCmdFileExpr( SimCmdFile *cmdFile, SimCmdFileOp *op ) {
+
+    SimExpr rExpr;
+
+    try {
+
+        tok -> setupTokenList( cmdFile -> toks + op -> tokIndex, op -> tokCount );
+        tok -> nextToken( );
+
+        eval -> parseCond( &rExpr );
+        tok -> checkEOS( );
+
+        if      ( rExpr.typ == TYP_BOOL ) return(( rExpr.u.bVal ) ? 1 : 0 );
+        else if ( rExpr.typ == TYP_NUM  ) return( rExpr.u.val );
+        else if ( rExpr.typ == TYP_NIL  ) throw ( ERR_EXPECTED_EXPR );
+        else                              throw ( ERR_EXPR_TYPE_MATCH );
+    }
+
+    catch ( SimErrMsgId errNum ) {
+        
+        glb -> env -> setEnvVar( ENV_HDL_EXIT_CODE, (T64Word) -1 );
+        cmdLineError( errNum );
+        return( 0 );
+    }
+}
+
 //----------------------------------------------------------------------------------------
 // Help command. With no arguments, a short help overview is printed. There are 
 // commands, widow commands and predefined functions.
@@ -1403,9 +1732,11 @@ void SimCommandsWin::helpCmd( ) {
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::exitCmd( ) {
     
+    glb -> console -> flushOutput( );
+
     if ( tok -> isToken( TOK_EOS )) {
         
-        int exitVal = glb -> env -> getEnvVarInt((char *) ENV_EXIT_CODE );
+        int exitVal = glb -> env -> getEnvVarInt( ENV_HDL_EXIT_CODE );
         exit(( exitVal > 255 ) ? 255 : exitVal );
     }
     else {
@@ -1674,7 +2005,8 @@ void SimCommandsWin::displayWindowCmd( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Reset command.
+// Reset command. A reset is not part of a recording, a recording or replay in 
+// progress is stopped. The log of a recording can still be saved.
 //
 //  RESET [ ( 'SYS' | 'STATS' ) ]
 //
@@ -1684,6 +2016,7 @@ void SimCommandsWin::resetCmd( ) {
     
     if ( tok -> isToken( TOK_EOS )) {
         
+        if ( glb -> replay != nullptr ) glb -> replay -> stop( );
         glb -> system -> reset( );
     }
     else if ( tok -> isToken( TOK_SYS )) {
@@ -1698,15 +2031,91 @@ void SimCommandsWin::resetCmd( ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Run command. The command will just run the CPU until a "halt" instruction is 
-// detected.
+// Run command. The command will run all processors until they halted, i.e. branch to
+// themselves, or the user presses the interrupt key. The simulation runs in large 
+// quanta of steps. After each quantum, the console is polled in non-blocking mode 
+// for the interrupt key and the windows are refreshed at most every RUN_REFRESH_MS 
+// milliseconds. This way, the simulation runs at full speed and the display stays 
+// alive. When the input does not come from a terminal, there is no polling and we 
+// run until the processors halted. When there is a console UART, all characters 
+// other than the interrupt key are passed to the first UART and the UART output is
+// shown in the command window after each quantum. A breakpoint or watchpoint hit 
+// also ends the run.
 //
 //  RUN
 //
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::runCmd( ) {
     
-    winOut -> writeChars( "RUN command to come ... \n");
+    T64Processor    *procs[ MAX_MOD_MAP_ENTRIES ];
+    T64Uart         *uarts[ MAX_MOD_MAP_ENTRIES ];
+    T64Word         startCycle  = glb -> system -> getCycleCount( );
+    bool            halted      = false;
+    bool            interrupted = false;
+    bool            stopped     = false;
+    bool            pollKeys    = glb -> console -> isConsole( );
+
+    tok -> checkEOS( );
+
+    int numProcs = getProcessorModules( glb -> system, procs );
+    if ( numProcs == 0 ) throw ( ERR_NO_PROC_MODULE );
+
+    int numUarts = getUartModules( glb -> system, uarts );
+
+    winOut -> writeChars( "Running, press Ctrl-E to stop\n" );
+    glb -> winDisplay -> reDraw( );
+
+    attachDebug( glb );
+
+    if ( pollKeys ) glb -> console -> setBlockingMode( false );
+
+    auto lastRefresh = std::chrono::steady_clock::now( );
+
+    while (( ! halted ) && ( ! interrupted ) && ( ! stopped )) {
+
+        glb -> system -> step( RUN_STEP_QUANTUM );
+        stopped = glb -> system -> isStopRequested( );
+
+        if ( ! stopped ) {
+
+            halted  = allProcessorsHalted( glb -> system, procs, numProcs );
+            stopped = glb -> system -> isStopRequested( );
+        }
+
+        if ( pollKeys ) {
+
+            char    keys[ MAX_WIN_OUT_LINE_SIZE ];
+            int     numKeys = 0;
+            int     ch;
+            
+            while (( ch = glb -> console -> readChar( )) > 0 ) {
+
+                if      ( ch == RUN_INTERRUPT_KEY ) interrupted = true;
+                else if ( numKeys < MAX_WIN_OUT_LINE_SIZE ) keys[ numKeys++ ] = (char) ch;
+            }
+
+            if (( numUarts > 0 ) && ( numKeys > 0 )) uarts[ 0 ] -> putRx( keys, numKeys );
+        }
+
+        if ( numUarts > 0 ) drainUartOutput( winOut, uarts, numUarts );
+
+        auto now = std::chrono::steady_clock::now( );
+
+        if ( std::chrono::duration_cast<std::chrono::milliseconds>( now - lastRefresh ).count( ) 
+             >= RUN_REFRESH_MS ) {
+
+            glb -> winDisplay -> reDraw( );
+            lastRefresh = now;
+        }
+    }
+
+    if ( pollKeys ) glb -> console -> setBlockingMode( true );
+
+    if ( stopped ) reportStop( winOut, glb );
+
+    winOut -> writeChars( "%s after %lld steps\n", 
+                          ( halted ) ? "Halted" : "Stopped",
+                          (long long) ( glb -> system -> getCycleCount( ) - startCycle ));
 }
 
 //----------------------------------------------------------------------------------------
@@ -1720,6 +2129,8 @@ void SimCommandsWin::runCmd( ) {
 // window. Put the console mode into non-blocking and hand over to the CPU. On 
 // return from the CPU steps, enable blocking mode again and restore the current 
 // window.
+//
+// A breakpoint or watchpoint hit ends the stepping early.
 // 
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::stepCmd( ) {
@@ -1732,7 +2143,323 @@ void SimCommandsWin::stepCmd( ) {
     }
     
     tok -> checkEOS( );
+
+    attachDebug( glb );
     glb -> system -> step( numOfSteps );
+    reportStop( winOut, glb );
+}
+
+//----------------------------------------------------------------------------------------
+// Trace command. With a file path argument, the cache and TLB access trace is started
+// for all processors and written to the file. Without an argument, a running trace is
+// stopped and the file is closed. The trace file can be replayed with the trace
+// replay program against all cache and TLB configurations.
+//
+//  TRACE [ "<filePath>" ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::traceCmd( ) {
+
+    T64TraceWriter *trace = nullptr;
+
+    if ( tok -> tokTyp( ) == TYP_STR ) {
+
+        if ( glb -> trace == nullptr ) glb -> trace = new T64TraceWriter( );
+
+        if ( ! glb -> trace -> open( tok -> tokStr( ))) throw ( ERR_OPEN_TRACE_FILE );
+
+        trace = glb -> trace;
+        tok -> nextToken( );
+    }
+
+    tok -> checkEOS( );
+
+    for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+        T64Module *mPtr = glb -> system -> lookupByModNum( i );
+
+        if (( mPtr != nullptr ) && ( mPtr -> getModuleType( ) == MT_PROC )) {
+
+            ((T64Processor *) mPtr ) -> setTrace( trace );
+        }
+    }
+
+    if (( trace == nullptr ) && ( glb -> trace != nullptr ) && ( glb -> trace -> isOpen( ))) {
+
+        glb -> trace -> close( );
+        winOut -> writeChars( "Trace closed, %lld records\n",
+                              (long long) glb -> trace -> getRecordCount( ));
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Record command. With a file path argument, a recording of the system inputs starts
+// at the current cycle. The file is written right away, so that a bad path shows up
+// at the start. Without an argument, the recording is stopped and the log is saved 
+// to the file. A recording contains the console input, the timer wall clock values
+// and the disk image data. For a replay, the program has to be loaded the same way.
+//
+//  REC [ "<filePath>" ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::recordCmd( ) {
+
+    if ( tok -> tokTyp( ) == TYP_STR ) {
+
+        if ( glb -> replay == nullptr ) glb -> replay = new T64Replay( glb -> system );
+
+        strncpy( glb -> recFileName, tok -> tokStr( ), MAX_FILE_PATH_SIZE - 1 );
+        tok -> nextToken( );
+        tok -> checkEOS( );
+
+        glb -> replay -> startRecording( );
+
+        if ( ! glb -> replay -> saveLog( glb -> recFileName )) {
+
+            glb -> replay -> stop( );
+            glb -> recFileName[ 0 ] = '\0';
+            throw ( ERR_OPEN_REPLAY_FILE );
+        }
+    }
+    else {
+
+        tok -> checkEOS( );
+
+        if (( glb -> replay == nullptr ) || ( glb -> recFileName[ 0 ] == '\0' )) 
+            throw ( ERR_REPLAY_NOT_ACTIVE );
+
+        glb -> replay -> stop( );
+
+        if ( ! glb -> replay -> saveLog( glb -> recFileName )) throw ( ERR_OPEN_REPLAY_FILE );
+
+        glb -> recFileName[ 0 ] = '\0';
+        winOut -> writeChars( "Recording saved, %lld records, %lld bytes\n",
+                              (long long) glb -> replay -> getRecordCount( ),
+                              (long long) glb -> replay -> getLogSize( ));
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Replay command. With a file path argument, the log is loaded and replayed from the
+// current cycle, which must be the cycle at which the recording started. The host 
+// inputs are ignored during the replay. At the end of the log, the replay continues
+// as a recording. Without an argument, a replay in progress is stopped.
+//
+//  REPLAY [ "<filePath>" ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::replayCmd( ) {
+
+    if ( tok -> tokTyp( ) == TYP_STR ) {
+
+        if ( glb -> replay == nullptr ) glb -> replay = new T64Replay( glb -> system );
+
+        char fileName[ MAX_FILE_PATH_SIZE ] = { 0 };
+
+        strncpy( fileName, tok -> tokStr( ), MAX_FILE_PATH_SIZE - 1 );
+        tok -> nextToken( );
+        tok -> checkEOS( );
+
+        glb -> recFileName[ 0 ] = '\0';
+
+        if ( ! glb -> replay -> loadLog( fileName )) throw ( ERR_OPEN_REPLAY_FILE );
+        if ( ! glb -> replay -> startReplay( )) throw ( ERR_REPLAY_START_CYCLE );
+
+        winOut -> writeChars( "Replay started, %lld records\n",
+                              (long long) glb -> replay -> getRecordCount( ));
+    }
+    else {
+
+        tok -> checkEOS( );
+
+        if (( glb -> replay == nullptr ) || 
+            ( glb -> replay -> getMode( ) != T64_RPM_REPLAY )) throw ( ERR_REPLAY_NOT_ACTIVE );
+
+        glb -> replay -> stop( );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Reverse step command. The system goes back by the number of cycles, the default is
+// one cycle. This works during a recording or a replay. The system state is restored
+// from the last snapshot before the target cycle and the log is replayed from there.
+// Breakpoints and watchpoints are not checked on the way. The snapshots become 
+// sparser as a recording grows, a long way back may therefore take a while.
+//
+//  RS [ <cycles> ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::reverseStepCmd( ) {
+
+    T64Word numOfCycles = 1;
+
+    if ( tok -> tokTyp( ) == TYP_NUM ) {
+
+        numOfCycles = eval -> acceptNumExpr( ERR_EXPECTED_STEPS, 0, UINT32_MAX );
+    }
+
+    tok -> checkEOS( );
+
+    if (( glb -> replay == nullptr ) || ( glb -> replay -> getMode( ) == T64_RPM_OFF )) 
+        throw ( ERR_REPLAY_NOT_ACTIVE );
+
+    T64Word cycle = glb -> system -> getCycleCount( ) - numOfCycles;
+
+    if ( cycle < glb -> replay -> getFirstSnapshotCycle( )) throw ( ERR_REPLAY_CYCLE_RANGE );
+
+    setProcDebug( glb, nullptr );
+
+    if ( ! glb -> replay -> gotoCycle( cycle )) {
+
+        if ( ! glb -> replay -> isDiverged( )) throw ( ERR_REPLAY_CYCLE_RANGE );
+        reportStop( winOut, glb );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Breakpoint commands. A breakpoint is set on an instruction address, a watchpoint on
+// a data address range with an access mode. The default watchpoint length is one
+// word, the default mode is WRITE. The addresses are virtual or physical, just as the
+// processor uses them. Breakpoints and watchpoints are checked when running or
+// stepping the system.
+//
+// A breakpoint can have a condition, such as "R3 == 0x100 && C9 > 5". The condition
+// is compiled once when the breakpoint is set and only evaluated when a processor
+// reaches the instruction address. Setting a breakpoint again replaces its condition.
+// For the breakpoint list, we keep the condition text as entered.
+//
+//  BP <adr> [ , <cond> ]
+//  WP <adr> [ , <len> [ , ( READ | WRITE | ANY ) ]]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::setBreakpointCmd( char *cmdBuf ) {
+
+    T64StopCond cond;
+    char        *condText = nullptr;
+    T64Word     adr       = eval -> acceptNumExpr( ERR_INVALID_NUM, 
+                                                   0, 
+                                                   T64_MAX_VIRT_MEM_LIMIT );
+
+    if ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+        eval -> compileCond( &cond );
+        if ( cond.isEmpty( )) throw ( ERR_EXPECTED_EXPR );
+
+        condText = findCondText( cmdBuf );
+    }
+
+    tok -> checkEOS( );
+
+    if ( glb -> debug == nullptr ) glb -> debug = new T64Debug( glb -> system );
+    if ( ! glb -> debug -> addBreakpoint( adr, &cond, condText )) 
+        throw ( ERR_DEBUG_TABLE_FULL );
+}
+
+void SimCommandsWin::setWatchpointCmd( ) {
+
+    T64Word         len     = sizeof( T64Word );
+    T64WatchMode    mode    = T64_WATCH_WRITE;
+    T64Word         adr     = eval -> acceptNumExpr( ERR_INVALID_NUM, 
+                                                     0, 
+                                                     T64_MAX_VIRT_MEM_LIMIT );
+
+    if ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+        if ( ! tok -> isToken( TOK_COMMA )) {
+
+            len = eval -> acceptNumExpr( ERR_EXPECTED_LEN, 1, T64_MAX_VIRT_MEM_LIMIT );
+        }
+    }
+
+    if ( tok -> isToken( TOK_COMMA )) {
+
+        tok -> nextToken( );
+
+        if      ( tok -> isTokenIdent((char *) "READ" ))  mode = T64_WATCH_READ;
+        else if ( tok -> isTokenIdent((char *) "WRITE" )) mode = T64_WATCH_WRITE;
+        else if ( tok -> isTokenIdent((char *) "ANY" ))   mode = T64_WATCH_READ_WRITE;
+        else throw ( ERR_INVALID_WATCH_MODE );
+
+        tok -> nextToken( );
+    }
+
+    tok -> checkEOS( );
+
+    if ( glb -> debug == nullptr ) glb -> debug = new T64Debug( glb -> system );
+    if ( ! glb -> debug -> addWatchpoint( adr, len, mode )) throw ( ERR_DEBUG_TABLE_FULL );
+}
+
+//----------------------------------------------------------------------------------------
+// List the breakpoints and watchpoints.
+//
+//  BL
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::listStopPointsCmd( ) {
+
+    tok -> checkEOS( );
+
+    if (( glb -> debug == nullptr ) || ( glb -> debug -> isEmpty( ))) {
+
+        winOut -> writeChars( "No breakpoints or watchpoints\n" );
+        return;
+    }
+
+    for ( int i = 0; i < glb -> debug -> getBreakpointCount( ); i++ ) {
+
+        T64Breakpoint *bp = glb -> debug -> getBreakpoint( i );
+
+        winOut -> writeChars( "BP  " );
+        winOut -> printNumber( bp -> adr, FMT_PREFIX_0X | FMT_HEX_4_4_4_4 );
+        if ( bp -> condText[ 0 ] != '\0' ) winOut -> writeChars( "  when %s", bp -> condText );
+        winOut -> writeChars( "\n" );
+    }
+
+    for ( int i = 0; i < glb -> debug -> getWatchpointCount( ); i++ ) {
+
+        T64Watchpoint *wp = glb -> debug -> getWatchpoint( i );
+
+        winOut -> writeChars( "WP  " );
+        winOut -> printNumber( wp -> adr, FMT_PREFIX_0X | FMT_HEX_4_4_4_4 );
+        winOut -> writeChars( "  len: %lld  %s\n", 
+                              (long long) wp -> len,
+                              ( wp -> mode == T64_WATCH_READ )  ? "READ" :
+                              ( wp -> mode == T64_WATCH_WRITE ) ? "WRITE" : "ANY" );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Clear breakpoints and watchpoints. With an address, the breakpoint and watchpoint
+// at this address are cleared. Without an address, all of them are cleared.
+//
+//  BC [ <adr> ]
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::clearStopPointsCmd( ) {
+
+    if ( tok -> isToken( TOK_EOS )) {
+
+        if ( glb -> debug != nullptr ) {
+
+            glb -> debug -> clearBreakpoints( );
+            glb -> debug -> clearWatchpoints( );
+        }
+
+        return;
+    }
+
+    T64Word adr = eval -> acceptNumExpr( ERR_INVALID_NUM, 0, T64_MAX_VIRT_MEM_LIMIT );
+
+    tok -> checkEOS( );
+
+    if ( glb -> debug == nullptr ) throw ( ERR_DEBUG_ENTRY_NOT_FOUND );
+
+    bool found = glb -> debug -> removeBreakpoint( adr );
+    found |= glb -> debug -> removeWatchpoint( adr );
+
+    if ( ! found ) throw ( ERR_DEBUG_ENTRY_NOT_FOUND );
 }
 
 //----------------------------------------------------------------------------------------
@@ -1746,7 +2473,7 @@ void SimCommandsWin::writeLineCmd( ) {
     SimExpr  rExpr;
     int      rdx;
     
-    eval -> parseExpr( &rExpr );
+    eval -> parseCond( &rExpr );
     
     if ( tok -> isToken( TOK_COMMA )) {
         
@@ -1758,7 +2485,7 @@ void SimCommandsWin::writeLineCmd( ) {
         }
         else throw ( ERR_INVALID_FMT_OPT );
     }
-    else rdx = glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT );
+    else rdx = glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT );
     
     tok -> checkEOS( );
     
@@ -1893,7 +2620,7 @@ void SimCommandsWin::redoCmd( ) {
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::displayAbsMemCmd( ) {
     
-    int         rdx     = glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT );
+    int         rdx     = glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT );
     T64Word     ofs     = 0;
     T64Word     len     = sizeof( T64Word );
     bool        asCode  = false;
@@ -2279,7 +3006,7 @@ void SimCommandsWin::winEnableCmd( bool enable ) {
 void SimCommandsWin::winSetRadixCmd( ) {
 
    
-    int rdx     = glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT );
+    int rdx     = glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT );
     int winNum  = -1;
    
     if ( tok -> isToken( TOK_EOS )) {
@@ -2289,7 +3016,7 @@ void SimCommandsWin::winSetRadixCmd( ) {
     }
     else if ( tok -> isToken( TOK_COMMA )) {
         
-        rdx = glb -> env -> getEnvVarInt((char *) ENV_RDX_DEFAULT );
+        rdx = glb -> env -> getEnvVarInt( ENV_HDL_RDX_DEFAULT );
         tok -> nextToken( );
 
         winNum = eval -> acceptNumExpr( ERR_EXPECTED_WIN_ID, 1, MAX_WINDOWS );
@@ -2778,9 +3505,8 @@ void SimCommandsWin::winSetStackCmd( ) {
 
 //----------------------------------------------------------------------------------------
 // Evaluate input line. There are commands, functions, expressions and so on. This 
-// routine sets up the tokenizer and dispatches based on the first token in the input
-// line. The commands are also added to the command history, with the exception of 
-// the HITS, DO and REDOP commands.
+// routine sets up the tokenizer and executes the command found as the first token in
+// the input line.
 //
 //----------------------------------------------------------------------------------------
 void SimCommandsWin::evalInputLine( char *cmdBuf ) {
@@ -2789,7 +3515,7 @@ void SimCommandsWin::evalInputLine( char *cmdBuf ) {
         
         if ( strlen( cmdBuf ) > 0 ) {
             
-            tok -> setupTokenizer( cmdBuf, (SimToken *) cmdTokTab );
+            tok -> setupTokenizer( cmdBuf );
             tok -> nextToken( );
             
             if (( tok -> isTokenTyp( TYP_CMD )) || ( tok -> isTokenTyp( TYP_WCMD ))) {
@@ -2797,87 +3523,12 @@ void SimCommandsWin::evalInputLine( char *cmdBuf ) {
                 currentCmd = tok -> tokId( );
                 tok -> nextToken( );
                 
-                if (( currentCmd != CMD_HIST ) &&
-                    ( currentCmd != CMD_DO ) &&
-                    ( currentCmd != CMD_REDO )) {
-                    
-                    hist -> addCmdLine( cmdBuf );
-                    glb -> env -> 
-                        setEnvVar((char *) ENV_CMD_CNT, (T64Word) hist -> getCmdNum( ));
-                }
-                
-                switch( currentCmd ) {
-                        
-                    case TOK_NIL:                                           break;
-                    case CMD_EXIT:          exitCmd( );                     break;
-                        
-                    case CMD_HELP:          helpCmd( );                     break;
-                    case CMD_ENV:           envCmd( );                      break;
-                    case CMD_XF:            execFileCmd( );                 break;
-                    case CMD_LF:            loadElfFileCmd( );              break;
-                        
-                    case CMD_WRITE_LINE:    writeLineCmd( );                break;
-                        
-                    case CMD_HIST:          histCmd( );                     break;
-                    case CMD_DO:            doCmd( );                       break;
-                    case CMD_REDO:          redoCmd( );                     break;
-                        
-                    case CMD_RESET:         resetCmd( );                    break;
-                    case CMD_RUN:           runCmd( );                      break;
-                    case CMD_STEP:          stepCmd( );                     break;
-
-                    case CMD_NM:            addModuleCmd( );                break;
-                    case CMD_RM:            removeModuleCmd( );             break;
-                    case CMD_DM:            displayModuleCmd( );            break;   
-
-                    case CMD_DW:            displayWindowCmd( );            break;  
-
-                    case CMD_MR:            modifyRegCmd( );                break;
-                        
-                    case CMD_DA:            displayAbsMemCmd( );            break;
-                    case CMD_MA:            modifyAbsMemCmd( );             break;
-                        
-                    case CMD_ITLB_I: 
-                    case CMD_ITLB_D:        insertTLBCmd( );                break;
-
-                    case CMD_PTLB_I:
-                    case CMD_PTLB_D:        purgeTLBCmd( );                 break;
-                        
-                    case CMD_PCA_I:  
-                    case CMD_PCA_D:         purgeCacheCmd( );               break;
-
-                    case CMD_FCA_D:         flushCacheCmd( );               break;
-                        
-                    case CMD_WON:           winOnCmd( );                    break;
-                    case CMD_WOFF:          winOffCmd( );                   break;
-                    case CMD_WDEF:          winDefCmd( );                   break;
-                    case CMD_WSE:           winStacksEnableCmd( true );     break;
-                    case CMD_WSD:           winStacksEnableCmd( false );    break;
-                        
-                    case CMD_WC:            winCurrentCmd( );               break;
-                    case CMD_WN:            winNewWinCmd( );                break;
-                    case CMD_WK:            winKillWinCmd( );               break;
-                    case CMD_WS:            winSetStackCmd( );              break;
-                    case CMD_WT:            winToggleCmd( );                break;
-                    case CMD_WX:            winExchangeCmd( );              break;
-                    case CMD_WF:            winForwardCmd( );               break;
-                    case CMD_WB:            winBackwardCmd( );              break;
-                    case CMD_WH:            winHomeCmd( );                  break;
-                    case CMD_WJ:            winJumpCmd( );                  break;
-                    case CMD_WE:            winEnableCmd( true );           break;
-                    case CMD_WD:            winEnableCmd( false );          break;
-                    case CMD_WR:            winSetRadixCmd( );              break;    
-                    case CMD_CWL:           winSetCmdWinRowsCmd( );         break;
-                    case CMD_CWC:           winClearCmdWinCmd( );           break;
-                    case CMD_WL:            winSetRowsCmd( );               break;
-                        
-                    default:                throw ( ERR_INVALID_CMD );
-                }
+                evalCmd( cmdBuf );
             }
             else {
             
                 hist -> addCmdLine( cmdBuf );
-                glb -> env -> setEnvVar((char *) ENV_CMD_CNT, 
+                glb -> env -> setEnvVar( ENV_HDL_CMD_CNT, 
                                         (T64Word) hist -> getCmdNum( ));
                 throw ( ERR_INVALID_CMD );
             }
@@ -2886,11 +3537,116 @@ void SimCommandsWin::evalInputLine( char *cmdBuf ) {
     
     catch ( SimErrMsgId errNum ) {
         
-        glb -> env -> setEnvVar((char *) ENV_EXIT_CODE, (T64Word) -1 );
+        glb -> env -> setEnvVar( ENV_HDL_EXIT_CODE, (T64Word) -1 );
         cmdLineError( errNum );
     }
 }
 
+//----------------------------------------------------------------------------------------
+// Execute a command. The tokenizer is set up to return the first argument token and
+// the current command is set. The command is dispatched based on its token Id. The 
+// commands are also added to the command history, with the exception of the HITS, DO
+// and REDO commands. The compiled command files also use this routine.
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::evalCmd( char *cmdBuf ) {
+    
+    if (( currentCmd != CMD_HIST ) &&
+        ( currentCmd != CMD_DO ) &&
+        ( currentCmd != CMD_REDO )) {
+        
+        hist -> addCmdLine( cmdBuf );
+        glb -> env -> 
+            setEnvVar( ENV_HDL_CMD_CNT, (T64Word) hist -> getCmdNum( ));
+    }
+    
+    switch( currentCmd ) {
+            
+        case TOK_NIL:                                           break;
+        case CMD_EXIT:          exitCmd( );                     break;
+            
+        case CMD_HELP:          helpCmd( );                     break;
+        case CMD_ENV:           envCmd( );                      break;
+        case CMD_XF:            execFileCmd( );                 break;
+        case CMD_LF:            loadElfFileCmd( );              break;
+            
+        case CMD_WRITE_LINE:    writeLineCmd( );                break;
+            
+        case CMD_HIST:          histCmd( );                     break;
+        case CMD_DO:            doCmd( );                       break;
+        case CMD_REDO:          redoCmd( );                     break;
+            
+        case CMD_RESET:         resetCmd( );                    break;
+        case CMD_RUN:           runCmd( );                      break;
+        case CMD_STEP:          stepCmd( );                     break;
+        case CMD_TRACE:         traceCmd( );                    break;
+
+        case CMD_BP:            setBreakpointCmd( cmdBuf );     break;
+        case CMD_WP:            setWatchpointCmd( );            break;
+        case CMD_BL:            listStopPointsCmd( );           break;
+        case CMD_BC:            clearStopPointsCmd( );          break;
+
+        case CMD_REC:           recordCmd( );                   break;
+        case CMD_REPLAY:        replayCmd( );                   break;
+        case CMD_RS:            reverseStepCmd( );              break;
+
+        case CMD_NM:            addModuleCmd( );                break;
+        case CMD_RM:            removeModuleCmd( );             break;
+        case CMD_DM:            displayModuleCmd( );            break;   
+
+        case CMD_DW:            displayWindowCmd( );            break;  
+
+        case CMD_MR:            modifyRegCmd( );                break;
+            
+        case CMD_DA:            displayAbsMemCmd( );            break;
+        case CMD_MA:            modifyAbsMemCmd( );             break;
+            
+        case CMD_ITLB_I: 
+        case CMD_ITLB_D:        insertTLBCmd( );                break;
+
+        case CMD_PTLB_I:
+        case CMD_PTLB_D:        purgeTLBCmd( );                 break;
+            
+        case CMD_PCA_I:  
+        case CMD_PCA_D:         purgeCacheCmd( );               break;
+
+        case CMD_FCA_D:         flushCacheCmd( );               break;
+            
+        case CMD_WON:           winOnCmd( );                    break;
+        case CMD_WOFF:          winOffCmd( );                   break;
+        case CMD_WDEF:          winDefCmd( );                   break;
+        case CMD_WSE:           winStacksEnableCmd( true );     break;
+        case CMD_WSD:           winStacksEnableCmd( false );    break;
+            
+        case CMD_WC:            winCurrentCmd( );               break;
+        case CMD_WN:            winNewWinCmd( );                break;
+        case CMD_WK:            winKillWinCmd( );               break;
+        case CMD_WS:            winSetStackCmd( );              break;
+        case CMD_WT:            winToggleCmd( );                break;
+        case CMD_WX:            winExchangeCmd( );              break;
+        case CMD_WF:            winForwardCmd( );               break;
+        case CMD_WB:            winBackwardCmd( );              break;
+        case CMD_WH:            winHomeCmd( );                  break;
+        case CMD_WJ:            winJumpCmd( );                  break;
+        case CMD_WE:            winEnableCmd( true );           break;
+        case CMD_WD:            winEnableCmd( false );          break;
+        case CMD_WR:            winSetRadixCmd( );              break;    
+        case CMD_CWL:           winSetCmdWinRowsCmd( );         break;
+        case CMD_CWC:           winClearCmdWinCmd( );           break;
+        case CMD_WL:            winSetRowsCmd( );               break;
+
+        case CMD_IF:
+        case CMD_ELSE:
+        case CMD_ENDIF:
+        case CMD_WHILE:
+        case CMD_ENDWHILE:
+        case CMD_LOOP:
+        case CMD_ENDLOOP:       throw ( ERR_CMD_FILE_ONLY );
+            
+        default:                throw ( ERR_INVALID_CMD );
+    }
+}
+
 //----------------------------------------------------------------------------------------
 // "cmdLoop" is the command line input interpreter. The basic loop is to prompt for
 // the next input, read the input and evaluates it. If we are in windows mode, we also
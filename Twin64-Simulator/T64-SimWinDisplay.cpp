@@ -349,6 +349,9 @@ void SimWinDisplay::setWindowOrigins( int winStack, int rowOffset, int colOffset
 // chance to resize itself. However, the resetting of the terminal size is only
 // done after the next command input.
 //
+// The windows are drawn as one frame into the console shadow screen buffer. Only the
+// screen cells that changed since the last frame are sent to the terminal.
+//
 //----------------------------------------------------------------------------------------
 void SimWinDisplay::reDraw( ) {
     
@@ -358,7 +361,7 @@ void SimWinDisplay::reDraw( ) {
     int maxRowsNeeded                       = 0;
     int maxColumnsNeeded                    = 0;
     int stackColumnGap                      = 2;
-    int minRowSize = glb -> env -> getEnvVarInt((char *) ENV_WIN_MIN_ROWS );
+    int minRowSize = glb -> env -> getEnvVarInt( ENV_HDL_WIN_MIN_ROWS );
     
     if ( winModeOn ) {
        
@@ -448,6 +451,9 @@ void SimWinDisplay::reDraw( ) {
             glb -> console -> setScrollArea( 2, maxRowsNeeded );
     }
     
+    glb -> console -> beginFrame(( actualRows > maxRowsNeeded ) ? actualRows : maxRowsNeeded,
+                                 ( actualCols > maxColumnsNeeded ) ? actualCols : maxColumnsNeeded );
+
     if ( winModeOn ) {
 
         for ( int i = 0; i < MAX_WINDOWS; i++ ) {
@@ -458,6 +464,7 @@ void SimWinDisplay::reDraw( ) {
     }
     
     cmdWin -> reDraw( );
+    glb -> console -> endFrame( );
     glb -> console -> setAbsCursor( maxRowsNeeded, 1 );
     winReFormatPending = false;
 }
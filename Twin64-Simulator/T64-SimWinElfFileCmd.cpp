@@ -87,13 +87,13 @@ bool elfioValidate( elfio *reader, char* msg, int msg_len ) {
 }
 
 //----------------------------------------------------------------------------------------
-// Write a word to the simulator memory.
+// Write a word to the simulator memory. The word is passed in host byte order, the
+// memory module stores it in big endian order.
 //
 //----------------------------------------------------------------------------------------
 bool writeMem( T64System *sys, uint32_t ofs, uint32_t val ) {
 
-   
-    return( true );
+    return( sys -> writeMem( ofs, (uint8_t *) &val, sizeof( val )));
 }
 
 //----------------------------------------------------------------------------------------
@@ -124,15 +124,18 @@ void loadSegmentIntoMemory( elfio           *reader,
         Elf_Xword       align       = segment -> get_align( );
         Elf_Word        flags       = segment -> get_flags( );
 
-        winOut -> writeChars( "Loading: Seg: %2d, adr: 0x%08x, "
-                              "mSize: 0x%08x, align: 0x%08x, ",
-                              index, vAdr, memorySize, align );
+        if ( winOut != nullptr ) {
+
+            winOut -> writeChars( "Loading: Seg: %2d, adr: 0x%08x, "
+                                  "mSize: 0x%08x, align: 0x%08x, ",
+                                  index, vAdr, memorySize, align );
         
-        winOut -> writeChars( "R" );
-        if ( flags & SHF_WRITE )     winOut -> writeChars( "W" );
-        if ( flags & SHF_EXECINSTR ) winOut -> writeChars( "X" );
+            winOut -> writeChars( "R" );
+            if ( flags & SHF_WRITE )     winOut -> writeChars( "W" );
+            if ( flags & SHF_EXECINSTR ) winOut -> writeChars( "X" );
        
-        winOut -> writeChars( "\n" );
+            winOut -> writeChars( "\n" );
+        }
     
         if ( memorySize >= T64_MAX_PHYS_MEM_LIMIT ) {
             
@@ -153,7 +156,7 @@ void loadSegmentIntoMemory( elfio           *reader,
             
            if ( ! writeMem( sys, uint32_t( vAdr + i ), 0 )) {
 
-                throw( 99 ); // ??? fix ....
+                throw( ERR_ELF_INVALID_ADR_RANGE );
            }
         }
         
@@ -170,42 +173,71 @@ void loadSegmentIntoMemory( elfio           *reader,
 //----------------------------------------------------------------------------------------
 // Loading a basic ELF file. This routine is rather simple. All we do is to locate 
 // the segments and load them into physical memory. Could be refined and do more 
-// checking one day.
+// checking one day. The routine is used by the load command and the batch mode, 
+// which has no output window. Errors are thrown, the reader is closed in any case.
 //
 //----------------------------------------------------------------------------------------
-void SimCommandsWin::loadElfFile( char *fileName ) {
+T64Word loadElfFileIntoMemory( T64System *sys, char *fileName, SimWinOutBuffer *winOut ) {
     
-    elfio *reader = nullptr;
-    char  errMsgBuf[ 256 ];
+    elfio       *reader = nullptr;
+    Elf64_Addr  entry   = 0;
+    char        errMsgBuf[ 256 ] = { 0 };
     
     try {
         
-        winOut -> writeChars( "Loading %s\n", fileName );
-        
         reader = openElfFile( fileName );
       
         if ( ! elfioValidate( reader, errMsgBuf, sizeof( errMsgBuf ))) {
             
-            winOut -> writeChars( "ELF: %s\n", errMsgBuf );
-            throw( 99 );
+            if ( winOut != nullptr ) winOut -> writeChars( "ELF: %s\n", errMsgBuf );
+            throw( ERR_INVALID_ELF_FILE );
         }
         
         Elf_Half numOfSeg = reader -> segments.size( );
         
         for ( int i = 0; i < numOfSeg; i++ ) {
             
-            loadSegmentIntoMemory(  reader, 
-                                    reader -> segments[ i ], 
-                                    glb -> system, 
-                                    winOut );
+            loadSegmentIntoMemory( reader, reader -> segments[ i ], sys, winOut );
         }
         
-        Elf64_Addr entry = reader -> get_entry( );
+        entry = reader -> get_entry( );
+    }
+    
+    catch ( ... ) {
+        
+        if ( reader != nullptr ) closeElfFile( reader );
+        throw;
+    }
+    
+    closeElfFile( reader );
+    return( entry );
+}
+
+//----------------------------------------------------------------------------------------
+// The load ELF file command routine. We load the file and set the entry address for
+// all processors. The processors start in privileged mode.
+//
+//----------------------------------------------------------------------------------------
+void SimCommandsWin::loadElfFile( char *fileName ) {
+    
+    try {
+        
+        winOut -> writeChars( "Loading %s\n", fileName );
+        
+        T64Word entry = loadElfFileIntoMemory( glb -> system, fileName, winOut );
         
         winOut -> writeChars( "Set entry: 0x%08x\n", entry );
     
-        // glb -> cpu -> setReg( RC_FD_PSTAGE, PSTAGE_REG_ID_PSW_0, (uint32_t) 0 );
-        // glb -> cpu -> setReg( RC_FD_PSTAGE, PSTAGE_REG_ID_PSW_1, (uint32_t) entry );
+        for ( int i = 0; i < MAX_MOD_MAP_ENTRIES; i++ ) {
+
+            T64Module *mPtr = glb -> system -> lookupByModNum( i );
+
+            if (( mPtr != nullptr ) && ( mPtr -> getModuleType( ) == MT_PROC )) {
+
+                (( T64Processor *) mPtr ) -> getCpuPtr( ) -> 
+                    setPsrReg(( 1ULL << 61 ) | entry );
+            }
+        }
         
         winOut -> writeChars( "Done\n" );
     }
@@ -214,6 +246,4 @@ void SimCommandsWin::loadElfFile( char *fileName ) {
         
         winOut -> writeChars( "ELF file load error: %d\n", errNum );
     }
-    
-    if ( reader != nullptr ) closeElfFile( reader );
 }
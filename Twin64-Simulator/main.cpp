@@ -24,23 +24,13 @@
 #include "T64-SimDeclarations.h"
 
 //----------------------------------------------------------------------------------------
-// Here we go.
+// Build the default system when no configuration file is specified. There is a 
+// processor, the PDC ROM and two memory modules.
+// The system is built before the window display is set up, since the batch mode has
+// no display. Configuration errors are therefore reported to standard error.
 //
 //----------------------------------------------------------------------------------------
-int main( int argc, char * argv[] ) {
-
-    SimGlobals *glb     = new SimGlobals( );
-
-    processCmdLineOptions( glb, argc, argv );
-   
-    glb -> console      = new SimConsoleIO( );
-    glb -> env          = new SimEnv( glb, 100 );
-    glb -> winDisplay   = new SimWinDisplay( glb );
-    glb -> system       = new T64System( );  
-    
-    glb -> console      -> initConsoleIO( );
-    glb -> env          -> setupPredefined( );
-    glb -> winDisplay   -> setupWinDisplay( );
+bool setupSystem( SimGlobals *glb ) {
 
     T64Processor *proc = 
         new T64Processor(   glb -> system,
@@ -80,30 +70,61 @@ int main( int argc, char * argv[] ) {
 
     if ( glb -> system -> addToModuleMap( pdc ) != 0 ) {
 
-        glb -> console -> writeChars( "Config Error: Module PDC\n" );
-        return( -1 );
+        fprintf( stderr, "Config Error: Module PDC\n" );
+        return( false );
     }
 
     pdc -> setSpaReadOnly( true );
     
     if ( glb -> system -> addToModuleMap( mem1 ) != 0 ) {
 
-        glb -> console -> writeChars( "Config Error: Module MEM 1\n" );
-        return( -1 );
+        fprintf( stderr, "Config Error: Module MEM 1\n" );
+        return( false );
     }
     
     if ( glb -> system -> addToModuleMap( mem2 ) != 0 ) {
 
-        glb -> console -> writeChars( "Config Error: Module MEM 2\n" );
-        return( -1 );
+        fprintf( stderr, "Config Error: Module MEM 2\n" );
+        return( false );
     }
 
     if ( glb -> system -> addToModuleMap( proc ) != 0 ) {
 
-        glb -> console -> writeChars( "Config Error: Module PROC\n" );
-        return( -1 );
+        fprintf( stderr, "Config Error: Module PROC\n" );
+        return( false );
+    }
+
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Here we go. In batch mode, we just build the system and hand over to the batch 
+// runner. Otherwise the window display is set up and the interactive session starts.
+//
+//----------------------------------------------------------------------------------------
+int main( int argc, char * argv[] ) {
+
+    SimGlobals *glb     = new SimGlobals( );
+
+    processCmdLineOptions( glb, argc, argv );
+
+    glb -> system       = new T64System( );  
+
+    if ( glb -> configFileName[ 0 ] != '\0' ) {
+
+        if ( ! setupSystemFromConfigFile( glb, glb -> configFileName )) return( -1 );
     }
+    else if ( ! setupSystem( glb )) return( -1 );
 
+    if ( glb -> batchFlag ) return( runBatch( glb ));
+   
+    glb -> console      = new SimConsoleIO( );
+    glb -> env          = new SimEnv( glb, 100 );
+    glb -> env          -> setupPredefined( );
+    glb -> winDisplay   = new SimWinDisplay( glb );
+    
+    glb -> console      -> initConsoleIO( );
+    glb -> winDisplay   -> setupWinDisplay( );
     glb -> winDisplay   -> startWinDisplay( );
     
     return 0;
@@ -0,0 +1,328 @@
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - Cache and TLB Trace Replay Program.
+//
+//----------------------------------------------------------------------------------------
+// TraceReplay reads a cache and TLB access trace captured by the simulator and replays
+// it against all cache and TLB configurations. Each configuration is run in its own
+// host thread, all threads read the same trace file. This way, one capture of a
+// guest program run is sufficient to compare all cache and TLB types. The program is
+// invoked as follows:
+//
+//  Twin64-TraceReplay <traceFile>
+//
+// The instruction cache records are replayed against all instruction cache types,
+// the data cache records against all data cache types. Likewise for the TLBs. The
+// cache model is a tag only model using the geometry and the pseudo LRU replacement
+// state of the simulator cache type. The TLB model is the simulator TLB itself.
+// On a TLB miss we insert a 4 Kb page translation, just like a miss handler would.
+//
+//----------------------------------------------------------------------------------------
+//
+// Twin-64 - Cache and TLB Trace Replay Program
+// Copyright (C) 2020 - 2026 Helmut Fieres
+//
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details. You should have received a copy of the GNU General Public
+// License along with this program. If not, see <http://www.gnu.org/licenses/>.
+//
+//----------------------------------------------------------------------------------------
+#include "T64-Common.h"
+#include "T64-Util.h"
+#include "T64-Processor.h"
+#include "T64-Trace.h"
+
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+// A replay configuration. Each configuration is either a cache or a TLB of a given
+// kind and type. The counters are filled in by the replay thread.
+//
+//----------------------------------------------------------------------------------------
+struct ReplayConfig {
+
+    bool            isCache         = false;
+    T64CacheKind    cacheKind       = T64_CK_NIL;
+    T64CacheType    cacheType       = T64_CT_NIL;
+    T64TlbKind      tlbKind         = T64_TK_NIL;
+    T64TlbType      tlbType         = T64_TT_NIL;
+
+    bool            traceOk         = false;
+    T64Word         requests        = 0;
+    T64Word         hits            = 0;
+    T64Word         misses          = 0;
+    T64Word         writeBacks      = 0;
+    T64Word         skipped         = 0;
+};
+
+//----------------------------------------------------------------------------------------
+// The tag only cache model entry.
+//
+//----------------------------------------------------------------------------------------
+struct ReplayCacheLine {
+
+    bool            valid           = false;
+    bool            modified        = false;
+    T64Word         tag             = 0;
+};
+
+const char *traceFileName = nullptr;
+
+//----------------------------------------------------------------------------------------
+// Program input parameters.
+//
+//----------------------------------------------------------------------------------------
+bool parseParameters( int argc, const char * argv[] ) {
+
+    if ( argc != 2 ) return( false );
+
+    traceFileName = argv[ 1 ];
+    return( true );
+}
+
+//----------------------------------------------------------------------------------------
+// Replay the cache records of the configured cache kind. The geometry is taken from
+// a simulator cache object of the configured type. We do not need its data path,
+// only the ways, sets, line size and the pseudo LRU state per set. Just like the
+// simulator cache, a miss fills an invalid way first and otherwise the pseudo LRU
+// victim. Uncached requests are counted as skipped.
+//
+//----------------------------------------------------------------------------------------
+void replayCache( ReplayConfig *cfg ) {
+
+    T64TraceReader  trace;
+    T64TraceRecord  rec;
+    T64Cache        geometry( nullptr, cfg -> cacheKind, cfg -> cacheType );
+
+    int ways        = geometry.getWays( );
+    int sets        = geometry.getSetSize( );
+    int lineSize    = geometry.getCacheLineSize( );
+
+    T64TraceKind readKind   = ( cfg -> cacheKind == T64_CK_INSTR_CACHE ) ?
+                                T64_TRK_I_CACHE_READ : T64_TRK_D_CACHE_READ;
+    T64TraceKind writeKind  = ( cfg -> cacheKind == T64_CK_INSTR_CACHE ) ?
+                                T64_TRK_I_CACHE_WRITE : T64_TRK_D_CACHE_WRITE;
+
+    std::vector<ReplayCacheLine> lines( ways * sets );
+
+    if ( ! trace.open( traceFileName )) return;
+    cfg -> traceOk = true;
+
+    while ( trace.next( &rec )) {
+
+        if (( rec.kind != readKind ) && ( rec.kind != writeKind )) continue;
+
+        if ( rec.uncached ) {
+
+            cfg -> skipped ++;
+            continue;
+        }
+
+        T64Word         lineAdr = rec.adr / lineSize;
+        int             set     = (int)( lineAdr % sets );
+        T64Word         tag     = lineAdr / sets;
+        int             way     = -1;
+        int             vWay    = -1;
+
+        cfg -> requests ++;
+
+        for ( int w = 0; w < ways; w++ ) {
+
+            ReplayCacheLine *l = &lines[ w * sets + set ];
+
+            if (( l -> valid ) && ( l -> tag == tag )) {
+
+                way = w;
+                break;
+            }
+
+            if (( vWay < 0 ) && ( ! l -> valid )) vWay = w;
+        }
+
+        if ( way >= 0 ) cfg -> hits ++;
+        else {
+
+            if ( vWay < 0 ) vWay = geometry.plruVictim( set );
+
+            ReplayCacheLine *victim = &lines[ vWay * sets + set ];
+
+            cfg -> misses ++;
+            if (( victim -> valid ) && ( victim -> modified )) cfg -> writeBacks ++;
+
+            way                 = vWay;
+            victim -> valid     = true;
+            victim -> modified  = false;
+            victim -> tag       = tag;
+        }
+
+        geometry.plruUpdate( set, way );
+
+        ReplayCacheLine *line = &lines[ way * sets + set ];
+        if ( rec.kind == writeKind ) line -> modified = true;
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Replay the TLB records of the configured TLB kind against a simulator TLB object.
+// I/O addresses are never entered into a TLB, they are counted as skipped.
+//
+//----------------------------------------------------------------------------------------
+void replayTlb( ReplayConfig *cfg ) {
+
+    T64TraceReader  trace;
+    T64TraceRecord  rec;
+    T64Tlb          tlb( nullptr, cfg -> tlbKind, cfg -> tlbType );
+
+    T64TraceKind lookupKind = ( cfg -> tlbKind == T64_TK_INSTR_TLB ) ?
+                                T64_TRK_I_TLB_LOOKUP : T64_TRK_D_TLB_LOOKUP;
+
+    if ( ! trace.open( traceFileName )) return;
+    cfg -> traceOk = true;
+
+    while ( trace.next( &rec )) {
+
+        if ( rec.kind != lookupKind ) continue;
+
+        if ( isInIoAdrRange( rec.adr )) {
+
+            cfg -> skipped ++;
+            continue;
+        }
+
+        cfg -> requests ++;
+
+        if ( tlb.lookup( rec.adr ) != nullptr ) cfg -> hits ++;
+        else {
+
+            cfg -> misses ++;
+            tlb.insert( rounddown( rec.adr, T64_PAGE_SIZE_BYTES ), 0 );
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Build the list of configurations. All cache types for both cache kinds and all
+// TLB types for both TLB kinds.
+//
+//----------------------------------------------------------------------------------------
+void buildConfigs( std::vector<ReplayConfig> &cfgs ) {
+
+    const T64CacheType cacheTypes[ ] = {
+
+        T64_CT_2W_128S_4L,  T64_CT_4W_128S_4L,  T64_CT_8W_128S_4L,
+        T64_CT_2W_64S_8L,   T64_CT_4W_64S_8L,   T64_CT_8W_64S_8L
+    };
+
+    const T64TlbType tlbTypes[ ] = { T64_TT_FA_64S, T64_TT_FA_128S };
+
+    for ( T64CacheKind kind : { T64_CK_INSTR_CACHE, T64_CK_DATA_CACHE }) {
+
+        for ( T64CacheType type : cacheTypes ) {
+
+            ReplayConfig cfg;
+            cfg.isCache     = true;
+            cfg.cacheKind   = kind;
+            cfg.cacheType   = type;
+            cfgs.push_back( cfg );
+        }
+    }
+
+    for ( T64TlbKind kind : { T64_TK_INSTR_TLB, T64_TK_DATA_TLB }) {
+
+        for ( T64TlbType type : tlbTypes ) {
+
+            ReplayConfig cfg;
+            cfg.isCache     = false;
+            cfg.tlbKind     = kind;
+            cfg.tlbType     = type;
+            cfgs.push_back( cfg );
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Print the result table.
+//
+//----------------------------------------------------------------------------------------
+void printResults( std::vector<ReplayConfig> &cfgs ) {
+
+    printf( "%-8s%-14s%14s%14s%14s%10s%14s%14s\n",
+            "Kind", "Type", "Requests", "Hits", "Misses", "Miss %",
+            "WriteBacks", "Skipped" );
+
+    for ( ReplayConfig &cfg : cfgs ) {
+
+        char typeStr[ 32 ];
+
+        if ( cfg.isCache ) {
+
+            T64Cache c( nullptr, cfg.cacheKind, cfg.cacheType );
+            snprintf( typeStr, sizeof( typeStr ), "%s", c.getCacheTypeString( ));
+        }
+        else {
+
+            snprintf( typeStr, sizeof( typeStr ), "%s",
+                      ( cfg.tlbType == T64_TT_FA_128S ) ? "FA_128S" : "FA_64S" );
+        }
+
+        const char *kindStr =
+            ( cfg.isCache ) ?
+                (( cfg.cacheKind == T64_CK_INSTR_CACHE ) ? "I-CACHE" : "D-CACHE" ) :
+                (( cfg.tlbKind == T64_TK_INSTR_TLB ) ? "I-TLB" : "D-TLB" );
+
+        double missRate = ( cfg.requests > 0 ) ?
+                            ( 100.0 * cfg.misses / cfg.requests ) : 0.0;
+
+        printf( "%-8s%-14s%14lld%14lld%14lld%10.2f%14lld%14lld\n",
+                kindStr, typeStr,
+                (long long) cfg.requests, (long long) cfg.hits,
+                (long long) cfg.misses, missRate,
+                (long long) cfg.writeBacks, (long long) cfg.skipped );
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Here we go. We first check that the trace file can be opened, then start a thread
+// for each configuration and wait for all of them to finish.
+//
+//----------------------------------------------------------------------------------------
+int main( int argc, const char * argv[] ) {
+
+    if ( ! parseParameters( argc, argv )) {
+
+        printf( "Usage: Twin64-TraceReplay <traceFile>\n" );
+        return( 1 );
+    }
+
+    T64TraceReader check;
+    if ( ! check.open( traceFileName )) {
+
+        printf( "Cannot open trace file: \"%s\"\n", traceFileName );
+        return( 1 );
+    }
+
+    check.close( );
+
+    std::vector<ReplayConfig>   cfgs;
+    std::vector<std::thread>    threads;
+
+    buildConfigs( cfgs );
+
+    for ( ReplayConfig &cfg : cfgs ) {
+
+        if ( cfg.isCache )  threads.emplace_back( replayCache, &cfg );
+        else                threads.emplace_back( replayTlb, &cfg );
+    }
+
+    for ( std::thread &t : threads ) t.join( );
+
+    printResults( cfgs );
+    return 0;
+}